@@ -0,0 +1,248 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/stopwatch.h>
+#include "AisArpaIndex.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define TEST_TARGETS (500)
+#define TEST_QUERIES (2000)
+#define TEST_OFFSET (50.)  // The default AISatARPAoffset
+
+// The linear search that radar_pi::FindAIS_at_arpaPos did before the index
+static bool LinearFind(const vector<AisArpa> &targets, const AisArpaQuery &query, double base_offset) {
+  double offset = (base_offset + (4.0 / 100) * query.dist) / 1852. / 60.;
+
+  for (size_t i = 0; i < targets.size(); i++) {
+    if (targets[i].ais_mmsi != 0) {
+      if (query.pos.lat + offset > targets[i].ais_lat && query.pos.lat - offset < targets[i].ais_lat &&
+          query.pos.lon + (offset * 1.75) > targets[i].ais_lon && query.pos.lon - (offset * 1.75) < targets[i].ais_lon) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+static GeoPosition Position(double lat, double lon) {
+  GeoPosition pos;
+  pos.lat = lat;
+  pos.lon = lon;
+  return pos;
+}
+
+static double Random(double lo, double hi) { return lo + (hi - lo) * rand() / (double)RAND_MAX; }
+
+// MMSIs that all start probing at the same slot of the smallest table
+static vector<long> CollidingMmsis(size_t n) {
+  vector<long> mmsis;
+
+  for (long mmsi = 244000000; mmsis.size() < n; mmsi++) {
+    if ((((unsigned long)mmsi * 2654435761u) & 63) == 7) {
+      mmsis.push_back(mmsi);
+    }
+  }
+  return mmsis;
+}
+
+static int TestHash() {
+  AisArpaIndex index;
+  vector<long> mmsis = CollidingMmsis(20);
+  int ret = 0;
+
+  // Colliding inserts, then updates that must find the same entry further down the probe chain
+  for (size_t i = 0; i < mmsis.size(); i++) {
+    index.Update(mmsis[i], 52., 4. + i, 1000);
+  }
+  for (size_t i = 0; i < mmsis.size(); i += 2) {
+    index.Update(mmsis[i], 53., 5. + i, 1100);
+  }
+  if (index.GetCount() != mmsis.size()) {
+    cout << "ERROR: " << index.GetCount() << " targets after updates instead of " << mmsis.size() << "\n";
+    ret = 1;
+  }
+  for (size_t i = 0; i < mmsis.size(); i++) {
+    const AisArpa *t = index.Find(mmsis[i]);
+    double lat = (i % 2 == 0) ? 53. : 52.;
+    if (!t || t->ais_mmsi != mmsis[i] || t->ais_lat != lat || t->ais_time_upd != ((i % 2 == 0) ? 1100 : 1000)) {
+      cout << "ERROR: colliding mmsi " << mmsis[i] << " not found or not updated\n";
+      ret = 1;
+    }
+  }
+
+  // Removing every other target from the middle of the probe chains keeps the others reachable
+  if (index.Expire(1000 + AIS_ARPA_MAX_AGE - 1) != 0) {
+    cout << "ERROR: targets expired early\n";
+    ret = 1;
+  }
+  size_t removed = index.Expire(1000 + AIS_ARPA_MAX_AGE + 1);
+  if (removed != mmsis.size() / 2 || index.GetCount() != mmsis.size() / 2) {
+    cout << "ERROR: expired " << removed << " of " << mmsis.size() << " targets\n";
+    ret = 1;
+  }
+  for (size_t i = 0; i < mmsis.size(); i++) {
+    if ((index.Find(mmsis[i]) != 0) != (i % 2 == 0)) {
+      cout << "ERROR: mmsi " << mmsis[i] << " is " << (i % 2 == 0 ? "missing" : "still there") << " after expiry\n";
+      ret = 1;
+    }
+  }
+  if (index.FindNear(Position(52., 5.), 0.01, 0.01)) {
+    cout << "ERROR: expired target still found by position\n";
+    ret = 1;
+  }
+
+  // A removed target comes back as a new one
+  index.Update(mmsis[1], 52., 5., 1200);
+  if (!index.Find(mmsis[1]) || index.GetCount() != mmsis.size() / 2 + 1) {
+    cout << "ERROR: expired mmsi cannot be added again\n";
+    ret = 1;
+  }
+
+  // Growing the table keeps everything
+  for (long i = 0; i < 1000; i++) {
+    index.Update(200000000 + i, 0., 0., 1200);
+  }
+  for (long i = 0; i < 1000; i++) {
+    if (!index.Find(200000000 + i)) {
+      cout << "ERROR: mmsi " << 200000000 + i << " lost after growing\n";
+      ret = 1;
+      break;
+    }
+  }
+  index.Clear();
+  if (index.GetCount() != 0 || index.Find(mmsis[0]) || index.FindNear(Position(0., 0.), 1., 1.)) {
+    cout << "ERROR: targets left after Clear()\n";
+    ret = 1;
+  }
+  return ret;
+}
+
+// Targets just either side of cell edges, around the equator and the prime meridian where the cells go negative
+static int TestGridEdges() {
+  AisArpaIndex index;
+  const double edges[] = {0., AIS_ARPA_GRID_CELL, -AIS_ARPA_GRID_CELL, 1000. * AIS_ARPA_GRID_CELL};
+  const double tiny = AIS_ARPA_GRID_CELL / 1000.;
+  const double offset = AIS_ARPA_GRID_CELL / 100.;
+  int ret = 0;
+
+  for (size_t e = 0; e < ARRAY_SIZE(edges); e++) {
+    for (int side = -1; side <= 1; side += 2) {
+      double lat = edges[e] + side * tiny;
+      double lon = -edges[e] + side * tiny;
+
+      index.Clear();
+      index.Update(366000000, lat, lon, 1000);
+      // The query is centered in the neighbouring cell, its rectangle reaches over the edge
+      GeoPosition across = Position(lat - 2 * side * tiny, lon - 2 * side * tiny);
+      GeoPosition beside = Position(lat - 2 * side * offset, lon);
+      if (!index.FindNear(across, offset, offset)) {
+        cout << "ERROR: target at " << lat << "," << lon << " not found from across the cell edge\n";
+        ret = 1;
+      }
+      if (index.FindNear(beside, offset, offset)) {
+        cout << "ERROR: target at " << lat << "," << lon << " found outside the rectangle\n";
+        ret = 1;
+      }
+    }
+  }
+  return ret;
+}
+
+// Random targets and queries give the same hits as the old linear search
+static int TestMatch() {
+  AisArpaIndex index;
+  vector<AisArpa> linear;
+  vector<AisArpaQuery> queries(TEST_QUERIES);
+  bool hit[TEST_QUERIES];
+  GeoPosition own = Position(51.9, 4.4);
+  size_t hits = 0;
+  int ret = 0;
+
+  srand(1);
+  for (size_t i = 0; i < TEST_TARGETS; i++) {
+    AisArpa t;
+    t.ais_mmsi = 244000000 + (long)i * 17;
+    t.ais_lat = own.lat + Random(-0.05, 0.05);
+    t.ais_lon = own.lon + Random(-0.1, 0.1);
+    t.ais_time_upd = 1000;
+    linear.push_back(t);
+    index.Update(t.ais_mmsi, t.ais_lat, t.ais_lon, 1000);
+  }
+  for (size_t i = 0; i < TEST_QUERIES; i++) {
+    queries[i].pos = Position(own.lat + Random(-0.05, 0.05), own.lon + Random(-0.1, 0.1));
+    queries[i].dist = Random(0., 6000.);
+  }
+
+  wxStopWatch stopwatch;
+  index.MatchArpaTargets(&queries[0], queries.size(), TEST_OFFSET, hit);
+  double indexed = stopwatch.TimeInMicro().ToDouble();
+
+  stopwatch.Start();
+  for (size_t i = 0; i < TEST_QUERIES; i++) {
+    bool expected = LinearFind(linear, queries[i], TEST_OFFSET);
+    if (expected != hit[i]) {
+      cout << "ERROR: query " << i << " at " << queries[i].pos.lat << "," << queries[i].pos.lon << " is " << hit[i]
+           << " instead of " << expected << "\n";
+      ret = 1;
+    }
+    hits += expected ? 1 : 0;
+  }
+  double scanned = stopwatch.TimeInMicro().ToDouble();
+
+  cout << "INFO: " << hits << " of " << TEST_QUERIES << " ARPA targets match one of " << TEST_TARGETS << " AIS targets, "
+       << indexed * 1000. / TEST_QUERIES << " ns per target with the index, " << scanned * 1000. / TEST_QUERIES
+       << " ns with a linear search\n";
+  if (hits == 0 || hits == TEST_QUERIES) {
+    cout << "ERROR: the test positions do not exercise both outcomes\n";
+    ret = 1;
+  }
+  return ret;
+}
+
+int main() {
+  int ret = 0;
+
+  ret |= TestHash();
+  ret |= TestGridEdges();
+  ret |= TestMatch();
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
@@ -0,0 +1,213 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "AisArpaIndex.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define MIN_SLOTS (64)
+
+AisArpaIndex::AisArpaIndex() {
+  m_slot_mask = 0;
+  m_grid_mask = 0;
+  m_grid_dirty = true;
+  m_next_expiry = 0;
+  Rehash();
+}
+
+static size_t PowerOfTwoAbove(size_t n) {
+  size_t r = MIN_SLOTS;
+  while (r < n) {
+    r <<= 1;
+  }
+  return r;
+}
+
+int AisArpaIndex::FindSlot(long mmsi) {
+  size_t slot = ((unsigned long)mmsi * 2654435761u) & m_slot_mask;
+
+  for (;;) {
+    int i = m_slots[slot];
+    if (i < 0 || m_targets[i].ais_mmsi == mmsi) {
+      return (int)slot;
+    }
+    slot = (slot + 1) & m_slot_mask;
+  }
+}
+
+void AisArpaIndex::Rehash() {
+  // Keep the load factor below 1/2 so probe sequences stay short
+  size_t size = PowerOfTwoAbove(m_targets.size() * 2);
+
+  m_slots.assign(size, -1);
+  m_slot_mask = size - 1;
+  for (size_t i = 0; i < m_targets.size(); i++) {
+    m_slots[FindSlot(m_targets[i].ais_mmsi)] = (int)i;
+  }
+}
+
+void AisArpaIndex::Update(long mmsi, double lat, double lon, time_t now) {
+  int slot = FindSlot(mmsi);
+  int i = m_slots[slot];
+
+  if (i < 0) {
+    AisArpa target;
+    target.ais_mmsi = mmsi;
+    m_targets.push_back(target);
+    i = (int)m_targets.size() - 1;
+    if (m_targets.size() * 2 > m_slots.size()) {
+      Rehash();
+    } else {
+      m_slots[slot] = i;
+    }
+    if (m_targets.size() == 1) {
+      m_next_expiry = now + AIS_ARPA_MAX_AGE;
+    }
+  }
+
+  AisArpa &target = m_targets[i];
+  target.ais_time_upd = now;
+  target.ais_lat = lat;
+  target.ais_lon = lon;
+  m_grid_dirty = true;
+}
+
+size_t AisArpaIndex::Expire(time_t now, time_t max_age) {
+  if (m_targets.empty() || now < m_next_expiry) {
+    return 0;  // Nothing can have expired yet
+  }
+
+  time_t oldest = now;
+  size_t n = 0;
+  for (size_t i = 0; i < m_targets.size(); i++) {
+    if (now - m_targets[i].ais_time_upd <= max_age) {
+      if (m_targets[i].ais_time_upd < oldest) {
+        oldest = m_targets[i].ais_time_upd;
+      }
+      m_targets[n++] = m_targets[i];
+    }
+  }
+
+  size_t removed = m_targets.size() - n;
+  m_next_expiry = oldest + max_age + 1;
+  if (removed > 0) {
+    m_targets.resize(n);
+    Rehash();
+    m_grid_dirty = true;
+  }
+  return removed;
+}
+
+void AisArpaIndex::Clear() {
+  m_targets.clear();
+  Rehash();
+  m_grid_dirty = true;
+}
+
+const AisArpa *AisArpaIndex::Find(long mmsi) {
+  int i = m_slots[FindSlot(mmsi)];
+
+  return (i < 0) ? 0 : &m_targets[i];
+}
+
+void AisArpaIndex::RebuildGrid() {
+  size_t size = PowerOfTwoAbove(m_targets.size() * 2);
+
+  m_grid_head.assign(size, -1);
+  m_grid_mask = size - 1;
+  m_grid_next.resize(m_targets.size());
+  for (size_t i = 0; i < m_targets.size(); i++) {
+    int lat_cell = (int)floor(m_targets[i].ais_lat / AIS_ARPA_GRID_CELL);
+    int lon_cell = (int)floor(m_targets[i].ais_lon / AIS_ARPA_GRID_CELL);
+    size_t h = CellHash(lat_cell, lon_cell);
+
+    m_grid_next[i] = m_grid_head[h];
+    m_grid_head[h] = (int)i;
+  }
+  m_grid_dirty = false;
+}
+
+bool AisArpaIndex::FindNear(const GeoPosition &pos, double lat_offset, double lon_offset) {
+  if (m_targets.empty()) {
+    return false;
+  }
+  if (m_grid_dirty) {
+    RebuildGrid();
+  }
+
+  int lat_lo = (int)floor((pos.lat - lat_offset) / AIS_ARPA_GRID_CELL);
+  int lat_hi = (int)floor((pos.lat + lat_offset) / AIS_ARPA_GRID_CELL);
+  int lon_lo = (int)floor((pos.lon - lon_offset) / AIS_ARPA_GRID_CELL);
+  int lon_hi = (int)floor((pos.lon + lon_offset) / AIS_ARPA_GRID_CELL);
+
+  if ((size_t)(lat_hi - lat_lo + 1) * (size_t)(lon_hi - lon_lo + 1) > m_targets.size()) {
+    // Searching the cells is more work than looking at every target
+    for (size_t i = 0; i < m_targets.size(); i++) {
+      const AisArpa &t = m_targets[i];
+      if (pos.lat + lat_offset > t.ais_lat && pos.lat - lat_offset < t.ais_lat && pos.lon + lon_offset > t.ais_lon &&
+          pos.lon - lon_offset < t.ais_lon) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  for (int lat_cell = lat_lo; lat_cell <= lat_hi; lat_cell++) {
+    for (int lon_cell = lon_lo; lon_cell <= lon_hi; lon_cell++) {
+      // Different cells may share a hash bucket, so the position is always checked
+      for (int i = m_grid_head[CellHash(lat_cell, lon_cell)]; i >= 0; i = m_grid_next[i]) {
+        const AisArpa &t = m_targets[i];
+        if (pos.lat + lat_offset > t.ais_lat && pos.lat - lat_offset < t.ais_lat && pos.lon + lon_offset > t.ais_lon &&
+            pos.lon - lon_offset < t.ais_lon) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+size_t AisArpaIndex::MatchArpaTargets(const AisArpaQuery *query, size_t n, double base_offset, bool *hit) {
+  size_t hits = 0;
+
+  for (size_t i = 0; i < n; i++) {
+    // Default 50 >> look 100 meters around + 4% of distance to target
+    double offset = (base_offset + (4.0 / 100) * query[i].dist) / 1852. / 60.;
+
+    hit[i] = FindNear(query[i].pos, offset, offset * 1.75);
+    if (hit[i]) {
+      hits++;
+    }
+  }
+  return hits;
+}
+
+PLUGIN_END_NAMESPACE
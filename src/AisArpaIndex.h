@@ -0,0 +1,116 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _AISARPAINDEX_H_
+#define _AISARPAINDEX_H_
+
+#include <vector>
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+// Table for AIS targets inside ARPA zone
+struct AisArpa {
+  long ais_mmsi;
+  time_t ais_time_upd;
+  double ais_lat;
+  double ais_lon;
+
+  AisArpa() : ais_mmsi(0), ais_time_upd(), ais_lat(), ais_lon() {}
+};
+
+// A (M)ARPA target position that is to be checked against the AIS targets
+struct AisArpaQuery {
+  GeoPosition pos;  // position of the ARPA target
+  double dist;      // distance from own ship to the ARPA target, in meters
+};
+
+#define AIS_ARPA_MAX_AGE (3 * 60)         // AIS targets not updated for this many seconds are removed
+#define AIS_ARPA_GRID_CELL (250. / 1852. / 60.)  // Size of a grid cell in degrees, about 250 m
+
+//
+// Index of the AIS targets that are near own ship, so that ARPA targets can be
+// recognized as AIS targets.
+//
+// Targets are stored densely, with an open addressing hash table from MMSI to the target,
+// and a coarse lat/lon grid for the position lookups. The grid is only rebuilt on the first
+// lookup after targets have moved, so a burst of AIS messages costs one rebuild.
+// Expired targets are removed in one pass, and only when the oldest target may have expired.
+//
+// Not thread safe; all calls are done from the GUI thread.
+//
+class AisArpaIndex {
+ public:
+  AisArpaIndex();
+
+  // Insert or update an AIS target
+  void Update(long mmsi, double lat, double lon, time_t now);
+
+  // Remove all targets that have not been updated since now - max_age. Returns the number removed.
+  size_t Expire(time_t now, time_t max_age = AIS_ARPA_MAX_AGE);
+
+  void Clear();
+  size_t GetCount() { return m_targets.size(); }
+  const AisArpa *Find(long mmsi);
+
+  // Is there an AIS target in the rectangle of +/- lat_offset and lon_offset degrees around pos?
+  bool FindNear(const GeoPosition &pos, double lat_offset, double lon_offset);
+
+  // Check n ARPA target positions in one pass. hit[i] is set when an AIS target is within
+  // base_offset meters + 4% of the distance of query i.
+  size_t MatchArpaTargets(const AisArpaQuery *query, size_t n, double base_offset, bool *hit);
+
+ private:
+  vector<AisArpa> m_targets;
+
+  // MMSI -> index in m_targets, -1 is empty, size is a power of two
+  vector<int> m_slots;
+  size_t m_slot_mask;
+
+  // Grid cell -> first index in m_targets, chained through m_grid_next
+  vector<int> m_grid_head;
+  vector<int> m_grid_next;
+  size_t m_grid_mask;
+  bool m_grid_dirty;
+
+  time_t m_next_expiry;  // Earliest time at which a target can expire
+
+  int FindSlot(long mmsi);
+  void Rehash();
+  void RebuildGrid();
+  size_t CellHash(int lat_cell, int lon_cell) {
+    return ((size_t)lat_cell * 73856093u ^ (size_t)lon_cell * 19349663u) & m_grid_mask;
+  }
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _AISARPAINDEX_H_ */
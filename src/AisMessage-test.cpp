@@ -0,0 +1,165 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/stopwatch.h>
+#include "AisMessage.h"
+#include "jsonreader.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+// AIS messages as sent by OpenCPN's AIS decoder through SendPluginMessage("AIS", ...)
+static const wxChar *ais_messages[] = {
+    wxT("{\n   \"Source\" : \"AIS_Decoder\",\n   \"Type\" : \"Information\",\n   \"Msg\" : \"AIS Target\",\n   \"MsgId\" : ")
+        wxT("\"244690123\",\n   \"lat\" : 52.1234567,\n   \"lon\" : 4.3456789,\n   \"sog\" : 5.4,\n   \"cog\" : 123.4,\n")
+        wxT("   \"hdg\" : 125,\n   \"mmsi\" : 244690123,\n   \"class\" : 0,\n   \"ownship\" : false,\n   \"active\" : true,\n")
+        wxT("   \"lost\" : false,\n   \"shipname\" : \"ZEEMEEUW\",\n   \"callsign\" : \"PD1234\",\n   \"removed\" : false\n}\n"),
+    wxT("{\n   \"Source\" : \"AIS_Decoder\",\n   \"Type\" : \"Information\",\n   \"Msg\" : \"AIS Target\",\n   \"MsgId\" : ")
+        wxT("\"211234560\",\n   \"lat\" : -33.8523,\n   \"lon\" : -151.2108,\n   \"sog\" : 0,\n   \"cog\" : 360,\n")
+        wxT("   \"hdg\" : 511,\n   \"mmsi\" : 211234560,\n   \"class\" : 1,\n   \"ownship\" : false,\n   \"active\" : true,\n")
+        wxT("   \"lost\" : false,\n   \"shipname\" : \"A \\\"QUOTED\\\" NAME\",\n   \"callsign\" : \"\",\n   \"removed\" : false\n}\n"),
+    wxT("{\"Source\":\"AIS_Decoder\",\"Type\":\"Information\",\"Msg\":\"AIS Target\",\"MsgId\":\"366123456\",")
+        wxT("\"lat\":\"37.80883\",\"lon\":\"-122.40929\",\"sog\":12.3,\"mmsi\":366123456,\"shipname\":\"GOLDEN GATE\"}"),
+    wxT("{\"Source\":\"AIS_Decoder\",\"extra\":{\"nested\":[1,2,{\"lat\":1}],\"x\":null},\"lat\":6.5e1,")
+        wxT("\"lon\":1.25E-1,\"mmsi\":257000001}"),
+};
+
+#define ASSERT_VALUE(name, actual, expected)                                                                               \
+  if (fabs((actual) - (expected)) > 1e-9) {                                                                                \
+    cout << "ERROR: message " << i << " " name " is not expected value " << (expected) << " but " << (actual) << "\n";     \
+    ret = 1;                                                                                                               \
+  }
+
+// The way radar_pi used to extract the fields
+static bool ParseWithJSONReader(const wxString &body, long *mmsi, double *lat, double *lon) {
+  wxJSONReader reader;
+  wxJSONValue message;
+
+  if (reader.Parse(body, &message)) {
+    return false;
+  }
+  wxJSONValue defaultValue(999);
+  *mmsi = message.Get(_T("mmsi"), defaultValue).AsLong();
+  wxJSONValue defaultPosition("90.0");
+  *lat = wxAtof(message.Get(_T("lat"), defaultPosition).AsString());
+  *lon = wxAtof(message.Get(_T("lon"), defaultPosition).AsString());
+  return true;
+}
+
+int main() {
+  int ret = 0;
+  size_t n = ARRAY_SIZE(ais_messages);
+  wxString body[ARRAY_SIZE(ais_messages)];
+
+  for (size_t i = 0; i < n; i++) {
+    long mmsi, expected_mmsi;
+    double lat, lon, expected_lat, expected_lon;
+
+    body[i] = ais_messages[i];
+    if (!ParseWithJSONReader(body[i], &expected_mmsi, &expected_lat, &expected_lon)) {
+      cout << "ERROR: message " << i << " is not valid JSON\n";
+      ret = 1;
+      continue;
+    }
+    if (!ParseAisMessage(body[i], &mmsi, &lat, &lon)) {
+      cout << "ERROR: message " << i << " is not parsed\n";
+      ret = 1;
+      continue;
+    }
+    ASSERT_VALUE("mmsi", mmsi, expected_mmsi);
+    ASSERT_VALUE("lat", lat, expected_lat);
+    ASSERT_VALUE("lon", lon, expected_lon);
+  }
+
+  // Multibyte characters in front of the fields, where a UTF-8 build has fewer characters than bytes
+  wxString multibyte = wxString::FromUTF8("{\"shipname\":\"\xc3\x86GIR \xc3\x98ST\xc3\x98Y\",\"callsign\":\"LA\xc3\x85\","
+                                          "\"lat\":60.5,\"lon\":5.25,\"mmsi\":257123450}");
+  {
+    long mmsi;
+    double lat, lon;
+    size_t i = n;
+    if (!ParseAisMessage(multibyte, &mmsi, &lat, &lon)) {
+      cout << "ERROR: message with multibyte characters is not parsed\n";
+      ret = 1;
+    } else {
+      ASSERT_VALUE("mmsi", mmsi, 257123450);
+      ASSERT_VALUE("lat", lat, 60.5);
+      ASSERT_VALUE("lon", lon, 5.25);
+    }
+  }
+
+  const char *broken[] = {"", "{", "{}", "[1,2]", "{\"mmsi\":123,\"lat\":1.0", "{\"mmsi\":,\"lat\":1,\"lon\":2}",
+                          "{\"lat\":1,\"lon\":2}", "{\"mmsi\" 1}"};
+  for (size_t i = 0; i < ARRAY_SIZE(broken); i++) {
+    long mmsi;
+    double lat, lon;
+    if (ParseAisMessage(broken[i], strlen(broken[i]), &mmsi, &lat, &lon)) {
+      cout << "ERROR: broken message " << i << " is accepted\n";
+      ret = 1;
+    }
+  }
+
+  // Benchmark
+  const int loops = 20000;
+  long mmsi;
+  double lat, lon, sum = 0.;
+
+  wxStopWatch stopwatch;
+  for (int l = 0; l < loops; l++) {
+    for (size_t i = 0; i < n; i++) {
+      ParseWithJSONReader(body[i], &mmsi, &lat, &lon);
+      sum += lat;
+    }
+  }
+  double reader_ns = stopwatch.TimeInMicro().ToDouble() * 1000. / (loops * n);
+
+  stopwatch.Start();
+  for (int l = 0; l < loops; l++) {
+    for (size_t i = 0; i < n; i++) {
+      ParseAisMessage(body[i], &mmsi, &lat, &lon);
+      sum -= lat;
+    }
+  }
+  double scanner_ns = stopwatch.TimeInMicro().ToDouble() * 1000. / (loops * n);
+
+  cout << "INFO: wxJSONReader takes " << reader_ns << " ns per message, AisMessageScanner takes " << scanner_ns
+       << " ns per message (" << sum << ")\n";
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
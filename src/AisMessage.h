@@ -0,0 +1,300 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _AISMESSAGE_H_
+#define _AISMESSAGE_H_
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Extract the fields we need from the JSON that OpenCPN sends as "AIS" plugin message,
+// without building a wxJSONValue tree.
+//
+// The scanner walks the message once and only looks at top level members. Nested objects,
+// arrays and other values are skipped. Numbers are converted in place, so it does not
+// allocate and does not depend on the locale's decimal point like wxAtof does.
+// It works on the characters of a wxString directly (wx_str()), which are wchar_t or char
+// depending on the wxWidgets build, hence the template. Use the wxString overload, which
+// passes the right length for either.
+//
+template <typename Ch>
+class AisMessageScanner {
+ public:
+  AisMessageScanner(const Ch *body, size_t len) : m_p(body), m_end(body + len) {}
+
+  // Returns true when mmsi, lat and lon were all found in a well formed object.
+  bool Parse(long *mmsi, double *lat, double *lon) {
+    bool have_mmsi = false, have_lat = false, have_lon = false;
+    const Ch *key;
+    size_t key_len;
+    double value;
+
+    SkipSpace();
+    if (!Accept('{')) {
+      return false;
+    }
+    SkipSpace();
+    if (Accept('}')) {
+      return false;
+    }
+    for (;;) {
+      SkipSpace();
+      if (!ScanString(&key, &key_len)) {
+        return false;
+      }
+      SkipSpace();
+      if (!Accept(':')) {
+        return false;
+      }
+      SkipSpace();
+      if (KeyIs(key, key_len, "mmsi")) {
+        if (!ScanNumber(&value)) {
+          return false;
+        }
+        *mmsi = (long)value;
+        have_mmsi = true;
+      } else if (KeyIs(key, key_len, "lat")) {
+        if (!ScanNumber(lat)) {
+          return false;
+        }
+        have_lat = true;
+      } else if (KeyIs(key, key_len, "lon")) {
+        if (!ScanNumber(lon)) {
+          return false;
+        }
+        have_lon = true;
+      } else if (!SkipValue()) {
+        return false;
+      }
+      if (have_mmsi && have_lat && have_lon) {
+        return true;  // No need to look at the rest
+      }
+      SkipSpace();
+      if (Accept(',')) {
+        continue;
+      }
+      return false;  // '}' without all fields, or a syntax error
+    }
+  }
+
+ private:
+  const Ch *m_p;
+  const Ch *m_end;
+
+  void SkipSpace() {
+    while (m_p < m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\r' || *m_p == '\n')) {
+      m_p++;
+    }
+  }
+
+  bool Accept(char c) {
+    if (m_p < m_end && *m_p == (Ch)c) {
+      m_p++;
+      return true;
+    }
+    return false;
+  }
+
+  static bool KeyIs(const Ch *key, size_t key_len, const char *name) {
+    size_t i;
+    for (i = 0; i < key_len; i++) {
+      if (!name[i] || key[i] != (Ch)name[i]) {
+        return false;
+      }
+    }
+    return name[i] == 0;
+  }
+
+  // Scan a string, returning its raw contents (escapes are not decoded)
+  bool ScanString(const Ch **start, size_t *len) {
+    if (!Accept('"')) {
+      return false;
+    }
+    *start = m_p;
+    while (m_p < m_end) {
+      if (*m_p == '\\') {
+        m_p += 2;
+        continue;
+      }
+      if (*m_p == '"') {
+        *len = m_p - *start;
+        m_p++;
+        return true;
+      }
+      m_p++;
+    }
+    return false;
+  }
+
+  // Scan a number, which may also be sent as a string "52.1"
+  bool ScanNumber(double *value) {
+    if (Accept('"')) {
+      SkipSpace();
+      if (!ParseNumber(value)) {
+        return false;
+      }
+      SkipSpace();
+      return Accept('"');
+    }
+    return ParseNumber(value);
+  }
+
+  bool ParseNumber(double *value) {
+    static const double pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    bool negative = false;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+
+    if (Accept('-')) {
+      negative = true;
+    } else {
+      Accept('+');
+    }
+    for (; m_p < m_end && *m_p >= '0' && *m_p <= '9'; m_p++, digits++) {
+      if (mantissa < 1000000000000000000ULL) {
+        mantissa = mantissa * 10 + (*m_p - '0');
+      } else {
+        exponent++;  // Precision is lost here anyway
+      }
+    }
+    if (Accept('.')) {
+      for (; m_p < m_end && *m_p >= '0' && *m_p <= '9'; m_p++, digits++) {
+        if (mantissa < 1000000000000000000ULL) {
+          mantissa = mantissa * 10 + (*m_p - '0');
+          exponent--;
+        }
+      }
+    }
+    if (digits == 0) {
+      return false;
+    }
+    if (m_p < m_end && (*m_p == 'e' || *m_p == 'E')) {
+      bool exp_negative = false;
+      int exp = 0;
+
+      m_p++;
+      if (Accept('-')) {
+        exp_negative = true;
+      } else {
+        Accept('+');
+      }
+      if (m_p >= m_end || *m_p < '0' || *m_p > '9') {
+        return false;
+      }
+      for (; m_p < m_end && *m_p >= '0' && *m_p <= '9'; m_p++) {
+        if (exp < 10000) {
+          exp = exp * 10 + (*m_p - '0');
+        }
+      }
+      exponent += exp_negative ? -exp : exp;
+    }
+
+    double v = (double)mantissa;
+    if (exponent < 0) {
+      v = (exponent >= -22) ? v / pow10[-exponent] : v * pow(10., exponent);
+    } else if (exponent > 0) {
+      v = (exponent <= 22) ? v * pow10[exponent] : v * pow(10., exponent);
+    }
+    *value = negative ? -v : v;
+    return true;
+  }
+
+  // Skip any JSON value, including nested objects and arrays
+  bool SkipValue() {
+    const Ch *start;
+    size_t len;
+    int depth = 0;
+
+    do {
+      SkipSpace();
+      if (m_p >= m_end) {
+        return false;
+      }
+      Ch c = *m_p;
+      if (c == '"') {
+        if (!ScanString(&start, &len)) {
+          return false;
+        }
+      } else if (c == '{' || c == '[') {
+        depth++;
+        m_p++;
+      } else if (c == '}' || c == ']') {
+        if (depth == 0) {
+          return false;
+        }
+        depth--;
+        m_p++;
+      } else if (c == ',' || c == ':') {
+        if (depth == 0) {
+          return false;
+        }
+        m_p++;
+      } else {
+        // number, true, false or null
+        const Ch *begin = m_p;
+        while (m_p < m_end && *m_p != ',' && *m_p != '}' && *m_p != ']' && *m_p != ' ' && *m_p != '\t' && *m_p != '\r' &&
+               *m_p != '\n') {
+          m_p++;
+        }
+        if (m_p == begin) {
+          return false;
+        }
+      }
+    } while (depth > 0);
+    return true;
+  }
+};
+
+template <typename Ch>
+bool ParseAisMessage(const Ch *body, size_t len, long *mmsi, double *lat, double *lon) {
+  AisMessageScanner<Ch> scanner(body, len);
+
+  return scanner.Parse(mmsi, lat, lon);
+}
+
+// In a UTF-8 build length() counts characters, not the bytes that wx_str() points to, so
+// there the UTF-8 bytes are scanned with their own length. utf8_str() does not copy then.
+inline bool ParseAisMessage(const wxString &body, long *mmsi, double *lat, double *lon) {
+#if wxUSE_UNICODE_WCHAR
+  return ParseAisMessage(body.wx_str(), body.length(), mmsi, lat, lon);
+#else
+  const wxScopedCharBuffer utf8 = body.utf8_str();
+  return ParseAisMessage(utf8.data(), utf8.length(), mmsi, lat, lon);
+#endif
+}
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _AISMESSAGE_H_ */
@@ -0,0 +1,153 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/stopwatch.h>
+#include "ArpaCpa.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define BENCH_TARGETS (500)
+
+#define ASSERT_VALUE(name, actual, expected)                                                                               \
+  if (fabs((actual) - (expected)) > 1e-6) {                                                                                \
+    cout << "ERROR: case " << i << " " name " is not expected value " << (expected) << " but " << (actual) << "\n";        \
+    ret = 1;                                                                                                               \
+  }
+
+struct CpaCase {
+  double north, east, v_north, v_east;
+  double cpa, tcpa;
+  bool dangerous;  // within 600 m in the next 200 s
+};
+
+static const CpaCase cases[] = {
+    {1000., 0., -10., 0., 0., 100., true},          // head on
+    {1000., 500., -10., 0., 500., 100., true},      // crossing ahead
+    {1000., 0., 10., 0., 0., -100., false},         // moving apart
+    {300., 400., 0., 0., 500., 0., true},           // same course and speed, close by
+    {-3000., -4000., 3., 4., 0., 1000., false},     // collision course, but far away
+    {0., 1000., 5., -5., 707.106781187, 100., false}  // passes just outside the limit
+};
+
+// The straightforward way, one target at a time
+static void ReferenceCpa(double north, double east, double v_north, double v_east, double *cpa, double *tcpa) {
+  double vv = v_north * v_north + v_east * v_east;
+  if (vv <= CPA_MIN_RELATIVE_SPEED2) {
+    *tcpa = 0.;
+    *cpa = sqrt(north * north + east * east);
+    return;
+  }
+  *tcpa = -(north * v_north + east * v_east) / vv;
+  double n = north + v_north * *tcpa;
+  double e = east + v_east * *tcpa;
+  *cpa = sqrt(n * n + e * e);
+}
+
+int main() {
+  int ret = 0;
+  ArpaCpa<BENCH_TARGETS> *cpa = new ArpaCpa<BENCH_TARGETS>;
+
+  for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+    cpa->Add(cases[i].north, cases[i].east, cases[i].v_north, cases[i].v_east);
+  }
+  cpa->Compute();
+  for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+    ASSERT_VALUE("cpa", cpa->GetCPA(i), cases[i].cpa);
+    ASSERT_VALUE("tcpa", cpa->GetTCPA(i), cases[i].tcpa);
+    if (cpa->IsDangerous(i, 600., 200.) != cases[i].dangerous) {
+      cout << "ERROR: case " << i << " dangerous is not " << cases[i].dangerous << "\n";
+      ret = 1;
+    }
+  }
+
+  // Fill up to capacity with pseudo random targets within 12 km, moving up to 15 m/s
+  static double north[BENCH_TARGETS], east[BENCH_TARGETS], v_north[BENCH_TARGETS], v_east[BENCH_TARGETS];
+  cpa->Clear();
+  srand(1);
+  for (size_t i = 0; i < BENCH_TARGETS; i++) {
+    north[i] = (rand() % 24000) - 12000.;
+    east[i] = (rand() % 24000) - 12000.;
+    v_north[i] = ((rand() % 3000) - 1500.) / 100.;
+    v_east[i] = ((rand() % 3000) - 1500.) / 100.;
+    if (cpa->Add(north[i], east[i], v_north[i], v_east[i]) != (int)i) {
+      cout << "ERROR: Add " << i << " failed\n";
+      ret = 1;
+    }
+  }
+  if (cpa->Add(0., 0., 0., 0.) != -1) {
+    cout << "ERROR: Add beyond capacity succeeded\n";
+    ret = 1;
+  }
+  cpa->Compute();
+  for (size_t i = 0; i < BENCH_TARGETS; i++) {
+    double c, t;
+    ReferenceCpa(north[i], east[i], v_north[i], v_east[i], &c, &t);
+    ASSERT_VALUE("cpa", cpa->GetCPA(i), c);
+    ASSERT_VALUE("tcpa", cpa->GetTCPA(i), t);
+  }
+
+  // Benchmark
+  const int loops = 20000;
+  double sum = 0.;
+
+  wxStopWatch stopwatch;
+  for (int l = 0; l < loops; l++) {
+    for (size_t i = 0; i < BENCH_TARGETS; i++) {
+      double c, t;
+      ReferenceCpa(north[i], east[i], v_north[i] + l * 1e-9, v_east[i], &c, &t);
+      sum += c;
+    }
+  }
+  double reference_us = stopwatch.TimeInMicro().ToDouble() / loops;
+
+  stopwatch.Start();
+  for (int l = 0; l < loops; l++) {
+    cpa->Compute();
+    sum -= cpa->GetCPA(l % BENCH_TARGETS);
+  }
+  double soa_us = stopwatch.TimeInMicro().ToDouble() / loops;
+
+  cout << "INFO: CPA of " << BENCH_TARGETS << " targets takes " << reference_us << " us one by one, " << soa_us
+       << " us as ArpaCpa (" << sum << ")\n";
+
+  delete cpa;
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
@@ -0,0 +1,109 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _ARPACPA_H_
+#define _ARPACPA_H_
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define CPA_MIN_RELATIVE_SPEED2 (1e-4)  // (m/s)^2, below this the relative motion is considered zero
+
+//
+// Closest point of approach for a whole set of targets at once.
+//
+// The targets are kept as a structure of arrays: one array per component of the position
+// and velocity relative to own ship. The computation is a single loop without branches
+// or calls (other than sqrt) so the compiler can vectorize it.
+//
+// All units are SI: positions in meters (north, east), velocities in m/s, TCPA in seconds.
+// A negative TCPA means the targets are moving apart, the CPA is then in the past.
+//
+template <size_t N>
+class ArpaCpa {
+ public:
+  ArpaCpa() { Clear(); }
+
+  void Clear() { m_count = 0; }
+
+  size_t GetCount() { return m_count; }
+
+  // Add a target, returns its index or -1 when full
+  int Add(double north, double east, double v_north, double v_east) {
+    if (m_count >= N) {
+      return -1;
+    }
+    m_north[m_count] = north;
+    m_east[m_count] = east;
+    m_v_north[m_count] = v_north;
+    m_v_east[m_count] = v_east;
+    return (int)m_count++;
+  }
+
+  void Compute() {
+    const size_t n = m_count;
+
+    for (size_t i = 0; i < n; i++) {
+      double pn = m_north[i];
+      double pe = m_east[i];
+      double vn = m_v_north[i];
+      double ve = m_v_east[i];
+      double vv = vn * vn + ve * ve;
+      double pv = pn * vn + pe * ve;
+      double t = vv > CPA_MIN_RELATIVE_SPEED2 ? -pv / vv : 0.;
+      double cn = pn + vn * t;
+      double ce = pe + ve * t;
+
+      m_tcpa[i] = t;
+      m_cpa[i] = sqrt(cn * cn + ce * ce);
+    }
+  }
+
+  double GetCPA(size_t i) { return m_cpa[i]; }
+  double GetTCPA(size_t i) { return m_tcpa[i]; }
+
+  // Is the target going to pass within cpa meters in the next tcpa seconds?
+  bool IsDangerous(size_t i, double cpa, double tcpa) { return m_cpa[i] <= cpa && m_tcpa[i] >= 0. && m_tcpa[i] <= tcpa; }
+
+ private:
+  size_t m_count;
+  double m_north[N];
+  double m_east[N];
+  double m_v_north[N];
+  double m_v_east[N];
+  double m_cpa[N];
+  double m_tcpa[N];
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _ARPACPA_H_ */
@@ -0,0 +1,132 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/init.h>
+#include <wx/stopwatch.h>
+#include "AsyncLog.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define PRODUCERS (4)
+#define MESSAGES (20000)  // Per producer, far more than the queue holds
+
+class Producer : public wxThread {
+ public:
+  Producer(int id) : wxThread(wxTHREAD_JOINABLE) { m_id = id; }
+
+  void *Entry(void) {
+    uint8_t data[LOG_BINARY_MAX * 2];
+    for (size_t i = 0; i < sizeof(data); i++) {
+      data[i] = (uint8_t)i;
+    }
+    for (int i = 0; i < MESSAGES; i++) {
+      if (i % 100 == 0) {
+        AsyncLogBinary(wxString::Format(wxT("radar_pi: producer %d binary"), m_id), data, (size_t)(i % sizeof(data)));
+      } else {
+        AsyncLogMessage(wxString::Format(wxT("radar_pi: producer %d message %d"), m_id, i));
+      }
+    }
+    return 0;
+  }
+
+ private:
+  int m_id;
+};
+
+int main() {
+  wxInitializer initializer;  // needed for wxThread
+  int ret = 0;
+
+  // A call site gets LOG_RATE_PER_SECOND messages per second, another site has its own budget.
+  // Retry when the second changes while we count.
+  int allowed = 0;
+  int other = 0;
+  for (int attempt = 0; attempt < 3; attempt++) {
+    time_t start = time(0);
+    allowed = 0;
+    other = 0;
+    for (int i = 0; i < 1000; i++) {
+      allowed += LogRateAllowed(__FILE__, 1000) ? 1 : 0;
+      other += LogRateAllowed(__FILE__, 2000) ? 1 : 0;
+    }
+    if (time(0) == start) {
+      break;
+    }
+  }
+  if (allowed != LOG_RATE_PER_SECOND || other != LOG_RATE_PER_SECOND) {
+    cout << "ERROR: call sites were allowed " << allowed << " and " << other << " messages, expected " << LOG_RATE_PER_SECOND
+         << "\n";
+    ret = 1;
+  }
+
+  // Many threads at once; messages that do not fit in the queue are counted, not waited for
+  StartAsyncLog();
+  wxStopWatch stopwatch;
+  Producer *producer[PRODUCERS];
+  for (int p = 0; p < PRODUCERS; p++) {
+    producer[p] = new Producer(p);
+    producer[p]->Run();
+  }
+  for (int p = 0; p < PRODUCERS; p++) {
+    producer[p]->Wait();
+    delete producer[p];
+  }
+  double ns = stopwatch.TimeInMicro().ToDouble() * 1e3 / (PRODUCERS * MESSAGES);
+  StopAsyncLog();
+  cout << "INFO: " << PRODUCERS << " threads logged at " << ns << " ns per message\n";
+
+  // Stop while the threads are still logging; they carry on logging directly
+  StartAsyncLog();
+  for (int p = 0; p < PRODUCERS; p++) {
+    producer[p] = new Producer(p);
+    producer[p]->Run();
+  }
+  wxMilliSleep(5);
+  StopAsyncLog();
+  for (int p = 0; p < PRODUCERS; p++) {
+    producer[p]->Wait();
+    delete producer[p];
+  }
+
+  // After stopping, messages are logged directly
+  AsyncLogMessage(wxT("radar_pi: logged after the background thread stopped"));
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
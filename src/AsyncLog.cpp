@@ -0,0 +1,302 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "AsyncLog.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#ifdef _MSC_VER
+#define ATOMIC_COMPARE_AND_SWAP(p, expected, desired) \
+  (InterlockedCompareExchange((volatile LONG *)(p), (LONG)(desired), (LONG)(expected)) == (LONG)(expected))
+#define ATOMIC_INCREMENT(p) InterlockedIncrement((volatile LONG *)(p))
+#define ATOMIC_SUBTRACT(p, n) InterlockedExchangeAdd((volatile LONG *)(p), -(LONG)(n))
+#define MEMORY_BARRIER() MemoryBarrier()
+#else
+#define ATOMIC_COMPARE_AND_SWAP(p, expected, desired) __sync_bool_compare_and_swap(p, expected, desired)
+#define ATOMIC_INCREMENT(p) __sync_add_and_fetch(p, 1)
+#define ATOMIC_SUBTRACT(p, n) __sync_sub_and_fetch(p, n)
+#define MEMORY_BARRIER() __sync_synchronize()
+#endif
+
+#define LOG_IDLE_SLEEP (50)  // ms the background thread waits when the queue is empty
+
+struct LogSlot {
+  volatile uint32_t sequence;  // Tells the writers and the reader whose turn it is
+  char text[LOG_TEXT_MAX];     // UTF-8
+  uint8_t data[LOG_BINARY_MAX];
+  size_t size;  // Bytes of binary data that were logged, more than LOG_BINARY_MAX if truncated
+  bool binary;
+};
+
+struct LogRateSite {
+  const char *file;
+  int line;
+  time_t second;
+  uint32_t count;       // Messages in this second
+  uint32_t suppressed;  // Dropped since the last report
+};
+
+/*
+ * A bounded queue for many writers and a single reader, after Dmitry Vyukov. Slot i is free for
+ * the writer that claims position p when its sequence equals p, and holds a message for the
+ * reader at position p when its sequence equals p + 1.
+ */
+static LogSlot s_slots[LOG_QUEUE_SIZE];
+static volatile uint32_t s_tail = 0;  // Next position to write
+static uint32_t s_head = 0;           // Next position to read, only used by the reader
+static volatile uint32_t s_dropped = 0;
+static volatile uint32_t s_writers = 0;  // Writers that saw the background thread running and may still enqueue
+
+static LogRateSite s_sites[LOG_RATE_SITES];
+
+class AsyncLogThread : public wxThread {
+ public:
+  AsyncLogThread() : wxThread(wxTHREAD_JOINABLE) { m_shutdown = false; }
+
+  void *Entry(void);
+  void Shutdown() { m_shutdown = true; }
+
+ private:
+  volatile bool m_shutdown;
+};
+
+static AsyncLogThread *s_thread = 0;
+
+// Append " <size> bytes: XX XX ..." for the first n bytes of data
+static void AppendHex(wxString *message, const uint8_t *data, size_t n, size_t size) {
+  static const char digits[] = "0123456789ABCDEF";
+  char hex[LOG_BINARY_MAX * 3 + 1];
+
+  *message << wxString::Format(wxT(" %u bytes:"), (unsigned)size);
+  while (n > 0) {
+    size_t chunk = wxMin(n, (size_t)LOG_BINARY_MAX);
+    for (size_t i = 0; i < chunk; i++) {
+      hex[i * 3] = ' ';
+      hex[i * 3 + 1] = digits[data[i] >> 4];
+      hex[i * 3 + 2] = digits[data[i] & 15];
+    }
+    hex[chunk * 3] = 0;
+    *message << wxString::FromAscii(hex);
+    data += chunk;
+    n -= chunk;
+    size -= chunk;
+  }
+  if (size > 0) {
+    *message << wxT(" ...");
+  }
+}
+
+static bool Dequeue(wxString *message) {
+  LogSlot *slot = &s_slots[s_head & (LOG_QUEUE_SIZE - 1)];
+
+  if (slot->sequence != s_head + 1) {
+    return false;
+  }
+  MEMORY_BARRIER();
+  *message = wxString::FromUTF8(slot->text);
+  if (slot->binary) {
+    AppendHex(message, slot->data, wxMin(slot->size, (size_t)LOG_BINARY_MAX), slot->size);
+  }
+  MEMORY_BARRIER();
+  slot->sequence = s_head + LOG_QUEUE_SIZE;
+  s_head++;
+  return true;
+}
+
+static void ReportSuppressed() {
+  time_t now = time(0);
+
+  for (size_t i = 0; i < LOG_RATE_SITES; i++) {
+    LogRateSite *site = &s_sites[i];
+    if (site->suppressed > 0 && site->second != now) {
+      wxLogMessage(wxT("radar_pi: %u messages from %s:%d were not logged"), site->suppressed, wxString::FromUTF8(site->file).c_str(),
+                   site->line);
+      site->suppressed = 0;
+    }
+  }
+  uint32_t dropped = s_dropped;
+  if (dropped > 0) {
+    wxLogMessage(wxT("radar_pi: %u messages were not logged because the log queue was full"), dropped);
+    ATOMIC_SUBTRACT(&s_dropped, dropped);
+  }
+}
+
+static void Drain() {
+  wxString message;
+
+  while (Dequeue(&message)) {
+    wxLogMessage(wxT("%s"), message.c_str());
+  }
+  ReportSuppressed();
+}
+
+void *AsyncLogThread::Entry(void) {
+  while (!m_shutdown) {
+    Drain();
+    wxMilliSleep(LOG_IDLE_SLEEP);
+  }
+  return 0;
+}
+
+void StartAsyncLog() {
+  if (s_thread) {
+    return;
+  }
+  for (uint32_t i = 0; i < LOG_QUEUE_SIZE; i++) {
+    s_slots[i].sequence = s_tail + i;
+  }
+  s_head = s_tail;
+
+  AsyncLogThread *thread = new AsyncLogThread;
+  if (thread->Run() != wxTHREAD_NO_ERROR) {
+    delete thread;
+    return;
+  }
+  s_thread = thread;
+}
+
+void StopAsyncLog() {
+  AsyncLogThread *thread = s_thread;
+
+  if (!thread) {
+    return;
+  }
+  s_thread = 0;  // New messages are logged directly from now on
+  MEMORY_BARRIER();
+  thread->Shutdown();
+  thread->Wait();
+  delete thread;
+
+  // A writer that saw the thread running just before we cleared s_thread may still be filling
+  // its slot. Wait until it has published, otherwise Drain() stops at that slot and the
+  // message and everything queued after it is lost.
+  while (s_writers != 0) {
+    wxMilliSleep(1);
+  }
+  Drain();
+}
+
+bool LogRateAllowed(const char *file, int line) {
+  LogRateSite *site = &s_sites[(((size_t)file >> 4) ^ (size_t)line * 2654435761U) & (LOG_RATE_SITES - 1)];
+  time_t now = time(0);
+
+  // Two call sites can share a slot, they then share the rate too. The counts are not updated
+  // atomically, so a few messages more or less may get through.
+  site->file = file;
+  site->line = line;
+  if (site->second != now) {
+    site->second = now;
+    site->count = 0;
+  }
+  if (site->count >= LOG_RATE_PER_SECOND) {
+    site->suppressed++;
+    return false;
+  }
+  site->count++;
+  return true;
+}
+
+static LogSlot *Enqueue() {
+  uint32_t pos = s_tail;
+
+  for (;;) {
+    LogSlot *slot = &s_slots[pos & (LOG_QUEUE_SIZE - 1)];
+    int32_t diff = (int32_t)(slot->sequence - pos);
+    if (diff == 0) {
+      if (ATOMIC_COMPARE_AND_SWAP(&s_tail, pos, pos + 1)) {
+        return slot;
+      }
+    } else if (diff < 0) {
+      ATOMIC_INCREMENT(&s_dropped);
+      return 0;
+    }
+    pos = s_tail;
+  }
+}
+
+static void Publish(LogSlot *slot) {
+  uint32_t pos = slot->sequence;
+
+  MEMORY_BARRIER();
+  slot->sequence = pos + 1;
+}
+
+// Returns false when the background thread is not running and the caller must log directly,
+// otherwise the caller may enqueue and must call EndWrite() when done.
+static bool BeginWrite() {
+  ATOMIC_INCREMENT(&s_writers);
+  if (!s_thread) {
+    ATOMIC_SUBTRACT(&s_writers, 1);
+    return false;
+  }
+  return true;
+}
+
+static void EndWrite() { ATOMIC_SUBTRACT(&s_writers, 1); }
+
+static void CopyText(char *text, const wxString &message) {
+  strncpy(text, (const char *)message.ToUTF8(), LOG_TEXT_MAX - 1);
+  text[LOG_TEXT_MAX - 1] = 0;
+}
+
+void AsyncLogMessage(const wxString &message) {
+  if (!BeginWrite()) {
+    wxLogMessage(wxT("%s"), message.c_str());
+    return;
+  }
+  LogSlot *slot = Enqueue();
+  if (slot) {
+    CopyText(slot->text, message);
+    slot->binary = false;
+    Publish(slot);
+  }
+  EndWrite();
+}
+
+void AsyncLogBinary(const wxString &what, const void *data, size_t size) {
+  if (!BeginWrite()) {
+    wxString explain = what;
+    AppendHex(&explain, (const uint8_t *)data, size, size);
+    wxLogMessage(wxT("%s"), explain.c_str());
+    return;
+  }
+  LogSlot *slot = Enqueue();
+  if (slot) {
+    CopyText(slot->text, what);
+    memcpy(slot->data, data, wxMin(size, (size_t)LOG_BINARY_MAX));
+    slot->size = size;
+    slot->binary = true;
+    Publish(slot);
+  }
+  EndWrite();
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _ASYNCLOG_H_
+#define _ASYNCLOG_H_
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Logging for the receive threads and other busy places. A message is put on a lock-free queue
+// and a background thread hands it to wxLog, so the caller never waits for the log target.
+// Binary data is copied as is and only turned into hex by the background thread.
+//
+// Every call site may log LOG_RATE_PER_SECOND messages per second. The rest is counted and
+// dropped before it is formatted, and the background thread reports how many were dropped.
+//
+// Until StartAsyncLog() is called, and after StopAsyncLog(), messages go to wxLog directly.
+//
+
+#define LOG_QUEUE_SIZE (256)      // Messages waiting for the background thread, a power of two
+#define LOG_TEXT_MAX (512)        // Bytes of a message that are kept
+#define LOG_BINARY_MAX (512)      // Bytes of binary data that are kept
+#define LOG_RATE_SITES (1024)     // Call sites that are rate limited separately, a power of two
+#define LOG_RATE_PER_SECOND (20)  // Messages per call site per second
+
+extern void StartAsyncLog();
+extern void StopAsyncLog();  // Writes what is still queued
+
+// Whether the call site file:line may log now. File must be __FILE__, only the pointer is used.
+extern bool LogRateAllowed(const char *file, int line);
+
+extern void AsyncLogMessage(const wxString &message);
+extern void AsyncLogBinary(const wxString &what, const void *data, size_t size);
+
+// So that the macros in radar_pi.h can end in wxString::Format and take its arguments
+struct AsyncLog {
+  void operator<<(const wxString &message) { AsyncLogMessage(message); }
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _ASYNCLOG_H_ */
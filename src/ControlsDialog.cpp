@@ -1443,7 +1443,7 @@ void ControlsDialog::OnClearTrailsButtonClick(wxCommandEvent& event) { m_ri->Cle
 void ControlsDialog::OnOrientationButtonClick(wxCommandEvent& event) {
   int value = m_ri->m_orientation.GetValue() + 1;
 
-  if (m_pi->GetHeadingSource() == HEADING_NONE) {
+  if (!m_ri->HasHeading()) {
     value = ORIENTATION_HEAD_UP;
   } else {  // There is a heading
     if (value == ORIENTATION_NUMBER) {
@@ -1571,7 +1571,7 @@ bool ControlsDialog::UpdateSizersButtonsShown() {
     }
   }
 
-  if (m_pi->GetHeadingSource() == HEADING_NONE) {
+  if (!m_ri->HasHeading()) {
     m_orientation_button->Disable();
   } else {
     m_orientation_button->Enable();
@@ -1987,9 +1987,9 @@ void ControlsDialog::UpdateDialogShown(bool resize) {
 
     // If the corresponding radar panel is now in a different position from what we remembered
     // then reset the dialog to the left or right of the radar panel.
-    wxPoint panelPos = m_ri->m_radar_panel->GetPos();
+    wxPoint panelPos = m_ri->m_radar_panel ? m_ri->m_radar_panel->GetPos() : wxDefaultPosition;
     bool controlInitialShow = !m_pi->m_settings.control_pos[m_ri->m_radar].IsFullySpecified();
-    bool panelShown = m_ri->m_radar_panel->IsShown();
+    bool panelShown = m_ri->m_radar_panel && m_ri->m_radar_panel->IsShown();
     bool panelMoved = !m_panel_position.IsFullySpecified() || panelPos != m_panel_position;
 
     if (panelShown                                  // if the radar pane is shown and
@@ -35,6 +35,15 @@ PLUGIN_BEGIN_NAMESPACE
 
 #undef TEST_GUARD_ZONE_LOCATION
 
+#ifdef _MSC_VER
+// Volatile accesses are acquire loads and release stores with /volatile:ms, the default on x86 and x64
+#define LOAD_ACQUIRE(p) (*(p))
+#define STORE_RELEASE(p, v) (*(p) = (v))
+#else
+#define LOAD_ACQUIRE(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#endif
+
 GuardZone::GuardZone(radar_pi* pi, RadarInfo* ri, int zone) {
   m_pi = pi;
   m_ri = ri;
@@ -47,74 +56,148 @@ GuardZone::GuardZone(radar_pi* pi, RadarInfo* ri, int zone) {
   m_arpa_on = 0;
   m_alarm_on = 0;
   m_show_time = 0;
-  CLEAR_STRUCT(arpa_update_time);
+  m_search_angle = 0;
+  m_polygon_count = 0;
+  m_polygon_version = 0;
+  m_compiled_type = GZ_ARC;
+  m_compiled_start_bearing = 0;
+  m_compiled_end_bearing = 0;
+  m_compiled_inner_range = 0;
+  m_compiled_outer_range = 0;
+  m_compiled_polygon_version = -1;
+  m_intervals = 0;
+  m_retired = 0;
+  m_acked_intervals = 0;
   ResetBogeys();
 }
 
-void GuardZone::ProcessSpoke(SpokeBearing angle, uint8_t* data, uint8_t* hist, size_t len) {
-  size_t range_start = m_inner_range * m_ri->m_pixels_per_meter;  // Convert from meters to [0..spoke_len_max>
-  size_t range_end = m_outer_range * m_ri->m_pixels_per_meter;    // Convert from meters to [0..spoke_len_max>
-  bool in_guard_zone = false;
-  AngleDegrees degAngle = SCALE_SPOKES_TO_DEGREES(angle);
+GuardZone::~GuardZone() {
+  delete m_retired;
+  delete m_intervals;
+  LOG_VERBOSE(wxT("%s destroyed"), m_log_name.c_str());
+}
+
+/*
+ * Free the intervals that were replaced last, once the receive thread has acknowledged the
+ * ones that replaced them. The receive thread acknowledges the intervals it loads at the start
+ * of every spoke, so by then it has finished the spoke that may have used the old ones.
+ * Returns false while the old intervals may still be in use.
+ */
+bool GuardZone::FreeRetired() {
+  if (m_retired) {
+    if (LOAD_ACQUIRE(&m_acked_intervals) != m_intervals) {
+      return false;
+    }
+    delete m_retired;
+    m_retired = 0;
+  }
+  return true;
+}
+
+void GuardZone::AcknowledgeIntervals() { STORE_RELEASE(&m_acked_intervals, LOAD_ACQUIRE(&m_intervals)); }
+
+void GuardZone::SetPolygon(const GuardZoneVertex* vertex, size_t n) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  if (n > GUARD_ZONE_POLYGON_MAX) {
+    n = GUARD_ZONE_POLYGON_MAX;
+  }
+  for (size_t i = 0; i < n; i++) {
+    m_polygon[i] = vertex[i];
+  }
+  m_polygon_count = n;
+  m_polygon_version++;
+  m_type = GZ_POLYGON;
+  ResetBogeys();
+}
+
+size_t GuardZone::GetPolygon(GuardZoneVertex* vertex) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  for (size_t i = 0; i < m_polygon_count; i++) {
+    vertex[i] = m_polygon[i];
+  }
+  return m_polygon_count;
+}
+
+/*
+ * Compile the zone into per spoke intervals, if anything has changed since the last time,
+ * and publish them to the receive thread.
+ */
+void GuardZone::UpdateIntervals() {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  size_t spokes = m_ri->m_spokes;
+
+  if (m_intervals && m_intervals->GetSpokes() == spokes && m_compiled_type == m_type &&
+      m_compiled_start_bearing == m_start_bearing && m_compiled_end_bearing == m_end_bearing &&
+      m_compiled_inner_range == m_inner_range && m_compiled_outer_range == m_outer_range &&
+      m_compiled_polygon_version == m_polygon_version) {
+    return;
+  }
+  if (!FreeRetired()) {
+    return;  // Publish at most one new table per acknowledgement, try again on the next call
+  }
+
+  m_compiled_type = m_type;
+  m_compiled_start_bearing = m_start_bearing;
+  m_compiled_end_bearing = m_end_bearing;
+  m_compiled_inner_range = m_inner_range;
+  m_compiled_outer_range = m_outer_range;
+  m_compiled_polygon_version = m_polygon_version;
 
+  GuardZoneIntervals *intervals = new GuardZoneIntervals;
   switch (m_type) {
     case GZ_ARC:
-      if ((degAngle >= m_start_bearing && degAngle < m_end_bearing) ||
-          (m_start_bearing >= m_end_bearing && (degAngle >= m_start_bearing || degAngle < m_end_bearing))) {
-        if (range_start < len) {
-          if (range_end > len) {
-            range_end = len;
-          }
-          for (size_t r = range_start; r <= range_end; r++) {
-            if (data[r] >= m_pi->m_settings.threshold_blue) {
-              m_running_count++;
-            }
-#ifdef TEST_GUARD_ZONE_LOCATION
-            // Zap guard zone computation location to green so this is visible on screen
-            else {
-              data[r] = m_pi->m_settings.threshold_green;
-            }
-#endif
-          }
-        }
-        in_guard_zone = true;
-      }
+    case GZ_CIRCLE:
+      intervals->CompileArc(spokes, m_start_bearing, m_end_bearing, m_inner_range, m_outer_range, m_type == GZ_CIRCLE);
       break;
 
-    case GZ_CIRCLE:
-      if (range_start < len) {
-        if (range_end > len) {
-          range_end = len;
-        }
+    case GZ_POLYGON:
+      intervals->CompilePolygon(spokes, m_polygon, m_polygon_count);
+      break;
+
+    default:
+      intervals->Clear(spokes);
+      break;
+  }
+
+  m_retired = m_intervals;
+  STORE_RELEASE(&m_intervals, intervals);  // The receive thread must not see the pointer before the intervals
+  LOG_GUARD(wxT("%s compiled for %d spokes"), m_log_name.c_str(), (int)spokes);
+}
+
+void GuardZone::ProcessSpoke(SpokeBearing angle, uint8_t* data, const GuardZoneSpoke& spoke) {
+  const GuardZoneIntervals* intervals = LOAD_ACQUIRE(&m_intervals);
+
+  // Done with the intervals of the previous spoke, the GUI thread may free anything older than these
+  STORE_RELEASE(&m_acked_intervals, intervals);
+
+  // Until the GUI thread has compiled the zone for the current number of spokes there is nothing to count
+  if (!intervals || (size_t)angle >= intervals->GetSpokes() || intervals->GetSpokes() != m_ri->m_spokes) {
+    return;
+  }
 
-        for (size_t r = range_start; r <= range_end; r++) {
-          if (data[r] >= m_pi->m_settings.threshold_blue) {
-            m_running_count++;
-          }
 #ifdef TEST_GUARD_ZONE_LOCATION
-          // Zap guard zone computation location to green so this is visible on screen
-          else {
+  if (intervals->HasIntervals(angle)) {
+    // Zap guard zone computation location to green so this is visible on screen
+    int threshold = m_pi->m_settings.threshold_blue;
+    size_t start, end;
+    for (const GuardZoneInterval* p = intervals->Begin(angle); p < intervals->End(angle); p++) {
+      if (GuardZoneIntervals::GetSamples(p, m_ri->m_pixels_per_meter, spoke.GetLen(), &start, &end)) {
+        for (size_t r = start; r < end; r++) {
+          if (data[r] < threshold) {
             data[r] = m_pi->m_settings.threshold_green;
           }
-#endif
-        }
-        if (angle > m_last_angle) {
-          in_guard_zone = true;
         }
       }
-      break;
-
-    default:
-      in_guard_zone = false;
-      break;
+    }
   }
+#endif
 
-  if (m_last_in_guard_zone && !in_guard_zone) {
-    // last bearing that could add to m_running_count, so store as bogey_count;
-    m_bogey_count = m_running_count;
-    m_running_count = 0;
-    LOG_GUARD(wxT("%s angle=%d last_angle=%d guardzone=%d..%d (%d - %d) bogey_count=%d"), m_log_name.c_str(), angle, m_last_angle,
-              range_start, range_end, m_inner_range, m_outer_range, m_bogey_count);
+  if (m_counter.ProcessSpoke(angle, intervals, spoke, m_ri->m_pixels_per_meter)) {
+    LOG_GUARD(wxT("%s angle=%d guardzone=%d - %d bogey_count=%d"), m_log_name.c_str(), angle, m_inner_range, m_outer_range,
+              m_counter.GetBogeyCount());
 
     // When debugging with a static ship it is hard to find moving targets, so move
     // the guard zone instead. This slowly rotates the guard zone.
@@ -125,13 +208,41 @@ void GuardZone::ProcessSpoke(SpokeBearing angle, uint8_t* data, uint8_t* hist, s
       m_end_bearing %= DEGREES_PER_ROTATION;
     }
   }
+}
+
+/*
+ * Try to acquire ARPA targets on the echoes in [start, end> of a spoke in the history.
+ * Returns false when the maximum number of targets has been reached.
+ */
+bool GuardZone::SearchEchoes(SpokeBearing angle, size_t start, size_t end) {
+  const uint8_t* line = m_ri->m_history[angle].line;
 
-  m_last_in_guard_zone = in_guard_zone;
-  m_last_angle = angle;
+  if (start < 1) {
+    start = 1;
+  }
+  if (end > m_ri->m_spoke_len_max) {
+    end = m_ri->m_spoke_len_max;
+  }
+  for (size_t rrr = FindArpaSample(line, start, end); rrr < end; rrr = FindArpaSample(line, rrr + 1, end)) {
+    if (m_ri->m_arpa->GetTargetCount() >= MAX_NUMBER_OF_TARGETS - 1) {
+      LOG_INFO(wxT("radar_pi: No more scanning for ARPA targets in loop, maximum number of targets reached"));
+      return false;
+    }
+    if (m_ri->m_arpa->MultiPix(angle, rrr)) {
+      // pixel found that does not belong to a known target
+      Polar pol;
+      pol.angle = angle;
+      pol.r = rrr;
+      int target_i = m_ri->m_arpa->AcquireNewARPATarget(pol, 0);
+      if (target_i == -1) break;
+    }
+  }
+  return true;
 }
 
 // Search guard zone for ARPA targets
 void GuardZone::SearchTargets() {
+  TRACE_SCOPE("GuardZone::SearchTargets");
   Position own_pos;
   if (!m_arpa_on) {
     return;
@@ -166,55 +277,39 @@ void GuardZone::SearchTargets() {
   if (m_ri->m_pixels_per_meter == 0.) {
     return;
   }
-  size_t range_start = m_inner_range * m_ri->m_pixels_per_meter;  // Convert from meters to 0..511
-  size_t range_end = m_outer_range * m_ri->m_pixels_per_meter;    // Convert from meters to 0..511
-  SpokeBearing hdt = SCALE_DEGREES_TO_SPOKES(m_pi->GetHeadingTrue());
-  SpokeBearing start_bearing = SCALE_DEGREES_TO_SPOKES(m_start_bearing) + hdt;
-  SpokeBearing end_bearing = SCALE_DEGREES_TO_SPOKES(m_end_bearing) + hdt;
-  start_bearing = MOD_SPOKES(start_bearing);
-  end_bearing = MOD_SPOKES(end_bearing);
-  if (start_bearing > end_bearing) {
-    end_bearing += m_ri->m_spokes;
-  }
-  if (m_type == GZ_CIRCLE) {
-    start_bearing = 0;
-    end_bearing = m_ri->m_spokes;
-  }
-  if (range_start < m_ri->m_spoke_len_max) {
-    if (range_end > m_ri->m_spoke_len_max) {
-      range_end = m_ri->m_spoke_len_max;
+  SpokeBearing hdt = SCALE_DEGREES_TO_SPOKES(m_ri->GetHeadingTrue());
+
+  UpdateIntervals();
+  const GuardZoneIntervals* intervals = m_intervals;
+  if (!intervals || intervals->GetSpokes() != m_ri->m_spokes) {
+    return;
+  }
+
+  // Search the spokes that the beam has passed by 3 * SCAN_MARGIN since the last call, so that
+  // pass 2 of the target refresh has been done for them. As m_search_angle only moves forward
+  // and stops behind the beam, every spoke is searched exactly once per rotation.
+  m_search_angle = MOD_SPOKES(m_search_angle);
+  for (size_t n = 0; n < m_ri->m_spokes; n++) {
+    SpokeBearing angle = m_search_angle;
+    wxLongLong time1 = m_ri->m_history[angle].time;
+    // time2 must be timed later than the pass 2 in refresh, otherwise target may be found multiple times
+    wxLongLong time2 = m_ri->m_history[MOD_SPOKES(angle + 3 * SCAN_MARGIN)].time;
+
+    if (time2 < time1) {
+      break;  // the beam has not passed far enough beyond this spoke yet
     }
-    if (range_end < range_start) return;
-
-    // loop with +2 increments as target must be larger than 2 pixels in width
-    for (int angleIter = start_bearing; angleIter < end_bearing; angleIter += 2) {
-      SpokeBearing angle = MOD_SPOKES(angleIter);
-      wxLongLong time1 = m_ri->m_history[angle].time;
-      // time2 must be timed later than the pass 2 in refresh, otherwise target may be found multiple times
-      wxLongLong time2 = m_ri->m_history[MOD_SPOKES(angle + 3 * SCAN_MARGIN)].time;
-
-      // check if target has been refreshed since last time
-      // and if the beam has passed the target location with SCAN_MARGIN spokes
-      if ((time1 > (arpa_update_time[angle] + SCAN_MARGIN2) &&
-           time2 >= time1)) {  // the beam sould have passed our "angle" AND a point SCANMARGIN further
-                               // set new refresh time
-        arpa_update_time[angle] = time1;
-        for (int rrr = (int)range_start; rrr < (int)range_end; rrr++) {
-          if (m_ri->m_arpa->GetTargetCount() >= MAX_NUMBER_OF_TARGETS - 1) {
-            LOG_INFO(wxT("radar_pi: No more scanning for ARPA targets in loop, maximum number of targets reached"));
-            return;
-          }
-          if (m_ri->m_arpa->MultiPix(angle, rrr)) {
-            bool next_r = false;
-            if (next_r) continue;
-            // pixel found that does not belong to a known target
-            Polar pol;
-            pol.angle = angle;
-            pol.r = rrr;
-            int target_i = m_ri->m_arpa->AcquireNewARPATarget(pol, 0);
-            if (target_i == -1) break;
-          }
-        }
+    m_search_angle = MOD_SPOKES(angle + 1);
+
+    // only search every other spoke as target must be larger than 2 pixels in width
+    SpokeBearing relative = MOD_SPOKES(angle - hdt);
+    if ((angle & 1) || time1 == 0 || !intervals->HasIntervals(relative)) {
+      continue;
+    }
+    for (const GuardZoneInterval* p = intervals->Begin(relative); p < intervals->End(relative); p++) {
+      size_t start, end;
+      if (GuardZoneIntervals::GetSamples(p, m_ri->m_pixels_per_meter, m_ri->m_spoke_len_max, &start, &end) &&
+          !SearchEchoes(angle, start, end)) {
+        return;
       }
     }
   }
@@ -32,6 +32,7 @@
 #ifndef _GUARDZONE_H_
 #define _GUARDZONE_H_
 
+#include "GuardZoneIntervals.h"
 #include "radar_pi.h"
 
 PLUGIN_BEGIN_NAMESPACE
@@ -46,20 +47,16 @@ class GuardZone {
   int m_alarm_on;
   int m_arpa_on;
   time_t m_show_time;
-  wxLongLong arpa_update_time[SPOKES_MAX];
 
-  void ResetBogeys() {
-    m_bogey_count = -1;
-    m_running_count = 0;
-    m_last_in_guard_zone = false;
-    m_last_angle = 0;
-  };
+  void ResetBogeys() { m_counter.Reset(); };
 
   void SetType(GuardZoneType type) {
     m_type = type;
-    if (m_type > (GuardZoneType)1) m_type = (GuardZoneType)0;
+    if (m_type > GZ_CIRCLE) m_type = GZ_ARC;  // Polygons can only be set with SetPolygon()
     ResetBogeys();
   };
+  void SetPolygon(const GuardZoneVertex *vertex, size_t n);
+  size_t GetPolygon(GuardZoneVertex *vertex);
   void SetStartBearing(SpokeBearing start_bearing) {
     m_start_bearing = start_bearing;
     ResetBogeys();
@@ -87,34 +84,61 @@ class GuardZone {
   };
 
   /*
-   * Check if data is in this GuardZone, if so update bogeyCount
+   * Check if data is in this GuardZone, if so update bogeyCount.
+   * Called on the receive thread without any lock, using the last published intervals.
    */
-  void ProcessSpoke(SpokeBearing angle, uint8_t *data, uint8_t *hist, size_t len);
+  void ProcessSpoke(SpokeBearing angle, uint8_t *data, const GuardZoneSpoke &spoke);
+
+  // Acknowledge the published intervals for a spoke that is not counted. Receive thread only.
+  void AcknowledgeIntervals();
+
+  // Compile and publish the intervals when the zone has changed. GUI thread only.
+  void UpdateIntervals();
 
   // Find targets inside the zone
   void SearchTargets();
 
   int GetBogeyCount() {
-    if (m_bogey_count > -1) {
-      LOG_GUARD(wxT("%s reporting bogey_count=%d"), m_log_name.c_str(), m_bogey_count);
+    int bogey_count = m_counter.GetBogeyCount();
+    if (bogey_count > -1) {
+      LOG_GUARD(wxT("%s reporting bogey_count=%d"), m_log_name.c_str(), bogey_count);
     }
-    return m_bogey_count;
+    return bogey_count;
   };
 
   GuardZone(radar_pi *pi, RadarInfo *ri, int zone);
 
-  ~GuardZone() { LOG_VERBOSE(wxT("%s destroyed"), m_log_name.c_str()); }
+  ~GuardZone();
 
  private:
   radar_pi *m_pi;
   RadarInfo *m_ri;
 
   wxString m_log_name;
-  bool m_last_in_guard_zone;
-  SpokeBearing m_last_angle;
-  int m_bogey_count;    // complete cycle
-  int m_running_count;  // current swipe
-
+  GuardZoneCounter m_counter;
+  SpokeBearing m_search_angle;  // Next spoke of the rotation to search for new ARPA targets
+
+  wxCriticalSection m_exclusive;  // protects the polygon
+  GuardZoneVertex m_polygon[GUARD_ZONE_POLYGON_MAX];
+  size_t m_polygon_count;
+  int m_polygon_version;  // incremented whenever the polygon changes
+
+  // The zone compiled into per spoke intervals, and what it was compiled from. The GUI thread
+  // compiles into a new object and swaps the pointer; the receive thread only reads the pointer
+  // and stores it in m_acked_intervals for every spoke. The replaced intervals are freed when
+  // the receive thread has acknowledged the new ones.
+  GuardZoneIntervals *volatile m_intervals;
+  GuardZoneIntervals *m_retired;
+  const GuardZoneIntervals *volatile m_acked_intervals;
+  GuardZoneType m_compiled_type;
+  AngleDegrees m_compiled_start_bearing;
+  AngleDegrees m_compiled_end_bearing;
+  int m_compiled_inner_range;
+  int m_compiled_outer_range;
+  int m_compiled_polygon_version;
+
+  bool FreeRetired();
+  bool SearchEchoes(SpokeBearing angle, size_t start, size_t end);
   void UpdateSettings();
 };
 
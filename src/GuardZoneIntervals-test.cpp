@@ -0,0 +1,262 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/stopwatch.h>
+#include <wx/thread.h>
+#include "GuardZoneIntervals.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define SPOKES (2048)
+#define SPOKE_LEN (1024)
+#define PIXELS_PER_METER (SPOKE_LEN / 2000.)  // 2 km range
+
+static uint8_t spoke_data[SPOKES][SPOKE_LEN];
+
+// How GuardZone::ProcessSpoke used to count, one sample at a time
+static size_t ReferenceCount(const uint8_t *data, size_t start, size_t end, uint8_t threshold) {
+  size_t count = 0;
+  for (size_t r = start; r < end; r++) {
+    if (data[r] >= threshold) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// The samples that an interval covers on a spoke of SPOKE_LEN at PIXELS_PER_METER, or [0, 0> when none
+static void Samples(const GuardZoneInterval *p, size_t *start, size_t *end) {
+  if (!GuardZoneIntervals::GetSamples(p, PIXELS_PER_METER, SPOKE_LEN, start, end)) {
+    *start = 0;
+    *end = 0;
+  }
+}
+
+int main() {
+  int ret = 0;
+  size_t start, end;
+
+  srand(1);
+  for (size_t a = 0; a < SPOKES; a++) {
+    for (size_t r = 0; r < SPOKE_LEN; r++) {
+      spoke_data[a][r] = (rand() % 4 == 0) ? (uint8_t)(rand() % 256) : 0;
+    }
+  }
+
+  // Counting, at all alignments and for long runs that could overflow the byte counters
+  uint8_t big[8192];
+  for (size_t i = 0; i < sizeof(big); i++) {
+    big[i] = (uint8_t)(rand() % 256);
+  }
+  const uint8_t thresholds[] = {0, 1, 100, 128, 200, 255};
+  for (size_t t = 0; t < ARRAY_SIZE(thresholds); t++) {
+    for (size_t start = 0; start < 40; start++) {
+      for (size_t len = 0; len < 80; len++) {
+        if (CountSamplesAbove(big + start, len, thresholds[t]) != ReferenceCount(big, start, start + len, thresholds[t])) {
+          cout << "ERROR: count start=" << start << " len=" << len << " threshold=" << (int)thresholds[t] << " is wrong\n";
+          ret = 1;
+        }
+      }
+    }
+    if (CountSamplesAbove(big, sizeof(big), thresholds[t]) != ReferenceCount(big, 0, sizeof(big), thresholds[t])) {
+      cout << "ERROR: count of " << sizeof(big) << " samples threshold=" << (int)thresholds[t] << " is wrong\n";
+      ret = 1;
+    }
+  }
+
+  // Counting from the per block totals, for intervals that start and end inside, on and across blocks
+  GuardZoneSpoke spoke;
+  for (size_t t = 0; t < ARRAY_SIZE(thresholds); t++) {
+    for (size_t len = 0; len < 300; len += 37) {
+      spoke.Set(big, len, thresholds[t]);
+      for (size_t start = 0; start < 300; start += 7) {
+        for (size_t end = start; end < 320; end += 13) {
+          if (spoke.Count(start, end) != ReferenceCount(big, start, wxMin(end, len), thresholds[t])) {
+            cout << "ERROR: spoke count len=" << len << " start=" << start << " end=" << end << " threshold=" << (int)thresholds[t]
+                 << " is wrong\n";
+            ret = 1;
+          }
+        }
+      }
+    }
+  }
+
+  // Arc from 350 to 10 degrees, 500 to 1000 meters
+  GuardZoneIntervals arc;
+  arc.CompileArc(SPOKES, 350, 10, 500, 1000, false);
+  for (int a = 0; a < SPOKES; a++) {
+    int deg = (int)(a * 360. / SPOKES);
+    bool inside = deg >= 350 || deg < 10;
+    if (arc.HasIntervals(a) != inside) {
+      cout << "ERROR: arc spoke " << a << " has intervals " << arc.HasIntervals(a) << "\n";
+      ret = 1;
+    } else if (inside) {
+      Samples(arc.Begin(a), &start, &end);
+      if (arc.End(a) - arc.Begin(a) != 1 || start != 256 || end != 512) {
+        cout << "ERROR: arc spoke " << a << " interval is wrong\n";
+        ret = 1;
+      }
+    }
+  }
+  spoke.Set(spoke_data[0], SPOKE_LEN, 100);
+  if (arc.Count(0, spoke, PIXELS_PER_METER) != arc.Count(0, spoke_data[0], SPOKE_LEN, 100, PIXELS_PER_METER) ||
+      arc.Count(0, spoke, PIXELS_PER_METER) != ReferenceCount(spoke_data[0], 256, 512, 100)) {
+    cout << "ERROR: arc count is wrong\n";
+    ret = 1;
+  }
+
+  // The same table holds after a range change: at 1 km range the zone covers the outer half of the spoke
+  if (arc.Count(0, spoke, PIXELS_PER_METER * 2) != ReferenceCount(spoke_data[0], 512, SPOKE_LEN, 100) ||
+      arc.Count(0, spoke_data[0], SPOKE_LEN, 100, PIXELS_PER_METER * 2) != ReferenceCount(spoke_data[0], 512, SPOKE_LEN, 100) ||
+      arc.Count(0, spoke, PIXELS_PER_METER * 4) != 0 || arc.Count(0, spoke, 0.) != 0) {
+    cout << "ERROR: arc count after a range change is wrong\n";
+    ret = 1;
+  }
+  if (arc.IsFullCircle()) {
+    cout << "ERROR: arc is a full circle\n";
+    ret = 1;
+  }
+
+  GuardZoneIntervals circle;
+  circle.CompileArc(SPOKES, 0, 0, 0, 5000, true);
+  Samples(circle.Begin(0), &start, &end);
+  if (!circle.IsFullCircle() || start != 0 || end != SPOKE_LEN) {
+    cout << "ERROR: circle is wrong\n";
+    ret = 1;
+  }
+
+  // Square 1000 m ahead, 400 m wide and deep: spoke 0 enters it at 1000 m and leaves at 1400 m
+  GuardZoneVertex square[4];
+  double corner = rad2deg(atan2(200., 1000.));
+  square[0].bearing = -corner;
+  square[0].range = sqrt(1000. * 1000. + 200. * 200.);
+  square[1].bearing = corner;
+  square[1].range = square[0].range;
+  corner = rad2deg(atan2(200., 1400.));
+  square[2].bearing = corner;
+  square[2].range = sqrt(1400. * 1400. + 200. * 200.);
+  square[3].bearing = -corner;
+  square[3].range = square[2].range;
+
+  GuardZoneIntervals polygon;
+  polygon.CompilePolygon(SPOKES, square, 4);
+  Samples(polygon.Begin(0), &start, &end);
+  if (!polygon.HasIntervals(0) || polygon.End(0) - polygon.Begin(0) != 1 || abs((int)start - 512) > 1 || abs((int)end - 717) > 1) {
+    cout << "ERROR: polygon spoke 0 interval is wrong\n";
+    ret = 1;
+  }
+  if (polygon.HasIntervals(SPOKES / 4) || polygon.HasIntervals(SPOKES / 2) || polygon.IsFullCircle()) {
+    cout << "ERROR: polygon has intervals where it should not\n";
+    ret = 1;
+  }
+
+  // A triangle around the radar covers every spoke, starting at the radar itself
+  GuardZoneVertex triangle[3] = {{0., 1000.}, {120., 1000.}, {240., 1000.}};
+  polygon.CompilePolygon(SPOKES, triangle, 3);
+  Samples(polygon.Begin(SPOKES / 3), &start, &end);
+  if (!polygon.IsFullCircle() || start != 0 || end < 256) {
+    cout << "ERROR: polygon around radar is wrong\n";
+    ret = 1;
+  }
+
+  // A concave polygon, a 'C' ahead that opens to starboard: spoke 0 passes through both bars
+  const double c[8][2] = {{1000., -200.}, {1600., -200.}, {1600., 200.}, {1450., 200.},
+                          {1450., -50.},  {1150., -50.},  {1150., 200.}, {1000., 200.}};  // north, east in meters
+  GuardZoneVertex shape[8];
+  for (int i = 0; i < 8; i++) {
+    shape[i].bearing = rad2deg(atan2(c[i][1], c[i][0]));
+    shape[i].range = sqrt(c[i][0] * c[i][0] + c[i][1] * c[i][1]);
+  }
+  polygon.CompilePolygon(SPOKES, shape, 8);
+  if (polygon.End(0) - polygon.Begin(0) != 2 || polygon.End(SPOKES - 28) - polygon.Begin(SPOKES - 28) != 1) {
+    cout << "ERROR: concave polygon has " << (polygon.End(0) - polygon.Begin(0)) << " and "
+         << (polygon.End(SPOKES - 28) - polygon.Begin(SPOKES - 28)) << " intervals\n";
+    ret = 1;
+  }
+
+  // Benchmark: two zones counted the old way, each under its own lock, against sixteen compiled zones
+  // that are read through a published pointer and share the block totals of the spoke.
+  const uint8_t threshold = 100;
+  const int loops = 20;
+  long sum = 0;
+  wxCriticalSection lock[2];
+
+  wxStopWatch stopwatch;
+  for (int l = 0; l < loops; l++) {
+    for (int a = 0; a < SPOKES; a++) {
+      for (int z = 0; z < 2; z++) {
+        wxCriticalSectionLocker locker(lock[z]);
+        size_t range_start = (250 + z * 100) * PIXELS_PER_METER;
+        size_t range_end = (1750 + z * 100) * PIXELS_PER_METER;
+        sum += (long)ReferenceCount(spoke_data[a], range_start, range_end, threshold);
+      }
+    }
+  }
+  double two_us = stopwatch.TimeInMicro().ToDouble() / loops;
+
+  GuardZoneIntervals zone[16];
+  const GuardZoneIntervals *volatile published[16];
+  for (int z = 0; z < 16; z++) {
+    published[z] = &zone[z];
+    if (z % 2) {
+      zone[z].CompileArc(SPOKES, 0, 0, 250 + z * 10, 1750 + z * 10, true);
+    } else {
+      zone[z].CompilePolygon(SPOKES, triangle, 3);
+    }
+  }
+  stopwatch.Start();
+  for (int l = 0; l < loops; l++) {
+    for (int a = 0; a < SPOKES; a++) {
+      spoke.Set(spoke_data[a], SPOKE_LEN, threshold);
+      for (int z = 0; z < 16; z++) {
+        const GuardZoneIntervals *intervals = published[z];
+        if (intervals && intervals->GetSpokes() == SPOKES) {
+          sum -= (long)intervals->Count(a, spoke, PIXELS_PER_METER);
+        }
+      }
+    }
+  }
+  double sixteen_us = stopwatch.TimeInMicro().ToDouble() / loops;
+
+  cout << "INFO: One rotation of " << SPOKES << " spokes takes " << two_us << " us for 2 zones counted per sample, "
+       << sixteen_us << " us for 16 compiled zones (" << sum << ")\n";
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
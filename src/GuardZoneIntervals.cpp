@@ -0,0 +1,313 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <algorithm>
+#include "GuardZoneIntervals.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GUARD_ZONE_SSE2
+#endif
+
+PLUGIN_BEGIN_NAMESPACE
+
+size_t CountSamplesAbove(const uint8_t *data, size_t len, uint8_t threshold) {
+  size_t count = 0;
+  size_t i = 0;
+
+#ifdef GUARD_ZONE_SSE2
+  const __m128i t = _mm_set1_epi8((char)threshold);
+  const __m128i zero = _mm_setzero_si128();
+
+  while (i + 16 <= len) {
+    // The per byte counters overflow after 255 blocks, so add them up before that
+    size_t blocks = (len - i) / 16;
+    if (blocks > 255) {
+      blocks = 255;
+    }
+    __m128i acc = zero;
+    for (size_t b = 0; b < blocks; b++, i += 16) {
+      __m128i x = _mm_loadu_si128((const __m128i *)(data + i));
+      __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(x, t), x);  // 0xff where x >= threshold
+      acc = _mm_sub_epi8(acc, ge);
+    }
+    __m128i sum = _mm_sad_epu8(acc, zero);
+    count += (size_t)_mm_cvtsi128_si32(sum) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+  }
+#endif
+
+  for (; i < len; i++) {
+    count += data[i] >= threshold;
+  }
+  return count;
+}
+
+void GuardZoneSpoke::Set(const uint8_t *data, size_t len, uint8_t threshold) {
+  size_t blocks = (len + GUARD_ZONE_BLOCK - 1) / GUARD_ZONE_BLOCK;
+
+  m_data = data;
+  m_len = len;
+  m_threshold = threshold;
+  if (m_before.size() < blocks + 1) {
+    m_before.resize(blocks + 1);  // Only the first spoke, or a longer one, allocates
+  }
+  m_before[0] = 0;
+  for (size_t b = 0; b < blocks; b++) {
+    size_t start = b * GUARD_ZONE_BLOCK;
+    size_t n = wxMin(len - start, (size_t)GUARD_ZONE_BLOCK);
+    m_before[b + 1] = m_before[b] + (uint32_t)CountSamplesAbove(data + start, n, threshold);
+  }
+}
+
+size_t GuardZoneSpoke::Count(size_t start, size_t end) const {
+  if (end > m_len) {
+    end = m_len;
+  }
+  if (start >= end) {
+    return 0;
+  }
+  size_t first_block = (start + GUARD_ZONE_BLOCK - 1) / GUARD_ZONE_BLOCK;  // First block that is completely inside
+  size_t end_block = end / GUARD_ZONE_BLOCK;                                // Block that the partial tail is in
+  if (first_block >= end_block) {
+    return CountSamplesAbove(m_data + start, end - start, m_threshold);
+  }
+  size_t head = first_block * GUARD_ZONE_BLOCK;
+  size_t tail = end_block * GUARD_ZONE_BLOCK;
+  return CountSamplesAbove(m_data + start, head - start, m_threshold) + (m_before[end_block] - m_before[first_block]) +
+         CountSamplesAbove(m_data + tail, end - tail, m_threshold);
+}
+
+GuardZoneIntervals::GuardZoneIntervals() {
+  m_spokes = 0;
+  m_full_circle = false;
+  m_base = 0;
+}
+
+void GuardZoneIntervals::Start(size_t spokes) {
+  m_spokes = spokes;
+  m_first.resize(spokes + 1);
+  m_intervals.clear();
+}
+
+void GuardZoneIntervals::Add(double start, double end) {
+  if (start < 0.) {
+    start = 0.;
+  }
+  if (start >= end) {
+    return;
+  }
+  GuardZoneInterval interval;
+  interval.start = (float)start;
+  interval.end = (float)end;
+  m_intervals.push_back(interval);
+}
+
+void GuardZoneIntervals::Finish() {
+  m_first[m_spokes] = m_intervals.size();
+  m_base = m_intervals.empty() ? 0 : &m_intervals[0];
+  m_full_circle = m_spokes > 0;
+  for (size_t angle = 0; angle < m_spokes; angle++) {
+    if (!HasIntervals(angle)) {
+      m_full_circle = false;
+      break;
+    }
+  }
+}
+
+void GuardZoneIntervals::Clear(size_t spokes) {
+  Start(spokes);
+  for (size_t angle = 0; angle < spokes; angle++) {
+    m_first[angle] = 0;
+  }
+  Finish();
+}
+
+void GuardZoneIntervals::CompileArc(size_t spokes, int start_bearing, int end_bearing, int inner_range, int outer_range,
+                                    bool circle) {
+  Start(spokes);
+  for (size_t angle = 0; angle < spokes; angle++) {
+    int deg = (int)(angle * (double)DEGREES_PER_ROTATION / spokes);
+
+    m_first[angle] = m_intervals.size();
+    if (circle || (deg >= start_bearing && deg < end_bearing) ||
+        (start_bearing >= end_bearing && (deg >= start_bearing || deg < end_bearing))) {
+      Add(inner_range, outer_range);
+    }
+  }
+  Finish();
+}
+
+void GuardZoneIntervals::CompilePolygon(size_t spokes, const GuardZoneVertex *vertex, size_t n) {
+  double x[GUARD_ZONE_POLYGON_MAX];
+  double y[GUARD_ZONE_POLYGON_MAX];
+
+  if (n > GUARD_ZONE_POLYGON_MAX) {
+    n = GUARD_ZONE_POLYGON_MAX;
+  }
+  for (size_t i = 0; i < n; i++) {
+    x[i] = vertex[i].range * cos(deg2rad(vertex[i].bearing));
+    y[i] = vertex[i].range * sin(deg2rad(vertex[i].bearing));
+  }
+
+  Start(spokes);
+  for (size_t angle = 0; angle < spokes; angle++) {
+    m_first[angle] = m_intervals.size();
+    if (n < 3) {
+      continue;
+    }
+
+    // Intersect the center line of the spoke with every edge of the polygon
+    double a = deg2rad((angle + 0.5) * (double)DEGREES_PER_ROTATION / spokes);
+    double dx = cos(a);
+    double dy = sin(a);
+    double hit[GUARD_ZONE_POLYGON_MAX + 1];
+    size_t hits = 0;
+
+    for (size_t i = 0; i < n; i++) {
+      size_t j = (i + 1) % n;
+      double ex = x[j] - x[i];
+      double ey = y[j] - y[i];
+      double denom = dx * ey - dy * ex;
+      if (fabs(denom) < 1e-9) {
+        continue;  // parallel to the spoke
+      }
+      double s = (x[i] * dy - y[i] * dx) / denom;  // position along the edge
+      double t = (x[i] * ey - y[i] * ex) / denom;  // distance from the radar
+      if (s >= 0. && s < 1. && t >= 0.) {
+        hit[hits++] = t;
+      }
+    }
+    std::sort(hit, hit + hits);
+
+    // An odd number of crossings means the radar is inside the polygon
+    size_t h = 0;
+    double start = 0.;
+    if (hits % 2 == 0) {
+      if (hits == 0) {
+        continue;
+      }
+      start = hit[h++];
+    }
+    while (h < hits) {
+      Add(start, hit[h++]);
+      if (h < hits) {
+        start = hit[h++];
+      }
+    }
+  }
+  Finish();
+}
+
+bool GuardZoneIntervals::GetSamples(const GuardZoneInterval *p, double pixels_per_meter, size_t len, size_t *start,
+                                    size_t *end) {
+  double s = p->start * pixels_per_meter;
+  double e = p->end * pixels_per_meter;
+
+  if (e > (double)len) {
+    e = (double)len;
+  }
+  if (s >= e) {
+    return false;
+  }
+  *start = (size_t)s;
+  *end = (size_t)ceil(e);
+  return *start < *end;
+}
+
+size_t GuardZoneIntervals::Count(int angle, const uint8_t *data, size_t len, uint8_t threshold, double pixels_per_meter) const {
+  size_t count = 0;
+  size_t start, end;
+
+  for (const GuardZoneInterval *p = Begin(angle); p < End(angle); p++) {
+    if (GetSamples(p, pixels_per_meter, len, &start, &end)) {
+      count += CountSamplesAbove(data + start, end - start, threshold);
+    }
+  }
+  return count;
+}
+
+size_t GuardZoneIntervals::Count(int angle, const GuardZoneSpoke &spoke, double pixels_per_meter) const {
+  size_t count = 0;
+  size_t start, end;
+
+  for (const GuardZoneInterval *p = Begin(angle); p < End(angle); p++) {
+    if (GetSamples(p, pixels_per_meter, spoke.GetLen(), &start, &end)) {
+      count += spoke.Count(start, end);
+    }
+  }
+  return count;
+}
+
+bool GuardZoneCounter::ProcessSpoke(int angle, const GuardZoneIntervals *intervals, const GuardZoneSpoke &spoke,
+                                    double pixels_per_meter) {
+  bool in_guard_zone = false;
+  bool done = false;
+
+  if (intervals->HasIntervals(angle)) {
+    m_running_count += (int)intervals->Count(angle, spoke, pixels_per_meter);
+    // A zone that covers all spokes is complete when the angle wraps around
+    in_guard_zone = !intervals->IsFullCircle() || angle > m_last_angle;
+  }
+
+  if (m_last_in_guard_zone && !in_guard_zone) {
+    // last bearing that could add to m_running_count, so store as bogey_count;
+    m_bogey_count = m_running_count;
+    m_running_count = 0;
+    done = true;
+  }
+
+  m_last_in_guard_zone = in_guard_zone;
+  m_last_angle = angle;
+  return done;
+}
+
+size_t FindArpaSample(const uint8_t *line, size_t start, size_t end) {
+  size_t r = start;
+
+  while (r < end) {
+    // Most of a zone is empty, skip 8 samples at a time when none of them has the ARPA bit set
+    while (r + 8 <= end) {
+      uint64_t samples;
+      memcpy(&samples, line + r, sizeof(samples));
+      if (samples & 0x8080808080808080ULL) {
+        break;
+      }
+      r += 8;
+    }
+    if (r >= end || (line[r] & 128)) {
+      break;
+    }
+    r++;
+  }
+  return r;
+}
+
+PLUGIN_END_NAMESPACE
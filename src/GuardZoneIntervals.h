@@ -0,0 +1,165 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _GUARDZONEINTERVALS_H_
+#define _GUARDZONEINTERVALS_H_
+
+#include <vector>
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define GUARD_ZONE_POLYGON_MAX (32)  // Maximum number of corners of a polygon guard zone
+
+// Corner of a polygon guard zone, in the same frame as the arc bearings
+struct GuardZoneVertex {
+  double bearing;  // degrees relative to the radar spoke 0
+  double range;    // meters
+};
+
+#define GUARD_ZONE_BLOCK (64)  // Samples per block of GuardZoneSpoke
+
+//
+// The samples of one spoke that are at or above the threshold, counted per block of
+// GUARD_ZONE_BLOCK samples once for all zones. Any interval is then counted from the block
+// totals and at most two partial blocks, so the cost of a zone hardly depends on its size.
+//
+class GuardZoneSpoke {
+ public:
+  GuardZoneSpoke() : m_data(0), m_len(0), m_threshold(0) {}
+
+  void Set(const uint8_t *data, size_t len, uint8_t threshold);
+
+  size_t GetLen() const { return m_len; }
+
+  // Number of samples in [start, end> that are at or above the threshold
+  size_t Count(size_t start, size_t end) const;
+
+ private:
+  const uint8_t *m_data;
+  size_t m_len;
+  uint8_t m_threshold;
+  std::vector<uint32_t> m_before;  // Samples at or above the threshold before each block
+};
+
+// Part of a spoke that is inside a guard zone
+struct GuardZoneInterval {
+  float start;  // meters from the radar where the zone starts
+  float end;    // meters from the radar where the zone ends
+};
+
+//
+// The geometry of a guard zone compiled into a list of [start, end> range intervals for
+// every spoke. Compiling is relatively expensive, so it should only be done when the zone
+// changes. The intervals are in meters so they stay valid when the radar range changes;
+// checking a spoke is then only a table lookup, scaling the intervals to samples with the
+// pixels per meter of that spoke and counting the samples in them, whatever the shape of the zone.
+//
+class GuardZoneIntervals {
+ public:
+  GuardZoneIntervals();
+
+  // Zone that has no intervals at all
+  void Clear(size_t spokes);
+
+  // Arc between two bearings (in degrees), or a full circle when circle is set.
+  void CompileArc(size_t spokes, int start_bearing, int end_bearing, int inner_range, int outer_range, bool circle);
+
+  // Polygon, which may be concave and may contain the radar itself.
+  void CompilePolygon(size_t spokes, const GuardZoneVertex *vertex, size_t n);
+
+  size_t GetSpokes() const { return m_spokes; }
+
+  // True if every spoke has at least one interval
+  bool IsFullCircle() const { return m_full_circle; }
+
+  bool HasIntervals(int angle) const { return m_first[angle + 1] > m_first[angle]; }
+
+  const GuardZoneInterval *Begin(int angle) const { return m_base + m_first[angle]; }
+  const GuardZoneInterval *End(int angle) const { return m_base + m_first[angle + 1]; }
+
+  // The samples [*start, *end> of a spoke of len samples that the interval covers at this
+  // scale, false if it covers none.
+  static bool GetSamples(const GuardZoneInterval *p, double pixels_per_meter, size_t len, size_t *start, size_t *end);
+
+  // Number of samples in the zone on this spoke that are at or above threshold
+  size_t Count(int angle, const uint8_t *data, size_t len, uint8_t threshold, double pixels_per_meter) const;
+  size_t Count(int angle, const GuardZoneSpoke &spoke, double pixels_per_meter) const;
+
+ private:
+  size_t m_spokes;
+  bool m_full_circle;
+  std::vector<size_t> m_first;  // Index of the first interval of each spoke, m_spokes + 1 entries
+  std::vector<GuardZoneInterval> m_intervals;
+  const GuardZoneInterval *m_base;  // &m_intervals[0], or 0 when there are none
+
+  void Start(size_t spokes);
+  void Add(double start, double end);
+  void Finish();
+};
+
+//
+// The bogey count of a zone, kept up to date per spoke on the receive thread. The samples counted
+// during one sweep of the beam through the zone become the bogey count when the beam leaves it.
+//
+class GuardZoneCounter {
+ public:
+  GuardZoneCounter() { Reset(); }
+
+  void Reset() {
+    m_bogey_count = -1;
+    m_running_count = 0;
+    m_last_in_guard_zone = false;
+    m_last_angle = 0;
+  }
+
+  // Count the samples of this spoke that are in the zone. Returns true when the sweep through the
+  // zone ended with this spoke, so GetBogeyCount() has a new value.
+  bool ProcessSpoke(int angle, const GuardZoneIntervals *intervals, const GuardZoneSpoke &spoke, double pixels_per_meter);
+
+  int GetBogeyCount() const { return m_bogey_count; }
+
+ private:
+  bool m_last_in_guard_zone;
+  int m_last_angle;
+  int m_bogey_count;    // complete cycle
+  int m_running_count;  // current swipe
+};
+
+// Number of samples in data[0..len> that are >= threshold
+extern size_t CountSamplesAbove(const uint8_t *data, size_t len, uint8_t threshold);
+
+// The first sample in line[start..end> that has the ARPA bit (128) set, or end if there is none
+extern size_t FindArpaSample(const uint8_t *line, size_t start, size_t end);
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _GUARDZONEINTERVALS_H_ */
@@ -0,0 +1,264 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/stopwatch.h>
+#include "InterfaceMonitor.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+PLUGIN_BEGIN_NAMESPACE
+
+// A veth pair: the radar sits on TEST_PEER, the plugin listens on TEST_INTERFACE
+#define TEST_INTERFACE "rpitest0"
+#define TEST_PEER "rpitest1"
+#define TEST_ADDRESS "169.254.77.1"
+#define TEST_PEER_ADDRESS "169.254.77.2"
+#define TEST_TIMEOUT_MILLIS (5000)
+
+static const NetworkAddress s_report_addr(239, 254, 77, 77, 17777);
+
+static bool HasAddress(const std::vector<NetworkAddress> &addresses, const NetworkAddress &address) {
+  for (size_t i = 0; i < addresses.size(); i++) {
+    if (addresses[i] == address) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static NetworkAddress MakeAddress(const char *dotted) {
+  NetworkAddress address;
+  radar_inet_aton(dotted, &address.addr);
+  return address;
+}
+
+// The monitor sees the same interfaces as getifaddrs
+static int TestAddresses() {
+  InterfaceMonitor &monitor = GetInterfaceMonitor();
+  std::vector<NetworkAddress> addresses;
+  uint32_t generation;
+  struct ifaddrs *interfaces;
+  size_t count = 0;
+  int ret = 0;
+
+  uint32_t first = monitor.Update();
+  monitor.GetAddresses(&addresses, &generation);
+  if (first == 0 || generation != first) {
+    cout << "ERROR: generation " << first << " after first update\n";
+    ret = 1;
+  }
+  if (!getifaddrs(&interfaces)) {
+    for (struct ifaddrs *i = interfaces; i; i = i->ifa_next) {
+      if (VALID_IPV4_ADDRESS(i)) {
+        NetworkAddress address;
+        address.addr = ((struct sockaddr_in *)i->ifa_addr)->sin_addr;
+        if (!HasAddress(addresses, address)) {
+          cout << "ERROR: interface " << FormatNetworkAddress(address).ToAscii() << " is missing\n";
+          ret = 1;
+        }
+        count++;
+      }
+    }
+    freeifaddrs(interfaces);
+  }
+  if (count != addresses.size()) {
+    cout << "ERROR: monitor has " << addresses.size() << " interfaces instead of " << count << "\n";
+    ret = 1;
+  }
+  if (monitor.Update() != first) {
+    cout << "ERROR: generation changed while nothing happened\n";
+    ret = 1;
+  }
+  cout << "INFO: " << count << " interfaces, " << (monitor.GetSocket() != INVALID_SOCKET ? "following changes" : "polling")
+       << "\n";
+  return ret;
+}
+
+#ifdef __linux__
+
+static bool Run(const char *command) { return system(command) == 0; }
+
+// Wait until the probe does or does not listen on the test interface, returns the milliseconds it took or -1
+static double WaitForProbe(InterfaceProbe &probe, bool present) {
+  wxStopWatch stopwatch;
+
+  while (stopwatch.Time() < TEST_TIMEOUT_MILLIS) {
+    fd_set fdin;
+    int maxFd = -1;
+    FD_ZERO(&fdin);
+    probe.Prepare(s_report_addr, &fdin, &maxFd);
+    if ((probe.GetInterfaces().Find(wxT(TEST_ADDRESS)) != wxNOT_FOUND) == present) {
+      return stopwatch.TimeInMicro().ToDouble() / 1000.;
+    }
+    // Like a receive thread, sleep in select() until something happens
+    struct timeval tv = {(long)0, (long)(250 * 1000)};
+    select(maxFd + 1, &fdin, 0, 0, &tv);
+  }
+  return -1.;
+}
+
+// A radar report sent from the peer of the veth pair, without a copy looped back to ourselves
+static bool SendReport() {
+  SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  NetworkAddress from = MakeAddress(TEST_PEER_ADDRESS);
+  struct sockaddr_in to;
+  unsigned char loop = 0;
+  const char report[] = "report";
+
+  CLEAR_STRUCT(to);
+  to.sin_family = AF_INET;
+  to.sin_addr = s_report_addr.addr;
+  to.sin_port = s_report_addr.port;
+  bool ok = s != INVALID_SOCKET && setsockopt(s, IPPROTO_IP, IP_MULTICAST_IF, &from.addr, sizeof(from.addr)) == 0 &&
+            setsockopt(s, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) == 0 &&
+            sendto(s, report, sizeof(report), 0, (struct sockaddr *)&to, sizeof(to)) == sizeof(report);
+  if (s != INVALID_SOCKET) {
+    closesocket(s);
+  }
+  return ok;
+}
+
+// A new interface is probed as soon as it has an address, and a report on it is picked up from there.
+// Runs in a network namespace of its own, so the veth pair and its settings never touch the host.
+static int TestNewInterface() {
+  int ret = 0;
+
+  if (unshare(CLONE_NEWNET) != 0) {
+    cout << "INFO: cannot create a network namespace, skipping the new interface test\n";
+    return 0;
+  }
+  StartInterfaceMonitor();  // Follows the interfaces of the new namespace
+  InterfaceProbe probe;
+
+  if (!Run("ip link add " TEST_INTERFACE " type veth peer name " TEST_PEER " 2>/dev/null")) {
+    cout << "INFO: cannot create a veth pair, skipping the new interface test\n";
+    StopInterfaceMonitor();
+    return 0;
+  }
+  // The report comes from an address of our own, which Linux drops unless told otherwise. When
+  // all interfaces do strict reverse path filtering it is dropped anyway. These settings belong to
+  // the namespace, so they go away with it.
+  Run("echo 1 > /proc/sys/net/ipv4/conf/" TEST_INTERFACE "/accept_local");
+  Run("echo 0 > /proc/sys/net/ipv4/conf/" TEST_INTERFACE "/rp_filter");
+  bool can_send = !Run("grep -q 1 /proc/sys/net/ipv4/conf/all/rp_filter");
+
+  if (WaitForProbe(probe, false) < 0.) {
+    cout << "ERROR: probing " TEST_INTERFACE " before it has an address\n";
+    ret = 1;
+  }
+
+  wxStopWatch stopwatch;
+  bool configured = Run("ip addr add " TEST_PEER_ADDRESS "/24 dev " TEST_PEER " && ip link set " TEST_PEER " up && ip addr add " TEST_ADDRESS
+                        "/24 dev " TEST_INTERFACE " && ip link set " TEST_INTERFACE " up");
+  double command = stopwatch.TimeInMicro().ToDouble() / 1000.;
+  double seen = WaitForProbe(probe, true);
+  if (!configured) {
+    cout << "ERROR: cannot configure the veth pair\n";
+    ret = 1;
+  } else if (seen < 0.) {
+    cout << "ERROR: new interface not seen in " << TEST_TIMEOUT_MILLIS << " ms\n";
+    ret = 1;
+  } else {
+    cout << "INFO: new interface probed " << command + seen << " ms after configuring started, " << seen
+         << " ms after the ip commands finished\n";
+    cout << "INFO: probing " << probe.GetInterfaces().ToAscii() << "\n";
+  }
+
+  // A report on the new interface is picked up by the socket for that interface only
+  if (ret == 0 && !can_send) {
+    cout << "INFO: strict reverse path filtering, skipping the report test\n";
+  } else if (ret == 0) {
+    stopwatch.Start();
+    if (!SendReport()) {
+      cout << "ERROR: cannot send a report on " TEST_PEER "\n";
+      ret = 1;
+    }
+    SOCKET picked = INVALID_SOCKET;
+    NetworkAddress interface_address;
+    while (picked == INVALID_SOCKET && ret == 0 && stopwatch.Time() < TEST_TIMEOUT_MILLIS) {
+      fd_set fdin;
+      int maxFd = -1;
+      FD_ZERO(&fdin);
+      probe.Prepare(s_report_addr, &fdin, &maxFd);
+      struct timeval tv = {(long)0, (long)(250 * 1000)};
+      if (select(maxFd + 1, &fdin, 0, 0, &tv) > 0) {
+        picked = probe.Pick(&fdin, &interface_address);
+      }
+    }
+    if (picked == INVALID_SOCKET) {
+      cout << "ERROR: no report received\n";
+      ret = 1;
+    } else {
+      cout << "INFO: report received on " << FormatNetworkAddress(interface_address).ToAscii() << " after "
+           << stopwatch.TimeInMicro().ToDouble() / 1000. << " ms\n";
+      if (!(interface_address == MakeAddress(TEST_ADDRESS))) {
+        cout << "ERROR: report was picked up on the wrong interface\n";
+        ret = 1;
+      }
+      closesocket(picked);
+    }
+  }
+
+  // And it goes away again
+  Run("ip link del " TEST_INTERFACE);
+  if (WaitForProbe(probe, false) < 0.) {
+    cout << "ERROR: still probing " TEST_INTERFACE " after it was removed\n";
+    ret = 1;
+  }
+  StopInterfaceMonitor();
+  return ret;
+}
+
+#endif
+
+int main() {
+  int ret = 0;
+
+  StartInterfaceMonitor();
+  ret |= TestAddresses();
+  StopInterfaceMonitor();
+#ifdef __linux__
+  ret |= TestNewInterface();
+#endif
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
@@ -0,0 +1,269 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "InterfaceMonitor.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#elif defined(__APPLE__)
+#include <fcntl.h>
+#include <net/route.h>
+#endif
+
+PLUGIN_BEGIN_NAMESPACE
+
+InterfaceMonitor::InterfaceMonitor() {
+  m_socket = INVALID_SOCKET;
+  m_changed = true;
+  m_last_scan = 0;
+  m_generation = 0;
+
+#if defined(__linux__)
+  m_socket = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+  if (m_socket != INVALID_SOCKET) {
+    struct sockaddr_nl groups;
+
+    CLEAR_STRUCT(groups);
+    groups.nl_family = AF_NETLINK;
+    groups.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR;
+    if (::bind(m_socket, (struct sockaddr *)&groups, sizeof(groups)) < 0) {
+      closesocket(m_socket);
+      m_socket = INVALID_SOCKET;
+    }
+  }
+#elif defined(__APPLE__)
+  m_socket = socket(PF_ROUTE, SOCK_RAW, AF_INET);
+#endif
+
+#if defined(__linux__) || defined(__APPLE__)
+  if (m_socket != INVALID_SOCKET) {
+    fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL) | O_NONBLOCK);
+  } else {
+    wxLogMessage(wxT("radar_pi: cannot follow interface changes, polling every %d ms"), INTERFACE_POLL_MILLIS);
+  }
+#endif
+}
+
+InterfaceMonitor::~InterfaceMonitor() {
+  if (m_socket != INVALID_SOCKET) {
+    closesocket(m_socket);
+  }
+}
+
+uint32_t InterfaceMonitor::Update() {
+  wxCriticalSectionLocker lock(m_lock);
+  wxLongLong now = wxGetUTCTimeMillis();
+
+  if (m_socket != INVALID_SOCKET) {
+#if defined(__linux__) || defined(__APPLE__)
+    char buf[8192];
+
+    // We don't care what changed, any message means the list has to be read again.
+    // ENOBUFS means the kernel dropped messages because we read too late, so the same.
+    for (;;) {
+      int r = recv(m_socket, buf, sizeof(buf), 0);
+      if (r > 0 || (r < 0 && errno == ENOBUFS)) {
+        m_changed = true;
+      } else if (r < 0 && errno == EINTR) {
+        continue;
+      } else {
+        break;
+      }
+    }
+#endif
+  } else if (now - m_last_scan >= INTERFACE_POLL_MILLIS) {
+    m_changed = true;
+  }
+
+  if (m_changed) {
+    m_changed = false;
+    m_last_scan = now;
+    Scan();
+  }
+  return m_generation;
+}
+
+void InterfaceMonitor::Scan() {
+  std::vector<NetworkAddress> addresses;
+  struct ifaddrs *interfaces;
+
+  if (!getifaddrs(&interfaces)) {
+    for (struct ifaddrs *i = interfaces; i; i = i->ifa_next) {
+      if (VALID_IPV4_ADDRESS(i)) {
+        NetworkAddress address;
+        address.addr = ((struct sockaddr_in *)i->ifa_addr)->sin_addr;
+        address.port = 0;
+        addresses.push_back(address);
+      }
+    }
+    freeifaddrs(interfaces);
+  }
+
+  if (addresses != m_addresses || m_generation == 0) {
+    m_addresses.swap(addresses);
+    m_generation++;
+  }
+}
+
+void InterfaceMonitor::GetAddresses(std::vector<NetworkAddress> *addresses, uint32_t *generation) {
+  wxCriticalSectionLocker lock(m_lock);
+
+  *addresses = m_addresses;
+  *generation = m_generation;
+}
+
+static InterfaceMonitor *s_monitor = 0;
+
+void StartInterfaceMonitor() {
+  if (!s_monitor) {
+    s_monitor = new InterfaceMonitor;
+  }
+}
+
+void StopInterfaceMonitor() {
+  delete s_monitor;
+  s_monitor = 0;
+}
+
+InterfaceMonitor &GetInterfaceMonitor() { return *s_monitor; }
+
+bool InterfaceProbe::Prepare(const NetworkAddress &mcast_address, fd_set *fdin, int *maxFd) {
+  InterfaceMonitor &monitor = GetInterfaceMonitor();
+  bool changed = false;
+
+  if (monitor.Update() != m_generation) {
+    std::vector<NetworkAddress> addresses;
+    std::vector<Probe> probes;
+    uint32_t generation;
+
+    monitor.GetAddresses(&addresses, &generation);
+
+    // Keep the sockets on interfaces that are still there, open the new ones
+    for (size_t a = 0; a < addresses.size(); a++) {
+      Probe probe;
+      probe.interface_address = addresses[a];
+      probe.socket = INVALID_SOCKET;
+      for (size_t p = 0; p < m_probes.size(); p++) {
+        if (m_probes[p].interface_address == addresses[a]) {
+          probe.socket = m_probes[p].socket;
+          m_probes[p].socket = INVALID_SOCKET;
+          break;
+        }
+      }
+      if (probe.socket == INVALID_SOCKET) {
+        wxString error;
+        probe.socket = startUDPMulticastReceiveSocket(probe.interface_address, mcast_address, error);
+        if (probe.socket == INVALID_SOCKET) {
+          wxLogError(wxT("radar_pi: cannot probe interface %s: %s"), FormatNetworkAddress(probe.interface_address).c_str(),
+                     error.c_str());
+          continue;
+        }
+#ifdef IP_MULTICAST_ALL
+        // Otherwise Linux delivers the reports from all interfaces to every socket, and we can't tell where they came from
+        int zero = 0;
+        setsockopt(probe.socket, IPPROTO_IP, IP_MULTICAST_ALL, (const char *)&zero, sizeof(zero));
+#endif
+      }
+      probes.push_back(probe);
+    }
+    Close();
+    m_probes.swap(probes);
+    m_generation = generation;
+    changed = true;
+  }
+
+  for (size_t p = 0; p < m_probes.size(); p++) {
+    FD_SET(m_probes[p].socket, fdin);
+    *maxFd = wxMax((int)m_probes[p].socket, *maxFd);
+  }
+  SOCKET events = monitor.GetSocket();
+  if (events != INVALID_SOCKET) {
+    FD_SET(events, fdin);
+    *maxFd = wxMax((int)events, *maxFd);
+  }
+  return changed;
+}
+
+SOCKET InterfaceProbe::Pick(fd_set *fdin, NetworkAddress *interface_address) {
+  SOCKET picked = INVALID_SOCKET;
+
+  for (size_t n = 0; n < m_probes.size(); n++) {
+    size_t p = (m_next + n) % m_probes.size();
+    if (FD_ISSET(m_probes[p].socket, fdin)) {
+      picked = m_probes[p].socket;
+      *interface_address = m_probes[p].interface_address;
+      m_probes[p].socket = INVALID_SOCKET;
+      m_next = p + 1;
+      break;
+    }
+  }
+  if (picked != INVALID_SOCKET) {
+    Close();
+  }
+  return picked;
+}
+
+void InterfaceProbe::Close() {
+  for (size_t p = 0; p < m_probes.size(); p++) {
+    if (m_probes[p].socket != INVALID_SOCKET) {
+      closesocket(m_probes[p].socket);
+    }
+  }
+  m_probes.clear();
+  m_generation = 0;
+}
+
+wxString InterfaceProbe::GetStatus() {
+  wxString s;
+
+  if (m_probes.empty()) {
+    s << _("No network interface with IPv4 multicast");
+  } else {
+    s << _("Scanning interfaces") << wxT(" ") << GetInterfaces();
+  }
+  return s;
+}
+
+wxString InterfaceProbe::GetInterfaces() {
+  wxString s;
+
+  for (size_t p = 0; p < m_probes.size(); p++) {
+    if (p > 0) {
+      s << wxT(" ");
+    }
+    s << FormatNetworkAddress(m_probes[p].interface_address);
+  }
+  return s;
+}
+
+PLUGIN_END_NAMESPACE
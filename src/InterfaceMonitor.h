@@ -0,0 +1,124 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _INTERFACEMONITOR_H_
+#define _INTERFACEMONITOR_H_
+
+#include <vector>
+#include "socketutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Keeps the list of network interfaces that a radar can be found on, shared by all receive
+// threads. On Linux the kernel tells us through a netlink socket when an interface or address
+// changes, and on Mac through a routing socket, so a newly configured card is seen at once and
+// getifaddrs() is only called when something changed. Elsewhere the list is read again every
+// INTERFACE_POLL_MILLIS.
+//
+
+#define INTERFACE_POLL_MILLIS (2000)
+
+class InterfaceMonitor {
+ public:
+  InterfaceMonitor();
+  ~InterfaceMonitor();
+
+  // Reads the change events, and the interfaces if they changed. Returns the generation,
+  // which changes every time the list of addresses does. Cheap enough to call for every select().
+  uint32_t Update();
+
+  void GetAddresses(std::vector<NetworkAddress> *addresses, uint32_t *generation);
+
+  // Becomes readable when the interfaces changed, or INVALID_SOCKET if we have to poll
+  SOCKET GetSocket() { return m_socket; }
+
+ private:
+  void Scan();
+
+  wxCriticalSection m_lock;
+  SOCKET m_socket;
+  bool m_changed;  // An event was seen, or the events were lost
+  wxLongLong m_last_scan;
+  uint32_t m_generation;
+  std::vector<NetworkAddress> m_addresses;  // IPv4 address of every interface that is up and can multicast
+};
+
+// The monitor is made explicitly before the first receive thread starts and deleted after the
+// last one has stopped. A function-local static is not constructed thread-safely by the v120_xp
+// compiler, and the receive threads would all race to make it.
+extern void StartInterfaceMonitor();
+extern void StopInterfaceMonitor();
+extern InterfaceMonitor &GetInterfaceMonitor();  // Only between StartInterfaceMonitor() and StopInterfaceMonitor()
+
+//
+// Listens for the reports of a radar on all interfaces at the same time, instead of trying
+// them one by one. Until a report comes in the receive thread adds the sockets to its select()
+// with Prepare(), and after select() Pick() hands over the socket that received something.
+//
+
+class InterfaceProbe {
+ public:
+  InterfaceProbe() {
+    m_generation = 0;
+    m_next = 0;
+  }
+  ~InterfaceProbe() { Close(); }
+
+  // Opens a socket for mcast_address on every interface that does not have one yet and
+  // adds them and the monitor's socket to fdin. Returns true when the interfaces changed, or
+  // when probing starts again after a Pick().
+  bool Prepare(const NetworkAddress &mcast_address, fd_set *fdin, int *maxFd);
+
+  // The socket that fdin says has data and the interface it is on, or INVALID_SOCKET.
+  // The caller owns the socket, all others are closed. When more than one has data the
+  // next call starts at the next interface, so a radar of the wrong type cannot hide another.
+  SOCKET Pick(fd_set *fdin, NetworkAddress *interface_address);
+
+  void Close();
+
+  wxString GetInterfaces();  // The interfaces being probed
+  wxString GetStatus();      // Userfriendly string
+
+ private:
+  struct Probe {
+    NetworkAddress interface_address;
+    SOCKET socket;
+  };
+
+  uint32_t m_generation;  // Of the monitor when m_probes was made, 0 when it has to be made again
+  size_t m_next;
+  std::vector<Probe> m_probes;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _INTERFACEMONITOR_H_ */
@@ -29,10 +29,119 @@
  ***************************************************************************
  */
 
+#include <wx/stopwatch.h>
 #include "Kalman.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
+#define ASSERT_MATRIX(name, actual, predicted, n, m)                                                                \
+  for (int r = 0; r < n; r++) {                                                                                     \
+    for (int c = 0; c < m; c++) {                                                                                   \
+      if (fabs(actual(r, c) - predicted(r, c)) > 1e-9) {                                                            \
+        cout << "ERROR: " name "(" << r << "," << c << ") is not expected value " << predicted(r, c) << " but "     \
+             << actual(r, c) << "\n";                                                                               \
+        ret = 1;                                                                                                    \
+      }                                                                                                             \
+    }                                                                                                               \
+  }
+
+// Straightforward reference implementation to check the unrolled kernels against
+template <typename Ty, int N, int M, int P>
+static Matrix<Ty, N, P> ReferenceProduct(const Matrix<Ty, N, M>& a, const Matrix<Ty, M, P>& b) {
+  Matrix<Ty, N, P> result;
+  for (int r = 0; r < N; ++r) {
+    for (int c = 0; c < P; ++c) {
+      Ty accum = Ty(0);
+      for (int i = 0; i < M; ++i) {
+        accum += a(r, i) * b(i, c);
+      }
+      result(r, c) = accum;
+    }
+  }
+  return result;
+}
+
+static int TestMatrixKernels() {
+  int ret = 0;
+  Matrix<double, 4> a = {4., 1., 0.5, 2., 1., 3., 0.25, 1., 0.5, 0.25, 5., 0.75, 2., 1., 0.75, 6.};  // symmetric
+  Matrix<double, 4> b = {1., 2., 3., 4., 0., 1., -1., 2., 3., 0., 1., 1., -2., 1., 0., 1.};
+  Matrix<double, 4, 2> w = {0., 0., 0., 0., 1., 0., 0., 1.};
+  Matrix<double, 2> q = {2., 0.5, 0.5, 1.};
+  Matrix<double, 4> i4 = i4.Identity();
+
+  ASSERT_MATRIX("product", (a * b), ReferenceProduct(a, b), 4, 4);
+  ASSERT_MATRIX("transpose", b.Transpose(), ReferenceProduct(i4, b.Transpose()), 4, 4);
+  for (int r = 0; r < 4; r++) {
+    for (int c = 0; c < 4; c++) {
+      if (b.Transpose()(r, c) != b(c, r)) {
+        cout << "ERROR: transpose(" << r << "," << c << ") is wrong\n";
+        ret = 1;
+      }
+    }
+  }
+  ASSERT_MATRIX("multiply transposed", MultiplyTransposed(a, b), ReferenceProduct(a, b.Transpose()), 4, 4);
+  ASSERT_MATRIX("sandwich", Sandwich(b, a), ReferenceProduct(ReferenceProduct(b, a), b.Transpose()), 4, 4);
+  ASSERT_MATRIX("sandwich 4x2", Sandwich(w, q), ReferenceProduct(ReferenceProduct(w, q), w.Transpose()), 4, 4);
+
+  Matrix<double, 4> sum = a + b - i4;
+  Matrix<double, 4> expected_sum;
+  for (int e = 0; e < 16; e++) expected_sum.flatten[e] = a.flatten[e] + b.flatten[e] - i4.flatten[e];
+  ASSERT_MATRIX("sum", sum, expected_sum, 4, 4);
+
+  ASSERT_MATRIX("inverse", ReferenceProduct(b, b.Inverse()), i4, 4, 4);
+  ASSERT_MATRIX("symmetric inverse", ReferenceProduct(a, a.SymmetricInverse()), i4, 4, 4);
+  ASSERT_MATRIX("symmetric inverse", a.SymmetricInverse(), a.Inverse(), 4, 4);
+  Matrix<double, 2> i2 = i2.Identity();
+  ASSERT_MATRIX("symmetric inverse 2x2", ReferenceProduct(q, q.SymmetricInverse()), i2, 2, 2);
+  ASSERT_MATRIX("symmetric inverse 2x2", q.SymmetricInverse(), q.Inverse(), 2, 2);
+
+  return ret;
+}
+
+// Times the filter the way RadarArpa runs it: every refresh predicts the target and then
+// measures it, so P stays bounded as it does for a tracked target.
+static int TimeFilter() {
+  const int loops = 1000000;
+  int ret = 0;
+  KalmanFilter filter(2048);
+  Polar pol, expected;
+  LocalPosition x_local;
+
+  pol.angle = 5;
+  pol.r = 1000;
+  expected.angle = 10;
+  expected.r = 1050;
+  x_local.pos.lat = 50;
+  x_local.pos.lon = -5;
+  x_local.dlat_dt = 5;
+  x_local.dlon_dt = 2;
+
+  LocalPosition x = x_local;
+  wxStopWatch stopwatch;
+  for (int i = 0; i < loops; i++) {
+    x = x_local;
+    filter.Predict(&x, 2.5);
+    filter.Update_P();
+    filter.SetMeasurement(&pol, &x, &expected, 512. / 4000.);
+  }
+  double cycle = stopwatch.TimeInMicro().ToDouble() * 1000. / loops;
+  if (!(x.sd_speed_m_s >= 0. && x.sd_speed_m_s < 100.)) {
+    cout << "ERROR: StdDev speed is " << x.sd_speed_m_s << " after " << loops << " refreshes\n";
+    ret = 1;
+  }
+
+  filter.ResetFilter();
+  stopwatch.Start();
+  for (int i = 0; i < loops; i++) {
+    x = x_local;
+    filter.SetMeasurement(&pol, &x, &expected, 512. / 4000.);
+  }
+  double update = stopwatch.TimeInMicro().ToDouble() * 1000. / loops;
+
+  cout << "INFO: Predict + Update_P + SetMeasurement takes " << cycle << " ns, of which SetMeasurement " << update << " ns\n";
+  return ret;
+}
+
 int main() {
   int ret = 0;
   KalmanFilter *filter = new KalmanFilter(2048);
@@ -70,6 +179,10 @@ int main() {
     ret = 1;
   }
 
+  if (TestMatrixKernels()) {
+    ret = 1;
+  }
+
   pol.angle = 0;
   pol.r = 1000;
   pol.time = 1000;
@@ -99,7 +212,18 @@ int main() {
 
   ASSERT_VALUE("lat", x_local.pos.lat, 69.1754);
   ASSERT_VALUE("lon", x_local.pos.lon, 5);
-  ASSERT_VALUE("stddev", x_local.sd_speed_m_s, 2.03224);
+  // The initial P has no covariance between position and speed, so the first measurement does
+  // not reduce the speed variances of 4.
+  ASSERT_VALUE("stddev", x_local.sd_speed_m_s, 2.);
+
+  // Update_P adds the process noise to the speed variances
+  filter->Update_P();
+  filter->Predict(&x_local, 0.);
+  ASSERT_VALUE("stddev after Update_P", x_local.sd_speed_m_s, sqrt(4. + NOISE));
+
+  if (TimeFilter()) {
+    ret = 1;
+  }
 
   if (ret == 0) {
     cout << "INFO: TEST PASSED\n";
@@ -131,7 +131,8 @@ void KalmanFilter::Update_P() {
   // calculate apriori P
   // separated from the predict to prevent the update being done both in pass 1 and pass2
 
-  P = A * P * AT + W * Q * WT;
+  // P and Q are symmetric, so this is P = A * P * AT + W * Q * WT with only half the products
+  P = Sandwich(A, P) + Sandwich(W, Q);
   return;
 }
 
@@ -169,7 +170,10 @@ void KalmanFilter::SetMeasurement(Polar* pol, LocalPosition* x, Polar* expected,
   X(3, 0) = x->dlon_dt;
 
   // calculate Kalman gain
-  K = P * HT * ((H * P * HT + R).Inverse());
+  // K = P * HT * (H * P * HT + R)^-1, the innovation covariance H * P * HT + R is symmetric
+  Matrix<double, 4, 2> PHT = P * HT;
+  Matrix<double, 2> S = H * PHT + R;
+  K = PHT * S.SymmetricInverse();
 
   // calculate apostriori expected position
   X = X + K * Z;
@@ -179,7 +183,8 @@ void KalmanFilter::SetMeasurement(Polar* pol, LocalPosition* x, Polar* expected,
   x->dlon_dt = X(3, 0);
 
   // update covariance P
-  P = (I - K * H) * P;
+  // P = (I - K * H) * P, as P is symmetric H * P is the transpose of PHT
+  P = P - MultiplyTransposed(K, PHT);
   x->sd_speed_m_s = sqrt((P(2, 2) + P(3, 3)) / 2.);  // rough approximation of standard dev of speed
   return;
 }
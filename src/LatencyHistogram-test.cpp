@@ -0,0 +1,126 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "LatencyHistogram.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+int main() {
+  int ret = 0;
+
+  // Every value lies in the bucket that starts at or below it and ends above it
+  for (uint64_t v = 0; v < ((uint64_t)1 << 40); v = v < 1000 ? v + 1 : v + v / 7) {
+    size_t bucket = LatencyHistogram::GetBucket(v);
+    if (LatencyHistogram::GetBucketStart(bucket) > v || LatencyHistogram::GetBucketStart(bucket + 1) <= v) {
+      cout << "ERROR: value " << v << " is in bucket " << bucket << " from " << LatencyHistogram::GetBucketStart(bucket)
+           << " to " << LatencyHistogram::GetBucketStart(bucket + 1) << "\n";
+      ret = 1;
+      break;
+    }
+    if (v >= LATENCY_SUB_BUCKETS && LatencyHistogram::GetBucketStart(bucket + 1) - LatencyHistogram::GetBucketStart(bucket) >
+                                        v / LATENCY_SUB_BUCKETS) {
+      cout << "ERROR: bucket " << bucket << " of value " << v << " is too wide\n";
+      ret = 1;
+      break;
+    }
+  }
+  if (LatencyHistogram::GetBucket((uint64_t)-1) != LATENCY_BUCKETS - 1) {
+    cout << "ERROR: the largest value is not in the last bucket\n";
+    ret = 1;
+  }
+
+  // 1..1000 us: the median is 500 us and the 99th percentile 990 us, within the bucket width
+  LatencyHistogram histogram;
+  for (uint64_t us = 1; us <= 1000; us++) {
+    histogram.Record(us * 1000);
+  }
+  LatencySnapshot first;
+  histogram.GetSnapshot(&first);
+  const double fractions[] = {0.5, 0.99, 1.};
+  const double expected[] = {500e3, 990e3, 1000e3};
+  for (size_t i = 0; i < ARRAY_SIZE(fractions); i++) {
+    double value = (double)first.GetPercentile(fractions[i]);
+    if (first.count != 1000 || value < expected[i] || value > expected[i] * (1. + 1. / LATENCY_SUB_BUCKETS)) {
+      cout << "ERROR: percentile " << fractions[i] << " is " << value << " ns, expected " << expected[i] << "\n";
+      ret = 1;
+    }
+  }
+
+  // A snapshot minus an earlier one only has what was recorded in between
+  histogram.Record(5000000);
+  LatencySnapshot second;
+  histogram.GetSnapshot(&second);
+  second.Subtract(first);
+  if (second.count != 1 || second.GetPercentile(0.5) < 5000000 || second.GetPercentile(0.5) > 5700000) {
+    cout << "ERROR: interval has " << second.count << " values with median " << second.GetPercentile(0.5) << "\n";
+    ret = 1;
+  }
+
+  // 1..1000 us add up to 500.5 ms, give or take half a bucket each
+  double total = (double)first.GetTotal();
+  if (total < 500.5e6 * (1. - 0.5 / LATENCY_SUB_BUCKETS) || total > 500.5e6 * (1. + 0.5 / LATENCY_SUB_BUCKETS)) {
+    cout << "ERROR: total is " << total << " ns, expected 500.5 ms\n";
+    ret = 1;
+  }
+
+  uint64_t start = GetLatencyNanos();
+  wxMilliSleep(10);
+  uint64_t slept = GetLatencyNanos() - start;
+  if (slept < 9000000 || slept > 1000000000) {
+    cout << "ERROR: sleeping 10 ms took " << slept << " ns\n";
+    ret = 1;
+  }
+
+  RadarLatency latency;
+  latency.Record(LATENCY_RENDER, 2000000);
+  if (latency.GetTotal(LATENCY_RENDER) < 2000000 || latency.GetTotal(LATENCY_RENDER) > 2300000 ||
+      latency.GetTotal(LATENCY_SPOKE) != 0) {
+    cout << "ERROR: render total is " << latency.GetTotal(LATENCY_RENDER) << " ns\n";
+    ret = 1;
+  }
+  wxString summary = latency.GetSummary();
+  latency.NextInterval();
+  if (!summary.StartsWith(wxT("latency p50/p99/max us\nrender 2")) || !latency.GetSummary().IsEmpty()) {
+    cout << "ERROR: summary is '" << summary.ToAscii() << "'\n";
+    ret = 1;
+  }
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
@@ -0,0 +1,194 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "LatencyHistogram.h"
+#include <math.h>
+#include <time.h>
+
+PLUGIN_BEGIN_NAMESPACE
+
+const char *latency_stage_names[LATENCY_STAGES] = {"socket",        "spoke",  "spoke_share", "spoke_history",
+                                                   "spoke_trails",  "spoke_draw", "upload",  "render"};
+
+uint64_t GetLatencyNanos() {
+#ifdef __WXMSW__
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+
+  if (frequency.QuadPart == 0) {
+    QueryPerformanceFrequency(&frequency);
+  }
+  QueryPerformanceCounter(&counter);
+  return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000 +
+         (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000 / frequency.QuadPart;
+#else
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+#endif
+}
+
+LatencyHistogram::LatencyHistogram() {
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    m_counts[i] = 0;
+  }
+}
+
+/*
+ * Values below LATENCY_SUB_BUCKETS have a bucket each. Above that a value with its highest bit
+ * at position m goes in one of the LATENCY_SUB_BUCKETS buckets of magnitude m, chosen by the
+ * LATENCY_SUB_BUCKET_BITS bits below the highest one.
+ */
+size_t LatencyHistogram::GetBucket(uint64_t value) {
+  if (value < LATENCY_SUB_BUCKETS) {
+    return (size_t)value;
+  }
+
+  size_t m = 0;
+  uint64_t v = value;
+  for (size_t shift = 32; shift > 0; shift /= 2) {
+    if (v >> shift) {
+      v >>= shift;
+      m += shift;
+    }
+  }
+
+  size_t bucket = (m - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS +
+                  (size_t)((value >> (m - LATENCY_SUB_BUCKET_BITS)) & (LATENCY_SUB_BUCKETS - 1));
+  return wxMin(bucket, (size_t)LATENCY_BUCKETS - 1);
+}
+
+uint64_t LatencyHistogram::GetBucketStart(size_t bucket) {
+  if (bucket < LATENCY_SUB_BUCKETS) {
+    return bucket;
+  }
+  size_t m = bucket / LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKET_BITS - 1;
+  uint64_t sub = bucket % LATENCY_SUB_BUCKETS;
+
+  return (LATENCY_SUB_BUCKETS + sub) << (m - LATENCY_SUB_BUCKET_BITS);
+}
+
+void LatencyHistogram::GetSnapshot(LatencySnapshot *snapshot) const {
+  snapshot->count = 0;
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    snapshot->counts[i] = m_counts[i];
+    snapshot->count += snapshot->counts[i];
+  }
+}
+
+void LatencySnapshot::Subtract(const LatencySnapshot &earlier) {
+  count = 0;
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    counts[i] -= earlier.counts[i];
+    count += counts[i];
+  }
+}
+
+uint64_t LatencySnapshot::GetPercentile(double fraction) const {
+  uint64_t wanted = (uint64_t)ceil(fraction * count);
+  uint64_t seen = 0;
+
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += counts[i];
+    if (seen >= wanted && counts[i] > 0) {
+      return LatencyHistogram::GetBucketStart(i + 1) - 1;
+    }
+  }
+  return 0;
+}
+
+uint64_t LatencySnapshot::GetTotal() const {
+  uint64_t total = 0;
+
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    if (counts[i] > 0) {
+      total += counts[i] * ((LatencyHistogram::GetBucketStart(i) + LatencyHistogram::GetBucketStart(i + 1)) / 2);
+    }
+  }
+  return total;
+}
+
+RadarLatency::RadarLatency() {
+  for (size_t s = 0; s < LATENCY_STAGES; s++) {
+    memset(&m_previous[s], 0, sizeof(m_previous[s]));
+  }
+}
+
+wxString RadarLatency::GetSummary() const {
+  wxString summary;
+
+  for (size_t s = 0; s < LATENCY_STAGES; s++) {
+    LatencySnapshot interval;
+
+    m_histogram[s].GetSnapshot(&interval);
+    interval.Subtract(m_previous[s]);
+    if (interval.count > 0) {
+      if (summary.length() == 0) {
+        summary << wxT("latency p50/p99/max us\n");
+      }
+      summary << wxString::Format(wxT("%s %.0f/%.0f/%.0f\n"), wxString::FromAscii(latency_stage_names[s]).c_str(),
+                                  interval.GetPercentile(0.5) / 1e3, interval.GetPercentile(0.99) / 1e3,
+                                  interval.GetPercentile(1.) / 1e3);
+    }
+  }
+  return summary;
+}
+
+uint64_t RadarLatency::GetTotal(LatencyStage stage) const {
+  LatencySnapshot interval;
+
+  m_histogram[stage].GetSnapshot(&interval);
+  interval.Subtract(m_previous[stage]);
+  return interval.GetTotal();
+}
+
+void RadarLatency::NextInterval() {
+  for (size_t s = 0; s < LATENCY_STAGES; s++) {
+    m_histogram[s].GetSnapshot(&m_previous[s]);
+  }
+}
+
+void RadarLatency::Export(FILE *f, const wxString &radar) const {
+  for (size_t s = 0; s < LATENCY_STAGES; s++) {
+    LatencySnapshot snapshot;
+
+    m_histogram[s].GetSnapshot(&snapshot);
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+      if (snapshot.counts[i] > 0) {
+        fprintf(f, "%s,%s,%.3f,%.3f,%u\n", (const char *)radar.ToUTF8(), latency_stage_names[s],
+                LatencyHistogram::GetBucketStart(i) / 1e3, LatencyHistogram::GetBucketStart(i + 1) / 1e3, snapshot.counts[i]);
+      }
+    }
+  }
+}
+
+PLUGIN_END_NAMESPACE
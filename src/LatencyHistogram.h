@@ -0,0 +1,123 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _LATENCYHISTOGRAM_H_
+#define _LATENCYHISTOGRAM_H_
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Histograms of how long things take, in the style of HdrHistogram: every power of two is split
+// into LATENCY_SUB_BUCKETS buckets, so a value is known to within 1 / LATENCY_SUB_BUCKETS
+// whatever its size, and recording a value is only a few shifts and an increment.
+//
+// Each histogram has a single thread that records into it, without a lock. Other threads read
+// it with GetSnapshot(); a snapshot may miss the values that are being recorded at that moment.
+//
+
+#define LATENCY_SUB_BUCKET_BITS (3)
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)  // So values are within 12.5%
+#define LATENCY_MAGNITUDES (40)                              // Up to 2^42 ns, more than an hour
+#define LATENCY_BUCKETS (LATENCY_MAGNITUDES * LATENCY_SUB_BUCKETS)
+
+// Monotonic time in nanoseconds from an arbitrary start, for measuring latencies
+extern uint64_t GetLatencyNanos();
+
+struct LatencySnapshot {
+  uint32_t counts[LATENCY_BUCKETS];
+  uint64_t count;
+
+  // Counts recorded since an earlier snapshot of the same histogram
+  void Subtract(const LatencySnapshot &earlier);
+
+  // The value that fraction (0..1) of the values are at or below, rounded up to the end of its
+  // bucket. GetPercentile(1.) is the largest value.
+  uint64_t GetPercentile(double fraction) const;
+
+  // The sum of the values, counting each one as the middle of its bucket
+  uint64_t GetTotal() const;
+};
+
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  void Record(uint64_t nanos) { m_counts[GetBucket(nanos)]++; }
+
+  void GetSnapshot(LatencySnapshot *snapshot) const;
+
+  static size_t GetBucket(uint64_t value);
+  static uint64_t GetBucketStart(size_t bucket);  // Smallest value that is counted in bucket
+
+ private:
+  volatile uint32_t m_counts[LATENCY_BUCKETS];
+};
+
+// What is measured for each radar
+enum LatencyStage {
+  LATENCY_SOCKET,         // The kernel received a frame until the receive thread processes it
+  LATENCY_SPOKE,          // All of RadarInfo::ProcessRadarSpoke
+  LATENCY_SPOKE_SHARE,    // ... publishing and recording the spoke
+  LATENCY_SPOKE_HISTORY,  // ... keeping the history and checking the guard zones
+  LATENCY_SPOKE_TRAILS,   // ... updating the trails
+  LATENCY_SPOKE_DRAW,     // ... handing it to the drawing methods and the stream
+  LATENCY_UPLOAD,         // The first spoke since the last draw arrived until it is sent to OpenGL
+  LATENCY_RENDER,         // Drawing the radar image
+  LATENCY_STAGES
+};
+
+extern const char *latency_stage_names[LATENCY_STAGES];
+
+class RadarLatency {
+ public:
+  RadarLatency();
+
+  void Record(LatencyStage stage, uint64_t nanos) { m_histogram[stage].Record(nanos); }
+
+  // Median, 99th percentile and maximum in microseconds for the values recorded since the last
+  // NextInterval(), one line per stage that has any.
+  wxString GetSummary() const;
+  uint64_t GetTotal(LatencyStage stage) const;  // Nanoseconds spent in stage since the last NextInterval()
+  void NextInterval();
+
+  // All buckets that have a count, as CSV lines "radar,stage,from_us,to_us,count"
+  void Export(FILE *f, const wxString &radar) const;
+
+ private:
+  LatencyHistogram m_histogram[LATENCY_STAGES];
+  LatencySnapshot m_previous[LATENCY_STAGES];  // At the last NextInterval()
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _LATENCYHISTOGRAM_H_ */
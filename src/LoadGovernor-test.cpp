@@ -0,0 +1,127 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "LoadGovernor.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define INTERVAL_NANOS (500000000ULL)  // TimedControlUpdate runs twice a second
+
+// Feed intervals with the given load, returns the level after them
+static DegradeLevel Run(LoadGovernor &governor, uint64_t *now, double load, int intervals) {
+  for (int i = 0; i < intervals; i++) {
+    *now += INTERVAL_NANOS;
+    governor.Update((uint64_t)(load * INTERVAL_NANOS), *now);
+  }
+  return governor.GetLevel();
+}
+
+int main() {
+  LoadGovernor governor;
+  uint64_t now = 1000000000ULL;
+  int ret = 0;
+
+  governor.Update(0, now);  // Starts the first interval
+  if (Run(governor, &now, 0.4, 20) != DEGRADE_NONE) {
+    cout << "ERROR: shedding within budget\n";
+    ret = 1;
+  }
+
+  // A single slow interval is not an overload
+  if (Run(governor, &now, 0.9, 1) != DEGRADE_NONE || Run(governor, &now, 0.4, 1) != DEGRADE_NONE) {
+    cout << "ERROR: shedding after one slow interval\n";
+    ret = 1;
+  }
+
+  // A steady overload sheds the levels in order, one step at a time
+  for (int level = DEGRADE_OVERLAY; level < DEGRADE_LEVELS; level++) {
+    DegradeLevel now_level = Run(governor, &now, 0.9, GOVERNOR_OVERLOAD_INTERVALS);
+    cout << "INFO: " << governor.GetSummary().ToAscii();
+    if (now_level != level) {
+      cout << "ERROR: level " << now_level << " instead of " << degrade_level_names[level] << "\n";
+      ret = 1;
+    }
+  }
+  if (Run(governor, &now, 0.9, 10) != DEGRADE_LEVELS - 1) {
+    cout << "ERROR: shedding beyond the last level\n";
+    ret = 1;
+  }
+
+  // Between the restore level and the budget nothing changes, below it the levels come back one by one
+  if (Run(governor, &now, 0.4, 20) != DEGRADE_LEVELS - 1) {
+    cout << "ERROR: restored while not calm\n";
+    ret = 1;
+  }
+  if (Run(governor, &now, 0.1, GOVERNOR_CALM_INTERVALS - 1) != DEGRADE_LEVELS - 1 ||
+      Run(governor, &now, 0.1, 1) != DEGRADE_LEVELS - 2) {
+    cout << "ERROR: level not restored after " << GOVERNOR_CALM_INTERVALS << " calm intervals\n";
+    ret = 1;
+  }
+  if (Run(governor, &now, 0.1, 2 * GOVERNOR_CALM_INTERVALS) != DEGRADE_NONE) {
+    cout << "ERROR: not all levels restored\n";
+    ret = 1;
+  }
+
+  // At DEGRADE_OVERLAY the overlay gets every other rotation
+  Run(governor, &now, 0.9, GOVERNOR_OVERLOAD_INTERVALS);
+  int skipped[3] = {0, 0, 0};
+  for (int rotation = 0; rotation < 3; rotation++) {
+    for (int angle = 0; angle < 2048; angle++) {
+      skipped[rotation] += governor.SkipOverlay(angle) ? 1 : 0;
+    }
+  }
+  if (governor.GetLevel() != DEGRADE_OVERLAY || skipped[0] + skipped[1] + skipped[2] != 2048 ||
+      skipped[0] == skipped[1] || skipped[1] == skipped[2]) {
+    cout << "ERROR: overlay skipped " << skipped[0] << "/" << skipped[1] << "/" << skipped[2] << " spokes\n";
+    ret = 1;
+  }
+
+  // Decimation keeps the strongest return of each group, also at the end of an odd spoke
+  const uint8_t spoke[] = {0, 200, 3, 0, 0, 0, 17};
+  const uint8_t expected[] = {200, 200, 3, 3, 0, 0, 17};
+  uint8_t decimated[sizeof(spoke)];
+  LoadGovernor::DecimateSpoke(spoke, sizeof(spoke), decimated);
+  if (memcmp(decimated, expected, sizeof(spoke)) != 0) {
+    cout << "ERROR: decimated spoke is wrong\n";
+    ret = 1;
+  }
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
@@ -0,0 +1,106 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "LoadGovernor.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+const char *degrade_level_names[DEGRADE_LEVELS] = {"none", "overlay", "true-trails", "decimate"};
+
+LoadGovernor::LoadGovernor() {
+  m_level = DEGRADE_NONE;
+  m_last_update = 0;
+  m_load = 0.;
+  m_overloaded = 0;
+  m_calm = 0;
+  m_last_angle = 0;
+  m_rotations = 0;
+}
+
+void LoadGovernor::Update(uint64_t busy_nanos, uint64_t now_nanos) {
+  if (m_last_update == 0 || now_nanos <= m_last_update) {
+    m_last_update = now_nanos;
+    return;
+  }
+  m_load = (double)busy_nanos / (double)(now_nanos - m_last_update);
+  m_last_update = now_nanos;
+
+  m_overloaded = m_load > GOVERNOR_BUDGET ? m_overloaded + 1 : 0;
+  m_calm = m_load < GOVERNOR_RESTORE ? m_calm + 1 : 0;
+
+  // One level at a time, and only after the previous step has been measured
+  if (m_overloaded >= GOVERNOR_OVERLOAD_INTERVALS && m_level < DEGRADE_LEVELS - 1) {
+    m_level++;
+    m_overloaded = 0;
+    m_calm = 0;
+  } else if (m_calm >= GOVERNOR_CALM_INTERVALS && m_level > DEGRADE_NONE) {
+    m_level--;
+    m_overloaded = 0;
+    m_calm = 0;
+  }
+}
+
+wxString LoadGovernor::GetSummary() {
+  return wxString::Format(wxT("load %.0f%% shedding %s\n"), m_load * 100.,
+                          wxString::FromAscii(degrade_level_names[m_level]).c_str());
+}
+
+/*
+ * The overlay keeps the last spoke it got for every bearing, so skipping every other
+ * rotation halves the work and only makes the picture one rotation older.
+ */
+bool LoadGovernor::SkipOverlay(int angle) {
+  if (angle < m_last_angle) {
+    m_rotations++;
+  }
+  m_last_angle = angle;
+  return m_level >= DEGRADE_OVERLAY && (m_rotations & 1) != 0;
+}
+
+/*
+ * Every group of GOVERNOR_DECIMATION range bins gets the strongest return of the group, so no
+ * echo disappears but the drawing methods get fewer and longer blobs to draw.
+ */
+void LoadGovernor::DecimateSpoke(const uint8_t *data, size_t len, uint8_t *decimated) {
+  for (size_t r = 0; r < len; r += GOVERNOR_DECIMATION) {
+    size_t end = wxMin(r + GOVERNOR_DECIMATION, len);
+    uint8_t strongest = 0;
+
+    for (size_t i = r; i < end; i++) {
+      strongest = wxMax(strongest, data[i]);
+    }
+    for (size_t i = r; i < end; i++) {
+      decimated[i] = strongest;
+    }
+  }
+}
+
+PLUGIN_END_NAMESPACE
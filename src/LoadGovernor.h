@@ -0,0 +1,94 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _LOADGOVERNOR_H_
+#define _LOADGOVERNOR_H_
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Keeps the time a radar costs within a budget, so that a slow machine drops detail in a
+// known order instead of dropping spokes at the socket. Every statistics interval the main
+// thread tells it how long the spoke pipeline and the rendering took. When that is over
+// GOVERNOR_BUDGET of the interval it sheds one more level of work, when it has been well
+// below for a while it gives one level back.
+//
+// ARPA and the guard zones are never part of this, they always see every spoke.
+//
+
+#define GOVERNOR_BUDGET (0.5)               // Of one CPU, for one radar
+#define GOVERNOR_RESTORE (0.25)             // Give a level back when below this
+#define GOVERNOR_OVERLOAD_INTERVALS (2)     // Intervals over budget before shedding a level
+#define GOVERNOR_CALM_INTERVALS (6)         // Intervals below GOVERNOR_RESTORE before restoring one
+#define GOVERNOR_DECIMATION (2)             // Range bins shown as one at DEGRADE_DECIMATE
+
+enum DegradeLevel {
+  DEGRADE_NONE,
+  DEGRADE_OVERLAY,      // The overlay is only updated every other rotation
+  DEGRADE_TRUE_TRAILS,  // ... and true trails are not kept
+  DEGRADE_DECIMATE,     // ... and the views get GOVERNOR_DECIMATION range bins at a time
+  DEGRADE_LEVELS
+};
+
+extern const char *degrade_level_names[DEGRADE_LEVELS];
+
+class LoadGovernor {
+ public:
+  LoadGovernor();
+
+  // Main thread
+  void Update(uint64_t busy_nanos, uint64_t now_nanos);
+  wxString GetSummary();  // "load ... level ..." line for the statistics
+
+  // Any thread
+  DegradeLevel GetLevel() const { return (DegradeLevel)m_level; }
+
+  // Receive thread, for every spoke
+  bool SkipOverlay(int angle);
+
+  static void DecimateSpoke(const uint8_t *data, size_t len, uint8_t *decimated);
+
+ private:
+  volatile int m_level;
+  uint64_t m_last_update;  // 0 before the first Update()
+  double m_load;           // Of the last interval, as a fraction of one CPU
+  int m_overloaded;        // Consecutive intervals over budget
+  int m_calm;              // Consecutive intervals below GOVERNOR_RESTORE
+
+  int m_last_angle;  // To count the rotations
+  uint32_t m_rotations;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _LOADGOVERNOR_H_ */
@@ -0,0 +1,150 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/init.h>
+#include "LockProfiler.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define WORKERS (4)
+#define ITERATIONS (100000)
+
+static ProfiledCriticalSection s_shared(LOCK_RADAR_PI);
+static volatile uint64_t s_sum = 0;
+
+// Takes the shared lock and its own lock, like receive threads do with radar_pi and RadarInfo
+class Worker : public wxThread {
+ public:
+  Worker() : wxThread(wxTHREAD_JOINABLE), m_own(LOCK_RADAR_INFO) { m_sum = 0; }
+
+  void *Entry(void) {
+    for (int i = 0; i < ITERATIONS; i++) {
+      {
+        ProfiledLocker lock(s_shared);
+        s_sum += i;
+      }
+      {
+        ProfiledLocker lock(m_own);
+        m_sum += i;
+      }
+    }
+    return 0;
+  }
+
+ private:
+  ProfiledCriticalSection m_own;
+  uint64_t m_sum;
+};
+
+static bool HasLine(const wxString &profile, LockClass c, wxString *line) {
+  wxString name = wxString::FromAscii(lock_class_names[c]) + wxT(" ");
+  int start = profile.Find(name);
+  if (start == wxNOT_FOUND) {
+    return false;
+  }
+  *line = profile.Mid(start).BeforeFirst('\n');
+  return true;
+}
+
+int main() {
+  wxInitializer initializer;  // needed for wxThread
+  int ret = 0;
+  wxString line;
+
+  // Nothing is counted while profiling is off
+  {
+    ProfiledLocker lock(s_shared);
+  }
+  EnableLockProfile(true);
+  wxString profile = GetLockProfile();
+  if (HasLine(profile, LOCK_RADAR_PI, &line)) {
+    cout << "ERROR: lock counted while profiling is off: " << line.ToAscii() << "\n";
+    ret = 1;
+  }
+
+  Worker *workers[WORKERS];
+  for (int i = 0; i < WORKERS; i++) {
+    workers[i] = new Worker();
+    workers[i]->Run();
+  }
+  for (int i = 0; i < WORKERS; i++) {
+    workers[i]->Wait();
+    delete workers[i];  // The counts of the RadarInfo locks must survive this
+  }
+  profile = GetLockProfile();
+  cout << "INFO: " << profile.ToAscii();
+
+  if (!HasLine(profile, LOCK_RADAR_PI, &line)) {
+    cout << "ERROR: shared lock is missing\n";
+    ret = 1;
+  }
+  if (!HasLine(profile, LOCK_RADAR_INFO, &line)) {
+    cout << "ERROR: locks of the workers are missing after they are gone\n";
+    ret = 1;
+  } else if (line.Find(wxT(" 0.0%")) == wxNOT_FOUND) {
+    cout << "ERROR: locks that are only used by one thread are contended: " << line.ToAscii() << "\n";
+    ret = 1;
+  }
+  if (s_sum != (uint64_t)WORKERS * ITERATIONS * (ITERATIONS - 1) / 2) {
+    cout << "ERROR: the shared lock did not protect the sum\n";
+    ret = 1;
+  }
+
+  // The report starts again after every call
+  profile = GetLockProfile();
+  if (HasLine(profile, LOCK_RADAR_PI, &line) || HasLine(profile, LOCK_RADAR_INFO, &line)) {
+    cout << "ERROR: counts were not reset: " << profile.ToAscii() << "\n";
+    ret = 1;
+  }
+
+  // Measure the cost of a lock with and without profiling
+  for (int on = 0; on < 2; on++) {
+    EnableLockProfile(on != 0);
+    uint64_t start = GetLatencyNanos();
+    for (int i = 0; i < ITERATIONS; i++) {
+      ProfiledLocker lock(s_shared);
+      s_sum++;
+    }
+    cout << "INFO: lock with profiling " << (on ? "on" : "off") << " takes " << (GetLatencyNanos() - start) / ITERATIONS
+         << " ns\n";
+  }
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
@@ -0,0 +1,158 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "LockProfiler.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+const char *lock_class_names[LOCK_CLASSES] = {"radar_pi::m_exclusive", "RadarInfo::m_exclusive", "RadarDraw::m_exclusive",
+                                              "RadarControlItem::m_exclusive"};
+
+volatile bool g_lock_profile = false;
+
+// The list of all locks and what the locks that are gone had counted, protected by GetLockList()
+static ProfiledCriticalSection *s_locks = 0;
+static LockCounts s_retired[LOCK_CLASSES];
+static uint64_t s_last_report = 0;
+
+// A function, so that it exists before the first lock is made by a static constructor
+static wxCriticalSection &GetLockList() {
+  static wxCriticalSection lock_list;
+  return lock_list;
+}
+
+static void AddCounts(LockCounts *total, const LockCounts &counts, const LockCounts &reported) {
+  total->acquired += counts.acquired - reported.acquired;
+  total->contended += counts.contended - reported.contended;
+  total->wait_nanos += counts.wait_nanos - reported.wait_nanos;
+  total->hold_nanos += counts.hold_nanos - reported.hold_nanos;
+}
+
+ProfiledCriticalSection::ProfiledCriticalSection(LockClass lock_class) {
+  m_class = lock_class;
+  CLEAR_STRUCT(m_counts);
+  CLEAR_STRUCT(m_reported);
+  m_acquired_at = 0;
+  m_depth = 0;
+
+  wxCriticalSectionLocker lock(GetLockList());
+  m_prev = 0;
+  m_next = s_locks;
+  if (s_locks) {
+    s_locks->m_prev = this;
+  }
+  s_locks = this;
+}
+
+ProfiledCriticalSection::~ProfiledCriticalSection() {
+  wxCriticalSectionLocker lock(GetLockList());
+
+  AddCounts(&s_retired[m_class], m_counts, m_reported);
+  if (m_prev) {
+    m_prev->m_next = m_next;
+  } else {
+    s_locks = m_next;
+  }
+  if (m_next) {
+    m_next->m_prev = m_prev;
+  }
+}
+
+void ProfiledCriticalSection::EnterProfiled() {
+  uint64_t wait = 0;
+  bool contended = false;
+
+  if (!TryEnter()) {
+    uint64_t start = GetLatencyNanos();
+    wxCriticalSection::Enter();
+    wait = GetLatencyNanos() - start;
+    contended = true;
+  }
+
+  // Now that we hold the lock we can count
+  if (m_depth++ == 0) {
+    m_acquired_at = GetLatencyNanos();
+  }
+  m_counts.acquired++;
+  if (contended) {
+    m_counts.contended++;
+    m_counts.wait_nanos += wait;
+  }
+}
+
+void EnableLockProfile(bool enable) {
+  if (enable && !g_lock_profile) {
+    GetLockProfile();  // Start counting from now
+  }
+  g_lock_profile = enable;
+}
+
+wxString GetLockProfile() {
+  wxCriticalSectionLocker lock(GetLockList());
+  LockCounts total[LOCK_CLASSES];
+  uint64_t busiest[LOCK_CLASSES];  // Most time that a single lock of the class was held
+  uint64_t now = GetLatencyNanos();
+  uint64_t interval = now - s_last_report;
+
+  s_last_report = now;
+  memcpy(total, s_retired, sizeof(total));
+  CLEAR_STRUCT(s_retired);
+  CLEAR_STRUCT(busiest);
+
+  for (ProfiledCriticalSection *p = s_locks; p; p = p->m_next) {
+    // Counts may change while we read them, they are only used as statistics
+    LockCounts counts = p->m_counts;
+
+    AddCounts(&total[p->m_class], counts, p->m_reported);
+    busiest[p->m_class] = wxMax(busiest[p->m_class], counts.hold_nanos - p->m_reported.hold_nanos);
+    p->m_reported = counts;
+  }
+
+  wxString s = wxT("locks taken/s contended wait/hold ms busiest\n");
+  int limiting = -1;
+  for (int c = 0; c < LOCK_CLASSES; c++) {
+    if (total[c].acquired == 0) {
+      continue;
+    }
+    s << wxString::Format(wxT("%s %.0f %.1f%% %.1f/%.1f %.0f%%\n"), wxString::FromAscii(lock_class_names[c]).c_str(),
+                          total[c].acquired * 1e9 / interval, total[c].contended * 100. / total[c].acquired,
+                          total[c].wait_nanos / 1e6, total[c].hold_nanos / 1e6, busiest[c] * 100. / interval);
+    if (total[c].wait_nanos > 0 && (limiting < 0 || total[c].wait_nanos > total[limiting].wait_nanos)) {
+      limiting = c;
+    }
+  }
+  if (limiting >= 0) {
+    s << wxT("limited by ") << wxString::FromAscii(lock_class_names[limiting]) << wxT("\n");
+  }
+  return s;
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,112 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _LOCKPROFILER_H_
+#define _LOCKPROFILER_H_
+
+#include "LatencyHistogram.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Counts how often the locks that the radars share are taken, how long threads wait for them
+// and how long they are held, to find which lock stops the radars from running side by side.
+// Locks are counted per class, so the RadarInfo::m_exclusive of all radars add up together.
+//
+// When profiling is off taking a lock costs a test of g_lock_profile extra. When it is on it costs
+// a TryEnter and two clock reads. The counts of a lock are only changed by the thread holding it.
+//
+
+enum LockClass { LOCK_RADAR_PI, LOCK_RADAR_INFO, LOCK_RADAR_DRAW, LOCK_CONTROL_ITEM, LOCK_CLASSES };
+
+extern const char *lock_class_names[LOCK_CLASSES];
+extern volatile bool g_lock_profile;
+
+struct LockCounts {
+  uint64_t acquired;
+  uint64_t contended;  // Times that another thread held the lock already
+  uint64_t wait_nanos;
+  uint64_t hold_nanos;
+};
+
+class ProfiledCriticalSection : public wxCriticalSection {
+ public:
+  ProfiledCriticalSection(LockClass lock_class);
+  ~ProfiledCriticalSection();
+
+  void Enter() {
+    if (g_lock_profile) {
+      EnterProfiled();
+    } else {
+      wxCriticalSection::Enter();
+    }
+  }
+
+  void Leave() {
+    if (m_depth > 0 && --m_depth == 0) {
+      m_counts.hold_nanos += GetLatencyNanos() - m_acquired_at;
+    }
+    wxCriticalSection::Leave();
+  }
+
+ private:
+  friend wxString GetLockProfile();
+
+  void EnterProfiled();
+
+  LockClass m_class;
+  LockCounts m_counts;
+  LockCounts m_reported;  // m_counts at the last GetLockProfile()
+  uint64_t m_acquired_at;
+  int m_depth;  // Times the holding thread has entered
+
+  ProfiledCriticalSection *m_prev;  // All locks, so they can be added up
+  ProfiledCriticalSection *m_next;
+};
+
+// wxCriticalSectionLocker for a ProfiledCriticalSection
+class ProfiledLocker {
+ public:
+  ProfiledLocker(ProfiledCriticalSection &cs) : m_cs(cs) { m_cs.Enter(); }
+  ~ProfiledLocker() { m_cs.Leave(); }
+
+ private:
+  ProfiledCriticalSection &m_cs;
+};
+
+extern void EnableLockProfile(bool enable);
+
+// One line per class of lock with the counts since the last call, and which lock was waited for most
+extern wxString GetLockProfile();
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _LOCKPROFILER_H_ */
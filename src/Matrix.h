@@ -32,6 +32,14 @@
 
 PLUGIN_BEGIN_NAMESPACE
 
+template <typename Ty, int N, int M, class L, class R, class Op>
+struct MatrixExpression;
+
+namespace detail {
+template <int K, int E>
+struct elementwise;
+}
+
 template <typename Ty, int N, int M = N>
 struct Matrix {
   typedef Ty value_type;
@@ -58,17 +66,18 @@ struct Matrix {
     return element[r][c];
   }
 
-  // Return matrix transpose
-  Matrix<Ty, M, N> Transpose() const {
-    Matrix<Ty, M, N> result;
-    for (int r = 0; r < N; ++r) {
-      for (int c = 0; c < M; ++c) {
-        result.element[c][r] = element[r][c];
-      }
-    }
-    return result;
+  // Evaluate an element-wise expression directly into this matrix, without a temporary.
+  // This is safe when the expression refers to this matrix, as every element only reads
+  // the same element of its operands.
+  template <class L, class R, class Op>
+  Matrix<Ty, N, M>& operator=(const MatrixExpression<Ty, N, M, L, R, Op>& expr) {
+    detail::elementwise<0, N * M>::assign(*this, expr);
+    return *this;
   }
 
+  // Return matrix transpose
+  Matrix<Ty, M, N> Transpose() const;
+
   // Return matrix initialized to value
   Matrix<Ty, M, N> Init(Ty value) const {
     Matrix<Ty, M, N> result;
@@ -81,6 +90,9 @@ struct Matrix {
   // Return matrix inverse
   Matrix<Ty, N, M> Inverse();
 
+  // Return matrix inverse of a symmetric matrix, only the upper triangle is computed
+  Matrix<Ty, N, M> SymmetricInverse();
+
   Matrix<Ty, N, N> Identity() {
     Matrix<Ty, N, N> result = Matrix<Ty, N, N>();
     for (int i = 0; i < N * N; ++i) result.flatten[i] = Ty(0);
@@ -89,6 +101,172 @@ struct Matrix {
   }
 };
 
+///
+// Compile time unrolled kernels
+///
+// The matrices used by the Kalman filter are at most 4x4, so all loops are unrolled at
+// compile time by template recursion over the flattened element index. Without C++11
+// there is no constexpr, so the element row and column are derived from the template
+// arguments instead.
+namespace detail {
+
+// Inner product of row a (stride 1) and column b (stride S) over I..E-1
+template <typename Ty, int S, int I, int E>
+struct dot {
+  static inline Ty run(const Ty* a, const Ty* b) { return a[I] * b[I * S] + dot<Ty, S, I + 1, E>::run(a, b); }
+};
+
+template <typename Ty, int S, int E>
+struct dot<Ty, S, E, E> {
+  static inline Ty run(const Ty*, const Ty*) { return Ty(0); }
+};
+
+// Matrix product a * b for result element K..E-1
+template <typename Ty, int N, int M, int P, int K, int E>
+struct product {
+  static inline void run(const Matrix<Ty, N, M>& a, const Matrix<Ty, M, P>& b, Matrix<Ty, N, P>& result) {
+    result.flatten[K] = dot<Ty, P, 0, M>::run(&a.flatten[(K / P) * M], &b.flatten[K % P]);
+    product<Ty, N, M, P, K + 1, E>::run(a, b, result);
+  }
+};
+
+template <typename Ty, int N, int M, int P, int E>
+struct product<Ty, N, M, P, E, E> {
+  static inline void run(const Matrix<Ty, N, M>&, const Matrix<Ty, M, P>&, Matrix<Ty, N, P>&) {}
+};
+
+// Matrix product a * Transpose(b) for result element K..E-1, b is not transposed in memory
+template <typename Ty, int N, int M, int P, int K, int E>
+struct product_transposed {
+  static inline void run(const Matrix<Ty, N, M>& a, const Matrix<Ty, P, M>& b, Matrix<Ty, N, P>& result) {
+    result.flatten[K] = dot<Ty, 1, 0, M>::run(&a.flatten[(K / P) * M], &b.flatten[(K % P) * M]);
+    product_transposed<Ty, N, M, P, K + 1, E>::run(a, b, result);
+  }
+};
+
+template <typename Ty, int N, int M, int P, int E>
+struct product_transposed<Ty, N, M, P, E, E> {
+  static inline void run(const Matrix<Ty, N, M>&, const Matrix<Ty, P, M>&, Matrix<Ty, N, P>&) {}
+};
+
+// As product_transposed, but the result is known to be symmetric so only the upper
+// triangle is computed and then mirrored.
+template <typename Ty, int N, int M, int K, int E>
+struct symmetric_product_transposed {
+  static inline void run(const Matrix<Ty, N, M>& a, const Matrix<Ty, N, M>& b, Matrix<Ty, N, N>& result) {
+    if (K / N <= K % N) {
+      result.flatten[K] = dot<Ty, 1, 0, M>::run(&a.flatten[(K / N) * M], &b.flatten[(K % N) * M]);
+      result.flatten[(K % N) * N + K / N] = result.flatten[K];
+    }
+    symmetric_product_transposed<Ty, N, M, K + 1, E>::run(a, b, result);
+  }
+};
+
+template <typename Ty, int N, int M, int E>
+struct symmetric_product_transposed<Ty, N, M, E, E> {
+  static inline void run(const Matrix<Ty, N, M>&, const Matrix<Ty, N, M>&, Matrix<Ty, N, N>&) {}
+};
+
+// Transpose for source element K..E-1
+template <typename Ty, int N, int M, int K, int E>
+struct transpose {
+  static inline void run(const Matrix<Ty, N, M>& a, Matrix<Ty, M, N>& result) {
+    result.flatten[(K % M) * N + K / M] = a.flatten[K];
+    transpose<Ty, N, M, K + 1, E>::run(a, result);
+  }
+};
+
+template <typename Ty, int N, int M, int E>
+struct transpose<Ty, N, M, E, E> {
+  static inline void run(const Matrix<Ty, N, M>&, Matrix<Ty, M, N>&) {}
+};
+
+// Element access that works for both matrices and expressions
+template <typename Ty, int N, int M>
+inline Ty flat_value(const Matrix<Ty, N, M>& a, const int e) {
+  return a.flatten[e];
+}
+
+template <typename Ty, int N, int M, class L, class R, class Op>
+inline Ty flat_value(const MatrixExpression<Ty, N, M, L, R, Op>& a, const int e) {
+  return a.flat(e);
+}
+
+// Element-wise evaluation of element K..E-1
+template <int K, int E>
+struct elementwise {
+  template <class Dst, class Src>
+  static inline void assign(Dst& dst, const Src& src) {
+    dst.flatten[K] = flat_value(src, K);
+    elementwise<K + 1, E>::assign(dst, src);
+  }
+};
+
+template <int E>
+struct elementwise<E, E> {
+  template <class Dst, class Src>
+  static inline void assign(Dst&, const Src&) {}
+};
+
+struct add {
+  template <typename Ty>
+  static inline Ty apply(const Ty a, const Ty b) {
+    return a + b;
+  }
+};
+
+struct subtract {
+  template <typename Ty>
+  static inline Ty apply(const Ty a, const Ty b) {
+    return a - b;
+  }
+};
+
+}  // namespace detail
+
+///
+// Matrix expressions
+///
+// Sums and differences of matrices are not evaluated immediately but return a
+// MatrixExpression that refers to its operands. The expression is evaluated
+// element by element when it is assigned to a Matrix, so A + B - C does not create
+// intermediate matrices.
+// An expression holds references to its operands, so it must be used within the
+// statement that creates it; do not store it.
+template <typename Ty, int N, int M, class L, class R, class Op>
+struct MatrixExpression {
+  typedef Ty value_type;
+
+  MatrixExpression(const L& l, const R& r) : lhs(l), rhs(r) {}
+
+  inline Ty flat(const int e) const { return Op::apply(detail::flat_value(lhs, e), detail::flat_value(rhs, e)); }
+
+  Ty operator()(const int r, const int c) const {
+    assert(r >= 0 && r < N);
+    assert(c >= 0 && c < M);
+    return flat(r * M + c);
+  }
+
+  Matrix<Ty, N, M> Eval() const {
+    Matrix<Ty, N, M> result;
+    detail::elementwise<0, N * M>::assign(result, *this);
+    return result;
+  }
+
+  operator Matrix<Ty, N, M>() const { return Eval(); }
+
+  const L& lhs;
+  const R& rhs;
+};
+
+// Define matrix transpose
+template <typename Ty, int N, int M>
+Matrix<Ty, M, N> Matrix<Ty, N, M>::Transpose() const {
+  Matrix<Ty, M, N> result;
+  detail::transpose<Ty, N, M, 0, N * M>::run(*this, result);
+  return result;
+}
+
 ///
 // Matrix Inverse
 ///
@@ -103,6 +281,9 @@ namespace detail {
 template <typename Ty, int N, int M>
 struct inverse;
 
+template <typename Ty, int N, int M>
+struct symmetric_inverse;
+
 // Matrix inversion for 2x2 matrix
 template <typename Ty>
 struct inverse<Ty, 2, 2> {
@@ -119,6 +300,121 @@ struct inverse<Ty, 2, 2> {
   }
 };
 
+// Matrix inversion for symmetric 2x2 matrix
+template <typename Ty>
+struct symmetric_inverse<Ty, 2, 2> {
+  Matrix<Ty, 2, 2> operator()(const Matrix<Ty, 2, 2>& a) {
+    Matrix<Ty, 2, 2> result;
+    Ty det = a.element[0][0] * a.element[1][1] - a.element[0][1] * a.element[0][1];
+    assert(det != 0);
+    Ty inv_det = Ty(1) / det;
+
+    result.element[0][0] = a.element[1][1] * inv_det;
+    result.element[1][1] = a.element[0][0] * inv_det;
+    result.element[0][1] = -a.element[0][1] * inv_det;
+    result.element[1][0] = result.element[0][1];
+    return result;
+  }
+};
+
+// Matrix inversion for 4x4 matrix, closed form using the 2x2 sub-determinants
+// of the upper two (s) and lower two (c) rows (Laplace expansion).
+template <typename Ty>
+struct inverse<Ty, 4, 4> {
+  Matrix<Ty, 4, 4> operator()(const Matrix<Ty, 4, 4>& m) {
+    const Ty(*a)[4] = m.element;
+    Matrix<Ty, 4, 4> result;
+    Ty(*b)[4] = result.element;
+
+    Ty s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+    Ty s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+    Ty s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+    Ty s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+    Ty s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+    Ty s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+
+    Ty c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+    Ty c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+    Ty c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+    Ty c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+    Ty c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+    Ty c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+
+    Ty det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    assert(det != 0);
+    Ty inv_det = Ty(1) / det;
+
+    b[0][0] = (a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * inv_det;
+    b[0][1] = (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * inv_det;
+    b[0][2] = (a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * inv_det;
+    b[0][3] = (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * inv_det;
+
+    b[1][0] = (-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1) * inv_det;
+    b[1][1] = (a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * inv_det;
+    b[1][2] = (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * inv_det;
+    b[1][3] = (a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * inv_det;
+
+    b[2][0] = (a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * inv_det;
+    b[2][1] = (-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0) * inv_det;
+    b[2][2] = (a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * inv_det;
+    b[2][3] = (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * inv_det;
+
+    b[3][0] = (-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0) * inv_det;
+    b[3][1] = (a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * inv_det;
+    b[3][2] = (-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0) * inv_det;
+    b[3][3] = (a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * inv_det;
+    return result;
+  }
+};
+
+// Matrix inversion for symmetric 4x4 matrix, as above but only the upper triangle
+// of the adjugate is computed.
+template <typename Ty>
+struct symmetric_inverse<Ty, 4, 4> {
+  Matrix<Ty, 4, 4> operator()(const Matrix<Ty, 4, 4>& m) {
+    const Ty(*a)[4] = m.element;
+    Matrix<Ty, 4, 4> result;
+    Ty(*b)[4] = result.element;
+
+    Ty s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+    Ty s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+    Ty s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+    Ty s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+    Ty s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+    Ty s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+
+    Ty c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+    Ty c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+    Ty c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+    Ty c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+    Ty c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+    Ty c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+
+    Ty det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    assert(det != 0);
+    Ty inv_det = Ty(1) / det;
+
+    b[0][0] = (a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * inv_det;
+    b[0][1] = (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * inv_det;
+    b[0][2] = (a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * inv_det;
+    b[0][3] = (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * inv_det;
+    b[1][1] = (a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * inv_det;
+    b[1][2] = (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * inv_det;
+    b[1][3] = (a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * inv_det;
+    b[2][2] = (a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * inv_det;
+    b[2][3] = (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * inv_det;
+    b[3][3] = (a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * inv_det;
+
+    b[1][0] = b[0][1];
+    b[2][0] = b[0][2];
+    b[3][0] = b[0][3];
+    b[2][1] = b[1][2];
+    b[3][1] = b[1][3];
+    b[3][2] = b[2][3];
+    return result;
+  }
+};
+
 }  // namespace detail
 
 // Define matrix inverse
@@ -127,6 +423,12 @@ Matrix<Ty, N, M> Matrix<Ty, N, M>::Inverse() {
   return detail::inverse<Ty, N, M>()(*this);
 }
 
+// Define symmetric matrix inverse
+template <typename Ty, int N, int M>
+Matrix<Ty, N, M> Matrix<Ty, N, M>::SymmetricInverse() {
+  return detail::symmetric_inverse<Ty, N, M>()(*this);
+}
+
 ///
 //  Matrix operations
 ///
@@ -134,16 +436,24 @@ Matrix<Ty, N, M> Matrix<Ty, N, M>::Inverse() {
 template <typename Ty, int N, int M, int P>
 Matrix<Ty, N, P> operator*(const Matrix<Ty, N, M>& a, const Matrix<Ty, M, P>& b) {
   Matrix<Ty, N, P> result;
+  detail::product<Ty, N, M, P, 0, N * P>::run(a, b, result);
+  return result;
+}
 
-  for (int r = 0; r < N; ++r) {
-    for (int c = 0; c < P; ++c) {
-      Ty accum = Ty(0);
-      for (int i = 0; i < M; ++i) {
-        accum += a.element[r][i] * b.element[i][c];
-      }
-      result.element[r][c] = accum;
-    }
-  }
+// Matrix product a * Transpose(b), without creating the transpose
+template <typename Ty, int N, int M, int P>
+Matrix<Ty, N, P> MultiplyTransposed(const Matrix<Ty, N, M>& a, const Matrix<Ty, P, M>& b) {
+  Matrix<Ty, N, P> result;
+  detail::product_transposed<Ty, N, M, P, 0, N * P>::run(a, b, result);
+  return result;
+}
+
+// Matrix product a * s * Transpose(a) where s is symmetric, so the result is symmetric too
+template <typename Ty, int N, int M>
+Matrix<Ty, N, N> Sandwich(const Matrix<Ty, N, M>& a, const Matrix<Ty, M, M>& s) {
+  Matrix<Ty, N, M> as = a * s;
+  Matrix<Ty, N, N> result;
+  detail::symmetric_product_transposed<Ty, N, M, 0, N * N>::run(as, a, result);
   return result;
 }
 
@@ -155,16 +465,34 @@ Matrix<Ty, N, M> operator-(const Matrix<Ty, N, M>& a) {
   return result;
 }
 
-#define MATRIX_WITH_MATRIX_OPERATOR(op_symbol, op)                                            \
-  template <typename Ty, int N, int M>                                                        \
-  Matrix<Ty, N, M> operator op_symbol(const Matrix<Ty, N, M>& a, const Matrix<Ty, N, M>& b) { \
-    Matrix<Ty, N, M> result;                                                                  \
-    for (int e = 0; e < N * M; ++e) result.flatten[e] = a.flatten[e] op b.flatten[e];         \
-    return result;                                                                            \
+#define MATRIX_WITH_MATRIX_OPERATOR(op_symbol, op)                                                                              \
+  template <typename Ty, int N, int M>                                                                                          \
+  MatrixExpression<Ty, N, M, Matrix<Ty, N, M>, Matrix<Ty, N, M>, detail::op> operator op_symbol(const Matrix<Ty, N, M>& a,     \
+                                                                                               const Matrix<Ty, N, M>& b) {    \
+    return MatrixExpression<Ty, N, M, Matrix<Ty, N, M>, Matrix<Ty, N, M>, detail::op>(a, b);                                    \
+  }                                                                                                                             \
+                                                                                                                                \
+  template <typename Ty, int N, int M, class L, class R, class Op>                                                              \
+  MatrixExpression<Ty, N, M, MatrixExpression<Ty, N, M, L, R, Op>, Matrix<Ty, N, M>, detail::op> operator op_symbol(            \
+      const MatrixExpression<Ty, N, M, L, R, Op>& a, const Matrix<Ty, N, M>& b) {                                               \
+    return MatrixExpression<Ty, N, M, MatrixExpression<Ty, N, M, L, R, Op>, Matrix<Ty, N, M>, detail::op>(a, b);                \
+  }                                                                                                                             \
+                                                                                                                                \
+  template <typename Ty, int N, int M, class L, class R, class Op>                                                              \
+  MatrixExpression<Ty, N, M, Matrix<Ty, N, M>, MatrixExpression<Ty, N, M, L, R, Op>, detail::op> operator op_symbol(            \
+      const Matrix<Ty, N, M>& a, const MatrixExpression<Ty, N, M, L, R, Op>& b) {                                               \
+    return MatrixExpression<Ty, N, M, Matrix<Ty, N, M>, MatrixExpression<Ty, N, M, L, R, Op>, detail::op>(a, b);                \
+  }                                                                                                                             \
+                                                                                                                                \
+  template <typename Ty, int N, int M, class L1, class R1, class Op1, class L2, class R2, class Op2>                            \
+  MatrixExpression<Ty, N, M, MatrixExpression<Ty, N, M, L1, R1, Op1>, MatrixExpression<Ty, N, M, L2, R2, Op2>, detail::op>      \
+  operator op_symbol(const MatrixExpression<Ty, N, M, L1, R1, Op1>& a, const MatrixExpression<Ty, N, M, L2, R2, Op2>& b) {      \
+    return MatrixExpression<Ty, N, M, MatrixExpression<Ty, N, M, L1, R1, Op1>, MatrixExpression<Ty, N, M, L2, R2, Op2>,         \
+                            detail::op>(a, b);                                                                                  \
   }
 
-MATRIX_WITH_MATRIX_OPERATOR(+, +);
-MATRIX_WITH_MATRIX_OPERATOR(-, -);
+MATRIX_WITH_MATRIX_OPERATOR(+, add);
+MATRIX_WITH_MATRIX_OPERATOR(-, subtract);
 #undef MATRIX_WITH_MATRIX_OPERATOR
 
 #define MATRIX_WITH_SCALAR_OPERATOR(op_symbol, op)                              \
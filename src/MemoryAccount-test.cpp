@@ -0,0 +1,143 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/init.h>
+#include "MemoryAccount.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define WORKERS (4)
+#define ITERATIONS (100000)
+#define BIG_BUFFER (32 * 1024 * 1024)
+
+static MemoryAccount s_account;
+
+// Allocates and frees all the time, like receive threads that grow their draw buffers
+class Worker : public wxThread {
+ public:
+  Worker(MemoryUse use) : wxThread(wxTHREAD_JOINABLE) { m_use = use; }
+
+  void *Entry(void) {
+    for (int i = 0; i < ITERATIONS; i++) {
+      s_account.Allocated(m_use, 100);
+      s_account.Resized(m_use, 100, 300);
+      s_account.Freed(m_use, 200);
+    }
+    return 0;
+  }
+
+ private:
+  MemoryUse m_use;
+};
+
+static int TestAccount() {
+  int ret = 0;
+
+  Worker *workers[WORKERS];
+  for (int i = 0; i < WORKERS; i++) {
+    workers[i] = new Worker(i % 2 ? MEMORY_TRAILS : MEMORY_DRAW);
+    workers[i]->Run();
+  }
+  for (int i = 0; i < WORKERS; i++) {
+    workers[i]->Wait();
+    delete workers[i];
+  }
+
+  size_t expected = (size_t)WORKERS / 2 * ITERATIONS * 100;
+  if (s_account.GetBytes(MEMORY_TRAILS) != expected || s_account.GetBytes(MEMORY_DRAW) != expected) {
+    cout << "ERROR: counted " << s_account.GetBytes(MEMORY_TRAILS) << " and " << s_account.GetBytes(MEMORY_DRAW)
+         << " bytes instead of " << expected << "\n";
+    ret = 1;
+  }
+  if (s_account.GetTotal() != 2 * expected) {
+    cout << "ERROR: total is " << s_account.GetTotal() << "\n";
+    ret = 1;
+  }
+
+  wxString summary = s_account.GetSummary();
+  cout << "INFO: " << summary.ToAscii();
+  if (summary.Find(wxT("trails")) == wxNOT_FOUND || summary.Find(wxT("history")) != wxNOT_FOUND) {
+    cout << "ERROR: summary does not show just the uses that hold memory\n";
+    ret = 1;
+  }
+
+  s_account.Freed(MEMORY_TRAILS, expected);
+  s_account.Freed(MEMORY_DRAW, expected);
+  if (s_account.GetTotal() != 0) {
+    cout << "ERROR: " << s_account.GetTotal() << " bytes left after freeing all\n";
+    ret = 1;
+  }
+  return ret;
+}
+
+static int TestResident() {
+  size_t before = GetResidentMemory();
+
+  if (before == 0) {
+    cout << "INFO: resident memory is not known on this OS\n";
+    return 0;
+  }
+
+  // Memory only becomes resident once it is touched, volatile so the compiler does not skip that
+  volatile uint8_t *big = (volatile uint8_t *)malloc(BIG_BUFFER);
+  for (size_t i = 0; i < BIG_BUFFER; i += 1024) {
+    big[i] = 1;
+  }
+  size_t after = GetResidentMemory();
+  free((void *)big);
+
+  cout << "INFO: resident " << before / 1024 << " kB, after touching " << BIG_BUFFER / 1024 << " kB " << after / 1024
+       << " kB\n";
+  if (after < before + BIG_BUFFER / 2) {
+    cout << "ERROR: resident memory did not grow\n";
+    return 1;
+  }
+  return 0;
+}
+
+int main() {
+  wxInitializer initializer;  // needed for wxThread
+  int ret = 0;
+
+  ret |= TestAccount();
+  ret |= TestResident();
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
@@ -0,0 +1,122 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "MemoryAccount.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+PLUGIN_BEGIN_NAMESPACE
+
+#ifdef _MSC_VER
+#define ATOMIC_ADD(p, n) InterlockedExchangeAdd((volatile LONG *)(p), (LONG)(n))
+#define ATOMIC_SUBTRACT(p, n) InterlockedExchangeAdd((volatile LONG *)(p), -(LONG)(n))
+#else
+#define ATOMIC_ADD(p, n) __sync_add_and_fetch(p, n)
+#define ATOMIC_SUBTRACT(p, n) __sync_sub_and_fetch(p, n)
+#endif
+
+#define MEGABYTE (1024. * 1024.)
+
+const char *memory_use_names[MEMORY_USES] = {"history", "lookup", "trails", "draw", "arpa"};
+
+MemoryAccount g_shared_memory;
+
+MemoryAccount::MemoryAccount() {
+  for (int use = 0; use < MEMORY_USES; use++) {
+    m_bytes[use] = 0;
+  }
+}
+
+void MemoryAccount::Allocated(MemoryUse use, size_t bytes) { ATOMIC_ADD(&m_bytes[use], (long)bytes); }
+
+void MemoryAccount::Freed(MemoryUse use, size_t bytes) { ATOMIC_SUBTRACT(&m_bytes[use], (long)bytes); }
+
+void MemoryAccount::Resized(MemoryUse use, size_t from, size_t to) {
+  if (to > from) {
+    Allocated(use, to - from);
+  } else if (to < from) {
+    Freed(use, from - to);
+  }
+}
+
+size_t MemoryAccount::GetTotal() const {
+  size_t total = 0;
+
+  for (int use = 0; use < MEMORY_USES; use++) {
+    total += GetBytes((MemoryUse)use);
+  }
+  return total;
+}
+
+wxString MemoryAccount::GetSummary() const {
+  wxString summary = wxString::Format(wxT("memory %.1f MB:"), GetTotal() / MEGABYTE);
+
+  for (int use = 0; use < MEMORY_USES; use++) {
+    size_t bytes = GetBytes((MemoryUse)use);
+    if (bytes > 0) {
+      summary << wxString::Format(wxT(" %s %.1f"), wxString::FromAscii(memory_use_names[use]).c_str(), bytes / MEGABYTE);
+    }
+  }
+  summary << wxT("\n");
+  return summary;
+}
+
+size_t GetResidentMemory() {
+#if defined(__linux__)
+  FILE *f = fopen("/proc/self/statm", "r");
+  unsigned long size, resident;
+  size_t ret = 0;
+
+  if (f) {
+    if (fscanf(f, "%lu %lu", &size, &resident) == 2) {
+      ret = (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+    }
+    fclose(f);
+  }
+  return ret;
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS) {
+    return (size_t)info.resident_size;
+  }
+  return 0;
+#else
+  return 0;
+#endif
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,75 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _MEMORYACCOUNT_H_
+#define _MEMORYACCOUNT_H_
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Keeps count of the large buffers that a radar holds, per use, so the statistics can show where
+// the memory goes. The counts are changed with atomic adds so any thread can allocate or free
+// without taking a lock; a buffer must be freed from the same account it was allocated in.
+//
+
+enum MemoryUse { MEMORY_HISTORY, MEMORY_LOOKUP, MEMORY_TRAILS, MEMORY_DRAW, MEMORY_ARPA, MEMORY_USES };
+
+extern const char *memory_use_names[MEMORY_USES];
+
+class MemoryAccount {
+ public:
+  MemoryAccount();
+
+  void Allocated(MemoryUse use, size_t bytes);
+  void Freed(MemoryUse use, size_t bytes);
+  void Resized(MemoryUse use, size_t from, size_t to);
+
+  size_t GetBytes(MemoryUse use) const { return (size_t)m_bytes[use]; }
+  size_t GetTotal() const;
+
+  // "memory 12.3 MB: history 2.0 trails 10.3", uses that hold nothing are left out
+  wxString GetSummary() const;
+
+ private:
+  volatile long m_bytes[MEMORY_USES];
+};
+
+// Buffers that are shared by all radars that need the same one
+extern MemoryAccount g_shared_memory;
+
+// Resident set size of the whole process in bytes, or 0 if the OS can't tell
+extern size_t GetResidentMemory();
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _MEMORYACCOUNT_H_ */
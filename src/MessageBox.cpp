@@ -38,6 +38,8 @@ PLUGIN_BEGIN_NAMESPACE
 enum {  // process ID's
   ID_MSG_CLOSE,
   ID_MSG_HIDE,
+  ID_EXPORT_LATENCY,
+  ID_EXPORT_TRACE,
   ID_RADAR,
   ID_DATA,
   ID_HEADING,
@@ -56,6 +58,8 @@ BEGIN_EVENT_TABLE(MessageBox, wxDialog)
 EVT_CLOSE(MessageBox::OnClose)
 EVT_BUTTON(ID_MSG_CLOSE, MessageBox::OnMessageCloseButtonClick)
 EVT_BUTTON(ID_MSG_HIDE, MessageBox::OnMessageHideRadarClick)
+EVT_BUTTON(ID_EXPORT_LATENCY, MessageBox::OnExportLatencyClick)
+EVT_BUTTON(ID_EXPORT_TRACE, MessageBox::OnExportTraceClick)
 
 EVT_MOVE(MessageBox::OnMove)
 EVT_SIZE(MessageBox::OnSize)
@@ -199,6 +203,16 @@ void MessageBox::CreateControls() {
   m_statistics->SetFont(GetOCPNGUIScaledFont_PlugIn(_T("StatusBar")));
   m_info_sizer->Add(m_statistics, 0, wxALIGN_CENTER_HORIZONTAL | wxST_NO_AUTORESIZE, BORDER);
 
+  wxButton *export_latency = new wxButton(this, ID_EXPORT_LATENCY, _("Export latency"), wxDefaultPosition, wxDefaultSize, 0);
+  export_latency->SetFont(m_pi->m_font);
+  m_info_sizer->Add(export_latency, 0, wxALIGN_CENTER_HORIZONTAL | wxALL, BORDER);
+
+  // Without a TraceFile in the configuration tracing is off until it is started here
+  m_trace_button = new wxButton(this, ID_EXPORT_TRACE, g_trace_enabled ? _("Export trace") : _("Start trace"),
+                                wxDefaultPosition, wxDefaultSize, 0);
+  m_trace_button->SetFont(m_pi->m_font);
+  m_info_sizer->Add(m_trace_button, 0, wxALIGN_CENTER_HORIZONTAL | wxALL, BORDER);
+
   // The <Close> button
   m_close_button = new wxButton(this, ID_MSG_CLOSE, _("&Close"), wxDefaultPosition, wxDefaultSize, 0);
   m_message_sizer->Add(m_close_button, 0, wxALL, BORDER);
@@ -251,7 +265,7 @@ bool MessageBox::Show(bool show) {
 
 bool MessageBox::UpdateMessage(bool force) {
   message_status new_message_state = HIDE;
-  time_t now = time(0);
+  time_t now = GetRadarTime();
 
   bool haveOpenGL = m_pi->IsOpenGLEnabled();
   bool haveGPS = m_pi->IsBoatPositionValid();
@@ -408,6 +422,32 @@ void MessageBox::OnMessageHideRadarClick(wxCommandEvent &event) {
   m_pi->NotifyRadarWindowViz();
 }
 
+void MessageBox::OnExportLatencyClick(wxCommandEvent &event) {
+  wxFileDialog *saveDialog = new wxFileDialog(this, _("Export latency histograms"), wxT(""), wxT("radar_latency.csv"),
+                                              _("CSV files (*.csv)|*.csv|All files (*.*)|*.*"),
+                                              wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+  if (saveDialog->ShowModal() == wxID_OK) {
+    m_pi->ExportLatency(saveDialog->GetPath());
+  }
+  saveDialog->Destroy();
+}
+
+void MessageBox::OnExportTraceClick(wxCommandEvent &event) {
+  if (!g_trace_enabled) {
+    m_pi->StartTrace();
+    m_trace_button->SetLabel(_("Export trace"));
+    return;
+  }
+
+  wxFileDialog *saveDialog = new wxFileDialog(this, _("Export trace"), wxT(""), wxT("radar_trace.json"),
+                                              _("JSON files (*.json)|*.json|All files (*.*)|*.*"),
+                                              wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+  if (saveDialog->ShowModal() == wxID_OK) {
+    m_pi->ExportTrace(saveDialog->GetPath());
+  }
+  saveDialog->Destroy();
+}
+
 void MessageBox::SetTrueHeadingInfo(wxString &msg) {
   wxString label;
 
@@ -102,6 +102,8 @@ class MessageBox : public wxDialog {
 
   void OnMessageCloseButtonClick(wxCommandEvent &event);
   void OnMessageHideRadarClick(wxCommandEvent &event);
+  void OnExportLatencyClick(wxCommandEvent &event);
+  void OnExportTraceClick(wxCommandEvent &event);
 
   bool IsModalDialogShown();
 
@@ -130,6 +132,7 @@ class MessageBox : public wxDialog {
   // MessageBox
   wxButton *m_close_button;
   wxButton *m_hide_radar;
+  wxButton *m_trace_button;  // Starts tracing, then exports the trace
   wxCheckBox *m_have_open_gl;
   wxCheckBox *m_have_boat_pos;
   wxCheckBox *m_have_true_heading;
@@ -0,0 +1,221 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/stopwatch.h>
+#include "NmeaHeading.h"
+#include "nmea0183/nmea0183.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define LOOPS (20000)
+
+struct HeadingCase {
+  const char *sentence;
+  NmeaHeadingType type;
+  double heading;
+  double variation;
+};
+
+#define NONE (-999.)  // Expect NaN
+
+// Sentences without "*" get a correct checksum added, the ones with "*" are used as they are
+static const HeadingCase cases[] = {
+    {"$HCHDG,98.3,0.0,E,12.6,W", NMEA_HEADING_HDG, 98.3, -12.6},
+    {"$HCHDG,98.3,,,12.6,E", NMEA_HEADING_HDG, 98.3, 12.6},
+    {"$HCHDG,271.05,,,,", NMEA_HEADING_HDG, 271.05, NONE},
+    {"$HCHDG,,,,7.1,W", NMEA_HEADING_HDG, NONE, -7.1},
+    {"$IIHDM,238.5,M", NMEA_HEADING_HDM, 238.5, NONE},
+    {"$IIHDM,,M", NMEA_HEADING_HDM, NONE, NONE},
+    {"$GPHDT,274.07,T", NMEA_HEADING_HDT, 274.07, NONE},
+    {"$HEHDT,0.5,T", NMEA_HEADING_HDT, 0.5, NONE},
+    {"$HEHDT,,T", NMEA_HEADING_HDT, NONE, NONE},
+    {"$HEHDT,1.5,T*2b", NMEA_HEADING_HDT, 1.5, NONE},          // Lower case checksum
+    {"$HEHDT,12.3,T", NMEA_HEADING_HDT, 12.3, NONE},           // No checksum, WithChecksum() leaves it
+    {"$HEHDT,12.3,T*00", NMEA_HEADING_NONE, NONE, NONE},       // Wrong checksum
+    {"$HEHDT,12.3,T*ZZ", NMEA_HEADING_NONE, NONE, NONE},       // Not a checksum
+    {"$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W", NMEA_HEADING_NONE, NONE, NONE},
+    {"$PGRMH,A,1,2,3", NMEA_HEADING_NONE, NONE, NONE},  // Proprietary, even though it has H at [3]
+    {"$GPHDX,1.0,T", NMEA_HEADING_NONE, NONE, NONE},
+    {"!AIVDM,1,1,,A,13u?etPv2;0n:dDPwUM1U1Cb069D,0", NMEA_HEADING_NONE, NONE, NONE},
+    {"$GPHD", NMEA_HEADING_NONE, NONE, NONE},
+    {"", NMEA_HEADING_NONE, NONE, NONE},
+};
+
+// The sentences OpenCPN forwards most, none of them a heading
+static const char *traffic[] = {
+    "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W",
+    "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,",
+    "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K",
+    "$GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45",
+    "$IIMWV,214.8,R,0.1,K,A",
+    "$SDDPT,12.3,0.5",
+    "!AIVDM,1,1,,A,13u?etPv2;0n:dDPwUM1U1Cb069D,0",
+};
+
+static wxString WithChecksum(const char *body) {
+  wxString s = wxString::FromAscii(body);
+  unsigned checksum = 0;
+
+  if (*body != '$' || strchr(body, '*') || strcmp(body, "$HEHDT,12.3,T") == 0) {
+    return s;
+  }
+  for (const char *p = body + 1; *p; p++) {
+    checksum ^= (unsigned char)*p;
+  }
+  s << wxString::Format(wxT("*%02X\r\n"), checksum);
+  return s;
+}
+
+static bool Same(double actual, double expected) {
+  return (expected == NONE) ? wxIsNaN(actual) : fabs(actual - expected) < 1e-9;
+}
+
+// What radar_pi::SetNMEASentence did before, returns the same values for the HDx sentences
+static NmeaHeadingType ParseWithNMEA0183(NMEA0183 &nmea, wxString &sentence, NmeaHeading *result) {
+  nmea << sentence;
+  if (!nmea.PreParse()) {
+    return NMEA_HEADING_NONE;
+  }
+  result->variation = nan("");
+  if (nmea.LastSentenceIDReceived == _T("HDG") && nmea.Parse()) {
+    result->heading = nmea.Hdg.MagneticSensorHeadingDegrees;
+    if (!wxIsNaN(nmea.Hdg.MagneticVariationDegrees)) {
+      result->variation = nmea.Hdg.MagneticVariationDirection == East ? nmea.Hdg.MagneticVariationDegrees
+                                                                      : -nmea.Hdg.MagneticVariationDegrees;
+    }
+    return NMEA_HEADING_HDG;
+  }
+  if (nmea.LastSentenceIDReceived == _T("HDM") && nmea.Parse()) {
+    result->heading = nmea.Hdm.DegreesMagnetic;
+    return NMEA_HEADING_HDM;
+  }
+  if (nmea.LastSentenceIDReceived == _T("HDT") && nmea.Parse()) {
+    result->heading = nmea.Hdt.DegreesTrue;
+    return NMEA_HEADING_HDT;
+  }
+  return NMEA_HEADING_NONE;
+}
+
+static int TestCases() {
+  NMEA0183 nmea;
+  int ret = 0;
+
+  for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+    const HeadingCase &c = cases[i];
+    wxString sentence = WithChecksum(c.sentence);
+    const wxCharBuffer ascii = sentence.ToAscii();
+    NmeaHeading narrow, wide, old;
+
+    // Both the char and the wxChar version of the parser, as the wxString build decides which one is used
+    NmeaHeadingType narrow_type = ParseNmeaHeading((const char *)ascii, strlen(ascii), &narrow);
+    NmeaHeadingType wide_type = ParseNmeaHeading(sentence, &wide);
+    if (narrow_type != c.type || wide_type != c.type) {
+      cout << "ERROR: " << ascii << " is type " << narrow_type << "/" << wide_type << " instead of " << c.type << "\n";
+      ret = 1;
+      continue;
+    }
+    if (c.type == NMEA_HEADING_NONE) {
+      continue;
+    }
+    if (!Same(narrow.heading, c.heading) || !Same(narrow.variation, c.variation) || !Same(wide.heading, c.heading) ||
+        !Same(wide.variation, c.variation)) {
+      cout << "ERROR: " << ascii << " gives heading " << narrow.heading << " variation " << narrow.variation << "\n";
+      ret = 1;
+    }
+
+    // The library agrees, as long as the sentence has a checksum it accepts
+    if (c.heading != NONE && ParseWithNMEA0183(nmea, sentence, &old) == c.type &&
+        (!Same(old.heading, c.heading) || (c.type == NMEA_HEADING_HDG && !Same(old.variation, c.variation)))) {
+      cout << "ERROR: " << ascii << " gives heading " << old.heading << " variation " << old.variation << " with NMEA0183\n";
+      ret = 1;
+    }
+  }
+  return ret;
+}
+
+// Rejecting the sentences that are not a heading is what SetNMEASentence does most
+static int TestRejectSpeed() {
+  wxString sentences[ARRAY_SIZE(traffic)];
+  NMEA0183 nmea;
+  NmeaHeading result;
+  size_t n = ARRAY_SIZE(traffic);
+  int rejected = 0;
+  int ret = 0;
+
+  for (size_t i = 0; i < n; i++) {
+    sentences[i] = WithChecksum(traffic[i]);
+  }
+
+  wxStopWatch stopwatch;
+  for (int l = 0; l < LOOPS; l++) {
+    for (size_t i = 0; i < n; i++) {
+      rejected += ParseNmeaHeading(sentences[i], &result) == NMEA_HEADING_NONE;
+    }
+  }
+  double fast_ns = stopwatch.TimeInMicro().ToDouble() * 1000. / (LOOPS * n);
+
+  stopwatch.Start();
+  for (int l = 0; l < LOOPS / 10; l++) {
+    for (size_t i = 0; i < n; i++) {
+      rejected += ParseWithNMEA0183(nmea, sentences[i], &result) == NMEA_HEADING_NONE;
+    }
+  }
+  double old_ns = stopwatch.TimeInMicro().ToDouble() * 1000. / (LOOPS / 10 * n);
+
+  cout << "INFO: rejecting a non-heading sentence takes " << fast_ns << " ns, with NMEA0183 PreParse " << old_ns << " ns\n";
+  if (rejected != (LOOPS + LOOPS / 10) * (int)n) {
+    cout << "ERROR: " << (LOOPS + LOOPS / 10) * (int)n - rejected << " non-heading sentences were accepted\n";
+    ret = 1;
+  }
+  if (fast_ns >= old_ns) {
+    cout << "ERROR: the prefilter is not faster than NMEA0183\n";
+    ret = 1;
+  }
+  return ret;
+}
+
+int main() {
+  int ret = 0;
+
+  ret |= TestCases();
+  ret |= TestRejectSpeed();
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
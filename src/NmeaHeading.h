@@ -0,0 +1,190 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _NMEAHEADING_H_
+#define _NMEAHEADING_H_
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Fast path for the NMEA sentences that OpenCPN forwards to SetNMEASentence.
+//
+// Only HDG, HDM and HDT are of interest, and they are a small fraction of the stream.
+// The sentence ID is checked on the raw characters first, so all other sentences are
+// rejected after a few compares. The three heading sentences are parsed in place,
+// including the checksum, without creating wxString or SENTENCE objects.
+// Like the NMEA0183 library a sentence without checksum is accepted, and an empty field
+// results in NaN. The parser works on wx_str() characters, which are wchar_t or char depending
+// on the wxWidgets build; use the wxString overload, which passes the right length for either.
+//
+enum NmeaHeadingType { NMEA_HEADING_NONE, NMEA_HEADING_HDG, NMEA_HEADING_HDM, NMEA_HEADING_HDT };
+
+struct NmeaHeading {
+  double heading;    // HDG/HDM: magnetic heading, HDT: true heading
+  double variation;  // HDG only: magnetic variation, East is positive
+};
+
+template <typename Ch>
+class NmeaHeadingParser {
+ public:
+  NmeaHeadingParser(const Ch *sentence, size_t len) : m_p(sentence), m_end(sentence + len) {}
+
+  NmeaHeadingType Parse(NmeaHeading *result) {
+    // $ttHDx, where tt is the talker, but not a proprietary $P... sentence
+    if (m_end - m_p < 7 || m_p[0] != '$' || m_p[1] == 'P' || m_p[3] != 'H' || m_p[4] != 'D' || m_p[6] != ',') {
+      return NMEA_HEADING_NONE;
+    }
+
+    NmeaHeadingType type;
+    switch (m_p[5]) {
+      case 'G':
+        type = NMEA_HEADING_HDG;
+        break;
+      case 'M':
+        type = NMEA_HEADING_HDM;
+        break;
+      case 'T':
+        type = NMEA_HEADING_HDT;
+        break;
+      default:
+        return NMEA_HEADING_NONE;
+    }
+
+    if (!ChecksumOK()) {
+      return NMEA_HEADING_NONE;
+    }
+
+    m_p += 7;  // First field
+    result->heading = Number();
+    result->variation = nan("");
+    if (type == NMEA_HEADING_HDG) {
+      Skip();  // Deviation
+      Skip();  // Deviation direction
+      double variation = Number();
+      if (!wxIsNaN(variation)) {
+        result->variation = (m_p < m_end && *m_p == 'E') ? variation : -variation;
+      }
+    }
+    return type;
+  }
+
+ private:
+  const Ch *m_p;
+  const Ch *m_end;
+
+  static int HexDigit(Ch c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+  }
+
+  bool ChecksumOK() {
+    unsigned checksum = 0;
+    const Ch *p;
+
+    for (p = m_p + 1; p < m_end && *p != '*' && *p != '\r' && *p != '\n'; p++) {
+      checksum ^= (unsigned)*p;
+    }
+    if (p + 2 >= m_end || *p != '*') {
+      return true;  // Checksums are optional
+    }
+    int hi = HexDigit(p[1]);
+    int lo = HexDigit(p[2]);
+    return hi >= 0 && lo >= 0 && (unsigned)(hi * 16 + lo) == (checksum & 0xff);
+  }
+
+  static bool EndOfField(Ch c) { return c == ',' || c == '*' || c == '\r' || c == '\n'; }
+
+  // Skip the current field and its separator
+  void Skip() {
+    while (m_p < m_end && !EndOfField(*m_p)) {
+      m_p++;
+    }
+    if (m_p < m_end && *m_p == ',') {
+      m_p++;
+    }
+  }
+
+  // Parse the current field as decimal number, and skip it
+  double Number() {
+    bool negative = false;
+    bool digits = false;
+    double value = 0.;
+    double scale = 1.;
+
+    if (m_p < m_end && (*m_p == '-' || *m_p == '+')) {
+      negative = *m_p == '-';
+      m_p++;
+    }
+    for (; m_p < m_end && *m_p >= '0' && *m_p <= '9'; m_p++) {
+      value = value * 10. + (*m_p - '0');
+      digits = true;
+    }
+    if (m_p < m_end && *m_p == '.') {
+      for (m_p++; m_p < m_end && *m_p >= '0' && *m_p <= '9'; m_p++) {
+        value = value * 10. + (*m_p - '0');
+        scale *= 10.;
+        digits = true;
+      }
+    }
+    Skip();
+    if (!digits) {
+      return nan("");
+    }
+    value /= scale;
+    return negative ? -value : value;
+  }
+};
+
+template <typename Ch>
+NmeaHeadingType ParseNmeaHeading(const Ch *sentence, size_t len, NmeaHeading *result) {
+  NmeaHeadingParser<Ch> parser(sentence, len);
+
+  return parser.Parse(result);
+}
+
+// In a UTF-8 build length() counts characters, not the bytes that wx_str() points to, so
+// there the UTF-8 bytes are parsed with their own length. utf8_str() does not copy then.
+inline NmeaHeadingType ParseNmeaHeading(const wxString &sentence, NmeaHeading *result) {
+#if wxUSE_UNICODE_WCHAR
+  return ParseNmeaHeading(sentence.wx_str(), sentence.length(), result);
+#else
+  const wxScopedCharBuffer utf8 = sentence.utf8_str();
+  return ParseNmeaHeading(utf8.data(), utf8.length(), result);
+#endif
+}
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _NMEAHEADING_H_ */
@@ -0,0 +1,159 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/stopwatch.h>
+#include "NmeaSentence.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define TARGETS (1000)
+
+struct TestTarget {
+  int id;
+  double dist;
+  double bearing;
+  double speed;
+  double course;
+};
+
+// The way ArpaTarget::PassARPAtoOCPN used to build the sentence, but with the precision that is sent now
+static wxString FormatWithPrintf(const TestTarget &t) {
+  wxString s_TargID, s_speed, s_course, s_distance, s_bearing, s_target_name, nmea;
+  char sentence[90];
+  char checksum = 0;
+  char *p;
+
+  s_TargID = wxString::Format(wxT("%2i"), t.id);
+  s_speed = wxString::Format(wxT("%.2f"), t.speed);
+  s_course = wxString::Format(wxT("%.1f"), t.course);
+  s_target_name = wxString::Format(wxT("ARPA%2i"), t.id);
+  s_distance = wxString::Format(wxT("%.3f"), t.dist);
+  s_bearing = wxString::Format(wxT("%.2f"), t.bearing);
+
+  snprintf(sentence, sizeof(sentence), "RATTM,%2s,%s,%s,%s,%s,%s,%s, , ,%s,%s,%s, ", (const char *)s_TargID.mb_str(),
+           (const char *)s_distance.mb_str(), (const char *)s_bearing.mb_str(), "", (const char *)s_speed.mb_str(),
+           (const char *)s_course.mb_str(), "T", "N", (const char *)s_target_name.mb_str(), "T");
+
+  for (p = sentence; *p; p++) {
+    checksum ^= *p;
+  }
+  nmea.Printf(wxT("$%s*%02X\r\n"), sentence, (unsigned)checksum);
+  return nmea;
+}
+
+static const char *FormatWithBuilder(NmeaSentence *nmea, const TestTarget &t) {
+  nmea->Begin("RATTM");
+  nmea->AddInt(t.id, 2);
+  nmea->AddFixed(t.dist, 3);
+  nmea->AddFixed(t.bearing, 2);
+  nmea->AddField("");
+  nmea->AddFixed(t.speed, 2);
+  nmea->AddFixed(t.course, 1);
+  nmea->AddChar('T');
+  nmea->AddChar(' ');
+  nmea->AddChar(' ');
+  nmea->AddChar('N');
+  nmea->AddField("ARPA");
+  nmea->AppendInt(t.id, 2);
+  nmea->AddChar('T');
+  nmea->AddChar(' ');
+  return nmea->Finish();
+}
+
+int main() {
+  int ret = 0;
+  static TestTarget target[TARGETS];
+  static NmeaSentence nmea[TARGETS];
+
+  srand(1);
+  for (int i = 0; i < TARGETS; i++) {
+    target[i].id = i % 100;
+    target[i].dist = (rand() % 12000) / 1000.;
+    target[i].bearing = (rand() % 36000) / 100.;
+    target[i].speed = (rand() % 3000) / 100.;
+    target[i].course = (rand() % 3600) / 10.;
+  }
+
+  for (int i = 0; i < TARGETS; i++) {
+    wxString expected = FormatWithPrintf(target[i]);
+    wxString actual = wxString::FromAscii(FormatWithBuilder(&nmea[i], target[i]));
+    if (actual != expected) {
+      cout << "ERROR: sentence " << i << " is " << actual.mb_str() << " instead of " << expected.mb_str() << "\n";
+      ret = 1;
+    }
+  }
+
+  // Unlike printf there is no negative zero, and halves are rounded away from zero
+  NmeaSentence fixed;
+  fixed.AddFixed(-0.0004, 3);
+  fixed.AddFixed(-1.25, 1);
+  fixed.AddFixed(9.9996, 3);
+  fixed.AddInt(-42, 4);
+  if (strcmp(fixed.Finish(), "$,0.000,-1.3,10.000, -42*3B\r\n") != 0) {
+    cout << "ERROR: fixed point formatting gives " << fixed.GetSentence() << "\n";
+    ret = 1;
+  }
+
+  // Benchmark
+  const int loops = 100;
+  size_t len = 0;
+
+  wxStopWatch stopwatch;
+  for (int l = 0; l < loops; l++) {
+    for (int i = 0; i < TARGETS; i++) {
+      len += FormatWithPrintf(target[i]).length();
+    }
+  }
+  double printf_ns = stopwatch.TimeInMicro().ToDouble() * 1000. / loops;
+
+  stopwatch.Start();
+  for (int l = 0; l < loops; l++) {
+    for (int i = 0; i < TARGETS; i++) {
+      FormatWithBuilder(&nmea[i], target[i]);
+      len += nmea[i].GetLength();
+    }
+  }
+  double builder_ns = stopwatch.TimeInMicro().ToDouble() * 1000. / loops;
+
+  cout << "INFO: " << TARGETS << " TTM sentences take " << printf_ns / 1000. << " us with wxString::Format, " << builder_ns / 1000.
+       << " us with NmeaSentence (" << len << ")\n";
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
@@ -0,0 +1,188 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _NMEASENTENCE_H_
+#define _NMEASENTENCE_H_
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define NMEA_SENTENCE_MAX (100)  // NMEA allows 82, TTM with long target names may be a bit longer
+
+//
+// Builds an NMEA sentence in a fixed buffer, computing the checksum as the fields are added.
+// Numbers are formatted as integer or fixed point, so there is no printf or wxString::Format
+// and no allocation involved.
+//
+// NmeaSentence s("RATTM");
+// s.AddInt(id, 2);
+// s.AddFixed(distance, 3);
+// ...
+// const char *nmea = s.Finish();  // "$RATTM, 1,0.123,...*4A\r\n"
+//
+// When a field would not fit it is truncated, the sentence remains well formed.
+//
+class NmeaSentence {
+ public:
+  NmeaSentence(const char *id) { Begin(id); }
+  NmeaSentence() { Begin(""); }
+
+  void Begin(const char *id) {
+    m_len = 0;
+    m_checksum = 0;
+    m_buf[m_len++] = '$';
+    for (; *id; id++) {
+      Put(*id);
+    }
+  }
+
+  // Start a new field
+  void Separator() { Put(','); }
+
+  void AddField(const char *s) {
+    Separator();
+    for (; *s; s++) {
+      Put(*s);
+    }
+  }
+
+  void AddChar(char c) {
+    Separator();
+    Put(c);
+  }
+
+  // Decimal integer, right aligned with spaces to width characters like printf("%*d")
+  void AddInt(int value, int width = 0) {
+    Separator();
+    AppendInt(value, width);
+  }
+
+  // Fixed point number with the given number of decimals like printf("%.*f")
+  void AddFixed(double value, int decimals) {
+    Separator();
+    AppendFixed(value, decimals);
+  }
+
+  void AppendChars(const char *s) {
+    for (; *s; s++) {
+      Put(*s);
+    }
+  }
+
+  void AppendInt(int value, int width = 0) {
+    char digits[12];
+    int n = 0;
+    unsigned v = (value < 0) ? (unsigned)-value : (unsigned)value;
+
+    do {
+      digits[n++] = (char)('0' + v % 10);
+      v /= 10;
+    } while (v > 0);
+    if (value < 0) {
+      digits[n++] = '-';
+    }
+    for (int i = n; i < width; i++) {
+      Put(' ');
+    }
+    while (n > 0) {
+      Put(digits[--n]);
+    }
+  }
+
+  void AppendFixed(double value, int decimals) {
+    static const double scale[] = {1., 10., 100., 1000., 10000., 100000., 1000000.};
+    if (decimals < 0) {
+      decimals = 0;
+    } else if (decimals > 6) {
+      decimals = 6;
+    }
+    if (wxIsNaN(value)) {
+      return;  // Leave the field empty
+    }
+    bool negative = value < 0.;
+    uint64_t v = (uint64_t)((negative ? -value : value) * scale[decimals] + 0.5);
+    uint64_t whole = v / (uint64_t)scale[decimals];
+    uint64_t fraction = v % (uint64_t)scale[decimals];
+    char digits[24];
+    int n = 0;
+
+    for (int i = 0; i < decimals; i++) {
+      digits[n++] = (char)('0' + fraction % 10);
+      fraction /= 10;
+    }
+    if (decimals > 0) {
+      digits[n++] = '.';
+    }
+    do {
+      digits[n++] = (char)('0' + whole % 10);
+      whole /= 10;
+    } while (whole > 0 && n < (int)sizeof(digits) - 1);
+    if (negative && v > 0) {
+      digits[n++] = '-';
+    }
+    while (n > 0) {
+      Put(digits[--n]);
+    }
+  }
+
+  // Append checksum and CR LF, and return the complete sentence
+  const char *Finish() {
+    static const char hex[] = "0123456789ABCDEF";
+
+    m_buf[m_len++] = '*';
+    m_buf[m_len++] = hex[(m_checksum >> 4) & 0xf];
+    m_buf[m_len++] = hex[m_checksum & 0xf];
+    m_buf[m_len++] = '\r';
+    m_buf[m_len++] = '\n';
+    m_buf[m_len] = 0;
+    return m_buf;
+  }
+
+  const char *GetSentence() const { return m_buf; }
+  size_t GetLength() const { return m_len; }
+
+ private:
+  char m_buf[NMEA_SENTENCE_MAX + 6];  // room for *hh\r\n and terminating zero
+  size_t m_len;
+  unsigned char m_checksum;
+
+  void Put(char c) {
+    if (m_len < NMEA_SENTENCE_MAX) {
+      m_buf[m_len++] = c;
+      m_checksum ^= (unsigned char)c;
+    }
+  }
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _NMEASENTENCE_H_ */
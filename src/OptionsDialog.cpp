@@ -99,6 +99,26 @@ OptionsDialog::OptionsDialog(wxWindow *parent, PersistentSettings &settings, Rad
                               this);
   m_GuardZoneTimeout->SetValue(wxString::Format(wxT("%d"), m_settings.guard_zone_timeout));
 
+  // ARPA collision alarm, sounds like the guard zone alarm
+
+  wxStaticText *arpaCPAAlarm =
+      new wxStaticText(this, wxID_ANY, _("ARPA CPA alarm (NM, 0 = off)"), wxDefaultPosition, wxDefaultSize, 0);
+  guardZoneSizer->Add(arpaCPAAlarm, 0, wxALIGN_CENTER_HORIZONTAL | wxALL, border_size);
+
+  m_ArpaCPAAlarm = new wxTextCtrl(this, wxID_ANY);
+  guardZoneSizer->Add(m_ArpaCPAAlarm, 1, wxALIGN_CENTER_HORIZONTAL | wxALL, border_size);
+  m_ArpaCPAAlarm->Connect(wxEVT_COMMAND_TEXT_UPDATED, wxCommandEventHandler(OptionsDialog::OnArpaCPAAlarmClick), NULL, this);
+  m_ArpaCPAAlarm->SetValue(wxString::Format(wxT("%.2f"), m_settings.arpa_cpa_alarm));
+
+  wxStaticText *arpaTCPAAlarm =
+      new wxStaticText(this, wxID_ANY, _("... when reached within (min)"), wxDefaultPosition, wxDefaultSize, 0);
+  guardZoneSizer->Add(arpaTCPAAlarm, 0, wxALIGN_CENTER_HORIZONTAL | wxALL, border_size);
+
+  m_ArpaTCPAAlarm = new wxTextCtrl(this, wxID_ANY);
+  guardZoneSizer->Add(m_ArpaTCPAAlarm, 1, wxALIGN_CENTER_HORIZONTAL | wxALL, border_size);
+  m_ArpaTCPAAlarm->Connect(wxEVT_COMMAND_TEXT_UPDATED, wxCommandEventHandler(OptionsDialog::OnArpaTCPAAlarmClick), NULL, this);
+  m_ArpaTCPAAlarm->SetValue(wxString::Format(wxT("%d"), m_settings.arpa_tcpa_alarm));
+
   // Drawing Method
 
   wxStaticBox *drawingMethodBox = new wxStaticBox(this, wxID_ANY, _("GPU drawing method"));
@@ -343,6 +363,20 @@ void OptionsDialog::OnGuardZoneTimeoutClick(wxCommandEvent &event) {
   m_settings.guard_zone_timeout = strtol(temp.c_str(), 0, 0);
 }
 
+void OptionsDialog::OnArpaCPAAlarmClick(wxCommandEvent &event) {
+  double value;
+
+  if (m_ArpaCPAAlarm->GetValue().ToDouble(&value) && value >= 0.) {
+    m_settings.arpa_cpa_alarm = value;
+  }
+}
+
+void OptionsDialog::OnArpaTCPAAlarmClick(wxCommandEvent &event) {
+  wxString temp = m_ArpaTCPAAlarm->GetValue();
+
+  m_settings.arpa_tcpa_alarm = wxMax(strtol(temp.c_str(), 0, 0), 0L);
+}
+
 void OptionsDialog::OnEnableCOGHeadingClick(wxCommandEvent &event) { m_settings.enable_cog_heading = m_COGHeading->GetValue(); }
 
 void OptionsDialog::OnTestSoundClick(wxCommandEvent &event) {
@@ -51,6 +51,8 @@ class OptionsDialog : public wxDialog {
   void OnGuardZoneOnOverlayClick(wxCommandEvent& event);
   void OnOverlayOnStandbyClick(wxCommandEvent& event);
   void OnGuardZoneTimeoutClick(wxCommandEvent& event);
+  void OnArpaCPAAlarmClick(wxCommandEvent& event);
+  void OnArpaTCPAAlarmClick(wxCommandEvent& event);
   void OnShowExtremeRangeClick(wxCommandEvent& event);
   void OnTrailsOnOverlayClick(wxCommandEvent& event);
   void OnTrailStartColourClick(wxCommandEvent& event);
@@ -79,6 +81,8 @@ class OptionsDialog : public wxDialog {
   wxRadioBox* m_DisplayMode;
   wxRadioBox* m_GuardZoneStyle;
   wxTextCtrl* m_GuardZoneTimeout;
+  wxTextCtrl* m_ArpaCPAAlarm;
+  wxTextCtrl* m_ArpaTCPAAlarm;
   wxColourPickerCtrl* m_TrailStartColour;
   wxColourPickerCtrl* m_TrailEndColour;
   wxColourPickerCtrl* m_WeakColour;
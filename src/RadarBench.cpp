@@ -0,0 +1,568 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/filefn.h>
+#include <wx/init.h>
+#include <wx/stopwatch.h>
+#include <vector>
+#include "GuardZoneIntervals.h"
+#include "Kalman.h"
+#include "RadarRaster.h"
+#include "RadarRecording.h"
+#include "RunLength.h"
+#include "TraceRecorder.h"
+#include "TrailBuffer.h"
+#include "socketutil.h"
+
+//
+// Measures the code that RadarInfo::ProcessRadarSpoke runs per spoke and that builds without
+// OpenCPN or OpenGL: the trail buffer, the guard zone bogey count, the ARPA search of the guard
+// zones, the software raster, run length coding and recording, plus the ARPA Kalman filter and
+// what a trace scope costs with tracing off and on. These are the same classes and functions that
+// the plugin calls. The spokes are made up for the geometry of every radar type, or read from a
+// recording.
+//
+// Not measured are the RadarInfo locks and its spoke history, target acquisition once the search
+// has found an echo (ARPA MultiPix and AcquireNewARPATarget) and the OpenGL draw methods.
+//
+// radar-bench [-r rotations] [-t type] [-o results.json] [recording.rpr]
+//
+
+// Count every allocation, so that we can see which stage allocates per spoke. The writer thread
+// of the recorder allocates too, so the counts of the record stage are not exact.
+static volatile uint64_t g_allocations = 0;
+static volatile uint64_t g_allocated_bytes = 0;
+
+void *operator new(size_t size) {
+  g_allocations++;
+  g_allocated_bytes += size;
+  void *p = malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) throw() { free(p); }
+void operator delete[](void *p) throw() { free(p); }
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define BENCH_ROTATIONS (20)      // Rotations per radar type unless given
+#define BENCH_RASTER_SIZE (1024)  // Pixels, about the size of a radar window
+#define BENCH_TARGETS (40)        // ARPA targets that are updated every rotation
+#define BENCH_RANGE (3000)        // Meters
+#define BENCH_THRESHOLD (100)     // Guard zone, trail and ARPA sample threshold
+#define BENCH_FILENAME wxT("radar-bench.rpr")
+
+struct BenchRadarType {
+  const wxChar *name;
+  size_t spokes;
+  size_t spoke_len;
+};
+
+static const BenchRadarType radar_types[] = {
+#define DEFINE_RADAR(t, x, s, l, a, b, c) {x, s, l},
+#include "RadarType.h"
+};
+
+struct BenchSpoke {
+  int angle;
+  int bearing;
+  int range_meters;
+  std::vector<uint8_t> data;
+};
+
+struct StageResult {
+  const char *name;
+  const char *unit;  // What one operation is
+  uint64_t operations;
+  double seconds;
+  uint64_t allocations;
+  uint64_t allocated_bytes;
+};
+
+// Measures one stage from construction until Stop()
+class StageTimer {
+ public:
+  StageTimer(StageResult *result, const char *name, const char *unit) {
+    m_result = result;
+    m_result->name = name;
+    m_result->unit = unit;
+    m_allocations = g_allocations;
+    m_allocated_bytes = g_allocated_bytes;
+    m_stopwatch.Start();
+  }
+
+  void Stop(uint64_t operations) {
+    m_result->seconds = m_stopwatch.TimeInMicro().ToDouble() / 1e6;
+    m_result->operations = operations;
+    m_result->allocations = g_allocations - m_allocations;
+    m_result->allocated_bytes = g_allocated_bytes - m_allocated_bytes;
+  }
+
+ private:
+  StageResult *m_result;
+  wxStopWatch m_stopwatch;
+  uint64_t m_allocations;
+  uint64_t m_allocated_bytes;
+};
+
+struct BenchResult {
+  wxString name;
+  size_t spokes;
+  size_t spoke_len;
+  uint64_t spokes_processed;
+  double spokes_per_second;  // All per spoke stages together, not the whole spoke path
+  uint64_t rss_bytes;        // Resident set size after the run, 0 when not known
+  std::vector<StageResult> stages;
+};
+
+static uint64_t GetResidentBytes() {
+#ifdef __linux__
+  FILE *f = fopen("/proc/self/statm", "r");
+  unsigned long size = 0;
+  unsigned long resident = 0;
+
+  if (f) {
+    if (fscanf(f, "%lu %lu", &size, &resident) != 2) {
+      resident = 0;
+    }
+    fclose(f);
+  }
+  return (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE);
+#else
+  return 0;
+#endif
+}
+
+// Something that looks like radar: mostly empty, with targets that span several spokes and
+// sea clutter near the boat.
+static void MakeRotation(size_t spokes, size_t spoke_len, std::vector<BenchSpoke> &input) {
+  input.resize(spokes);
+  for (size_t a = 0; a < spokes; a++) {
+    input[a].angle = (int)a;
+    input[a].bearing = (int)a;
+    input[a].range_meters = BENCH_RANGE;
+    input[a].data.assign(spoke_len, 0);
+  }
+  for (size_t t = 0; t < spokes / 10; t++) {
+    size_t angle = rand() % spokes;
+    size_t range = rand() % (spoke_len - spoke_len / 25);
+    size_t width = 1 + rand() % (spokes / 100 + 1);
+    size_t depth = 1 + rand() % (spoke_len / 30);
+    uint8_t strength = (uint8_t)(rand() % 256);
+    for (size_t a = angle; a < angle + width; a++) {
+      memset(&input[a % spokes].data[range], strength, wxMin(depth, spoke_len - range));
+    }
+  }
+  for (size_t a = 0; a < spokes; a++) {
+    for (size_t r = 0; r < spoke_len / 16; r++) {
+      input[a].data[r] = (uint8_t)(rand() % 256);
+    }
+  }
+}
+
+static bool ReadRecording(const wxString &filename, int rotations, BenchResult *result, std::vector<BenchSpoke> &input) {
+  RadarRecordingReader reader;
+  RecordingRecord record;
+
+  if (!reader.Open(filename)) {
+    return false;
+  }
+  result->name = reader.GetName();
+  result->spokes = reader.GetSpokes();
+  result->spoke_len = reader.GetSpokeLenMax();
+  while (input.size() < (size_t)rotations * result->spokes && reader.Next(&record)) {
+    if (record.type == RECORD_SPOKE && record.range_meters > 0) {
+      BenchSpoke spoke;
+      spoke.angle = record.angle;
+      spoke.bearing = record.bearing;
+      spoke.range_meters = record.range_meters;
+      spoke.data.assign(record.data, record.data + record.len);
+      input.push_back(spoke);
+    }
+  }
+  return !input.empty();
+}
+
+// Count the echoes in the guard zone of one spoke of the history, as GuardZone::SearchTargets does
+static size_t SearchZone(const GuardZoneIntervals &zone, int angle, const uint8_t *line, size_t spoke_len,
+                         double pixels_per_meter) {
+  size_t found = 0;
+
+  if ((angle & 1) || !zone.HasIntervals(angle)) {
+    return 0;
+  }
+  for (const GuardZoneInterval *p = zone.Begin(angle); p < zone.End(angle); p++) {
+    size_t start, end;
+    if (GuardZoneIntervals::GetSamples(p, pixels_per_meter, spoke_len, &start, &end)) {
+      for (size_t r = FindArpaSample(line, start, end); r < end; r = FindArpaSample(line, r + 1, end)) {
+        found++;
+      }
+    }
+  }
+  return found;
+}
+
+/*
+ * Run every stage over all spokes of the input, passes times, one stage after the other so that
+ * the time of each stage is known. Then run them interleaved per spoke, as in the plugin, for the
+ * number of spokes per second.
+ */
+static void RunBench(const std::vector<BenchSpoke> &input, int passes, BenchResult *result) {
+  size_t spokes = result->spokes;
+  size_t spoke_len = result->spoke_len;
+  uint64_t count = (uint64_t)input.size() * passes;
+  uint64_t rotations = wxMax(count / spokes, (uint64_t)1);
+  double pixels_per_meter = spoke_len / (double)BENCH_RANGE;
+  volatile size_t sink = 0;
+  StageResult stage;
+
+  GuardZoneIntervals arc;
+  GuardZoneIntervals polygon;
+  GuardZoneVertex vertex[] = {{10., 500.}, {60., 2500.}, {120., 800.}, {200., 2900.}, {300., 300.}};
+  arc.CompileArc(spokes, 300, 60, 200, 1500, false);
+  polygon.CompilePolygon(spokes, vertex, ARRAY_SIZE(vertex));
+
+  RadarRaster raster;
+  uint8_t map[RASTER_PALETTE_SIZE];
+  raster.Init(spokes, spoke_len, BENCH_RASTER_SIZE);
+  for (size_t i = 0; i < RASTER_PALETTE_SIZE; i++) {
+    map[i] = (uint8_t)(i / 16);
+    raster.SetPalette(i, (uint8_t)i, (uint8_t)(255 - i), 0, 255);
+  }
+
+  GuardZoneSpoke guard_spoke;
+  GuardZoneCounter arc_counter;
+  GuardZoneCounter polygon_counter;
+
+  // The spoke history has the ARPA bit set on every sample at or above the threshold
+  std::vector<std::vector<uint8_t> > history(input.size());
+  for (size_t i = 0; i < input.size(); i++) {
+    history[i] = input[i].data;
+    for (size_t r = 0; r < history[i].size(); r++) {
+      if (history[i][r] >= BENCH_THRESHOLD) {
+        history[i][r] |= 128;
+      }
+    }
+  }
+
+  PolarToCartesianLookup lookup(spokes, spoke_len);
+  TrailBuffer trails(spokes, spoke_len, &lookup);
+  uint8_t trail_colour[TRAIL_MAX_REVOLUTIONS + 1];
+  std::vector<uint8_t> trail_line(spoke_len);
+  GeoPosition boat;
+  for (size_t i = 0; i < ARRAY_SIZE(trail_colour); i++) {
+    trail_colour[i] = (uint8_t)(i ? 16 + i % 32 : 0);
+  }
+  boat.lat = 50.;
+  boat.lon = -5.;
+
+  std::vector<uint8_t> encoded;
+  encoded.reserve(2 * spoke_len);
+
+  RadarRecorder recorder;
+  recorder.Open(BENCH_FILENAME, result->name, 0, spokes, spoke_len);
+  wxLongLong start = wxGetUTCTimeMillis();
+
+  KalmanFilter filter(spokes);
+  Polar pol;
+  Polar expected;
+  LocalPosition x_local;
+  pol.angle = 5;
+  pol.r = 1000;
+  expected.angle = 10;
+  expected.r = 1050;
+  x_local.pos.lat = 50;
+  x_local.pos.lon = -5;
+  x_local.dlat_dt = 5;
+  x_local.dlon_dt = 2;
+
+  {
+    // Moving at about 10 knots, so that the true trails shift now and then
+    StageTimer timer(&stage, "trails", "spoke");
+    for (int p = 0; p < passes; p++) {
+      for (size_t i = 0; i < input.size(); i++) {
+        const BenchSpoke &s = input[i];
+        if (i % spokes == 0) {
+          boat.lat += 0.00006;
+          trails.UpdateTrailPosition(pixels_per_meter, &boat);
+        }
+        memcpy(&trail_line[0], &s.data[0], s.data.size());
+        trails.UpdateTrueTrails(s.bearing, &trail_line[0], s.data.size(), BENCH_THRESHOLD, trail_colour);
+        trails.UpdateRelativeTrails(s.angle, &trail_line[0], s.data.size(), BENCH_THRESHOLD, 0);
+      }
+    }
+    timer.Stop(count);
+    result->stages.push_back(stage);
+  }
+  {
+    StageTimer timer(&stage, "guard_zone", "spoke");
+    for (int p = 0; p < passes; p++) {
+      for (size_t i = 0; i < input.size(); i++) {
+        const BenchSpoke &s = input[i];
+        guard_spoke.Set(&s.data[0], s.data.size(), BENCH_THRESHOLD);  // Once per spoke, as RadarInfo does
+        sink += arc_counter.ProcessSpoke(s.angle, &arc, guard_spoke, pixels_per_meter);
+        sink += polygon_counter.ProcessSpoke(s.angle, &polygon, guard_spoke, pixels_per_meter);
+      }
+    }
+    sink += arc_counter.GetBogeyCount() + polygon_counter.GetBogeyCount();
+    timer.Stop(count);
+    result->stages.push_back(stage);
+  }
+  {
+    StageTimer timer(&stage, "arpa_search", "spoke");
+    for (int p = 0; p < passes; p++) {
+      for (size_t i = 0; i < input.size(); i++) {
+        const BenchSpoke &s = input[i];
+        sink += SearchZone(arc, s.angle, &history[i][0], history[i].size(), pixels_per_meter);
+        sink += SearchZone(polygon, s.angle, &history[i][0], history[i].size(), pixels_per_meter);
+      }
+    }
+    timer.Stop(count);
+    result->stages.push_back(stage);
+  }
+  {
+    StageTimer timer(&stage, "raster_spoke", "spoke");
+    for (int p = 0; p < passes; p++) {
+      for (size_t i = 0; i < input.size(); i++) {
+        const BenchSpoke &s = input[i];
+        raster.SetSpoke(s.bearing, &s.data[0], s.data.size(), map);
+      }
+    }
+    timer.Stop(count);
+    result->stages.push_back(stage);
+  }
+  {
+    StageTimer timer(&stage, "raster_render", "image");
+    for (uint64_t r = 0; r < rotations; r++) {
+      raster.Render(RASTER_RGBA, 1);
+    }
+    timer.Stop(rotations);
+    result->stages.push_back(stage);
+  }
+  {
+    StageTimer timer(&stage, "encode", "spoke");
+    for (int p = 0; p < passes; p++) {
+      for (size_t i = 0; i < input.size(); i++) {
+        const BenchSpoke &s = input[i];
+        encoded.clear();
+        RunLengthEncode(&s.data[0], s.data.size(), encoded);
+        sink += encoded.size();
+      }
+    }
+    timer.Stop(count);
+    result->stages.push_back(stage);
+  }
+  {
+    StageTimer timer(&stage, "record", "spoke");
+    uint64_t n = 0;
+    for (int p = 0; p < passes; p++) {
+      for (size_t i = 0; i < input.size(); i++, n++) {
+        const BenchSpoke &s = input[i];
+        recorder.RecordSpoke(s.angle, s.bearing, &s.data[0], s.data.size(), s.range_meters, start + wxLongLong((long)n));
+      }
+    }
+    timer.Stop(count);
+    result->stages.push_back(stage);
+  }
+  {
+    StageTimer timer(&stage, "kalman", "target");
+    for (uint64_t r = 0; r < rotations * BENCH_TARGETS; r++) {
+      filter.Predict(&x_local, 2.5);
+      filter.Update_P();
+      filter.SetMeasurement(&pol, &x_local, &expected, 1.);
+    }
+    timer.Stop(rotations * BENCH_TARGETS);
+    result->stages.push_back(stage);
+  }
+  for (int on = 0; on < 2; on++) {
+    StageTimer timer(&stage, on ? "trace_on" : "trace_idle", "scope");
+    TraceEnable(on != 0);
+    for (int p = 0; p < passes; p++) {
+      for (size_t i = 0; i < input.size(); i++) {
+        TRACE_SCOPE("bench");
+        sink += input[i].angle;
+      }
+    }
+    TraceEnable(false);
+    timer.Stop(count);
+    result->stages.push_back(stage);
+  }
+
+  // The per spoke stages together, in the order the receive thread calls them. The ARPA search
+  // runs on the GUI thread in the plugin, but over the same spokes.
+  wxStopWatch stopwatch;
+  uint64_t n = 0;
+  for (int p = 0; p < passes; p++) {
+    for (size_t i = 0; i < input.size(); i++, n++) {
+      const BenchSpoke &s = input[i];
+      TRACE_SCOPE("spoke");
+      guard_spoke.Set(&s.data[0], s.data.size(), BENCH_THRESHOLD);
+      sink += arc_counter.ProcessSpoke(s.angle, &arc, guard_spoke, pixels_per_meter);
+      sink += polygon_counter.ProcessSpoke(s.angle, &polygon, guard_spoke, pixels_per_meter);
+      sink += SearchZone(arc, s.angle, &history[i][0], history[i].size(), pixels_per_meter);
+      sink += SearchZone(polygon, s.angle, &history[i][0], history[i].size(), pixels_per_meter);
+      if (i % spokes == 0) {
+        boat.lat += 0.00006;
+        trails.UpdateTrailPosition(pixels_per_meter, &boat);
+      }
+      memcpy(&trail_line[0], &s.data[0], s.data.size());
+      trails.UpdateTrueTrails(s.bearing, &trail_line[0], s.data.size(), BENCH_THRESHOLD, trail_colour);
+      trails.UpdateRelativeTrails(s.angle, &trail_line[0], s.data.size(), BENCH_THRESHOLD, 0);
+      raster.SetSpoke(s.bearing, &trail_line[0], s.data.size(), map);
+      encoded.clear();
+      RunLengthEncode(&s.data[0], s.data.size(), encoded);
+      recorder.RecordSpoke(s.angle, s.bearing, &s.data[0], s.data.size(), s.range_meters, start + wxLongLong((long)n));
+      if ((n + 1) % spokes == 0) {
+        for (int t = 0; t < BENCH_TARGETS; t++) {
+          filter.Predict(&x_local, 2.5);
+          filter.Update_P();
+          filter.SetMeasurement(&pol, &x_local, &expected, 1.);
+        }
+      }
+    }
+  }
+  double seconds = stopwatch.TimeInMicro().ToDouble() / 1e6;
+  result->spokes_processed = count;
+  result->spokes_per_second = seconds > 0. ? count / seconds : 0.;
+
+  recorder.Close();
+  wxRemoveFile(BENCH_FILENAME);
+  result->rss_bytes = GetResidentBytes();
+}
+
+static void PrintResult(const BenchResult &result) {
+  cout << "INFO: " << (const char *)result.name.ToUTF8() << " " << result.spokes << "x" << result.spoke_len << ": "
+       << result.spokes_processed << " spokes, " << (uint64_t)result.spokes_per_second << " spokes/s through the spoke stages, RSS "
+       << result.rss_bytes / 1024 << " kB\n";
+  for (size_t i = 0; i < result.stages.size(); i++) {
+    const StageResult &stage = result.stages[i];
+    double ns = stage.operations ? stage.seconds * 1e9 / stage.operations : 0.;
+    cout << "INFO:   " << stage.name << ": " << ns << " ns/" << stage.unit << ", " << stage.allocations << " allocations, "
+         << stage.allocated_bytes << " bytes\n";
+  }
+}
+
+static void WriteJson(FILE *f, const std::vector<BenchResult> &results) {
+  fprintf(f, "{\n  \"scope\": \"spoke_stages\",\n  \"radars\": [\n");
+  for (size_t r = 0; r < results.size(); r++) {
+    const BenchResult &result = results[r];
+    fprintf(f, "    {\n      \"name\": \"%s\",\n", (const char *)result.name.ToUTF8());
+    fprintf(f, "      \"spokes\": %u,\n      \"spoke_len\": %u,\n", (unsigned)result.spokes, (unsigned)result.spoke_len);
+    fprintf(f, "      \"spokes_processed\": %llu,\n", (unsigned long long)result.spokes_processed);
+    fprintf(f, "      \"spokes_per_second\": %.0f,\n", result.spokes_per_second);
+    fprintf(f, "      \"rss_bytes\": %llu,\n      \"stages\": [\n", (unsigned long long)result.rss_bytes);
+    for (size_t i = 0; i < result.stages.size(); i++) {
+      const StageResult &stage = result.stages[i];
+      double ns = stage.operations ? stage.seconds * 1e9 / stage.operations : 0.;
+      fprintf(f, "        {\"name\": \"%s\", \"unit\": \"%s\", \"operations\": %llu, \"ns_per_operation\": %.1f, ", stage.name,
+              stage.unit, (unsigned long long)stage.operations, ns);
+      fprintf(f, "\"allocations\": %llu, \"allocated_bytes\": %llu}%s\n", (unsigned long long)stage.allocations,
+              (unsigned long long)stage.allocated_bytes, i + 1 < result.stages.size() ? "," : "");
+    }
+    fprintf(f, "      ]\n    }%s\n", r + 1 < results.size() ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+}
+
+int main(int argc, char *argv[]) {
+  wxInitializer initializer;  // needed for wxThread
+  int rotations = BENCH_ROTATIONS;
+  const char *type = 0;
+  const char *output = 0;
+  const char *recording = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      rotations = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      type = argv[++i];
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (argv[i][0] != '-') {
+      recording = argv[i];
+    } else {
+      cout << "usage: radar-bench [-r rotations] [-t type] [-o results.json] [recording.rpr]\n";
+      exit(1);
+    }
+  }
+  rotations = wxMax(rotations, 1);
+
+  std::vector<BenchResult> results;
+  srand(1);
+
+  if (recording) {
+    BenchResult result;
+    std::vector<BenchSpoke> input;
+
+    if (!ReadRecording(wxString::FromUTF8(recording), rotations, &result, input)) {
+      cout << "ERROR: cannot read spokes from " << recording << "\n";
+      exit(1);
+    }
+    RunBench(input, 1, &result);
+    PrintResult(result);
+    results.push_back(result);
+  } else {
+    for (size_t t = 0; t < ARRAY_SIZE(radar_types); t++) {
+      BenchResult result;
+      std::vector<BenchSpoke> input;
+
+      result.name = radar_types[t].name;
+      result.spokes = radar_types[t].spokes;
+      result.spoke_len = radar_types[t].spoke_len;
+      if (type && !strstr((const char *)result.name.ToUTF8(), type)) {
+        continue;
+      }
+      MakeRotation(result.spokes, result.spoke_len, input);
+      RunBench(input, rotations, &result);
+      PrintResult(result);
+      results.push_back(result);
+    }
+  }
+
+  if (output) {
+    FILE *f = fopen(output, "w");
+    if (!f) {
+      cout << "ERROR: cannot write " << output << "\n";
+      exit(1);
+    }
+    WriteJson(f, results);
+    fclose(f);
+  }
+  exit(0);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main(int argc, char *argv[]) { RadarPlugin::main(argc, argv); }
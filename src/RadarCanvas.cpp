@@ -262,25 +262,25 @@ void RadarCanvas::RenderRangeRingsAndHeading(int w, int h, float r) {
     }
   }
 
-  if (m_pi->GetHeadingSource() != HEADING_NONE) {
+  if (m_ri->HasHeading()) {
     double heading;
     double predictor;
     switch (m_ri->GetOrientation()) {
       case ORIENTATION_HEAD_UP:
-        heading = m_pi->GetHeadingTrue() + 180.;
+        heading = m_ri->GetHeadingTrue() + 180.;
         predictor = 180.;
         break;
       case ORIENTATION_STABILIZED_UP:
         heading = m_ri->m_course + 180.;
-        predictor = m_pi->GetHeadingTrue() + 180. - m_ri->m_course;
+        predictor = m_ri->GetHeadingTrue() + 180. - m_ri->m_course;
         break;
       case ORIENTATION_NORTH_UP:
         heading = 180;
-        predictor = m_pi->GetHeadingTrue() + 180;
+        predictor = m_ri->GetHeadingTrue() + 180;
         break;
       case ORIENTATION_COG_UP:
         heading = m_pi->GetCOG() + 180.;
-        predictor = m_pi->GetHeadingTrue() + 180. - heading;
+        predictor = m_ri->GetHeadingTrue() + 180. - heading;
         break;
     }
 
@@ -408,7 +408,7 @@ void RadarCanvas::RenderCursor(int w, int h, float radius) {
     distance = local_distance(pos, m_ri->m_mouse_pos) * 1852.;
     bearing = local_bearing(pos, m_ri->m_mouse_pos);
     if (m_ri->GetOrientation() != ORIENTATION_NORTH_UP) {
-      bearing -= m_pi->GetHeadingTrue();
+      bearing -= m_ri->GetHeadingTrue();
     }
     // LOG_DIALOG(wxT("radar_pi: Chart Mouse vrm=%f ebl=%f"), distance / 1852.0, bearing);
   }
@@ -534,7 +534,7 @@ void RadarCanvas::Render(wxPaintEvent &evt) {
   PlugIn_ViewPort vp;
   GeoPosition pos;
 
-  if (m_pi->GetHeadingSource() != HEADING_NONE && m_ri->GetRadarPosition(&pos) && m_ri->m_target_on_ppi.GetValue() > 0) {
+  if (m_ri->HasHeading() && m_ri->GetRadarPosition(&pos) && m_ri->m_target_on_ppi.GetValue() > 0) {
     // LAYER 2 - AIS AND ARPA TARGETS
 
     ResetGLViewPort(w, h);
@@ -548,7 +548,7 @@ void RadarCanvas::Render(wxPaintEvent &evt) {
     switch (m_ri->GetOrientation()) {
       case ORIENTATION_HEAD_UP:
       case ORIENTATION_STABILIZED_UP:
-        vp.rotation = deg2rad(-m_pi->GetHeadingTrue());
+        vp.rotation = deg2rad(-m_ri->GetHeadingTrue());
         break;
       case ORIENTATION_NORTH_UP:
         vp.rotation = 0.;
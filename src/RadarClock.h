@@ -0,0 +1,147 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RADARCLOCK_H_
+#define _RADARCLOCK_H_
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// The time as seen by the radar processing. Normally this is the wall clock, but when a
+// recorded session is replayed it is the time in the recording, so that a session can be
+// played faster (or slower) than it happened. Every radar has its own clock (RadarInfo::m_clock)
+// so that a replayed radar does not move the time of the others. Everything that compares against
+// times set by a radar's receiver (timeouts, trails, targets, guard zones) must read that radar's
+// clock; the rest of the plugin reads the process wide clock below.
+//
+class RadarClock {
+ public:
+  RadarClock() { m_coarse_time = 0; }
+  virtual ~RadarClock() {}
+
+  // Milliseconds since 1970
+  wxLongLong GetMillis() {
+    wxLongLong millis = ReadMillis();
+    m_coarse_time = (time_t)(millis.GetValue() / MILLISECONDS_PER_SECOND);
+    return millis;
+  }
+
+  time_t GetTime() { return (time_t)(GetMillis().GetValue() / MILLISECONDS_PER_SECOND); }
+
+  // The time in seconds at the last GetMillis() or GetTime(). It is only a memory read, so it
+  // is meant for code that runs for every spoke. The receivers read the clock for every frame,
+  // so while spokes come in it is never more than a frame behind.
+  time_t GetCoarseTime() {
+    time_t t = m_coarse_time;
+    return t ? t : GetTime();
+  }
+
+ protected:
+  virtual wxLongLong ReadMillis() = 0;
+
+ private:
+  volatile time_t m_coarse_time;
+};
+
+class RealTimeClock : public RadarClock {
+ protected:
+  wxLongLong ReadMillis() { return wxGetUTCTimeMillis(); }
+};
+
+//
+// A clock that only moves when it is told to.
+//
+class SimulatedClock : public RadarClock {
+ public:
+  SimulatedClock() { m_millis = 0; }
+
+  void SetMillis(wxLongLong millis) {
+    wxCriticalSectionLocker lock(m_lock);
+    m_millis = millis;
+  }
+
+  void Advance(wxLongLong millis) {
+    wxCriticalSectionLocker lock(m_lock);
+    m_millis += millis;
+  }
+
+ protected:
+  wxLongLong ReadMillis() {
+    wxCriticalSectionLocker lock(m_lock);
+    return m_millis;
+  }
+
+ private:
+  wxCriticalSection m_lock;
+  wxLongLong m_millis;
+};
+
+//
+// A clock that runs a number of times faster than real time, from the moment it is started.
+//
+class FastForwardClock : public RadarClock {
+ public:
+  FastForwardClock() { Start(wxGetUTCTimeMillis(), 1); }
+
+  void Start(wxLongLong from, int factor) {
+    wxCriticalSectionLocker lock(m_lock);
+    m_origin = from;
+    m_real_origin = wxGetUTCTimeMillis();
+    m_factor = factor;
+  }
+
+ protected:
+  wxLongLong ReadMillis() {
+    wxCriticalSectionLocker lock(m_lock);
+    return m_origin + (wxGetUTCTimeMillis() - m_real_origin) * m_factor;
+  }
+
+ private:
+  wxCriticalSection m_lock;
+  wxLongLong m_origin;       // Time of this clock when it was started
+  wxLongLong m_real_origin;  // ... and the real time at that moment
+  int m_factor;
+};
+
+// The process wide clock, the real time clock unless replaced. New radars start on it. A clock that
+// is set must stay valid until it is replaced, so use one with static lifetime.
+extern RadarClock *GetRadarClock();
+extern void SetRadarClock(RadarClock *clock);  // 0 = real time
+
+inline wxLongLong GetRadarMillis() { return GetRadarClock()->GetMillis(); }
+inline time_t GetRadarTime() { return GetRadarClock()->GetTime(); }
+inline time_t GetRadarCoarseTime() { return GetRadarClock()->GetCoarseTime(); }
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADARCLOCK_H_ */
@@ -32,6 +32,7 @@
 #ifndef _RADAR_CONTROL_ITEM_H_
 #define _RADAR_CONTROL_ITEM_H_
 
+#include "LockProfiler.h"
 #include "pi_common.h"
 
 PLUGIN_BEGIN_NAMESPACE
@@ -63,7 +64,7 @@ class RadarControlItem {
  public:
   static const int VALUE_NOT_SET = -10000;
 
-  RadarControlItem() {
+  RadarControlItem() : m_exclusive(LOCK_CONTROL_ITEM) {
     m_value = 0;
     m_state = RCS_OFF;
     m_button_v = VALUE_NOT_SET;  // Unlikely value so that first actual set sets proper value + mod
@@ -72,7 +73,7 @@ class RadarControlItem {
   }
 
   // The copy constructor
-  RadarControlItem(const RadarControlItem &other) { Update(other.m_value, other.m_state); }
+  RadarControlItem(const RadarControlItem &other) : m_exclusive(LOCK_CONTROL_ITEM) { Update(other.m_value, other.m_state); }
 
   // The assignment constructor
   RadarControlItem &operator=(const RadarControlItem &other) {
@@ -89,7 +90,7 @@ class RadarControlItem {
   }
 
   void Update(int v, RadarControlState s) {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
 
     if (v != m_button_v || s != m_button_s) {
       m_mod = true;
@@ -101,7 +102,7 @@ class RadarControlItem {
   };
 
   void UpdateState(RadarControlState s) {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
 
     if (s != m_button_s) {
       m_mod = true;
@@ -113,7 +114,7 @@ class RadarControlItem {
   void Update(int v) { Update(v, RCS_MANUAL); };
 
   bool GetButton(int *value, RadarControlState *state) {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
     if (value) {
       *value = this->m_button_v;
     }
@@ -127,7 +128,7 @@ class RadarControlItem {
   }
 
   bool GetButton(int *value) {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
     if (value) {
       *value = this->m_button_v;
     }
@@ -138,32 +139,32 @@ class RadarControlItem {
   }
 
   int GetButton() {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
 
     m_mod = false;
     return m_button_v;
   }
 
   int GetValue() {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
 
     return m_value;
   }
 
   RadarControlState GetState() {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
 
     return m_state;
   }
 
   bool IsModified() {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
 
     return m_mod;
   }
 
  protected:
-  wxCriticalSection m_exclusive;
+  ProfiledCriticalSection m_exclusive;
   int m_value;
   int m_button_v;
   RadarControlState m_state;
@@ -188,7 +189,7 @@ class RadarRangeControlItem : public RadarControlItem {
   }
 
   void Update(int v) {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
 
     if (v != m_button_v) {
       m_mod = true;
@@ -31,6 +31,7 @@
 
 #include "RadarDraw.h"
 #include "RadarDrawShader.h"
+#include "RadarDrawSoftware.h"
 #include "RadarDrawVertex.h"
 
 PLUGIN_BEGIN_NAMESPACE
@@ -42,6 +43,8 @@ RadarDraw* RadarDraw::make_Draw(RadarInfo* ri, int draw_method) {
       return new RadarDrawVertex(ri);
     case 1:
       return new RadarDrawShader(ri);
+    case 2:
+      return new RadarDrawSoftware(ri);
     default:
       wxLogError(wxT("radar_pi: unsupported draw method %d"), draw_method);
   }
@@ -51,7 +54,7 @@ RadarDraw* RadarDraw::make_Draw(RadarInfo* ri, int draw_method) {
 RadarDraw::~RadarDraw() {}
 
 void RadarDraw::GetDrawingMethods(wxArrayString& methods) {
-  wxString m[] = {_("Vertex Array"), _("Shader")};
+  wxString m[] = {_("Vertex Array"), _("Shader"), _("Software")};
 
   methods = wxArrayString(ARRAY_SIZE(m), m);
 }
@@ -44,6 +44,9 @@ class RadarDraw {
   virtual void DrawRadarImage() = 0;
   virtual void ProcessRadarSpoke(int transparency, SpokeBearing angle, uint8_t* data, size_t len) = 0;
 
+  // The RGBA image of size x size pixels that was last drawn, for methods that make one on the CPU
+  virtual const uint8_t* GetImage(size_t* size) { return 0; }
+
   virtual ~RadarDraw() = 0;
 
   static void GetDrawingMethods(wxArrayString& methods);
@@ -71,7 +71,7 @@ static const char *FragmentShaderColorText =
     "} \n";
 
 bool RadarDrawShader::Init(size_t spokes, size_t spoke_len_max) {
-  wxCriticalSectionLocker lock(m_exclusive);
+  ProfiledLocker lock(m_exclusive);
 
   m_format = GL_RGBA;
   m_channels = SHADER_COLOR_CHANNELS;
@@ -100,10 +100,11 @@ bool RadarDrawShader::Init(size_t spokes, size_t spoke_len_max) {
   glGenTextures(1, &m_texture);
   glBindTexture(GL_TEXTURE_2D, m_texture);
 
+  m_data = (unsigned char *)calloc(m_channels, m_spoke_len_max * m_spokes);
   if (m_data) {
-    free(m_data);
+    m_data_size = m_channels * m_spoke_len_max * m_spokes;
+    m_ri->m_memory.Allocated(MEMORY_DRAW, m_data_size);
   }
-  m_data = (unsigned char *)calloc(SHADER_COLOR_CHANNELS, m_spoke_len_max * m_spokes);
   // Tell the GPU the size of the texture:
   glTexImage2D(/* target          = */ GL_TEXTURE_2D,
                /* level           = */ 0,
@@ -144,17 +145,19 @@ void RadarDrawShader::Reset() {
   if (m_data) {
     free(m_data);
     m_data = 0;
+    m_ri->m_memory.Freed(MEMORY_DRAW, m_data_size);
+    m_data_size = 0;
   }
 }
 
 RadarDrawShader::~RadarDrawShader() {
-  wxCriticalSectionLocker lock(m_exclusive);
+  ProfiledLocker lock(m_exclusive);
 
   Reset();
 }
 
 void RadarDrawShader::DrawRadarImage() {
-  wxCriticalSectionLocker lock(m_exclusive);
+  ProfiledLocker lock(m_exclusive);
 
   if (!m_program || !m_texture || !m_data) {
     return;
@@ -205,6 +208,7 @@ void RadarDrawShader::DrawRadarImage() {
                       /* type =     */ GL_UNSIGNED_BYTE,
                       /* pixels =   */ m_data + m_start_line * m_spoke_len_max * m_channels);
     }
+    m_ri->m_latency.Record(LATENCY_UPLOAD, GetLatencyNanos() - m_start_time);
     m_start_line = -1;
     m_lines = 0;
   }
@@ -229,10 +233,11 @@ void RadarDrawShader::DrawRadarImage() {
 
 void RadarDrawShader::ProcessRadarSpoke(int transparency, SpokeBearing angle, uint8_t *data, size_t len) {
   GLubyte alpha = 255 * (MAX_OVERLAY_TRANSPARENCY - transparency) / MAX_OVERLAY_TRANSPARENCY;
-  wxCriticalSectionLocker lock(m_exclusive);
+  ProfiledLocker lock(m_exclusive);
 
   if (m_start_line == -1) {
     m_start_line = angle;  // Note that this only runs once after each draw,
+    m_start_time = GetLatencyNanos();
   }
   if (m_lines < (int)m_spokes) {
     m_lines++;
@@ -40,10 +40,11 @@ PLUGIN_BEGIN_NAMESPACE
 
 class RadarDrawShader : public RadarDraw {
  public:
-  RadarDrawShader(RadarInfo* ri) {
+  RadarDrawShader(RadarInfo* ri) : m_exclusive(LOCK_RADAR_DRAW) {
     m_ri = ri;
     m_start_line = -1;  // No spokes received since last draw
     m_lines = 0;
+    m_start_time = 0;
     m_texture = 0;
     m_fragment = 0;
     m_vertex = 0;
@@ -51,6 +52,7 @@ class RadarDrawShader : public RadarDraw {
     m_format = GL_RGBA;
     m_channels = SHADER_COLOR_CHANNELS;
     m_data = 0;
+    m_data_size = 0;
     m_spokes = 0;
     m_spoke_len_max = 0;
   }
@@ -64,13 +66,15 @@ class RadarDrawShader : public RadarDraw {
  private:
   RadarInfo* m_ri;
 
-  wxCriticalSection m_exclusive;  // protects the following data structures
+  ProfiledCriticalSection m_exclusive;  // protects the following data structures
   unsigned char* m_data;          // [SHADER_COLOR_CHANNELS * m_spokes * m_spoke_len_max];
+  size_t m_data_size;             // Bytes in m_data
   size_t m_spokes;
   size_t m_spoke_len_max;
 
   int m_start_line;  // First line received since last draw, or -1
   int m_lines;       // # of lines received since last draw
+  uint64_t m_start_time;  // When m_start_line was received, in GetLatencyNanos() time
 
   int m_format;
   int m_channels;
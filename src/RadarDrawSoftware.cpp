@@ -0,0 +1,174 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "RadarDrawSoftware.h"
+#include "RadarInfo.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+bool RadarDrawSoftware::Init(size_t spokes, size_t spoke_len_max) {
+  ProfiledLocker lock(m_exclusive);
+
+  // One pixel per sample along the radius. The texture is made on the next draw.
+  m_polar.Init(spokes, spoke_len_max);
+  m_raster.Init(spokes, spoke_len_max, 2 * spoke_len_max);
+  m_raster.SetBackground(BLOB_NONE);
+  AccountMemory();
+
+  m_dirty = true;
+
+  return true;
+}
+
+void RadarDrawSoftware::Reset() {
+  if (m_texture) {
+    glDeleteTextures(1, &m_texture);
+    m_texture = 0;
+  }
+  m_texture_size = 0;
+}
+
+RadarDrawSoftware::~RadarDrawSoftware() {
+  ProfiledLocker lock(m_exclusive);
+
+  Reset();  // Only calls GL when a texture was made
+  m_ri->m_memory.Freed(MEMORY_DRAW, m_memory_size);
+}
+
+void RadarDrawSoftware::AccountMemory() {
+  size_t size = m_polar.GetMemorySize() + m_raster.GetMemorySize();
+
+  m_ri->m_memory.Resized(MEMORY_DRAW, m_memory_size, size);
+  m_memory_size = size;
+}
+
+bool RadarDrawSoftware::RenderImage() {
+  {
+    ProfiledLocker lock(m_exclusive);
+
+    if (!m_dirty) {
+      return false;
+    }
+    m_raster.SetSpokes(m_polar);  // A copy, so the receive thread can go on while we render
+    m_image_alpha = m_alpha;
+    m_dirty = false;
+  }
+
+  // The colours may have changed since the last render, so set the palette each time
+  for (size_t colour = 0; colour < BLOB_COLOURS; colour++) {
+    wxColour rgb = m_ri->m_colour_map_rgb[colour];
+    m_raster.SetPalette(colour, rgb.Red(), rgb.Green(), rgb.Blue(), colour != BLOB_NONE ? m_image_alpha : 0);
+  }
+
+  int threads = wxThread::GetCPUCount();
+  m_raster.Render(RASTER_RGBA, threads > 0 ? (size_t)threads : 1);
+  AccountMemory();  // The image is made on the first render
+  m_image_changed = true;
+  return true;
+}
+
+void RadarDrawSoftware::DrawRadarImage() {
+  RenderImage();
+
+  size_t size = m_raster.GetSize();
+  if (size == 0 || !m_raster.GetImage()) {
+    return;
+  }
+
+  if (m_texture_size != size) {
+    Reset();
+    m_texture_size = size;
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexImage2D(/* target          = */ GL_TEXTURE_2D,
+                 /* level           = */ 0,
+                 /* internal_format = */ GL_RGBA,
+                 /* width           = */ m_texture_size,
+                 /* heigth          = */ m_texture_size,
+                 /* border          = */ 0,
+                 /* format          = */ GL_RGBA,
+                 /* type            = */ GL_UNSIGNED_BYTE,
+                 /* data            = */ 0);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    m_image_changed = true;
+  }
+
+  glPushAttrib(GL_TEXTURE_BIT | GL_ENABLE_BIT);
+  glEnable(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+
+  if (m_image_changed) {
+    glTexSubImage2D(/* target =   */ GL_TEXTURE_2D,
+                    /* level =    */ 0,
+                    /* x-offset = */ 0,
+                    /* y-offset = */ 0,
+                    /* width =    */ m_texture_size,
+                    /* height =   */ m_texture_size,
+                    /* format =   */ GL_RGBA,
+                    /* type =     */ GL_UNSIGNED_BYTE,
+                    /* pixels =   */ m_raster.GetImage());
+    m_image_changed = false;
+  }
+
+  // The raster has spoke 0 at the top of the image and turns clockwise, the other draw methods
+  // have spoke 0 along +x turning towards +y. Rotate the texture coordinates to match.
+  float fullscale = m_texture_size / 2;
+  glColor4ub(255, 255, 255, 255);
+  glBegin(GL_QUADS);
+  glTexCoord2f(0, 1);
+  glVertex2f(-fullscale, -fullscale);
+  glTexCoord2f(0, 0);
+  glVertex2f(fullscale, -fullscale);
+  glTexCoord2f(1, 0);
+  glVertex2f(fullscale, fullscale);
+  glTexCoord2f(1, 1);
+  glVertex2f(-fullscale, fullscale);
+  glEnd();
+
+  glPopAttrib();
+}
+
+void RadarDrawSoftware::ProcessRadarSpoke(int transparency, SpokeBearing angle, uint8_t *data, size_t len) {
+  uint8_t map[RASTER_PALETTE_SIZE];
+
+  for (size_t strength = 0; strength < RASTER_PALETTE_SIZE; strength++) {
+    map[strength] = (uint8_t)m_ri->m_colour_map[strength];
+  }
+
+  ProfiledLocker lock(m_exclusive);
+
+  m_alpha = 255 * (MAX_OVERLAY_TRANSPARENCY - transparency) / MAX_OVERLAY_TRANSPARENCY;
+  m_polar.SetSpoke(angle, data, len, map);
+  m_dirty = true;
+}
+
+PLUGIN_END_NAMESPACE
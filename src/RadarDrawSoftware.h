@@ -0,0 +1,97 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RADARDRAWSOFTWARE_H_
+#define _RADARDRAWSOFTWARE_H_
+
+#include "RadarDraw.h"
+#include "RadarRaster.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Draws the radar image by scan converting it on the CPU into a cartesian raster (see RadarRaster),
+// which is then shown as a single texture. This needs no shaders and puts all the work
+// in the plugin, so it is also the reference for what the other methods should show.
+//
+// RenderImage() makes the image without any GL call, so it can be used without a GL context;
+// DrawRadarImage() only uploads that image to a texture and draws it. The receive thread stores
+// spokes under the lock, the image is rendered from a copy of them outside the lock.
+//
+class RadarDrawSoftware : public RadarDraw {
+ public:
+  RadarDrawSoftware(RadarInfo* ri) : m_exclusive(LOCK_RADAR_DRAW) {
+    m_ri = ri;
+    m_texture = 0;
+    m_texture_size = 0;
+    m_alpha = 255;
+    m_dirty = false;
+    m_image_alpha = 255;
+    m_image_changed = false;
+    m_memory_size = 0;
+  }
+
+  ~RadarDrawSoftware();
+
+  bool Init(size_t spokes, size_t spoke_len_max);
+  void DrawRadarImage();
+  void ProcessRadarSpoke(int transparency, SpokeBearing angle, uint8_t* data, size_t len);
+
+  // Render the spokes received since the last call into the RGBA image. Returns true when the image changed.
+  bool RenderImage();
+  const uint8_t* GetImage(size_t* size) {
+    *size = m_raster.GetSize();
+    return m_raster.GetImage();
+  }
+
+ private:
+  RadarInfo* m_ri;
+
+  ProfiledCriticalSection m_exclusive;  // protects the following data structures
+  RadarPolar m_polar;                   // Spokes as stored by the receive thread
+  uint8_t m_alpha;                      // Alpha of the last spoke received
+  bool m_dirty;                         // Spokes received since last render
+
+  // Only used by the thread that draws
+  RadarRaster m_raster;
+  uint8_t m_image_alpha;  // Alpha the image was rendered with
+  bool m_image_changed;   // Image rendered but not yet uploaded to the texture
+  GLuint m_texture;
+  size_t m_texture_size;
+  size_t m_memory_size;  // What m_polar and m_raster held when last told to the radar's memory account
+
+  void Reset();
+  void AccountMemory();
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADARDRAWSOFTWARE_H_ */
@@ -35,7 +35,7 @@
 PLUGIN_BEGIN_NAMESPACE
 
 bool RadarDrawVertex::Init(size_t spokes, size_t spoke_len_max) {
-  wxCriticalSectionLocker lock(m_exclusive);
+  ProfiledLocker lock(m_exclusive);
 
   if (m_spokes != spokes) {
     Reset();
@@ -45,6 +45,9 @@ bool RadarDrawVertex::Init(size_t spokes, size_t spoke_len_max) {
 
   if (!m_vertices) {
     m_vertices = (VertexLine*)calloc(sizeof(VertexLine), m_spokes);
+    if (m_vertices) {
+      m_ri->m_memory.Allocated(MEMORY_DRAW, m_spokes * sizeof(VertexLine));
+    }
   }
   if (!m_vertices) {
     if (!m_oom) {
@@ -66,6 +69,8 @@ void RadarDrawVertex::Reset() {
     }
     free(m_vertices);
     m_vertices = 0;
+    m_ri->m_memory.Freed(MEMORY_DRAW, m_spokes * sizeof(VertexLine) + m_count * sizeof(VertexPoint));
+    m_count = 0;
   }
 }
 
@@ -89,18 +94,21 @@ void RadarDrawVertex::SetBlob(VertexLine* line, int angle_begin, int angle_end,
   size_t count = line->count;
 
   if (line->count + VERTEX_PER_QUAD > line->allocated) {
-    const size_t extra = 8 * VERTEX_PER_QUAD;
-    line->points = (VertexPoint*)realloc(line->points, (line->allocated + extra) * sizeof(VertexPoint));
-    line->allocated += extra;
-    m_count += extra;
-  }
+    // Double the line, so a spoke with many blobs only needs a few reallocs before it is large enough
+    const size_t extra = line->allocated;
+    VertexPoint* points = (VertexPoint*)realloc(line->points, (line->allocated + extra) * sizeof(VertexPoint));
 
-  if (!line->points) {
-    if (!m_oom) {
-      wxLogError(wxT("radar_pi: Out of memory"));
-      m_oom = true;
+    if (!points) {
+      if (!m_oom) {
+        wxLogError(wxT("radar_pi: Out of memory"));
+        m_oom = true;
+      }
+      return;
     }
-    return;
+    line->points = points;
+    line->allocated += extra;
+    m_count += extra;
+    m_ri->m_memory.Allocated(MEMORY_DRAW, extra * sizeof(VertexPoint));
   }
 
   // First triangle
@@ -122,9 +130,9 @@ void RadarDrawVertex::ProcessRadarSpoke(int transparency, SpokeBearing angle, ui
   GLubyte alpha = 255 * (MAX_OVERLAY_TRANSPARENCY - transparency) / MAX_OVERLAY_TRANSPARENCY;
   BlobColour previous_colour = BLOB_NONE;
   GLubyte strength = 0;
-  time_t now = time(0);
+  time_t now = m_ri->GetRadarCoarseTime();
 
-  wxCriticalSectionLocker lock(m_exclusive);
+  ProfiledLocker lock(m_exclusive);
 
   int r_begin = 0;
   int r_end = 0;
@@ -136,10 +144,9 @@ void RadarDrawVertex::ProcessRadarSpoke(int transparency, SpokeBearing angle, ui
   VertexLine* line = &m_vertices[angle];
 
   if (!line->points) {
-    static size_t INITIAL_ALLOCATION = 600;  // Empirically found to be enough for a complicated picture
-    line->allocated = INITIAL_ALLOCATION * VERTEX_PER_QUAD;
-    m_count += INITIAL_ALLOCATION * VERTEX_PER_QUAD;
-    line->points = (VertexPoint*)malloc(line->allocated * sizeof(VertexPoint));
+    // Most spokes only have a few blobs, SetBlob() grows the line for the ones that have more
+    static size_t INITIAL_ALLOCATION = 16;
+    line->points = (VertexPoint*)malloc(INITIAL_ALLOCATION * VERTEX_PER_QUAD * sizeof(VertexPoint));
     if (!line->points) {
       if (!m_oom) {
         wxLogError(wxT("radar_pi: Out of memory"));
@@ -149,9 +156,15 @@ void RadarDrawVertex::ProcessRadarSpoke(int transparency, SpokeBearing angle, ui
       line->count = 0;
       return;
     }
+    line->allocated = INITIAL_ALLOCATION * VERTEX_PER_QUAD;
+    m_count += INITIAL_ALLOCATION * VERTEX_PER_QUAD;
+    m_ri->m_memory.Allocated(MEMORY_DRAW, line->allocated * sizeof(VertexPoint));
   }
   line->count = 0;
   line->timeout = now + m_ri->m_pi->m_settings.max_age;
+  if (!m_first_spoke_time) {
+    m_first_spoke_time = GetLatencyNanos();
+  }
 
   for (size_t radius = 0; radius < len; radius++) {
     strength = data[radius];
@@ -189,9 +202,9 @@ void RadarDrawVertex::DrawRadarImage() {
   glEnableClientState(GL_VERTEX_ARRAY);
   glEnableClientState(GL_COLOR_ARRAY);
 
-  time_t now = time(0);
+  time_t now = m_ri->GetRadarTime();
   {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
 
     for (size_t i = 0; i < m_spokes; i++) {
       VertexLine* line = &m_vertices[i];
@@ -203,6 +216,10 @@ void RadarDrawVertex::DrawRadarImage() {
       glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(VertexPoint), &line->points[0].red);
       glDrawArrays(GL_TRIANGLES, 0, line->count);
     }
+    if (m_first_spoke_time) {
+      m_ri->m_latency.Record(LATENCY_UPLOAD, GetLatencyNanos() - m_first_spoke_time);
+      m_first_spoke_time = 0;
+    }
   }
   glDisableClientState(GL_VERTEX_ARRAY);  // disable vertex arrays
   glDisableClientState(GL_COLOR_ARRAY);
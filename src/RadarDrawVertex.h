@@ -41,13 +41,14 @@ PLUGIN_BEGIN_NAMESPACE
 
 class RadarDrawVertex : public RadarDraw {
  public:
-  RadarDrawVertex(RadarInfo* ri) {
-    wxCriticalSectionLocker lock(m_exclusive);
+  RadarDrawVertex(RadarInfo* ri) : m_exclusive(LOCK_RADAR_DRAW) {
+    ProfiledLocker lock(m_exclusive);
 
     m_ri = ri;
     m_vertices = 0;
     m_count = 0;
     m_oom = false;
+    m_first_spoke_time = 0;
     m_spokes = 0;
     m_spoke_len_max = 0;
   }
@@ -57,7 +58,7 @@ class RadarDrawVertex : public RadarDraw {
   void ProcessRadarSpoke(int transparency, SpokeBearing angle, uint8_t* data, size_t len);
 
   ~RadarDrawVertex() {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
 
     Reset();
   }
@@ -91,10 +92,11 @@ class RadarDrawVertex : public RadarDraw {
 
   void Reset();
 
-  wxCriticalSection m_exclusive;  // protects the following
+  ProfiledCriticalSection m_exclusive;  // protects the following
   VertexLine* m_vertices;
-  unsigned int m_count;
+  unsigned int m_count;  // Vertices allocated in all lines
   bool m_oom;
+  uint64_t m_first_spoke_time;  // First spoke since the last draw in GetLatencyNanos() time, or 0
 };
 
 PLUGIN_END_NAMESPACE
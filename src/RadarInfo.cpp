@@ -38,12 +38,26 @@
 #include "RadarFactory.h"
 #include "RadarMarpa.h"
 #include "RadarPanel.h"
+#include "RadarRecording.h"
 #include "RadarReceive.h"
+#include "RadarStream.h"
+#include "SpokeNetwork.h"
 #include "TrailBuffer.h"
 #include "drawutil.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
+#ifdef _MSC_VER
+#define ATOMIC_EXCHANGE(p, v) InterlockedExchange((volatile LONG *)(p), (LONG)(v))
+// Volatile accesses are acquire loads and release stores with /volatile:ms, the default on x86 and x64
+#define LOAD_ACQUIRE(p) (*(p))
+#define STORE_RELEASE(p, v) (*(p) = (v))
+#else
+#define ATOMIC_EXCHANGE(p, v) __sync_lock_test_and_set(p, v)
+#define LOAD_ACQUIRE(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#endif
+
 bool g_first_render = true;
 
 /**
@@ -52,17 +66,17 @@ bool g_first_render = true;
  * Called when the config is not yet known, so this should not start any
  * computations based on those yet.
  */
-RadarInfo::RadarInfo(radar_pi *pi, int radar) {
+RadarInfo::RadarInfo(radar_pi *pi, int radar) : m_exclusive(LOCK_RADAR_INFO) {
   m_pi = pi;
   m_radar = radar;
+  m_clock = GetRadarClock();
+  m_replay_heading = nan("");
   m_arpa = 0;
   m_range.UpdateState(RCS_AUTO_1);
   m_timed_run.Update(1, RCS_MANUAL);
   m_timed_idle.Update(1, RCS_OFF);
   m_course_index = 0;
   m_old_range = 0;
-  m_dir_lat = 0;
-  m_dir_lon = 0;
   m_pixels_per_meter = 0.;
   m_previous_auto_range_meters = 0;
   m_previous_orientation = ORIENTATION_HEAD_UP;
@@ -74,6 +88,9 @@ RadarInfo::RadarInfo(radar_pi *pi, int radar) {
   m_spokes = 0;
   m_spoke_len_max = 0;
   m_trails = 0;
+  m_clear_trails = 0;
+  m_first_spoke_logged = false;
+  m_history_on = true;
   m_idle_standby = 0;
   m_idle_transmit = 0;
   m_showManualValueInAuto = false;
@@ -94,6 +111,13 @@ RadarInfo::RadarInfo(radar_pi *pi, int radar) {
   }
   m_control = 0;
   m_receive = 0;
+  m_stream = 0;
+  m_stream_generation = 0;
+  m_stream_acked = 0;
+  m_stream_port = 0;
+  m_stream_all_interfaces = false;
+  m_spoke_publisher = 0;
+  m_recorder = 0;
   m_draw_panel.draw = 0;
   m_draw_overlay.draw = 0;
   m_draw_time_ms = 1000;  // Assume really bad draw time until we actually measure it to prevent fast redraw at start
@@ -103,9 +127,29 @@ RadarInfo::RadarInfo(radar_pi *pi, int radar) {
   m_state.Update(RADAR_OFF);
   m_refresh_millis = 50;
 
+  CLEAR_STRUCT(m_guard_zone);
   for (size_t z = 0; z < GUARD_ZONES; z++) {
     m_guard_zone[z] = new GuardZone(m_pi, this, z);
   }
+  m_guard_zone_count = GUARD_ZONES;
+}
+
+/*
+ * Create the guard zones beyond the ones shown in the controls dialog. Zones are never
+ * deleted until the radar is, as the receive thread may be using them.
+ */
+void RadarInfo::SetGuardZoneCount(size_t count) {
+  if (count > GUARD_ZONES_MAX) {
+    count = GUARD_ZONES_MAX;
+  }
+  for (size_t z = m_guard_zone_count; z < count; z++) {
+    if (!m_guard_zone[z]) {
+      m_guard_zone[z] = new GuardZone(m_pi, this, z);
+    }
+  }
+  if (count > m_guard_zone_count) {
+    m_guard_zone_count = count;
+  }
 }
 
 void RadarInfo::Shutdown() {
@@ -147,6 +191,27 @@ void RadarInfo::Shutdown() {
     m_receive = 0;
   }
 
+  if (m_stream) {
+    m_stream->Shutdown();
+    delete m_stream;
+    m_stream = 0;
+  }
+  for (size_t i = 0; i < m_stream_retired.size(); i++) {
+    delete m_stream_retired[i];
+  }
+  m_stream_retired.clear();
+  m_stream_retired_generation.clear();
+
+  if (m_spoke_publisher) {
+    delete m_spoke_publisher;
+    m_spoke_publisher = 0;
+  }
+
+  if (m_recorder) {
+    delete m_recorder;  // Writes the time index
+    m_recorder = 0;
+  }
+
   if (m_control_dialog) {
     delete m_control_dialog;
     m_control_dialog = 0;
@@ -177,10 +242,12 @@ RadarInfo::~RadarInfo() {
     m_arpa = 0;
   }
   if (m_trails) {
+    m_memory.Freed(MEMORY_TRAILS, m_trails->GetMemorySize());
     delete m_trails;
     m_trails = 0;
   }
-  for (size_t z = 0; z < GUARD_ZONES; z++) {
+  m_guard_zone_count = 0;
+  for (size_t z = 0; z < GUARD_ZONES_MAX; z++) {
     if (m_guard_zone[z]) {
       delete m_guard_zone[z];
       m_guard_zone[z] = 0;
@@ -194,6 +261,11 @@ RadarInfo::~RadarInfo() {
       }
     }
     free(m_history);
+    m_memory.Freed(MEMORY_HISTORY, m_spokes * (sizeof(line_history) + m_spoke_len_max));
+  }
+  if (m_polar_lookup) {
+    ReleasePolarToCartesianLookup(m_polar_lookup);
+    m_polar_lookup = 0;
   }
 }
 
@@ -207,31 +279,57 @@ RadarInfo::~RadarInfo() {
 bool RadarInfo::Init() {
   m_verbose = M_SETTINGS.verbose;
   m_name = RadarTypeName[m_radar_type];
-  m_spokes = RadarSpokes[m_radar_type];
-  m_spoke_len_max = RadarSpokeLenMax[m_radar_type];
 
-  m_history = (line_history *)calloc(sizeof(line_history), m_spokes);
-  for (size_t i = 0; i < m_spokes; i++) {
-    m_history[i].line = (uint8_t *)calloc(sizeof(uint8_t), m_spoke_len_max);
+  // The buffers are sized for this type of radar once; the receive thread keeps using them
+  // when Init() is called again for a radar of the same type.
+  if (!m_history) {
+    m_spokes = RadarSpokes[m_radar_type];
+    m_spoke_len_max = RadarSpokeLenMax[m_radar_type];
+    if (m_radar_type == RT_EMULATOR) {
+      // The emulator can pretend to be any radar up to the size of its type
+      m_spokes = M_SETTINGS.emulator_spokes;
+      m_spoke_len_max = M_SETTINGS.emulator_spoke_len;
+    }
+
+    m_history = (line_history *)calloc(sizeof(line_history), m_spokes);
+    for (size_t i = 0; i < m_spokes; i++) {
+      m_history[i].line = (uint8_t *)calloc(sizeof(uint8_t), m_spoke_len_max);
+    }
+    m_memory.Allocated(MEMORY_HISTORY, m_spokes * (sizeof(line_history) + m_spoke_len_max));
+    m_polar_lookup = AcquirePolarToCartesianLookup(m_spokes, m_spoke_len_max);
+  }
+
+  UpdateStream();
+
+  if (!m_spoke_publisher && M_SETTINGS.spoke_publish && m_radar_type != RT_NETWORK) {
+    NetworkAddress group(SPOKE_NET_GROUP, M_SETTINGS.spoke_network_port + m_radar);
+
+    m_spoke_publisher = new SpokePublisher;
+    if (!m_spoke_publisher->Init(group, m_pi->GetRadarInterfaceAddress(m_radar), m_spokes, m_spoke_len_max, m_radar)) {
+      delete m_spoke_publisher;
+      m_spoke_publisher = 0;
+    }
+  }
+
+  if (!m_recorder && !M_SETTINGS.record_directory.IsEmpty()) {
+    wxString filename = M_SETTINGS.record_directory + wxFileName::GetPathSeparator() +
+                        wxString::Format(wxT("radar%d-%s.rpr"), m_radar, wxDateTime::Now().Format(wxT("%Y%m%d-%H%M%S")).c_str());
+
+    m_recorder = new RadarRecorder;
+    if (!m_recorder->Open(filename, m_name, (int)m_radar_type, m_spokes, m_spoke_len_max)) {
+      delete m_recorder;
+      m_recorder = 0;
+    }
   }
-  m_polar_lookup = new PolarToCartesianLookup(m_spokes, m_spoke_len_max);
 
   ComputeColourMap();
 
   if (!m_control) {
     m_control = RadarFactory::MakeRadarControl(m_radar_type);
   }
-  if (!m_radar_panel) {
-    m_radar_panel = new RadarPanel(m_pi, this, GetOCPNCanvasWindow());
-    if (!m_radar_panel || !m_radar_panel->Create()) {
-      wxLogError(wxT("radar_pi %s: Unable to create RadarPanel"), m_name.c_str());
-      return false;
-    }
-  }
   if (!m_arpa) {
     m_arpa = new RadarArpa(m_pi, this);
   }
-  m_trails = new TrailBuffer(this, m_spokes, m_spoke_len_max);
   ComputeTargetTrails();
 
   UpdateControlState(true);
@@ -268,7 +366,7 @@ void RadarInfo::ShowControlDialog(bool show, bool reparent) {
       m_control_dialog->m_panel_position = panel_pos;
       m_control_dialog->m_manually_positioned = manually_positioned;
       wxWindow *parent = (wxWindow *)m_radar_panel;
-      if (!m_pi->m_settings.show_radar[m_radar]) {
+      if (!m_pi->m_settings.show_radar[m_radar] || !m_radar_panel) {
         parent = GetOCPNCanvasWindow();
       }
       LOG_VERBOSE(wxT("radar_pi %s: Creating control dialog"), m_name.c_str());
@@ -289,11 +387,72 @@ void RadarInfo::DetectedRadar(NetworkAddress &interfaceAddress, NetworkAddress &
   m_pi->NotifyControlDialog();
 }
 
+/*
+ * Start, stop or restart the image stream when its settings have changed. GUI thread only.
+ *
+ * The old stream is shut down at once so its port is free, but only deleted once the receive
+ * thread has acknowledged the generation that replaced it, as until then it may still be passing
+ * it a spoke.
+ */
+void RadarInfo::UpdateStream() {
+  int port = M_SETTINGS.stream_port > 0 ? M_SETTINGS.stream_port + m_radar : 0;
+  bool all_interfaces = M_SETTINGS.stream_all_interfaces;
+
+  uint32_t acked = LOAD_ACQUIRE(&m_stream_acked);
+  size_t kept = 0;
+  for (size_t i = 0; i < m_stream_retired.size(); i++) {
+    if ((int32_t)(acked - m_stream_retired_generation[i]) >= 0) {
+      delete m_stream_retired[i];
+    } else {
+      m_stream_retired[kept] = m_stream_retired[i];
+      m_stream_retired_generation[kept] = m_stream_retired_generation[i];
+      kept++;
+    }
+  }
+  m_stream_retired.resize(kept);
+  m_stream_retired_generation.resize(kept);
+
+  if (port == m_stream_port && all_interfaces == m_stream_all_interfaces) {
+    return;
+  }
+  m_stream_port = port;
+  m_stream_all_interfaces = all_interfaces;
+
+  RadarStream *old = m_stream;
+  if (old) {
+    old->Shutdown();  // Frees the port, the receive thread can still pass it spokes until the swap below
+  }
+
+  RadarStream *stream = 0;
+  if (port > 0) {
+    stream = new RadarStream(m_name);
+    stream->Init(m_spokes, m_spoke_len_max);
+    if (!stream->Start(port, all_interfaces)) {
+      delete stream;
+      stream = 0;
+    }
+  }
+
+  // Publish the stream before the generation, the receive thread reads them the other way around
+  STORE_RELEASE(&m_stream, stream);
+  STORE_RELEASE(&m_stream_generation, m_stream_generation + 1);
+  if (old) {
+    m_stream_retired.push_back(old);
+    m_stream_retired_generation.push_back(m_stream_generation);
+  }
+  if (stream) {
+    ComputeColourMap();  // Passes the colours to the new stream
+  }
+  LOG_INFO(wxT("radar_pi: %s image stream %s on port %d"), m_name.c_str(), m_stream ? wxT("started") : wxT("stopped"), port);
+}
+
 void RadarInfo::SetName(wxString name) {
   if (name != m_name) {
     LOG_DIALOG(wxT("radar_pi: Changing name of radar #%d from '%s' to '%s'"), m_radar, m_name.c_str(), name.c_str());
     m_name = name;
-    m_radar_panel->SetCaption(name);
+    if (m_radar_panel) {
+      m_radar_panel->SetCaption(name);
+    }
     if (m_control_dialog) {
       m_control_dialog->SetTitle(name);
     }
@@ -335,20 +494,42 @@ void RadarInfo::ComputeColourMap() {
       b1 += delta_b;
     }
   }
-}
 
-void RadarInfo::ResetSpokes() {
-  uint8_t zap[SPOKE_LEN_MAX];
+  if (m_stream) {
+    uint8_t map[RASTER_PALETTE_SIZE];
+    uint8_t palette[RASTER_PALETTE_SIZE][4];
 
-  LOG_VERBOSE(wxT("radar_pi: reset spokes"));
+    CLEAR_STRUCT(palette);
+    for (int i = 0; i <= UINT8_MAX; i++) {
+      map[i] = (uint8_t)m_colour_map[i];
+    }
+    for (int i = BLOB_NONE + 1; i < BLOB_COLOURS; i++) {
+      palette[i][0] = m_colour_map_rgb[i].Red();
+      palette[i][1] = m_colour_map_rgb[i].Green();
+      palette[i][2] = m_colour_map_rgb[i].Blue();
+      palette[i][3] = 255;
+    }
+    m_stream->SetColourMap(map, &palette[0][0]);
+  }
+}
 
-  CLEAR_STRUCT(zap);
+void RadarInfo::ClearHistory() {
   for (size_t i = 0; i < m_spokes; i++) {
     memset(m_history[i].line, 0, m_spoke_len_max);
     m_history[i].time = 0;
     m_history[i].pos.lat = 0.;
     m_history[i].pos.lon = 0.;
+    m_history[i].angle = 0;
   }
+}
+
+void RadarInfo::ResetSpokes() {
+  uint8_t zap[SPOKE_LEN_MAX];
+
+  LOG_VERBOSE(wxT("radar_pi: reset spokes"));
+
+  CLEAR_STRUCT(zap);
+  ClearHistory();
 
   if (m_draw_panel.draw) {
     for (size_t r = 0; r < m_spokes; r++) {
@@ -361,7 +542,7 @@ void RadarInfo::ResetSpokes() {
     }
   }
 
-  for (size_t z = 0; z < GUARD_ZONES; z++) {
+  for (size_t z = 0; z < m_guard_zone_count; z++) {
     // Zap them anyway just to be sure
     m_guard_zone[z]->ResetBogeys();
   }
@@ -381,6 +562,24 @@ void RadarInfo::ResetSpokes() {
 void RadarInfo::ProcessRadarSpoke(SpokeBearing angle, SpokeBearing bearing, uint8_t *data, size_t len, int range_meters,
                                   wxLongLong time_rec) {
   int orientation;
+  uint64_t start = GetLatencyNanos();
+
+  if (!m_first_spoke_logged) {
+    m_first_spoke_logged = true;
+    LOG_INFO(wxT("radar_pi: %s first spoke %.1f ms after Init"), m_name.c_str(), (start - m_pi->GetInitNanos()) / 1e6);
+  }
+
+  // Share and record the spoke as decoded, before anything below changes it
+  if (m_spoke_publisher) {
+    m_spoke_publisher->Publish(angle, bearing, data, len, range_meters, time_rec);
+  }
+  if (m_recorder) {
+    if ((angle & 127) == 0) {
+      RecordState(time_rec);
+    }
+    m_recorder->RecordSpoke(angle, bearing, data, len, range_meters, time_rec);
+  }
+  uint64_t shared = GetLatencyNanos();
 
   // calculate course as the moving average of m_hdt over one revolution
   SampleCourse(angle);  // used for course_up mode
@@ -420,22 +619,41 @@ void RadarInfo::ProcessRadarSpoke(SpokeBearing angle, SpokeBearing bearing, uint
   int stabilized_mode = orientation != ORIENTATION_HEAD_UP;
   uint8_t weakest_normal_blob = m_pi->m_settings.threshold_blue;
 
-  uint8_t *hist_data = m_history[bearing].line;
-  m_history[bearing].time = time_rec;
-  memset(hist_data, 0, m_spoke_len_max);
-  GetRadarPosition(&m_history[bearing].pos);
-  for (size_t radius = 0; radius < len; radius++) {
-    if (data[radius] >= weakest_normal_blob) {
-      // and add 1 if above threshold and set the left 2 bits, used for ARPA
-      hist_data[radius] = 192;
+  // The history is read by ARPA, and to rebuild a view that was not kept up to date.
+  // When it is not kept it is cleared, so nobody finds old echoes in it later.
+  bool history_on = m_consumers.IsActive(CONSUMER_HISTORY);
+  if (history_on) {
+    uint8_t *hist_data = m_history[bearing].line;
+    m_history[bearing].time = time_rec;
+    m_history[bearing].angle = angle;
+    memset(hist_data, 0, m_spoke_len_max);
+    GetRadarPosition(&m_history[bearing].pos);
+    for (size_t radius = 0; radius < len; radius++) {
+      hist_data[radius] = data[radius] >> 2;
+      if (data[radius] >= weakest_normal_blob) {
+        // and add 1 if above threshold and set the left 2 bits, used for ARPA
+        hist_data[radius] |= 192;
+      }
     }
+  } else if (m_history_on) {
+    ClearHistory();
   }
+  m_history_on = history_on;
 
-  for (size_t z = 0; z < GUARD_ZONES; z++) {
+  bool guard_spoke_set = false;
+  for (size_t z = 0; z < m_guard_zone_count; z++) {
     if (m_guard_zone[z]->m_alarm_on) {
-      m_guard_zone[z]->ProcessSpoke(angle, data, m_history[bearing].line, len);
+      if (!guard_spoke_set) {
+        // Count the samples above the threshold once for all zones
+        m_guard_spoke.Set(data, len, (uint8_t)wxMin(M_SETTINGS.threshold_blue, UINT8_MAX));
+        guard_spoke_set = true;
+      }
+      m_guard_zone[z]->ProcessSpoke(angle, data, m_guard_spoke);
+    } else {
+      m_guard_zone[z]->AcknowledgeIntervals();  // The zone may still be searched for ARPA targets
     }
   }
+  uint64_t history = GetLatencyNanos();
 
   size_t trail_len = len;
   if (m_pi->m_settings.show_extreme_range) {
@@ -444,32 +662,179 @@ void RadarInfo::ProcessRadarSpoke(SpokeBearing angle, SpokeBearing bearing, uint
   }
 
   bool draw_trails_on_overlay = M_SETTINGS.trails_on_overlay;
-  if (m_draw_overlay.draw && !draw_trails_on_overlay) {
-    m_draw_overlay.draw->ProcessRadarSpoke(M_SETTINGS.overlay_transparency.GetValue(), bearing, data, len);
+  int overlay_transparency = M_SETTINGS.overlay_transparency.GetValue();
+  bool overlay = !m_governor.SkipOverlay(angle) && m_draw_overlay.draw && m_consumers.IsActive(CONSUMER_OVERLAY);
+  bool panel = m_draw_panel.draw && m_consumers.IsActive(CONSUMER_PANEL);
+
+  // When overloaded the views get a coarser copy, the history, trails and stream keep all detail
+  bool decimate = m_governor.GetLevel() >= DEGRADE_DECIMATE;
+  uint8_t decimated[SPOKE_LEN_MAX];
+  uint8_t *display = decimate ? decimated : data;
+
+  if (overlay && m_consumers.TakeRebuild(CONSUMER_OVERLAY)) {
+    RebuildFromHistory(&m_draw_overlay, overlay_transparency, true);
   }
+  if (overlay && !draw_trails_on_overlay) {
+    if (decimate) {
+      LoadGovernor::DecimateSpoke(data, len, decimated);
+    }
+    m_draw_overlay.draw->ProcessRadarSpoke(overlay_transparency, bearing, display, len);
+  }
+
+  uint64_t trails_start = GetLatencyNanos();
+  UpdateTrailBuffer();
+  if (m_trails) {
+    GeoPosition radar_pos;
+    bool moved = GetRadarPosition(&radar_pos) && HasHeading();
+    m_trails->UpdateTrailPosition(m_pixels_per_meter, moved ? &radar_pos : 0);
+
+    bool trails_on = m_target_trails.GetState() != RCS_OFF;
+    int motion = m_trails_motion.GetValue();
+    uint8_t threshold = (uint8_t)wxMin(M_SETTINGS.threshold_blue, UINT8_MAX);
+
+    // Only the trails for the motion that is shown. The other ones are started again from the
+    // history when they are shown, as they have not aged while they were skipped.
+    if (m_consumers.TakeRebuild(CONSUMER_TRUE_TRAILS) | m_consumers.TakeRebuild(CONSUMER_RELATIVE_TRAILS)) {
+      RebuildTrailsFromHistory(threshold);
+    }
 
-  m_trails->UpdateTrailPosition();
+    // True trails
+    if (m_consumers.IsActive(CONSUMER_TRUE_TRAILS)) {
+      m_trails->UpdateTrueTrails(bearing, data, trail_len, threshold,
+                                 trails_on && motion == TARGET_MOTION_TRUE ? m_trail_colour : 0);
+    }
 
-  // True trails
-  m_trails->UpdateTrueTrails(bearing, data, trail_len);
+    // Relative trails
+    if (m_consumers.IsActive(CONSUMER_RELATIVE_TRAILS)) {
+      m_trails->UpdateRelativeTrails(angle, data, trail_len, threshold,
+                                     trails_on && motion == TARGET_MOTION_RELATIVE ? m_trail_colour : 0);
+    }
+  }
+  uint64_t trails = GetLatencyNanos() - trails_start;
 
-  // Relative trails
-  m_trails->UpdateRelativeTrails(angle, data, trail_len);
+  if (decimate && ((overlay && draw_trails_on_overlay) || panel)) {
+    LoadGovernor::DecimateSpoke(data, len, decimated);
+  }
 
-  if (m_draw_overlay.draw && draw_trails_on_overlay) {
-    m_draw_overlay.draw->ProcessRadarSpoke(M_SETTINGS.overlay_transparency.GetValue(), bearing, data, len);
+  if (overlay && draw_trails_on_overlay) {
+    m_draw_overlay.draw->ProcessRadarSpoke(overlay_transparency, bearing, display, len);
   }
 
-  if (m_draw_panel.draw) {
-    m_draw_panel.draw->ProcessRadarSpoke(4, stabilized_mode ? bearing : angle, data, len);
+  // Read the generation before the stream, so that acknowledging it below covers the stream that was used
+  uint32_t stream_generation = LOAD_ACQUIRE(&m_stream_generation);
+  RadarStream *stream = LOAD_ACQUIRE(&m_stream);
+  if (stream) {
+    stream->ProcessRadarSpoke(bearing, data, len);
+  }
+  STORE_RELEASE(&m_stream_acked, stream_generation);  // Streams replaced up to this generation may now be deleted
+
+  if (panel) {
+    if (m_consumers.TakeRebuild(CONSUMER_PANEL)) {
+      RebuildFromHistory(&m_draw_panel, 4, stabilized_mode);
+    }
+    m_draw_panel.draw->ProcessRadarSpoke(4, stabilized_mode ? bearing : angle, display, len);
+  }
+
+  uint64_t total = GetLatencyNanos() - start;
+  m_latency.Record(LATENCY_SPOKE, total);
+  m_latency.Record(LATENCY_SPOKE_SHARE, shared - start);
+  m_latency.Record(LATENCY_SPOKE_HISTORY, history - shared);
+  m_latency.Record(LATENCY_SPOKE_TRAILS, trails);
+  m_latency.Record(LATENCY_SPOKE_DRAW, total - (history - start) - trails);
+  if (g_trace_enabled) {
+    TraceRecord("trails", trails_start, trails_start + trails);
+    TraceRecord("ProcessRadarSpoke", start, start + total);
+  }
+}
+
+/*
+ * A view that was skipped, or that has a new RadarDraw, gets the last rotation from the
+ * history so it does not start empty. When no history was kept, as for a hidden view, the
+ * old image is wiped instead and the view fills up in one rotation.
+ * Called by the receive thread before the next spoke.
+ */
+void RadarInfo::RebuildFromHistory(DrawInfo *di, int transparency, bool stabilized) {
+  uint8_t spoke[SPOKE_LEN_MAX];
+
+  for (size_t i = 0; i < m_spokes; i++) {
+    uint8_t *line = m_history[i].line;
+    bool kept = m_history_on && m_history[i].time != 0;
+
+    memset(spoke, 0, m_spoke_len_max);
+    if (kept) {
+      for (size_t r = 0; r < m_spoke_len_max; r++) {
+        spoke[r] = (line[r] & 63) << 2;
+      }
+    }
+    di->draw->ProcessRadarSpoke(transparency, stabilized || !kept ? (SpokeBearing)i : m_history[i].angle, spoke, m_spoke_len_max);
+  }
+  LOG_VERBOSE(wxT("radar_pi: %s rebuilt %s from %s"), m_name.c_str(), di == &m_draw_overlay ? wxT("overlay") : wxT("panel"),
+              m_history_on ? wxT("history") : wxT("nothing"));
+}
+
+/*
+ * Trails that were skipped are out of date. Start them again with the echoes of the last rotation
+ * in the history, so they do not start empty; how old the echoes before that were is not kept.
+ * Called by the receive thread before the next spoke.
+ */
+void RadarInfo::RebuildTrailsFromHistory(uint8_t threshold) {
+  uint8_t spoke[SPOKE_LEN_MAX];
+
+  m_trails->ClearTrails();
+  if (!m_history_on) {
+    LOG_VERBOSE(wxT("radar_pi: %s ClearTrails"), m_name.c_str());
+    return;
+  }
+  // The history keeps the top 6 bits of each sample, so compare at that precision
+  threshold &= ~3;
+  for (size_t i = 0; i < m_spokes; i++) {
+    uint8_t *line = m_history[i].line;
+
+    if (m_history[i].time == 0) {
+      continue;
+    }
+    for (size_t r = 0; r < m_spoke_len_max; r++) {
+      spoke[r] = (line[r] & 63) << 2;
+    }
+    if (m_consumers.IsActive(CONSUMER_TRUE_TRAILS)) {
+      m_trails->UpdateTrueTrails((int)i, spoke, m_spoke_len_max, threshold, 0);
+    }
+    if (m_consumers.IsActive(CONSUMER_RELATIVE_TRAILS)) {
+      m_trails->UpdateRelativeTrails(m_history[i].angle, spoke, m_spoke_len_max, threshold, 0);
+    }
+  }
+  LOG_VERBOSE(wxT("radar_pi: %s rebuilt trails from history"), m_name.c_str());
+}
+
+/*
+ * Add the navigation and control state to the recording, the recorder only stores what changed.
+ */
+void RadarInfo::RecordState(wxLongLong time) {
+  double heading = HasHeading() ? GetHeadingTrue() : nan("");
+  GeoPosition pos;
+
+  GetRadarPosition(&pos);
+  m_recorder->RecordNavigation(time, heading, pos.lat, pos.lon);
+
+  RadarControlItem *controls[] = {&m_range,        &m_gain,       &m_sea,
+                                  &m_rain,         &m_ftc,        &m_interference_rejection,
+                                  &m_target_boost, &m_scan_speed, &m_target_expansion,
+                                  &m_noise_rejection, &m_bearing_alignment};
+  ControlType types[] = {CT_RANGE,        CT_GAIN,       CT_SEA,
+                         CT_RAIN,         CT_FTC,        CT_INTERFERENCE_REJECTION,
+                         CT_TARGET_BOOST, CT_SCAN_SPEED, CT_TARGET_EXPANSION,
+                         CT_NOISE_REJECTION, CT_BEARING_ALIGNMENT};
+
+  for (size_t i = 0; i < ARRAY_SIZE(types); i++) {
+    m_recorder->RecordControl(time, types[i], controls[i]->GetValue(), controls[i]->GetState());
   }
 }
 
 void RadarInfo::SampleCourse(int angle) {
   //  Calculates the moving average of m_hdt and returns this in m_course
   //  This is a bit more complicated then expected, average of 359 and 1 is 180 and that is not what we want
-  if (m_pi->GetHeadingSource() != HEADING_NONE && ((angle & 127) == 0)) {  // sample m_hdt every 128 spokes
-    if (m_course_log[m_course_index] > 720.) {                             // keep values within limits
+  if (HasHeading() && ((angle & 127) == 0)) {  // sample m_hdt every 128 spokes
+    if (m_course_log[m_course_index] > 720.) {  // keep values within limits
       for (int i = 0; i < COURSE_SAMPLES; i++) {
         m_course_log[i] -= 720;
       }
@@ -479,7 +844,7 @@ void RadarInfo::SampleCourse(int angle) {
         m_course_log[i] += 720;
       }
     }
-    double hdt = m_pi->GetHeadingTrue();
+    double hdt = GetHeadingTrue();
     while (m_course_log[m_course_index] - hdt > 180.) {  // compare with previous value
       hdt += 360.;
     }
@@ -498,8 +863,8 @@ void RadarInfo::SampleCourse(int angle) {
 }
 
 void RadarInfo::UpdateTransmitState() {
-  wxCriticalSectionLocker lock(m_exclusive);
-  time_t now = time(0);
+  ProfiledLocker lock(m_exclusive);
+  time_t now = GetRadarTime();
 
   int state = m_state.GetValue();
 
@@ -537,7 +902,7 @@ void RadarInfo::RequestRadarState(RadarState state) {
 
   if (m_pi->IsRadarOnScreen(m_radar) && oldState != RADAR_OFF) {                         // if radar is visible and detected
     if (oldState != state && !(oldState != RADAR_STANDBY && state == RADAR_TRANSMIT)) {  // and change is wanted
-      time_t now = time(0);
+      time_t now = GetRadarTime();
 
       if (state == RADAR_TRANSMIT) {
         m_control->RadarTxOn();
@@ -562,27 +927,41 @@ void RadarInfo::RenderGuardZone() {
   int start_bearing = 0, end_bearing = 0;
   GLubyte red = 0, green = 200, blue = 0, alpha = 50;
 
-  for (size_t z = 0; z < GUARD_ZONES; z++) {
+  for (size_t z = 0; z < m_guard_zone_count; z++) {
     if (m_guard_zone[z]->m_alarm_on || m_guard_zone[z]->m_arpa_on || m_guard_zone[z]->m_show_time + 5 > time(0)) {
-      if (m_guard_zone[z]->m_type == GZ_CIRCLE) {
-        start_bearing = 0;
-        end_bearing = 359;
-      } else {
-        start_bearing = m_guard_zone[z]->m_start_bearing;
-        end_bearing = m_guard_zone[z]->m_end_bearing;
-      }
-      switch (m_pi->m_settings.guard_zone_render_style) {
-        case 1:
+      if (m_guard_zone[z]->m_type == GZ_POLYGON) {
+        // Polygons may be concave, so these are only drawn as an outline
+        GuardZoneVertex polygon[GUARD_ZONE_POLYGON_MAX];
+        size_t n = m_guard_zone[z]->GetPolygon(polygon);
+
+        if (m_pi->m_settings.guard_zone_render_style == 1) {
           glColor4ub((GLubyte)255, (GLubyte)0, (GLubyte)0, (GLubyte)255);
-          DrawOutlineArc(m_guard_zone[z]->m_outer_range, m_guard_zone[z]->m_inner_range, start_bearing, end_bearing, true);
-          break;
-        case 2:
-          glColor4ub(red, green, blue, alpha);
-          DrawOutlineArc(m_guard_zone[z]->m_outer_range, m_guard_zone[z]->m_inner_range, start_bearing, end_bearing, false);
-        // fall thru
-        default:
-          glColor4ub(red, green, blue, alpha);
-          DrawFilledArc(m_guard_zone[z]->m_outer_range, m_guard_zone[z]->m_inner_range, start_bearing, end_bearing);
+          DrawOutlinePolygon(polygon, n, true);
+        } else {
+          glColor4ub(red, green, blue, 4 * alpha);
+          DrawOutlinePolygon(polygon, n, false);
+        }
+      } else {
+        if (m_guard_zone[z]->m_type == GZ_CIRCLE) {
+          start_bearing = 0;
+          end_bearing = 359;
+        } else {
+          start_bearing = m_guard_zone[z]->m_start_bearing;
+          end_bearing = m_guard_zone[z]->m_end_bearing;
+        }
+        switch (m_pi->m_settings.guard_zone_render_style) {
+          case 1:
+            glColor4ub((GLubyte)255, (GLubyte)0, (GLubyte)0, (GLubyte)255);
+            DrawOutlineArc(m_guard_zone[z]->m_outer_range, m_guard_zone[z]->m_inner_range, start_bearing, end_bearing, true);
+            break;
+          case 2:
+            glColor4ub(red, green, blue, alpha);
+            DrawOutlineArc(m_guard_zone[z]->m_outer_range, m_guard_zone[z]->m_inner_range, start_bearing, end_bearing, false);
+          // fall thru
+          default:
+            glColor4ub(red, green, blue, alpha);
+            DrawFilledArc(m_guard_zone[z]->m_outer_range, m_guard_zone[z]->m_inner_range, start_bearing, end_bearing);
+        }
       }
     }
 
@@ -684,9 +1063,9 @@ bool RadarInfo::SetControlValue(ControlType controlType, RadarControlItem &item)
         m_idle_standby = 0;
         m_idle_transmit = 0;
         if (m_state.GetValue() == RADAR_TRANSMIT) {
-          m_idle_standby = time(0) + 10;
+          m_idle_standby = GetRadarTime() + 10;
         } else {
-          m_idle_transmit = time(0) + 10;
+          m_idle_transmit = GetRadarTime() + 10;
         }
         m_pi->UpdateAllControlStates(true);
         return true;
@@ -712,12 +1091,56 @@ bool RadarInfo::SetControlValue(ControlType controlType, RadarControlItem &item)
   return false;
 }
 
-void RadarInfo::ShowRadarWindow(bool show) { m_radar_panel->ShowFrame(show); }
+/**
+ * The panel is only made when it is first shown, many radars are never shown in a window.
+ */
+void RadarInfo::ShowRadarWindow(bool show) {
+  if (!m_radar_panel) {
+    if (!show) {
+      return;
+    }
+    m_radar_panel = new RadarPanel(m_pi, this, GetOCPNCanvasWindow());
+    if (!m_radar_panel->Create()) {
+      wxLogError(wxT("radar_pi %s: Unable to create RadarPanel"), m_name.c_str());
+      delete m_radar_panel;
+      m_radar_panel = 0;
+      return;
+    }
+  }
+  m_radar_panel->ShowFrame(show);
+  UpdateConsumers();
+}
 
-bool RadarInfo::IsPaneShown() { return m_radar_panel->IsPaneShown(); }
+bool RadarInfo::IsPaneShown() { return m_radar_panel && m_radar_panel->IsPaneShown(); }
+
+/*
+ * Tell the receive thread which stages of ProcessRadarSpoke are looked at. Called from the
+ * main thread whenever a view may have changed, and every second to catch the rest.
+ */
+void RadarInfo::UpdateConsumers() {
+  bool overlay = m_pi->m_settings.chart_overlay == m_radar;
+  bool trails = m_target_trails.GetState() != RCS_OFF;
+  int motion = m_trails_motion.GetValue();
+
+  // ARPA and the guard zones that search for targets always get the history. A view only keeps
+  // it while it is shown, for a MARPA click; a hidden view is wiped when it is shown again.
+  bool history = IsPaneShown() || (overlay && m_pi->m_settings.show) || (m_arpa && m_arpa->GetTargetCount() > 0);
+  for (size_t z = 0; z < m_guard_zone_count; z++) {
+    if (m_guard_zone[z]->m_arpa_on) {
+      history = true;
+    }
+  }
+
+  m_consumers.SetActive(CONSUMER_PANEL, IsPaneShown());
+  m_consumers.SetActive(CONSUMER_OVERLAY, overlay && m_pi->m_settings.show);
+  m_consumers.SetActive(CONSUMER_TRUE_TRAILS,
+                        trails && motion == TARGET_MOTION_TRUE && m_governor.GetLevel() < DEGRADE_TRUE_TRAILS);
+  m_consumers.SetActive(CONSUMER_RELATIVE_TRAILS, trails && motion == TARGET_MOTION_RELATIVE);
+  m_consumers.SetActive(CONSUMER_HISTORY, history);
+}
 
 void RadarInfo::UpdateControlState(bool all) {
-  wxCriticalSectionLocker lock(m_exclusive);
+  ProfiledLocker lock(m_exclusive);
 
   m_overlay.Update(m_pi->m_settings.chart_overlay == m_radar);
 
@@ -767,7 +1190,7 @@ void RadarInfo::RefreshDisplay() {
 }
 
 void RadarInfo::RenderRadarImage(DrawInfo *di) {
-  wxCriticalSectionLocker lock(m_exclusive);
+  ProfiledLocker lock(m_exclusive);
   int drawing_method = m_pi->m_settings.drawing_method;
   int state = m_state.GetValue();
 
@@ -794,6 +1217,7 @@ void RadarInfo::RenderRadarImage(DrawInfo *di) {
       }
       di->draw = newDraw;
       di->drawing_method = drawing_method;
+      m_consumers.RequestRebuild(di == &m_draw_overlay ? CONSUMER_OVERLAY : CONSUMER_PANEL);
     } else {
       m_pi->m_settings.drawing_method = 0;
       delete newDraw;
@@ -803,7 +1227,18 @@ void RadarInfo::RenderRadarImage(DrawInfo *di) {
     }
   }
 
-  di->draw->DrawRadarImage();
+  {
+    TRACE_SCOPE("DrawRadarImage");
+    di->draw->DrawRadarImage();
+  }
+  if (m_stream && di == &m_draw_panel) {
+    // Serve the image as drawn when the draw method makes one, it has the colours of the screen
+    size_t size;
+    const uint8_t *image = di->draw->GetImage(&size);
+    if (image && m_stream->WantsFrame()) {
+      m_stream->Publish(image, size, 4);
+    }
+  }
   if (g_first_render) {
     g_first_render = false;
     wxLongLong startup_elapsed = wxGetUTCTimeMillis() - m_pi->GetBootMillis();
@@ -811,11 +1246,39 @@ void RadarInfo::RenderRadarImage(DrawInfo *di) {
   }
 }
 
+double RadarInfo::GetHeadingTrue() {
+  {
+    ProfiledLocker lock(m_exclusive);
+
+    if (!isnan(m_replay_heading)) {
+      return m_replay_heading;
+    }
+  }
+  return m_pi->GetHeadingTrue();
+}
+
+bool RadarInfo::HasHeading() {
+  {
+    ProfiledLocker lock(m_exclusive);
+
+    if (!isnan(m_replay_heading)) {
+      return true;
+    }
+  }
+  return m_pi->GetHeadingSource() != HEADING_NONE;
+}
+
+void RadarInfo::SetReplayHeading(double heading) {
+  ProfiledLocker lock(m_exclusive);
+
+  m_replay_heading = heading;
+}
+
 int RadarInfo::GetOrientation() {
   int orientation;
 
   // check for no longer allowed value
-  if (m_pi->GetHeadingSource() == HEADING_NONE) {
+  if (!HasHeading()) {
     orientation = ORIENTATION_HEAD_UP;
   } else {
     orientation = m_orientation.GetValue();
@@ -827,7 +1290,7 @@ int RadarInfo::GetOrientation() {
 void RadarInfo::RenderRadarImage(wxPoint center, double scale, double overlay_rotate, bool overlay) {
   bool arpa_on = false;
   if (m_arpa) {
-    for (int i = 0; i < GUARD_ZONES; i++) {
+    for (size_t i = 0; i < m_guard_zone_count; i++) {
       if (m_guard_zone[i]->m_arpa_on) arpa_on = true;
     }
     if (m_arpa->GetTargetCount() > 0) {
@@ -857,23 +1320,23 @@ void RadarInfo::RenderRadarImage(wxPoint center, double scale, double overlay_ro
       case ORIENTATION_STABILIZED_UP:
         panel_rotate -= m_course;  // Panel only needs stabilized heading applied
         arpa_rotate -= m_course;
-        guard_rotate += m_pi->GetHeadingTrue() - m_course;
+        guard_rotate += GetHeadingTrue() - m_course;
         break;
       case ORIENTATION_COG_UP: {
         double cog = m_pi->GetCOG();
         panel_rotate -= cog;  // Panel only needs stabilized heading applied
         arpa_rotate -= cog;
-        guard_rotate += m_pi->GetHeadingTrue() - cog;
+        guard_rotate += GetHeadingTrue() - cog;
       } break;
       case ORIENTATION_NORTH_UP:
-        guard_rotate += m_pi->GetHeadingTrue();
+        guard_rotate += GetHeadingTrue();
         break;
       case ORIENTATION_HEAD_UP:
-        arpa_rotate += -m_pi->GetHeadingTrue();  // Undo the actual heading calculation always done for ARPA
+        arpa_rotate += -GetHeadingTrue();  // Undo the actual heading calculation always done for ARPA
         break;
     }
   } else {
-    guard_rotate += m_pi->GetHeadingTrue();
+    guard_rotate += GetHeadingTrue();
     arpa_rotate = overlay_rotate - OPENGL_ROTATION;
   }
 
@@ -882,6 +1345,7 @@ void RadarInfo::RenderRadarImage(wxPoint center, double scale, double overlay_ro
   }
 
   wxStopWatch stopwatch;
+  uint64_t render_start = GetLatencyNanos();
 
   // Render the guard zone
   if (!overlay || (M_SETTINGS.guard_zone_on_overlay && (M_SETTINGS.overlay_on_standby || m_state.GetValue() == RADAR_TRANSMIT))) {
@@ -920,6 +1384,7 @@ void RadarInfo::RenderRadarImage(wxPoint center, double scale, double overlay_ro
   }
 
   m_draw_time_ms = stopwatch.Time();
+  m_latency.Record(LATENCY_RENDER, GetLatencyNanos() - render_start);
 
   glPopAttrib();
 }
@@ -1011,10 +1476,18 @@ wxString RadarInfo::FormatAngle(double angle) {
 wxString RadarInfo::GetCanvasTextBottomLeft() {
   GeoPosition radar_pos;
   wxString s = GetTimedIdleText();
+  wxString degraded = GetDegradedText();
+
+  if (degraded.length() > 0) {
+    if (s.length() > 0) {
+      s << wxT("\n");
+    }
+    s << degraded;
+  }
 
   LOG_VERBOSE(wxT("radar_pi: %s BottomLeft = %s"), m_name.c_str(), s.c_str());
 
-  for (int z = 0; z < GUARD_ZONES; z++) {
+  for (size_t z = 0; z < m_guard_zone_count; z++) {
     int bogeys = m_guard_zone[z]->GetBogeyCount();
     if (bogeys > 0 || (m_pi->m_guard_bogey_confirmed && bogeys == 0)) {
       if (s.length() > 0) {
@@ -1065,7 +1538,7 @@ wxString RadarInfo::GetCanvasTextBottomLeft() {
       distance = local_distance(radar_pos, m_mouse_pos);
       bearing = local_bearing(radar_pos, m_mouse_pos);
       if (GetOrientation() != ORIENTATION_NORTH_UP) {
-        bearing -= m_pi->GetHeadingTrue();
+        bearing -= GetHeadingTrue();
       }
     }
 
@@ -1228,13 +1701,13 @@ void RadarInfo::SetMouseVrmEbl(double vrm, double ebl) {
       m_mouse_ebl[ORIENTATION_NORTH_UP] = ebl + m_course;
       m_mouse_ebl[ORIENTATION_COG_UP] = ebl + m_course - cog;
       m_mouse_ebl[ORIENTATION_STABILIZED_UP] = ebl;
-      bearing = ebl + m_pi->GetHeadingTrue();
+      bearing = ebl + GetHeadingTrue();
       break;
     case ORIENTATION_COG_UP:
       m_mouse_ebl[ORIENTATION_NORTH_UP] = ebl + cog;
       m_mouse_ebl[ORIENTATION_STABILIZED_UP] = ebl + cog - m_course;
       m_mouse_ebl[ORIENTATION_COG_UP] = ebl;
-      bearing = ebl + m_pi->GetHeadingTrue();
+      bearing = ebl + GetHeadingTrue();
       break;
   }
 
@@ -1306,10 +1779,10 @@ void RadarInfo::ComputeTargetTrails() {
   // Disperse the BLOB_HISTORY values over 0..maxrev
   for (revolution = 0; revolution <= TRAIL_MAX_REVOLUTIONS; revolution++) {
     if (revolution >= 1 && revolution < maxRev) {
-      m_trail_colour[revolution] = (BlobColour)(BLOB_HISTORY_0 + (int)colour);
+      m_trail_colour[revolution] = (uint8_t)(BLOB_HISTORY_0 + (int)colour);
       colour += coloursPerRevolution;
     } else {
-      m_trail_colour[revolution] = BLOB_NONE;
+      m_trail_colour[revolution] = (uint8_t)BLOB_NONE;
     }
     // LOG_VERBOSE(wxT("radar_pi: ComputeTargetTrails rev=%u color=%d"), revolution, m_trail_colour[revolution]);
   }
@@ -1322,11 +1795,31 @@ wxString RadarInfo::GetInfoStatus() {
   return _("Uninitialized");
 }
 
-void RadarInfo::ClearTrails() {
-  if (m_trails) {
+void RadarInfo::ClearTrails() { m_clear_trails = 1; }
+
+/**
+ * Start, clear or free the trails as asked for. Only called by the receive thread,
+ * so m_trails does not go away while a spoke is added to it.
+ *
+ * The trails are megabytes per radar, so they only exist while they are on. Clearing them
+ * keeps the buffer, as a range change would otherwise free and allocate it again.
+ */
+void RadarInfo::UpdateTrailBuffer() {
+  bool on = m_target_trails.GetState() != RCS_OFF;
+  bool clear = ATOMIC_EXCHANGE(&m_clear_trails, 0) != 0;  // A request made after this is seen next spoke
+
+  if (m_trails && !on) {
+    m_memory.Freed(MEMORY_TRAILS, m_trails->GetMemorySize());
     delete m_trails;
+    m_trails = 0;
+  } else if (m_trails && clear) {
+    LOG_VERBOSE(wxT("radar_pi: %s ClearTrails"), m_name.c_str());
+    m_trails->ClearTrails();
+  }
+  if (on && !m_trails) {
+    m_trails = new TrailBuffer(m_spokes, m_spoke_len_max, m_polar_lookup);
+    m_memory.Allocated(MEMORY_TRAILS, m_trails->GetMemorySize());
   }
-  m_trails = new TrailBuffer(this, m_spokes, m_spoke_len_max);
 }
 
 int RadarInfo::GetNearestRange(int range_meters, int units) {
@@ -1384,6 +1877,30 @@ wxString RadarInfo::GetTimedIdleText() {
   return s;
 }
 
+/*
+ * What the load governor has given up on, so a picture with less detail is not mistaken
+ * for what the radar sees.
+ */
+wxString RadarInfo::GetDegradedText() {
+  wxString s;
+
+  switch (m_governor.GetLevel()) {
+    case DEGRADE_NONE:
+    case DEGRADE_LEVELS:
+      break;
+    case DEGRADE_OVERLAY:
+      s << _("Overload") << wxT(": ") << _("overlay every other rotation");
+      break;
+    case DEGRADE_TRUE_TRAILS:
+      s << _("Overload") << wxT(": ") << _("no true trails");
+      break;
+    case DEGRADE_DECIMATE:
+      s << _("Overload") << wxT(": ") << _("reduced range detail");
+      break;
+  }
+  return s;
+}
+
 wxString RadarInfo::GetRadarStateText() {
   wxString o;
   RadarState state = (RadarState)m_state.GetValue();
@@ -1473,7 +1990,7 @@ void RadarInfo::CheckTimedTransmit() {
     return;
   }
 
-  time_t now = time(0);
+  time_t now = GetRadarTime();
   int time_to_go;
 
   if (m_idle_standby > 0) {
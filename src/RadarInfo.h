@@ -35,17 +35,23 @@
 #include "radar_pi.h"
 
 #include "ControlsDialog.h"
+#include "GuardZoneIntervals.h"
+#include "LoadGovernor.h"
 #include "RadarControlItem.h"
 #include "RadarReceive.h"
+#include "SpokeConsumers.h"
+#include "TrailBuffer.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
 class RadarDraw;
 class RadarCanvas;
 class RadarPanel;
+class RadarRecorder;
+class RadarStream;
+class SpokePublisher;
 class GuardZoneBogey;
 class RadarInfo;
-class TrailBuffer;
 
 struct DrawInfo {
   RadarDraw *draw;
@@ -53,15 +59,11 @@ struct DrawInfo {
   bool color_option;
 };
 
-#define SECONDS_TO_REVOLUTIONS(x) ((x)*2 / 5)
-#define TRAIL_MAX_REVOLUTIONS SECONDS_TO_REVOLUTIONS(600) + 1
 enum { TRAIL_15SEC, TRAIL_30SEC, TRAIL_1MIN, TRAIL_3MIN, TRAIL_5MIN, TRAIL_10MIN, TRAIL_CONTINUOUS, TRAIL_ARRAY_SIZE };
 
 #define COURSE_SAMPLES (16)
 
 class RadarInfo {
-  friend class TrailBuffer;
-
  public:
   wxString m_name;         // Either "Radar", "Radar A", "Radar B".
   radar_pi *m_pi;          // Pointer back to the plugin
@@ -84,7 +86,7 @@ class RadarInfo {
   double m_course_log[COURSE_SAMPLES];
   int m_course_index;
   RadarArpa *m_arpa;
-  wxCriticalSection m_exclusive;
+  ProfiledCriticalSection m_exclusive;
 
   /* User radar settings */
 
@@ -129,6 +131,21 @@ class RadarInfo {
 
   RadarControl *m_control;
   RadarReceive *m_receive;
+  RadarStream *volatile m_stream;                     // Serves the image to other displays, if enabled
+  volatile uint32_t m_stream_generation;              // Incremented by the GUI thread each time m_stream is replaced
+  volatile uint32_t m_stream_acked;                   // Generation the receive thread read before its last use of m_stream
+  std::vector<RadarStream *> m_stream_retired;        // Replaced streams, the receive thread may still be using them
+  std::vector<uint32_t> m_stream_retired_generation;  // The generation that replaced each of them
+  int m_stream_port;                                  // Settings that m_stream was made for
+  bool m_stream_all_interfaces;
+  SpokePublisher *m_spoke_publisher;                  // Shares the spokes with other stations, if enabled
+  RadarRecorder *m_recorder;                          // Records the session, if enabled
+
+  // The time of this radar's data: the real time, or the time in the file while it is replayed.
+  // The replay clock belongs to the radar and not to ReplayReceive, so m_clock is always valid.
+  RadarClock *volatile m_clock;
+  SimulatedClock m_replay_clock;
+  double m_replay_heading;  // Heading recorded with the replayed session, NaN if none. Protected by m_exclusive.
   ControlsDialog *m_control_dialog;
   RadarPanel *m_radar_panel;
   RadarCanvas *m_radar_canvas;
@@ -147,23 +164,32 @@ class RadarInfo {
 
   int m_refresh_millis;
 
-  GuardZone *m_guard_zone[GUARD_ZONES];
+  GuardZone *m_guard_zone[GUARD_ZONES_MAX];
+  GuardZoneSpoke m_guard_spoke;  // Samples of the current spoke counted for the guard zones, receive thread only
+  size_t m_guard_zone_count;
   double m_ebl[ORIENTATION_NUMBER][BEARING_LINES];
   double m_vrm[BEARING_LINES];
   receive_statistics m_statistics;
+  RadarLatency m_latency;      // How long each stage of the spoke pipeline takes
+  MemoryAccount m_memory;      // The large buffers that this radar holds
+  SpokeConsumers m_consumers;  // The stages of ProcessRadarSpoke that someone looks at
+  LoadGovernor m_governor;     // Sheds display work when this radar costs too much
 
+  // The top two bits of a sample are used by ARPA, the others keep the strength of the
+  // return so a view can be rebuilt from the history.
   struct line_history {
     uint8_t *line;
     wxLongLong time;
     GeoPosition pos;
+    SpokeBearing angle;  // Relative to the boat, for a head up panel
   };
 
   line_history *m_history;
 
   int m_old_range;
-  int m_dir_lat;
-  int m_dir_lon;
-  TrailBuffer *m_trails;
+  TrailBuffer *m_trails;             // Only exists while the trails are on, owned by the receive thread
+  volatile uint32_t m_clear_trails;  // Set by ClearTrails(), taken by the receive thread which clears m_trails
+  bool m_first_spoke_logged;         // The time from Init to the first spoke is logged once
 
   // Timed Transmit
   time_t m_idle_standby;   // When we will change to standby
@@ -174,8 +200,19 @@ class RadarInfo {
   RadarInfo(radar_pi *pi, int radar);
   ~RadarInfo();
 
+  wxLongLong GetRadarMillis() { return m_clock->GetMillis(); }
+  time_t GetRadarTime() { return m_clock->GetTime(); }
+  time_t GetRadarCoarseTime() { return m_clock->GetCoarseTime(); }
+
+  // The true heading for this radar's bearings: the heading of a replayed session, or else the ship's.
+  // A replay keeps its heading to itself, so the other radars and OpenCPN keep the ship's heading.
+  double GetHeadingTrue();
+  bool HasHeading();
+  void SetReplayHeading(double heading);
+
   bool Init();
   void SetName(wxString name);
+  void SetGuardZoneCount(size_t count);
   wxString GetInfoStatus();
 
   void AdjustRange(int adjustment);
@@ -193,15 +230,17 @@ class RadarInfo {
   void Shutdown();
   // void DeleteReceive();
   void UpdateTransmitState();
+  void UpdateConsumers();
   void RequestRadarState(RadarState state);
   int GetDrawTime() {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
     return IsPaneShown() ? m_draw_time_ms : 0;
   };
   bool IsPaneShown();
 
   void UpdateControlState(bool all);
   void ComputeColourMap();
+  void UpdateStream();
   void ComputeTargetTrails();
   void CheckTimedTransmit();
   void SetTimedNextStateTimer(int ms);
@@ -213,10 +252,11 @@ class RadarInfo {
   void SetMouseVrmEbl(double vrm, double ebl);
   void SetBearing(int bearing);
   void SampleCourse(int angle);
+  void RecordState(wxLongLong time);
   int GetOrientation();
   void ClearTrails();
   void SetRadarPosition(GeoPosition boat_pos, double heading) {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
 
     if (m_antenna_starboard.GetValue() != 0 || m_antenna_forward.GetValue() != 0) {
       double sine = sin(deg2rad(heading));
@@ -230,7 +270,7 @@ class RadarInfo {
     }
   }
   bool GetRadarPosition(GeoPosition *pos) {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
 
     if (m_pi->IsBoatPositionValid() && VALID_GEO(m_radar_position.lat) && VALID_GEO(m_radar_position.lon)) {
       *pos = m_radar_position;
@@ -245,6 +285,7 @@ class RadarInfo {
   wxString GetCanvasTextBottomLeft();
   wxString GetCanvasTextCenter();
   wxString GetTimedIdleText();
+  wxString GetDegradedText();
   wxString GetRadarStateText();
 
   GeoPosition m_mouse_pos;
@@ -263,6 +304,10 @@ class RadarInfo {
 
  private:
   void ResetSpokes();
+  void ClearHistory();
+  void RebuildFromHistory(DrawInfo *di, int transparency, bool stabilized);
+  void RebuildTrailsFromHistory(uint8_t threshold);
+  void UpdateTrailBuffer();
   void RenderRadarImage(DrawInfo *di);
   wxString FormatDistance(double distance);
   wxString FormatAngle(double angle);
@@ -278,9 +323,10 @@ class RadarInfo {
 
   wxString m_range_text;
 
-  BlobColour m_trail_colour[TRAIL_MAX_REVOLUTIONS + 1];
+  uint8_t m_trail_colour[TRAIL_MAX_REVOLUTIONS + 1];  // BlobColour of each trail age
 
   int m_previous_orientation;
+  bool m_history_on;  // The last spoke was added to m_history, receive thread only
 
   GeoPosition m_radar_position;
 };
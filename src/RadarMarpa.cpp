@@ -43,6 +43,7 @@ RadarArpa::RadarArpa(radar_pi* pi, RadarInfo* ri) {
   m_ri = ri;
   m_pi = pi;
   m_number_of_targets = 0;
+  m_dangerous_targets = 0;
   CLEAR_STRUCT(m_targets);
 }
 
@@ -54,10 +55,11 @@ ArpaTarget::~ArpaTarget() {
 }
 
 RadarArpa::~RadarArpa() {
-  int n = m_number_of_targets;
   m_number_of_targets = 0;
-  for (int i = 0; i < n; i++) {
+  // Lost targets are kept beyond m_number_of_targets for reuse, so free all of them
+  for (int i = 0; i < MAX_NUMBER_OF_TARGETS; i++) {
     if (m_targets[i]) {
+      m_ri->m_memory.Freed(MEMORY_ARPA, sizeof(ArpaTarget) + (m_targets[i]->m_kalman ? sizeof(KalmanFilter) : 0));
       delete m_targets[i];
       m_targets[i] = 0;
     }
@@ -114,7 +116,7 @@ bool ArpaTarget::MultiPix(int ang, int rad) {  // checks if the blob has a conto
   // pol must start on the contour of the blob
   // false if not
   // if false clears out pixels of the blob in hist
-  wxCriticalSectionLocker lock(ArpaTarget::m_ri->m_exclusive);
+  ProfiledLocker lock(ArpaTarget::m_ri->m_exclusive);
   int length = m_ri->m_min_contour_length;
   Polar start;
   start.angle = ang;
@@ -335,6 +337,7 @@ void RadarArpa::AcquireOrDeleteMarpaTarget(Position target_pos, int status) {
       (m_number_of_targets == MAX_NUMBER_OF_TARGETS - 1 && status == FOR_DELETION)) {
     if (m_targets[m_number_of_targets] == 0) {
       m_targets[m_number_of_targets] = new ArpaTarget(m_pi, m_ri);
+      m_ri->m_memory.Allocated(MEMORY_ARPA, sizeof(ArpaTarget));
     }
     i_target = m_number_of_targets;
     m_number_of_targets++;
@@ -351,6 +354,7 @@ void RadarArpa::AcquireOrDeleteMarpaTarget(Position target_pos, int status) {
   target->m_position.dlat_dt = 0.;
   target->m_position.dlon_dt = 0.;
   target->m_status = status;
+  target->m_pass_to_ocpn = false;
 
   target->m_max_angle.angle = 0;
   target->m_min_angle.angle = 0;
@@ -359,6 +363,7 @@ void RadarArpa::AcquireOrDeleteMarpaTarget(Position target_pos, int status) {
 
   if (!target->m_kalman) {
     target->m_kalman = new KalmanFilter(m_ri->m_spokes);
+    m_ri->m_memory.Allocated(MEMORY_ARPA, sizeof(KalmanFilter));
   }
   target->m_automatic = false;
   return;
@@ -396,7 +401,7 @@ bool ArpaTarget::FindContourFromInside(Polar* pol) {  // moves pol to contour of
  * Returns 0 if ok, or a small integer on error (but nothing is done with this)
  */
 int ArpaTarget::GetContour(Polar* pol) {
-  wxCriticalSectionLocker lock(ArpaTarget::m_ri->m_exclusive);
+  ProfiledLocker lock(ArpaTarget::m_ri->m_exclusive);
   // the 4 possible translations to move from a point on the contour to the next
   Polar transl[4];  //   = { 0, 1,   1, 0,   0, -1,   -1, 0 };
   transl[0].angle = 0;
@@ -577,6 +582,7 @@ void RadarArpa::CleanUpLostTargets() {
 }
 
 void RadarArpa::RefreshArpaTargets() {
+  TRACE_SCOPE("RefreshArpaTargets");
   CleanUpLostTargets();
   int target_to_delete = -1;
   // find a target with status FOR_DELETION if it is there
@@ -641,7 +647,93 @@ void RadarArpa::RefreshArpaTargets() {
     m_targets[i]->RefreshTarget(dist);
   }
 
-  for (int i = 0; i < GUARD_ZONES; i++) m_ri->m_guard_zone[i]->SearchTargets();
+  UpdateCPA();
+  PassTargetsToOCPN();
+
+  for (size_t i = 0; i < m_ri->m_guard_zone_count; i++) m_ri->m_guard_zone[i]->SearchTargets();
+}
+
+// Compute CPA and TCPA of all active targets relative to own ship, and count the targets that
+// are within the alarm limits.
+void RadarArpa::UpdateCPA() {
+  ArpaCpa<MAX_NUMBER_OF_TARGETS> cpa;
+  ArpaTarget* target[MAX_NUMBER_OF_TARGETS];
+  GeoPosition own;
+  double own_dlat_dt;
+  double own_dlon_dt;
+  bool valid = m_ri->GetRadarPosition(&own) && m_pi->GetOwnShipVelocity(&own_dlat_dt, &own_dlon_dt);
+  wxLongLong now = m_ri->GetRadarMillis();
+
+  for (int i = 0; i < m_number_of_targets; i++) {
+    ArpaTarget* t = m_targets[i];
+    if (!t) continue;
+    t->m_cpa = nan("");
+    t->m_tcpa = nan("");
+    t->m_cpa_state = CPA_UNKNOWN;
+    if (!valid || t->m_status < STATUS_TO_OCPN) continue;
+
+    // Move the target to where it is now, it was last seen somewhere during the previous sweep
+    double delta_t = (now - t->m_position.time).ToDouble() / 1000.;
+    double north = (t->m_position.pos.lat - own.lat) * 60. * 1852. + t->m_position.dlat_dt * delta_t;
+    double east = (t->m_position.pos.lon - own.lon) * 60. * 1852. * cos(deg2rad(own.lat)) + t->m_position.dlon_dt * delta_t;
+    int n = cpa.Add(north, east, t->m_position.dlat_dt - own_dlat_dt, t->m_position.dlon_dt - own_dlon_dt);
+    if (n >= 0) {
+      target[n] = t;
+    }
+  }
+
+  cpa.Compute();
+
+  double alarm_cpa = M_SETTINGS.arpa_cpa_alarm * 1852.;  // 0 = alarm off
+  double alarm_tcpa = M_SETTINGS.arpa_tcpa_alarm * 60.;
+  int dangerous = 0;
+
+  for (size_t i = 0; i < cpa.GetCount(); i++) {
+    target[i]->m_cpa = cpa.GetCPA(i) / 1852.;
+    target[i]->m_tcpa = cpa.GetTCPA(i) / 60.;
+    if (alarm_cpa > 0. && cpa.IsDangerous(i, alarm_cpa, alarm_tcpa)) {
+      target[i]->m_cpa_state = CPA_DANGEROUS;
+      dangerous++;
+    } else {
+      target[i]->m_cpa_state = CPA_SAFE;
+    }
+  }
+  m_dangerous_targets = dangerous;
+}
+
+void RadarArpa::PassTargetsToOCPN() {
+  AisArpaQuery query[MAX_NUMBER_OF_TARGETS];
+  ArpaTarget* target[MAX_NUMBER_OF_TARGETS];
+  bool ais_hit[MAX_NUMBER_OF_TARGETS];
+  size_t n = 0;
+
+  for (int i = 0; i < m_number_of_targets; i++) {
+    ArpaTarget* t = m_targets[i];
+    if (!t || !t->m_pass_to_ocpn) continue;
+    t->m_pass_to_ocpn = false;
+    if (t->m_status < STATUS_TO_OCPN) continue;
+    query[n].pos = t->m_position.pos;
+    query[n].dist = t->m_ocpn_polar.r / m_ri->m_pixels_per_meter;
+    target[n] = t;
+    n++;
+  }
+  if (n == 0) {
+    return;
+  }
+
+  // Check for AIS targets at the (M)ARPA positions
+  m_pi->FindAIS_at_arpaPos(query, n, ais_hit);
+
+  // OpenCPN takes a single sentence per PushNMEABuffer, so they can not be pushed together.
+  // What is saved is the formatting, and the TTMs of targets that did not change.
+  NmeaSentence nmea;
+  wxLongLong now = m_ri->GetRadarMillis();
+
+  for (size_t i = 0; i < n; i++) {
+    if (target[i]->MakeTTM(&nmea, &target[i]->m_ocpn_polar, ais_hit[i] ? L : target[i]->m_ocpn_status, now, false)) {
+      PushNMEABuffer(wxString::FromAscii(nmea.GetSentence()));
+    }
+  }
 }
 
 void ArpaTarget::RefreshTarget(int dist) {
@@ -666,7 +758,7 @@ void ArpaTarget::RefreshTarget(int dist) {
   // the beam sould have passed our "angle" AND a point SCANMARGIN further
   // always refresh when status == 0
   if ((time1 < (m_refresh + SCAN_MARGIN2) || time2 < time1) && m_status != 0) {
-    wxLongLong now = wxGetUTCTimeMillis();  // millis
+    wxLongLong now = m_ri->GetRadarMillis();  // millis
     int diff = now.GetLo() - m_refresh.GetLo();
     if (diff > 8000) {
       LOG_ARPA(wxT("radar_pi: target not refreshed, missing spokes, set lost, status= %i, target_id= %i timediff= %i"), m_status,
@@ -860,10 +952,10 @@ void ArpaTarget::RefreshTarget(int dist) {
         // if target was not seen last sweep, color yellow
         s = Q;
       }
-      // Check for AIS target at (M)ARPA position
-      double dist2target = pol.r / m_ri->m_pixels_per_meter;
-      if (m_pi->FindAIS_at_arpaPos(m_position.pos, dist2target)) s = L;
-      PassARPAtoOCPN(&pol, s);
+      // RadarArpa checks all refreshed targets against AIS in one go and then sends them
+      m_ocpn_polar = pol;
+      m_ocpn_status = s;
+      m_pass_to_ocpn = true;
     }
   }
   return;
@@ -929,6 +1021,12 @@ ArpaTarget::ArpaTarget(radar_pi* pi, RadarInfo* ri) {
   m_position.dlon_dt = 0.;
   m_pass1_result = UNKNOWN;
   m_pass_nr = PASS1;
+  m_pass_to_ocpn = false;
+  m_sent.status = -1;
+  m_sent.time = 0;
+  m_cpa = nan("");
+  m_tcpa = nan("");
+  m_cpa_state = CPA_UNKNOWN;
 }
 
 ArpaTarget::ArpaTarget() {
@@ -946,6 +1044,12 @@ ArpaTarget::ArpaTarget() {
   m_position.dlon_dt = 0.;
   m_pass1_result = UNKNOWN;
   m_pass_nr = PASS1;
+  m_pass_to_ocpn = false;
+  m_sent.status = -1;
+  m_sent.time = 0;
+  m_cpa = nan("");
+  m_tcpa = nan("");
+  m_cpa_state = CPA_UNKNOWN;
 }
 
 bool ArpaTarget::GetTarget(Polar* pol, int dist1) {
@@ -983,69 +1087,70 @@ bool ArpaTarget::GetTarget(Polar* pol, int dist1) {
 }
 
 void ArpaTarget::PassARPAtoOCPN(Polar* pol, OCPN_target_status status) {
-  wxString s_TargID, s_Bear_Unit, s_Course_Unit;
-  wxString s_speed, s_course, s_Dist_Unit, s_status;
-  wxString s_bearing;
-  wxString s_distance;
-  wxString s_target_name;
-  wxString nmea;
-  char sentence[90];
-  char checksum = 0;
-  char* p;
-
-  s_Bear_Unit = wxEmptyString;  // Bearing Units  R or empty
-  s_Course_Unit = wxT("T");     // Course type R; Realtive T; true
-  s_Dist_Unit = wxT("N");       // Speed/Distance Unit K, N, S N= NM/h = Knots
-  switch (status) {
-    case Q:
-      s_status = wxT("Q");  // yellow
-      break;
-    case T:
-      s_status = wxT("T");  // green
-      break;
-    case L:
-      s_status = wxT("L");  // ?
-      break;
-  }
+  NmeaSentence nmea;
 
+  MakeTTM(&nmea, pol, status, m_ri->GetRadarMillis(), true);
+  PushNMEABuffer(wxString::FromAscii(nmea.GetSentence()));
+}
+
+bool ArpaTarget::MakeTTM(NmeaSentence* nmea, Polar* pol, OCPN_target_status status, wxLongLong now, bool force) {
   double dist = pol->r / m_ri->m_pixels_per_meter / 1852.;
   double bearing = pol->angle * 360. / m_ri->m_spokes;
 
   if (bearing < 0) bearing += 360;
-  s_TargID = wxString::Format(wxT("%2i"), m_target_id);
-  s_speed = wxString::Format(wxT("%4.2f"), m_speed_kn);
-  s_course = wxString::Format(wxT("%3.1f"), m_course);
-  if (m_automatic) {
-    s_target_name = wxString::Format(wxT("ARPA%2i"), m_target_id);
-  } else {
-    s_target_name = wxString::Format(wxT("MARPA%2i"), m_target_id);
+
+  // Don't send the target again if nothing has changed in the resolution that we send
+  SentTTM sent;
+  sent.status = status;
+  sent.distance = (int)(dist * 1000. + 0.5);
+  sent.bearing = (int)(bearing * 100. + 0.5);
+  sent.speed = (int)(m_speed_kn * 100. + 0.5);
+  sent.course = (int)(m_course * 10. + 0.5);
+  sent.cpa = m_cpa_state;  // So a target that crosses the alarm limits is sent at once
+  sent.time = now;
+  if (!force && sent.status == m_sent.status && sent.distance == m_sent.distance && sent.bearing == m_sent.bearing &&
+      sent.speed == m_sent.speed && sent.course == m_sent.course && sent.cpa == m_sent.cpa &&
+      now < m_sent.time + TTM_RESEND_TIMEOUT) {
+    return false;
   }
-  s_distance = wxString::Format(wxT("%f"), dist);
-  s_bearing = wxString::Format(wxT("%f"), bearing);
+  m_sent = sent;
 
   /* Code for TTM follows. Send speed and course using TTM*/
-  snprintf(sentence, sizeof(sentence), "RATTM,%2s,%s,%s,%s,%s,%s,%s, , ,%s,%s,%s, ",
-           (const char*)s_TargID.mb_str(),       // 1 target id
-           (const char*)s_distance.mb_str(),     // 2 Targ distance
-           (const char*)s_bearing.mb_str(),      // 3 Bearing fr own ship.
-           (const char*)s_Bear_Unit.mb_str(),    // 4 Brearing unit ( T = true)
-           (const char*)s_speed.mb_str(),        // 5 Target speed
-           (const char*)s_course.mb_str(),       // 6 Target Course.
-           (const char*)s_Course_Unit.mb_str(),  // 7 Course ref T // 8 CPA Not used // 9 TCPA Not used
-           (const char*)s_Dist_Unit.mb_str(),    // 10 S/D Unit N = knots/Nm
-           (const char*)s_target_name.mb_str(),  // 11 Target name
-           (const char*)s_status.mb_str());      // 12 Target Status L/Q/T // 13 Ref N/A
-
-  for (p = sentence; *p; p++) {
-    checksum ^= *p;
-  }
-  nmea.Printf(wxT("$%s*%02X\r\n"), sentence, (unsigned)checksum);
-  PushNMEABuffer(nmea);
+  nmea->Begin("RATTM");
+  nmea->AddInt(m_target_id, 2);                    // 1 target id
+  nmea->AddFixed(dist, 3);                         // 2 Targ distance
+  nmea->AddFixed(bearing, 2);                      // 3 Bearing fr own ship.
+  nmea->AddField("");                              // 4 Brearing unit ( T = true)
+  nmea->AddFixed(m_speed_kn, 2);                   // 5 Target speed
+  nmea->AddFixed(m_course, 1);                     // 6 Target Course.
+  nmea->AddChar('T');                              // 7 Course ref T; true, R; relative
+  nmea->AddFixed(m_cpa, 2);                        // 8 CPA, empty if not known
+  nmea->AddFixed(m_tcpa, 1);                       // 9 TCPA in minutes
+  nmea->AddChar('N');                              // 10 S/D Unit N = knots/Nm
+  nmea->AddField(m_automatic ? "ARPA" : "MARPA");  // 11 Target name
+  nmea->AppendInt(m_target_id, 2);
+  switch (status) {  // 12 Target Status L/Q/T
+    case Q:
+      nmea->AddChar('Q');  // yellow
+      break;
+    case T:
+      nmea->AddChar('T');  // green
+      break;
+    case L:
+      nmea->AddChar('L');  // ?
+      break;
+  }
+  nmea->AddChar(' ');  // 13 Ref N/A
+  nmea->Finish();
+  return true;
 }
 
 void ArpaTarget::SetStatusLost() {
   m_contour_length = 0;
   m_lost_count = 0;
+  m_cpa = nan("");
+  m_tcpa = nan("");
+  m_cpa_state = CPA_UNKNOWN;
   if (m_kalman) {
     // reset kalman filter, don't delete it, too  expensive
     m_kalman->ResetFilter();
@@ -1066,6 +1171,9 @@ void ArpaTarget::SetStatusLost() {
   m_position.dlat_dt = 0.;
   m_position.dlon_dt = 0.;
   m_pass_nr = PASS1;
+  m_pass_to_ocpn = false;
+  m_sent.status = -1;
+  m_sent.time = 0;
 }
 
 void RadarArpa::DeleteAllTargets() {
@@ -1073,6 +1181,7 @@ void RadarArpa::DeleteAllTargets() {
     if (!m_targets[i]) continue;
     m_targets[i]->SetStatusLost();
   }
+  m_dangerous_targets = 0;
 }
 
 int RadarArpa::AcquireNewARPATarget(Polar pol, int status) {
@@ -1091,6 +1200,7 @@ int RadarArpa::AcquireNewARPATarget(Polar pol, int status) {
   if (m_number_of_targets < MAX_NUMBER_OF_TARGETS - 1 || (m_number_of_targets == MAX_NUMBER_OF_TARGETS - 1 && status == -2)) {
     if (!m_targets[m_number_of_targets]) {
       m_targets[m_number_of_targets] = new ArpaTarget(m_pi, m_ri);
+      m_ri->m_memory.Allocated(MEMORY_ARPA, sizeof(ArpaTarget));
     }
     i = m_number_of_targets;
     m_number_of_targets++;
@@ -1102,17 +1212,19 @@ int RadarArpa::AcquireNewARPATarget(Polar pol, int status) {
   target_pos = target->Polar2Pos(pol, own_pos);
 
   target->m_position = target_pos;  // Expected position
-  target->m_position.time = wxGetUTCTimeMillis();
+  target->m_position.time = m_ri->GetRadarMillis();
   target->m_position.dlat_dt = 0.;
   target->m_position.dlon_dt = 0.;
   target->m_position.sd_speed_kn = 0.;
   target->m_status = status;
+  target->m_pass_to_ocpn = false;
   target->m_max_angle.angle = 0;
   target->m_min_angle.angle = 0;
   target->m_max_r.r = 0;
   target->m_min_r.r = 0;
   if (!target->m_kalman) {
     target->m_kalman = new KalmanFilter(m_ri->m_spokes);
+    m_ri->m_memory.Allocated(MEMORY_ARPA, sizeof(KalmanFilter));
   }
   target->m_check_for_duplicate = false;
   target->m_automatic = true;
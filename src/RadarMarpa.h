@@ -36,8 +36,10 @@
 //#include "pi_common.h"
 
 //#include "radar_pi.h"
+#include "ArpaCpa.h"
 #include "Kalman.h"
 #include "Matrix.h"
+#include "NmeaSentence.h"
 #include "RadarInfo.h"
 
 PLUGIN_BEGIN_NAMESPACE
@@ -70,6 +72,7 @@ class Position;
 #define STATUS_TO_OCPN (5)            // First status to be send to OCPN
 #define START_UP_SPEED (0.5)          // maximum allowed speed (m/sec) for new target, real format with .
 #define DISTANCE_BETWEEN_TARGETS (4)  // minimum separation between targets
+#define TTM_RESEND_TIMEOUT (10000)    // millis after which an unchanged target is sent to OCPN again
 
 typedef int target_status;
 enum OCPN_target_status {
@@ -78,6 +81,20 @@ enum OCPN_target_status {
   L   // lost
 };
 
+enum CpaState { CPA_UNKNOWN, CPA_SAFE, CPA_DANGEROUS };
+
+// What was last sent to OCPN for a target, in the resolution of the TTM fields
+class SentTTM {
+ public:
+  int status;
+  int distance;  // 1/1000 NM
+  int bearing;   // 1/100 degree
+  int speed;     // 1/100 kn
+  int course;    // 1/10 degree
+  int cpa;       // CPA_UNKNOWN, CPA_SAFE or CPA_DANGEROUS
+  wxLongLong time;
+};
+
 class Position {
  public:
   GeoPosition pos;
@@ -106,6 +123,7 @@ class ArpaTarget {
   bool GetTarget(Polar* pol, int dist);
   void RefreshTarget(int dist);
   void PassARPAtoOCPN(Polar* p, OCPN_target_status s);
+  bool MakeTTM(NmeaSentence* nmea, Polar* p, OCPN_target_status s, wxLongLong now, bool force);
   void SetStatusLost();
   void ResetPixels();
   void GetSpeed();
@@ -131,7 +149,14 @@ class ArpaTarget {
   int m_contour_length;
   Polar m_max_angle, m_min_angle, m_max_r, m_min_r;  // charasterictics of contour
   Polar m_expected;
-  bool m_automatic;  // True for ARPA, false for MARPA.
+  bool m_automatic;                  // True for ARPA, false for MARPA.
+  bool m_pass_to_ocpn;               // Target refreshed, to be sent to OCPN after the refresh loop
+  Polar m_ocpn_polar;                // Position to send to OCPN
+  OCPN_target_status m_ocpn_status;  // Status to send to OCPN unless it is an AIS target
+  SentTTM m_sent;                    // Last TTM sent to OCPN
+  double m_cpa;                      // Closest point of approach in NM, or nan if not known
+  double m_tcpa;                     // Time to CPA in minutes, negative if CPA is in the past
+  CpaState m_cpa_state;              // Whether m_cpa and m_tcpa are within the alarm limits
 
   Position Polar2Pos(Polar pol, Position own_ship);
   Polar Pos2Polar(Position p, Position own_ship);
@@ -154,15 +179,19 @@ class RadarArpa {
   }
   void ClearContours();
   int GetTargetCount() { return m_number_of_targets; }
+  int GetDangerousTargetCount() { return m_dangerous_targets; }
 
  private:
   int m_number_of_targets;
+  int m_dangerous_targets;  // Targets within the CPA/TCPA alarm limits on the last refresh
   ArpaTarget* m_targets[MAX_NUMBER_OF_TARGETS];
 
   radar_pi* m_pi;
   RadarInfo* m_ri;
 
   void AcquireOrDeleteMarpaTarget(Position p, int status);
+  void UpdateCPA();
+  void PassTargetsToOCPN();
   void CalculateCentroid(ArpaTarget* t);
   void DrawContour(ArpaTarget* t);
   bool Pix(int ang, int rad);
@@ -0,0 +1,199 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/init.h>
+#include <wx/stopwatch.h>
+#include "RadarRaster.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define SPOKES (2048)
+#define SPOKE_LEN (512)
+#define SIZE (1024)
+
+static uint8_t spoke_data[SPOKES][SPOKE_LEN];
+
+// Hashes of the images rendered from the pseudo random spokes below. Only the lookup tables use
+// floating point, the rendering itself is integer, so a different hash means a different image.
+#define HASH_INDEXED (0x9512686cU)
+#define HASH_RGBA (0x16589feeU)
+
+// Numerical Recipes LCG, so the input is the same whatever the C library
+static uint32_t s_random = 1;
+static uint8_t Random() {
+  s_random = s_random * 1664525U + 1013904223U;
+  return (uint8_t)(s_random >> 24);
+}
+
+// FNV-1a, to compare an image with the checked in hash
+static uint32_t Hash(const uint8_t *data, size_t len) {
+  uint32_t h = 2166136261U;
+  for (size_t i = 0; i < len; i++) {
+    h = (h ^ data[i]) * 16777619U;
+  }
+  return h;
+}
+
+static uint8_t Pixel(RadarRaster &raster, size_t x, size_t y) { return raster.GetImage()[y * raster.GetSize() + x]; }
+
+int main() {
+  int ret = 0;
+  wxInitializer initializer;  // needed for wxThread
+
+  RadarRaster raster;
+  uint8_t map[RASTER_PALETTE_SIZE];
+
+  raster.Init(SPOKES, SPOKE_LEN, SIZE);
+  for (size_t i = 0; i < RASTER_PALETTE_SIZE; i++) {
+    map[i] = (uint8_t)i;
+    raster.SetPalette(i, (uint8_t)i, (uint8_t)(255 - i), (uint8_t)(i / 2), 255);
+  }
+  raster.SetBackground(7);
+
+  // Orientation: spoke 0 is up, spoke SPOKES/4 is right
+  memset(spoke_data, 0, sizeof(spoke_data));
+  memset(spoke_data[0], 1, SPOKE_LEN);
+  memset(spoke_data[SPOKES / 4], 2, SPOKE_LEN);
+  spoke_data[SPOKES / 2][SPOKE_LEN / 2] = 3;
+  for (size_t a = 0; a < SPOKES; a++) {
+    raster.SetSpoke((int)a, spoke_data[a], SPOKE_LEN, map);
+  }
+  raster.Render(RASTER_INDEXED, 1);
+
+  struct {
+    size_t x, y;
+    uint8_t expected;
+  } pixels[] = {
+      {SIZE / 2, 10, 1},                   // just right of the vertical, so spoke 0
+      {SIZE / 2 - 1, 10, 0},               // just left of it, so the last spoke
+      {SIZE - 10, SIZE / 2, 2},            // right
+      {SIZE / 2 - 1, SIZE * 3 / 4, 3},     // down, halfway the radius
+      {SIZE / 2 - 1, SIZE * 3 / 4 + 2, 0}  // down, further out
+  };
+  for (size_t i = 0; i < ARRAY_SIZE(pixels); i++) {
+    if (Pixel(raster, pixels[i].x, pixels[i].y) != pixels[i].expected) {
+      cout << "ERROR: pixel " << pixels[i].x << "," << pixels[i].y << " is " << (int)Pixel(raster, pixels[i].x, pixels[i].y)
+           << " instead of " << (int)pixels[i].expected << "\n";
+      ret = 1;
+    }
+  }
+  if (Pixel(raster, 0, 0) != 7 || Pixel(raster, SIZE - 1, SIZE - 1) != 7 || Pixel(raster, 10, SIZE - 10) != 7) {
+    cout << "ERROR: corners are not the background\n";
+    ret = 1;
+  }
+
+  // Byte identical images whatever the number of threads, and RGBA matches the palette indices
+  for (size_t a = 0; a < SPOKES; a++) {
+    for (size_t r = 0; r < SPOKE_LEN; r++) {
+      spoke_data[a][r] = Random();
+    }
+    raster.SetSpoke((int)a, spoke_data[a], SPOKE_LEN - (a % 16), map);
+  }
+  raster.Render(RASTER_INDEXED, 1);
+  std::vector<uint8_t> indexed(raster.GetImage(), raster.GetImage() + raster.GetImageBytes());
+  raster.Render(RASTER_RGBA, 1);
+  std::vector<uint8_t> rgba(raster.GetImage(), raster.GetImage() + raster.GetImageBytes());
+
+  for (size_t i = 0; i < indexed.size(); i++) {
+    uint8_t p = indexed[i];
+    if (rgba[i * 4] != p || rgba[i * 4 + 1] != 255 - p || rgba[i * 4 + 2] != p / 2 || rgba[i * 4 + 3] != 255) {
+      cout << "ERROR: RGBA pixel " << i << " does not match palette index " << (int)p << "\n";
+      ret = 1;
+      break;
+    }
+  }
+
+  const size_t threads[] = {2, 3, 4, 7, RASTER_MAX_THREADS};
+  for (size_t t = 0; t < ARRAY_SIZE(threads); t++) {
+    raster.Render(RASTER_INDEXED, threads[t]);
+    if (raster.GetImageBytes() != indexed.size() || memcmp(raster.GetImage(), &indexed[0], indexed.size()) != 0) {
+      cout << "ERROR: indexed image with " << threads[t] << " threads differs\n";
+      ret = 1;
+    }
+    raster.Render(RASTER_RGBA, threads[t]);
+    if (raster.GetImageBytes() != rgba.size() || memcmp(raster.GetImage(), &rgba[0], rgba.size()) != 0) {
+      cout << "ERROR: RGBA image with " << threads[t] << " threads differs\n";
+      ret = 1;
+    }
+  }
+  // Spokes stored apart and copied in before the render, as the software draw method does
+  RadarPolar polar;
+  RadarRaster copy;
+  polar.Init(SPOKES, SPOKE_LEN);
+  for (size_t a = 0; a < SPOKES; a++) {
+    polar.SetSpoke((int)a, spoke_data[a], SPOKE_LEN - (a % 16), map);
+  }
+  copy.Init(SPOKES, SPOKE_LEN, SIZE);
+  copy.SetBackground(7);
+  copy.SetSpokes(polar);
+  copy.Render(RASTER_INDEXED, 4);
+  if (copy.GetImageBytes() != indexed.size() || memcmp(copy.GetImage(), &indexed[0], indexed.size()) != 0) {
+    cout << "ERROR: image rendered from a copy of the spokes differs\n";
+    ret = 1;
+  }
+  uint32_t hash_indexed = Hash(&indexed[0], indexed.size());
+  uint32_t hash_rgba = Hash(&rgba[0], rgba.size());
+  if (hash_indexed != HASH_INDEXED || hash_rgba != HASH_RGBA) {
+    cout << "ERROR: image hash indexed " << hex << hash_indexed << " RGBA " << hash_rgba << " instead of " << HASH_INDEXED << " and "
+         << HASH_RGBA << dec << "\n";
+    ret = 1;
+  }
+
+  // Speed: a full rotation of new spokes followed by a render, as the draw method does each frame
+  const int frames = 50;
+  int cpus = wxThread::GetCPUCount();
+  size_t max_threads = cpus > 1 ? wxMin((size_t)cpus, (size_t)RASTER_MAX_THREADS) : 1;
+  wxStopWatch stopwatch;
+
+  for (size_t n = 1; n <= max_threads; n *= 2) {
+    stopwatch.Start();
+    for (int f = 0; f < frames; f++) {
+      for (size_t a = 0; a < SPOKES; a++) {
+        raster.SetSpoke((int)a, spoke_data[(a + f) % SPOKES], SPOKE_LEN, map);
+      }
+      raster.Render(RASTER_RGBA, n);
+    }
+    double us = stopwatch.TimeInMicro().ToDouble() / frames;
+    cout << "INFO: " << SIZE << "x" << SIZE << " RGBA with " << n << " threads takes " << us << " us per frame, "
+         << 1e6 / us << " fps\n";
+  }
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
@@ -0,0 +1,289 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "RadarRaster.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RADAR_RASTER_SSE2
+#endif
+
+PLUGIN_BEGIN_NAMESPACE
+
+// Fill n RGBA pixels with the same colour
+static void FillRGBA(uint8_t *dst, const uint8_t *rgba, size_t n) {
+  size_t i = 0;
+
+#ifdef RADAR_RASTER_SSE2
+  uint32_t value;
+  memcpy(&value, rgba, sizeof(value));
+  const __m128i v = _mm_set1_epi32((int)value);
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_si128((__m128i *)(dst + i * 4), v);
+  }
+#endif
+  for (; i < n; i++) {
+    memcpy(dst + i * 4, rgba, 4);
+  }
+}
+
+// Renders a band of rows each time it is started, until it is stopped
+class RadarRasterWorker : public wxThread {
+ public:
+  RadarRasterWorker(RadarRaster *raster) : wxThread(wxTHREAD_JOINABLE) {
+    m_raster = raster;
+    m_y_begin = 0;
+    m_y_end = 0;
+    m_stop = false;
+  }
+
+  void Start(size_t y_begin, size_t y_end) {
+    m_y_begin = y_begin;
+    m_y_end = y_end;
+    m_start.Post();
+  }
+
+  void WaitDone() { m_done.Wait(); }
+
+  void Stop() {
+    m_stop = true;
+    m_start.Post();
+  }
+
+  void *Entry(void) {
+    for (;;) {
+      m_start.Wait();
+      if (m_stop) {
+        break;
+      }
+      m_raster->RenderRows(m_y_begin, m_y_end);
+      m_done.Post();
+    }
+    return 0;
+  }
+
+ private:
+  RadarRaster *m_raster;
+  size_t m_y_begin;
+  size_t m_y_end;
+  volatile bool m_stop;
+  wxSemaphore m_start;  // posted for each band to render, and to stop
+  wxSemaphore m_done;   // posted when the band has been rendered
+};
+
+void RadarPolar::Init(size_t spokes, size_t spoke_len) {
+  m_spokes = spokes;
+  m_spoke_len = spoke_len;
+  m_data.assign(spokes * spoke_len, 0);
+}
+
+void RadarPolar::SetSpoke(int angle, const uint8_t *data, size_t len, const uint8_t *map) {
+  if (angle < 0 || (size_t)angle >= m_spokes) {
+    return;
+  }
+  uint8_t *d = &m_data[angle * m_spoke_len];
+
+  if (len > m_spoke_len) {
+    len = m_spoke_len;
+  }
+  for (size_t r = 0; r < len; r++) {
+    d[r] = map[data[r]];
+  }
+  if (len < m_spoke_len) {
+    memset(d + len, 0, m_spoke_len - len);
+  }
+}
+
+RadarRaster::RadarRaster() {
+  m_size = 0;
+  m_background = 0;
+  m_format = RASTER_RGBA;
+  CLEAR_STRUCT(m_palette);
+}
+
+RadarRaster::~RadarRaster() {
+  for (size_t t = 0; t < m_workers.size(); t++) {
+    m_workers[t]->Stop();
+    m_workers[t]->Wait();
+    delete m_workers[t];
+  }
+}
+
+size_t RadarRaster::GetMemorySize() const {
+  return m_polar.GetMemorySize() + m_row_first.capacity() * sizeof(size_t) +
+         m_span_start.capacity() * sizeof(uint16_t) + m_lookup.capacity() * sizeof(uint32_t) + m_image.capacity() * sizeof(uint8_t);
+}
+
+void RadarRaster::Init(size_t spokes, size_t spoke_len, size_t size) {
+  m_size = size;
+
+  m_polar.Init(spokes, spoke_len);
+  m_row_first.resize(size + 1);
+  m_span_start.resize(size);
+  m_lookup.clear();
+
+  // Work in half pixels so that the pixel centers are at integer positions
+  const int64_t s = (int64_t)size;
+  const int64_t radius2 = s * s;
+
+  for (size_t y = 0; y < size; y++) {
+    int64_t dy = 2 * (int64_t)y + 1 - s;
+
+    m_row_first[y] = m_lookup.size();
+    m_span_start[y] = (uint16_t)(size / 2);
+    for (size_t x = 0; x < size; x++) {
+      int64_t dx = 2 * (int64_t)x + 1 - s;
+      int64_t d2 = dx * dx + dy * dy;
+      if (d2 >= radius2) {
+        continue;
+      }
+      if (m_lookup.size() == m_row_first[y]) {
+        m_span_start[y] = (uint16_t)x;
+      }
+      size_t r = (size_t)(sqrt((double)d2) * spoke_len / size);
+      double a = atan2((double)dx, (double)-dy);  // clockwise from up
+      if (a < 0.) {
+        a += 2. * PI;
+      }
+      size_t angle = (size_t)(a * spokes / (2. * PI));
+      if (angle >= spokes) {
+        angle = 0;
+      }
+      if (r >= spoke_len) {
+        r = spoke_len - 1;
+      }
+      m_lookup.push_back((uint32_t)(angle * spoke_len + r));
+    }
+  }
+  m_row_first[size] = m_lookup.size();
+
+  m_image.clear();
+}
+
+void RadarRaster::SetSpokes(const RadarPolar &polar) {
+  if (polar.GetSpokes() != m_polar.GetSpokes() || polar.GetSpokeLen() != m_polar.GetSpokeLen()) {
+    return;
+  }
+  m_polar = polar;  // Same size, so this copies without allocating
+}
+
+void RadarRaster::SetPalette(size_t index, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha) {
+  if (index < RASTER_PALETTE_SIZE) {
+    m_palette[index][0] = red;
+    m_palette[index][1] = green;
+    m_palette[index][2] = blue;
+    m_palette[index][3] = alpha;
+  }
+}
+
+void RadarRaster::RenderRows(size_t y_begin, size_t y_end) {
+  const uint8_t *polar = m_polar.GetData();
+
+  for (size_t y = y_begin; y < y_end; y++) {
+    size_t start = m_span_start[y];
+    size_t end = m_size - start;
+    const uint32_t *lookup = m_lookup.empty() ? 0 : &m_lookup[0] + m_row_first[y];
+    size_t inside = m_row_first[y + 1] - m_row_first[y];
+
+    if (inside == 0) {
+      start = end = m_size;
+    }
+
+    if (m_format == RASTER_RGBA) {
+      uint8_t *row = &m_image[y * m_size * 4];
+
+      FillRGBA(row, m_palette[m_background], start);
+      for (size_t i = 0; i < inside; i++) {
+        memcpy(row + (start + i) * 4, m_palette[polar[lookup[i]]], 4);
+      }
+      FillRGBA(row + end * 4, m_palette[m_background], m_size - end);
+    } else {
+      uint8_t *row = &m_image[y * m_size];
+
+      memset(row, m_background, start);
+      for (size_t i = 0; i < inside; i++) {
+        row[start + i] = polar[lookup[i]];
+      }
+      memset(row + end, m_background, m_size - end);
+    }
+  }
+}
+
+void RadarRaster::Render(RasterFormat format, size_t threads) {
+  if (m_size == 0) {
+    return;
+  }
+  m_format = format;
+  m_image.resize(m_size * m_size * (format == RASTER_RGBA ? 4 : 1));
+
+  if (threads > RASTER_MAX_THREADS) {
+    threads = RASTER_MAX_THREADS;
+  }
+  if (threads > m_size) {
+    threads = m_size;
+  }
+  if (threads <= 1) {
+    RenderRows(0, m_size);
+    return;
+  }
+
+  // Start the workers that are missing, if the system lets us
+  while (m_workers.size() < threads - 1) {
+    RadarRasterWorker *worker = new RadarRasterWorker(this);
+    if (worker->Create() != wxTHREAD_NO_ERROR || worker->Run() != wxTHREAD_NO_ERROR) {
+      delete worker;
+      break;
+    }
+    m_workers.push_back(worker);
+  }
+
+  // Split the image in bands of rows, this thread renders the bands that have no worker and the last one
+  size_t band = (m_size + threads - 1) / threads;
+  size_t started = 0;
+
+  for (size_t t = 0; t < threads - 1; t++) {
+    size_t y_begin = wxMin(t * band, m_size);
+    size_t y_end = wxMin(y_begin + band, m_size);
+    if (t < m_workers.size()) {
+      m_workers[t]->Start(y_begin, y_end);
+      started++;
+    } else {
+      RenderRows(y_begin, y_end);
+    }
+  }
+  RenderRows(wxMin((threads - 1) * band, m_size), m_size);
+
+  for (size_t t = 0; t < started; t++) {
+    m_workers[t]->WaitDone();
+  }
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,147 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RADARRASTER_H_
+#define _RADARRASTER_H_
+
+#include <vector>
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define RASTER_MAX_THREADS (16)
+#define RASTER_PALETTE_SIZE (256)
+
+enum RasterFormat {
+  RASTER_RGBA,    // 4 bytes per pixel: red, green, blue, alpha
+  RASTER_INDEXED  // 1 byte per pixel: the palette index
+};
+
+//
+// The spokes as polar data of palette indices. Kept apart from the raster so that the receive thread
+// can store spokes in one copy under a lock, while another thread renders from a copy of its own.
+//
+class RadarPolar {
+ public:
+  RadarPolar() : m_spokes(0), m_spoke_len(0) {}
+
+  void Init(size_t spokes, size_t spoke_len);
+
+  // Store a spoke, converting the data through map (RASTER_PALETTE_SIZE entries) into palette indices.
+  // Samples beyond len are cleared to index 0.
+  void SetSpoke(int angle, const uint8_t *data, size_t len, const uint8_t *map);
+
+  const uint8_t *GetData() const { return m_data.empty() ? 0 : &m_data[0]; }
+  size_t GetSpokes() const { return m_spokes; }
+  size_t GetSpokeLen() const { return m_spoke_len; }
+  size_t GetMemorySize() const { return m_data.capacity() * sizeof(uint8_t); }
+
+ private:
+  size_t m_spokes;
+  size_t m_spoke_len;
+  std::vector<uint8_t> m_data;  // m_spokes * m_spoke_len palette indices
+};
+
+class RadarRasterWorker;
+
+//
+// Software scan conversion of radar spokes into a square cartesian image, for use
+// where there is no OpenGL such as servers and tests.
+//
+// The spokes are kept as polar data of palette indices. The image is made by looking up
+// for every pixel inside the circle which polar sample it shows; this table is built once
+// in Init(). Rendering is then only a gather through the table and the palette, and a fill
+// of the corners, so the same input always gives the same bytes whatever the number of threads.
+//
+// Spoke 0 points up, spokes go clockwise, and the circle touches the edges of the image.
+//
+// Rendering with more than one thread uses worker threads that are started on the first such
+// Render() and kept until the raster is destroyed.
+//
+class RadarRaster {
+ public:
+  RadarRaster();
+  ~RadarRaster();
+
+  // Set up for spokes x spoke_len polar data and an image of size x size pixels.
+  void Init(size_t spokes, size_t spoke_len, size_t size);
+
+  // Store a spoke, converting the data through map (RASTER_PALETTE_SIZE entries) into palette indices.
+  // Samples beyond len are cleared to index 0.
+  void SetSpoke(int angle, const uint8_t *data, size_t len, const uint8_t *map) { m_polar.SetSpoke(angle, data, len, map); }
+
+  // Replace all spokes by a copy of polar, which must have the same dimensions.
+  void SetSpokes(const RadarPolar &polar);
+
+  void SetPalette(size_t index, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha);
+  void SetBackground(size_t index) { m_background = (uint8_t)index; }
+
+  void Render(RasterFormat format, size_t threads);
+
+  const uint8_t *GetImage() const { return m_image.empty() ? 0 : &m_image[0]; }
+  size_t GetImageBytes() const { return m_image.size(); }
+  size_t GetSize() const { return m_size; }
+  size_t GetSpokes() const { return m_polar.GetSpokes(); }
+  size_t GetSpokeLen() const { return m_polar.GetSpokeLen(); }
+
+  // Bytes held by the polar data, the scan conversion tables and the image
+  size_t GetMemorySize() const;
+
+  // Render rows [y_begin, y_end> in the format of the last Render(). Used by the worker threads.
+  void RenderRows(size_t y_begin, size_t y_end);
+
+ private:
+  size_t m_size;
+
+  RadarPolar m_polar;
+
+  // For each row the pixels [m_span_start, m_size - m_span_start> are inside the circle,
+  // m_lookup holds the polar sample of each of those pixels starting at m_row_first.
+  std::vector<size_t> m_row_first;
+  std::vector<uint16_t> m_span_start;
+  std::vector<uint32_t> m_lookup;
+
+  uint8_t m_palette[RASTER_PALETTE_SIZE][4];
+  uint8_t m_background;
+
+  RasterFormat m_format;
+  std::vector<uint8_t> m_image;
+
+  std::vector<RadarRasterWorker *> m_workers;
+
+  // Not copyable, the workers point back at this raster
+  RadarRaster(const RadarRaster &);
+  RadarRaster &operator=(const RadarRaster &);
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADARRASTER_H_ */
@@ -0,0 +1,229 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/filefn.h>
+#include <wx/init.h>
+#include <wx/stopwatch.h>
+#include "RadarRecording.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define SPOKES (2048)
+#define SPOKE_LEN (1024)
+#define ROTATIONS (40)
+#define ROTATION_MILLIS (2500)  // 24 RPM
+#define SEEKS (200)
+#define FILENAME wxT("radar-recording-test.rpr")
+
+static uint8_t spoke_data[SPOKES][SPOKE_LEN];
+
+// Something that looks like radar: mostly empty, with targets that span several spokes and some noise
+static void MakeRotation() {
+  memset(spoke_data, 0, sizeof(spoke_data));
+  for (int t = 0; t < 200; t++) {
+    size_t angle = rand() % SPOKES;
+    size_t range = rand() % (SPOKE_LEN - 40);
+    size_t width = 2 + rand() % 20;
+    size_t depth = 2 + rand() % 30;
+    uint8_t strength = (uint8_t)(rand() % 256);
+    for (size_t a = angle; a < angle + width; a++) {
+      memset(&spoke_data[a % SPOKES][range], strength, depth);
+    }
+  }
+  for (size_t a = 0; a < SPOKES; a++) {
+    for (size_t r = 0; r < 60; r++) {
+      spoke_data[a][r] = (uint8_t)(rand() % 256);  // sea clutter near the boat
+    }
+  }
+}
+
+static wxLongLong SpokeTime(wxLongLong start, int rotation, size_t a) {
+  return start + wxLongLong((long)(rotation * ROTATION_MILLIS + a * ROTATION_MILLIS / SPOKES));
+}
+
+// Range changes every 10 rotations, so the control state in the file can be checked
+static int RotationRange(int rotation) { return 1852 * (1 + rotation / 10); }
+
+int main() {
+  wxInitializer initializer;  // needed for wxThread
+  int ret = 0;
+  wxLongLong start = 1500000000000LL;
+
+  // Record a session with simulated time at 100 times the speed of the radar
+  RadarRecorder recorder;
+  if (!recorder.Open(FILENAME, wxT("Radar"), 3, SPOKES, SPOKE_LEN)) {
+    cout << "ERROR: cannot create recording\n";
+    exit(1);
+  }
+
+  srand(1);
+  MakeRotation();
+  double encode_seconds = 0.;
+  for (int rotation = 0; rotation < ROTATIONS; rotation++) {
+    wxLongLong t = SpokeTime(start, rotation, 0);
+    recorder.RecordNavigation(t, rotation * 2., 52. + rotation * 1e-4, 4.5);
+    recorder.RecordControl(t, 1, RotationRange(rotation), 1);
+
+    wxStopWatch stopwatch;
+    for (size_t a = 0; a < SPOKES; a++) {
+      recorder.RecordSpoke((int)a, (int)((a + rotation) % SPOKES), spoke_data[a], SPOKE_LEN, RotationRange(rotation),
+                           SpokeTime(start, rotation, a));
+    }
+    encode_seconds += stopwatch.TimeInMicro().ToDouble() / 1e6;
+    wxMilliSleep(ROTATION_MILLIS / 100);
+  }
+  recorder.Close();
+
+  uint64_t bytes = recorder.GetBytesWritten();
+  double overhead = encode_seconds / (ROTATIONS * ROTATION_MILLIS / 1000.);
+  cout << "INFO: recorded " << ROTATIONS << " rotations of " << SPOKES << "x" << SPOKE_LEN << " in " << encode_seconds
+       << " s on the receive thread, " << overhead * 100. << "% of real time, " << bytes << " bytes for "
+       << recorder.GetSamples() << " samples, " << recorder.GetDroppedChunks() << " chunks dropped\n";
+  if (overhead > 0.05) {
+    cout << "ERROR: recording costs more than 5% of a receive thread\n";
+    ret = 1;
+  }
+  if (recorder.GetDroppedChunks() != 0) {
+    cout << "ERROR: chunks were dropped\n";
+    ret = 1;
+  }
+
+  // Read it all back
+  RadarRecordingReader reader;
+  if (!reader.Open(FILENAME)) {
+    cout << "ERROR: cannot open recording\n";
+    exit(1);
+  }
+  if (reader.GetSpokes() != SPOKES || reader.GetSpokeLenMax() != SPOKE_LEN || reader.GetRadarType() != 3 ||
+      reader.GetName() != wxT("Radar") || reader.GetEndTime() != SpokeTime(start, ROTATIONS - 1, SPOKES - 1)) {
+    cout << "ERROR: recording header does not match\n";
+    ret = 1;
+  }
+
+  RecordingRecord record;
+  size_t spokes = 0;
+  size_t navigation = 0;
+  size_t controls = 0;
+  wxLongLong last = 0;
+  while (reader.Next(&record)) {
+    if (record.time < last) {
+      cout << "ERROR: time goes backwards\n";
+      ret = 1;
+    }
+    last = record.time;
+    if (record.type == RECORD_SPOKE) {
+      int rotation = (int)(spokes / SPOKES);
+      size_t a = spokes % SPOKES;
+      if (record.angle != (int)a || record.bearing != (int)((a + rotation) % SPOKES) ||
+          record.range_meters != RotationRange(rotation) || record.time != SpokeTime(start, rotation, a) ||
+          record.len != SPOKE_LEN || memcmp(record.data, spoke_data[a], SPOKE_LEN) != 0) {
+        cout << "ERROR: spoke " << spokes << " does not match what was recorded\n";
+        ret = 1;
+        break;
+      }
+      spokes++;
+    } else if (record.type == RECORD_NAVIGATION) {
+      navigation++;
+    } else {
+      controls++;
+    }
+  }
+  cout << "INFO: read " << spokes << " spokes, " << navigation << " navigation and " << controls << " control records in "
+       << reader.GetChunkCount() << " chunks\n";
+  if (spokes != (size_t)ROTATIONS * SPOKES) {
+    cout << "ERROR: not all spokes were read back\n";
+    ret = 1;
+  }
+
+  // Seek to random times, the first spoke must be the one at or after that time and the state must be known
+  wxStopWatch stopwatch;
+  for (int i = 0; i < SEEKS; i++) {
+    int rotation = rand() % ROTATIONS;
+    size_t a = rand() % SPOKES;
+    wxLongLong t = SpokeTime(start, rotation, a);
+    double heading = nan("");
+    int range = 0;
+
+    if (!reader.Seek(t)) {
+      cout << "ERROR: cannot seek\n";
+      ret = 1;
+      break;
+    }
+    while (reader.Next(&record) && record.type != RECORD_SPOKE) {
+      if (record.type == RECORD_NAVIGATION) {
+        heading = record.heading;
+      } else if (record.type == RECORD_CONTROL && record.control == 1) {
+        range = record.value;
+      }
+    }
+    if (record.type != RECORD_SPOKE || record.time < t || record.time > t + 2 ||
+        memcmp(record.data, spoke_data[record.angle], SPOKE_LEN) != 0 || heading != rotation * 2. ||
+        range != RotationRange(rotation)) {
+      cout << "ERROR: seek to rotation " << rotation << " spoke " << a << " lands on the wrong spoke or state\n";
+      ret = 1;
+      break;
+    }
+  }
+  cout << "INFO: " << SEEKS << " seeks in " << stopwatch.Time() << " ms\n";
+  if (reader.Seek(reader.GetEndTime() + 1)) {
+    cout << "ERROR: seek beyond the end succeeds\n";
+    ret = 1;
+  }
+  reader.Close();
+
+  // A recording that was not closed loses its index, but can still be read
+  FILE *f = wxFopen(FILENAME, wxT("r+b"));
+  if (f) {
+    uint8_t zero[RECORDING_TRAILER_SIZE] = {0};
+    fseek(f, -RECORDING_TRAILER_SIZE, SEEK_END);
+    fwrite(zero, 1, sizeof(zero), f);
+    fclose(f);
+  }
+  if (!reader.Open(FILENAME) || !reader.Seek(SpokeTime(start, ROTATIONS / 2, 0)) || !reader.Next(&record)) {
+    cout << "ERROR: recording without index cannot be read\n";
+    ret = 1;
+  } else {
+    cout << "INFO: rebuilt index of " << reader.GetChunkCount() << " chunks\n";
+  }
+  reader.Close();
+  wxRemoveFile(FILENAME);
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
@@ -0,0 +1,746 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "RadarRecording.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+static const uint8_t RECORDING_MAGIC[4] = {'R', 'P', 'I', 'R'};
+static const uint8_t RECORDING_CHUNK_MAGIC[4] = {'R', 'P', 'C', 'K'};
+static const uint8_t RECORDING_INDEX_MAGIC[4] = {'R', 'P', 'I', 'X'};
+static const uint8_t RECORDING_TRAILER_MAGIC[4] = {'R', 'P', 'T', 'R'};
+
+#define RECORD_HEADER_SIZE (5)  // type + time
+#define SPOKE_RECORD_SIZE (RECORD_HEADER_SIZE + 13)
+#define NAVIGATION_RECORD_SIZE (RECORD_HEADER_SIZE + 12)
+#define CONTROL_RECORD_SIZE (RECORD_HEADER_SIZE + 7)
+
+static void PutU16(uint8_t *p, size_t v) {
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+}
+
+static void PutU32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static void PutU64(uint8_t *p, wxLongLong v) {
+  PutU32(p, (uint32_t)v.GetHi());
+  PutU32(p + 4, (uint32_t)v.GetLo());
+}
+
+static size_t GetU16(const uint8_t *p) { return ((size_t)p[0] << 8) | p[1]; }
+
+static uint32_t GetU32(const uint8_t *p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]; }
+
+static wxLongLong GetU64(const uint8_t *p) { return wxLongLong((long)(int32_t)GetU32(p), (unsigned long)GetU32(p + 4)); }
+
+static uint64_t AlignUp(uint64_t n) { return (n + RECORDING_ALIGN - 1) / RECORDING_ALIGN * RECORDING_ALIGN; }
+
+static int32_t ToFixed(double v, double scale) {
+  if (wxIsNaN(v)) {
+    return RECORDING_NO_VALUE;
+  }
+  return (int32_t)floor(v * scale + 0.5);
+}
+
+static double FromFixed(int32_t v, double scale) {
+  if (v == RECORDING_NO_VALUE) {
+    return nan("");
+  }
+  return v / scale;
+}
+
+// Recordings grow beyond 2 GB, so do not use fseek/ftell with their long offsets.
+static bool SeekFile(FILE *f, uint64_t offset) {
+#ifdef __WXMSW__
+  return _fseeki64(f, (__int64)offset, SEEK_SET) == 0;
+#else
+  return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static uint64_t FileSize(FILE *f) {
+#ifdef __WXMSW__
+  _fseeki64(f, 0, SEEK_END);
+  return (uint64_t)_ftelli64(f);
+#else
+  fseeko(f, 0, SEEK_END);
+  return (uint64_t)ftello(f);
+#endif
+}
+
+//
+// Writes the finished chunks, so that a slow disk never holds up the receive thread.
+//
+class RecordingWriter : public wxThread {
+ public:
+  RecordingWriter(RadarRecorder *recorder) : wxThread(wxTHREAD_JOINABLE) {
+    m_recorder = recorder;
+    m_failed = false;
+  }
+
+  void *Entry(void) {
+    RadarRecorder *r = m_recorder;
+
+    while (true) {
+      std::vector<uint8_t> *chunk = 0;
+      uint64_t offset;
+      {
+        wxCriticalSectionLocker lock(r->m_lock);
+        if (!r->m_queue.empty()) {
+          chunk = r->m_queue.front();
+          r->m_queue.pop_front();
+        } else if (r->m_quit) {
+          break;
+        }
+        offset = r->m_offset;
+      }
+      if (!chunk) {
+        wxMilliSleep(20);
+        continue;
+      }
+
+      bool ok = !m_failed && fwrite(&(*chunk)[0], 1, chunk->size(), r->m_file) == chunk->size();
+      if (!ok && !m_failed) {
+        wxLogError(wxT("radar_pi: cannot write recording %s, recording stopped"), r->m_filename.c_str());
+        m_failed = true;  // Offsets are no longer known, so stop writing altogether
+      }
+
+      wxCriticalSectionLocker lock(r->m_lock);
+      if (ok) {
+        RadarRecorder::IndexEntry entry;
+        entry.time = GetU64(&(*chunk)[16]);
+        entry.offset = offset;
+        r->m_index.push_back(entry);
+        r->m_offset += chunk->size();
+      } else {
+        r->m_dropped_chunks++;
+      }
+      delete chunk;
+    }
+    return 0;
+  }
+
+  bool HasFailed() { return m_failed; }
+
+ private:
+  RadarRecorder *m_recorder;
+  bool m_failed;
+};
+
+RadarRecorder::RadarRecorder() {
+  m_file = 0;
+  m_spoke_len_max = 0;
+  m_chunk = 0;
+  m_chunk_records = 0;
+  m_chunk_sequence = 0;
+  m_chunk_start = 0;
+  m_chunk_end = 0;
+  m_have_navigation = false;
+  m_records = 0;
+  m_samples = 0;
+  m_offset = 0;
+  m_dropped_chunks = 0;
+  m_quit = false;
+  m_writer = 0;
+}
+
+RadarRecorder::~RadarRecorder() { Close(); }
+
+bool RadarRecorder::Open(const wxString &filename, const wxString &name, int radar_type, size_t spokes, size_t spoke_len_max) {
+  Close();
+
+  m_file = wxFopen(filename, wxT("wb"));
+  if (!m_file) {
+    wxLogError(wxT("radar_pi: cannot create recording %s"), filename.c_str());
+    return false;
+  }
+  m_filename = filename;
+  m_spoke_len_max = wxMin(spoke_len_max, (size_t)RECORDING_LEN_MAX);
+
+  std::vector<uint8_t> header(RECORDING_ALIGN, 0);
+  memcpy(&header[0], RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+  header[4] = RECORDING_VERSION;
+  PutU16(&header[8], spokes);
+  PutU16(&header[10], m_spoke_len_max);
+  PutU16(&header[12], (size_t)radar_type);
+  PutU64(&header[16], wxGetUTCTimeMillis());
+  strncpy((char *)&header[24], name.ToUTF8(), RECORDING_NAME_LEN - 1);
+
+  if (fwrite(&header[0], 1, header.size(), m_file) != header.size()) {
+    wxLogError(wxT("radar_pi: cannot write recording %s"), filename.c_str());
+    fclose(m_file);
+    m_file = 0;
+    return false;
+  }
+
+  m_chunk = new std::vector<uint8_t>;
+  m_chunk->reserve(RECORDING_CHUNK_SIZE + RECORDING_ALIGN);
+  m_chunk->resize(RECORDING_CHUNK_HEADER_SIZE);
+  m_chunk_records = 0;
+  m_chunk_sequence = 0;
+  m_chunk_end = 0;
+  m_have_navigation = false;
+  m_controls.clear();
+  m_previous.clear();
+  m_records = 0;
+  m_samples = 0;
+  m_index.clear();
+  m_offset = RECORDING_ALIGN;
+  m_dropped_chunks = 0;
+  m_quit = false;
+
+  m_writer = new RecordingWriter(this);
+  if (m_writer->Create() != wxTHREAD_NO_ERROR || m_writer->Run() != wxTHREAD_NO_ERROR) {
+    wxLogError(wxT("radar_pi: cannot start recording thread"));
+    delete m_writer;
+    m_writer = 0;
+    delete m_chunk;
+    m_chunk = 0;
+    fclose(m_file);
+    m_file = 0;
+    return false;
+  }
+
+  wxLogMessage(wxT("radar_pi: recording %s to %s"), name.c_str(), filename.c_str());
+  return true;
+}
+
+void RadarRecorder::Close() {
+  if (!m_file) {
+    return;
+  }
+
+  FinishChunk();
+  {
+    wxCriticalSectionLocker lock(m_lock);
+    m_quit = true;
+  }
+  m_writer->Wait();
+  bool failed = m_writer->HasFailed();
+  delete m_writer;
+  m_writer = 0;
+  delete m_chunk;
+  m_chunk = 0;
+
+  if (!failed) {
+    std::vector<uint8_t> index(8 + m_index.size() * 16 + RECORDING_TRAILER_SIZE);
+    uint8_t *p = &index[0];
+
+    memcpy(p, RECORDING_INDEX_MAGIC, sizeof(RECORDING_INDEX_MAGIC));
+    PutU32(p + 4, (uint32_t)m_index.size());
+    p += 8;
+    for (size_t i = 0; i < m_index.size(); i++, p += 16) {
+      PutU64(p, m_index[i].time);
+      PutU64(p + 8, wxLongLong((long)(m_index[i].offset >> 32), (unsigned long)(m_index[i].offset & 0xffffffff)));
+    }
+    memcpy(p, RECORDING_TRAILER_MAGIC, sizeof(RECORDING_TRAILER_MAGIC));
+    PutU32(p + 4, (uint32_t)m_index.size());
+    PutU64(p + 8, wxLongLong((long)(m_offset >> 32), (unsigned long)(m_offset & 0xffffffff)));
+
+    if (fwrite(&index[0], 1, index.size(), m_file) != index.size()) {
+      wxLogError(wxT("radar_pi: cannot write index of recording %s"), m_filename.c_str());
+    }
+  }
+  fclose(m_file);
+  m_file = 0;
+
+  wxLogMessage(wxT("radar_pi: recorded %s, %u chunks, %u dropped"), m_filename.c_str(), (unsigned)m_index.size(),
+               (unsigned)m_dropped_chunks);
+}
+
+uint64_t RadarRecorder::GetBytesWritten() {
+  wxCriticalSectionLocker lock(m_lock);
+  return m_offset;
+}
+
+uint64_t RadarRecorder::GetDroppedChunks() {
+  wxCriticalSectionLocker lock(m_lock);
+  return m_dropped_chunks;
+}
+
+/*
+ * Called before every record. Keeps the time monotonic so that the index stays sorted,
+ * closes the chunk when it is full or old enough and starts a new chunk with the current
+ * navigation and control state.
+ *
+ * @return true if a new chunk was started, which already contains the current state.
+ */
+bool RadarRecorder::NextChunk(wxLongLong *time, size_t len) {
+  if (*time < m_chunk_end) {
+    *time = m_chunk_end;
+  }
+  if (m_chunk_records > 0 &&
+      (m_chunk->size() + len > RECORDING_CHUNK_SIZE || *time - m_chunk_start >= RECORDING_CHUNK_MILLIS)) {
+    FinishChunk();
+  }
+  if (m_chunk_records > 0) {
+    return false;
+  }
+
+  m_chunk_start = *time;
+  if (m_have_navigation) {
+    PutNavigation(*time);
+  }
+  for (size_t i = 0; i < m_controls.size(); i++) {
+    if (m_controls[i].valid) {
+      PutControl(*time, (int)i);
+    }
+  }
+  return true;
+}
+
+uint8_t *RadarRecorder::Append(RecordingRecordType type, wxLongLong time, size_t len) {
+  size_t pos = m_chunk->size();
+
+  m_chunk->resize(pos + len);
+  uint8_t *p = &(*m_chunk)[pos];
+  p[0] = (uint8_t)type;
+  PutU32(p + 1, (uint32_t)(time - m_chunk_start).GetLo());
+  m_chunk_records++;
+  m_chunk_end = time;
+  m_records++;
+  return p + RECORD_HEADER_SIZE;
+}
+
+void RadarRecorder::PutNavigation(wxLongLong time) {
+  uint8_t *p = Append(RECORD_NAVIGATION, time, NAVIGATION_RECORD_SIZE);
+
+  PutU32(p, (uint32_t)m_navigation.heading);
+  PutU32(p + 4, (uint32_t)m_navigation.lat);
+  PutU32(p + 8, (uint32_t)m_navigation.lon);
+}
+
+void RadarRecorder::PutControl(wxLongLong time, int control) {
+  uint8_t *p = Append(RECORD_CONTROL, time, CONTROL_RECORD_SIZE);
+
+  PutU16(p, (size_t)control);
+  PutU32(p + 2, (uint32_t)m_controls[control].value);
+  p[6] = (uint8_t)m_controls[control].state;
+}
+
+void RadarRecorder::RecordSpoke(int angle, int bearing, const uint8_t *data, size_t len, int range_meters, wxLongLong time) {
+  if (!m_file) {
+    return;
+  }
+  if (len > m_spoke_len_max) {
+    len = m_spoke_len_max;
+  }
+  NextChunk(&time, SPOKE_RECORD_SIZE + len);
+
+  m_rle.clear();
+  RunLengthEncode(data, len, m_rle);
+
+  // Adjacent spokes look alike, so the XOR with the previous one is often mostly zero
+  bool have_delta = false;
+  if (m_previous.size() == len && len > 0) {
+    m_delta.resize(len);
+    for (size_t i = 0; i < len; i++) {
+      m_delta[i] = data[i] ^ m_previous[i];
+    }
+    m_delta_rle.clear();
+    RunLengthEncode(&m_delta[0], len, m_delta_rle);
+    have_delta = m_delta_rle.size() < m_rle.size();
+  }
+
+  RecordingEncoding encoding = have_delta ? RECORDING_DELTA_RLE : (m_rle.size() < len ? RECORDING_RLE : RECORDING_RAW);
+  const uint8_t *encoded = encoding == RECORDING_DELTA_RLE ? &m_delta_rle[0] : encoding == RECORDING_RLE ? &m_rle[0] : data;
+  size_t encoded_len = encoding == RECORDING_DELTA_RLE ? m_delta_rle.size() : encoding == RECORDING_RLE ? m_rle.size() : len;
+
+  uint8_t *p = Append(RECORD_SPOKE, time, SPOKE_RECORD_SIZE + encoded_len);
+  PutU16(p, (size_t)angle);
+  PutU16(p + 2, (size_t)bearing);
+  PutU32(p + 4, (uint32_t)range_meters);
+  PutU16(p + 8, len);
+  p[10] = (uint8_t)encoding;
+  PutU16(p + 11, encoded_len);
+  if (encoded_len > 0) {
+    memcpy(p + 13, encoded, encoded_len);
+  }
+
+  m_samples += len;
+  m_previous.assign(data, data + len);
+}
+
+void RadarRecorder::RecordNavigation(wxLongLong time, double heading, double lat, double lon) {
+  if (!m_file) {
+    return;
+  }
+
+  Navigation nav;
+  nav.heading = ToFixed(heading, 1e3);
+  nav.lat = ToFixed(lat, 1e7);
+  nav.lon = ToFixed(lon, 1e7);
+  if (m_have_navigation && nav.heading == m_navigation.heading && nav.lat == m_navigation.lat && nav.lon == m_navigation.lon) {
+    return;
+  }
+  m_navigation = nav;
+  m_have_navigation = true;
+
+  if (!NextChunk(&time, NAVIGATION_RECORD_SIZE)) {
+    PutNavigation(time);
+  }
+}
+
+void RadarRecorder::RecordControl(wxLongLong time, int control, int value, int state) {
+  if (!m_file || control < 0) {
+    return;
+  }
+
+  if ((size_t)control >= m_controls.size()) {
+    Control none = {false, 0, 0};
+    m_controls.resize(control + 1, none);
+  }
+  Control &c = m_controls[control];
+  if (c.valid && c.value == value && c.state == state) {
+    return;
+  }
+  c.valid = true;
+  c.value = value;
+  c.state = state;
+
+  if (!NextChunk(&time, CONTROL_RECORD_SIZE)) {
+    PutControl(time, control);
+  }
+}
+
+void RadarRecorder::FinishChunk() {
+  if (m_chunk_records == 0) {
+    return;
+  }
+
+  uint8_t *p = &(*m_chunk)[0];
+  memcpy(p, RECORDING_CHUNK_MAGIC, sizeof(RECORDING_CHUNK_MAGIC));
+  PutU32(p + 4, (uint32_t)(m_chunk->size() - RECORDING_CHUNK_HEADER_SIZE));
+  PutU32(p + 8, (uint32_t)m_chunk_records);
+  PutU32(p + 12, m_chunk_sequence++);
+  PutU64(p + 16, m_chunk_start);
+  PutU64(p + 24, m_chunk_end);
+  m_chunk->resize(AlignUp(m_chunk->size()), 0);
+
+  std::vector<uint8_t> *next = 0;
+  {
+    wxCriticalSectionLocker lock(m_lock);
+    if (m_queue.size() < RECORDING_QUEUE_MAX) {
+      m_queue.push_back(m_chunk);
+    } else {
+      m_dropped_chunks++;
+      next = m_chunk;  // Reuse the buffer
+    }
+  }
+  if (!next) {
+    next = new std::vector<uint8_t>;
+    next->reserve(RECORDING_CHUNK_SIZE + RECORDING_ALIGN);
+  }
+  next->resize(RECORDING_CHUNK_HEADER_SIZE);
+  m_chunk = next;
+  m_chunk_records = 0;
+  m_previous.clear();
+}
+
+RadarRecordingReader::RadarRecordingReader() {
+  m_file = 0;
+  m_spokes = 0;
+  m_spoke_len_max = 0;
+  m_radar_type = 0;
+  m_start_time = 0;
+  m_end_time = 0;
+  m_next_chunk = 0;
+  m_chunk_pos = 0;
+  m_chunk_start = 0;
+  m_skip_before = 0;
+}
+
+RadarRecordingReader::~RadarRecordingReader() { Close(); }
+
+bool RadarRecordingReader::Open(const wxString &filename) {
+  uint8_t header[RECORDING_HEADER_SIZE];
+
+  Close();
+  m_file = wxFopen(filename, wxT("rb"));
+  if (!m_file) {
+    wxLogError(wxT("radar_pi: cannot open recording %s"), filename.c_str());
+    return false;
+  }
+  if (fread(header, 1, sizeof(header), m_file) != sizeof(header) ||
+      memcmp(header, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0 || header[4] != RECORDING_VERSION) {
+    wxLogError(wxT("radar_pi: %s is not a radar recording"), filename.c_str());
+    Close();
+    return false;
+  }
+
+  m_spokes = GetU16(header + 8);
+  m_spoke_len_max = GetU16(header + 10);
+  m_radar_type = (int)GetU16(header + 12);
+  m_start_time = GetU64(header + 16);
+  header[24 + RECORDING_NAME_LEN - 1] = 0;
+  m_name = wxString::FromUTF8((const char *)header + 24);
+
+  uint64_t file_size = FileSize(m_file);
+  if (!ReadIndex(file_size)) {
+    wxLogMessage(wxT("radar_pi: recording %s has no index, rebuilding it"), filename.c_str());
+    RebuildIndex(file_size);
+  }
+  m_next_chunk = 0;
+  m_chunk.clear();
+  m_chunk_pos = 0;
+  m_skip_before = 0;
+  return true;
+}
+
+void RadarRecordingReader::Close() {
+  if (m_file) {
+    fclose(m_file);
+    m_file = 0;
+  }
+  m_index.clear();
+  m_chunk.clear();
+  m_chunk_pos = 0;
+}
+
+bool RadarRecordingReader::ReadIndex(uint64_t file_size) {
+  uint8_t trailer[RECORDING_TRAILER_SIZE];
+
+  if (file_size < RECORDING_ALIGN + 8 + RECORDING_TRAILER_SIZE || !SeekFile(m_file, file_size - RECORDING_TRAILER_SIZE) ||
+      fread(trailer, 1, sizeof(trailer), m_file) != sizeof(trailer) ||
+      memcmp(trailer, RECORDING_TRAILER_MAGIC, sizeof(RECORDING_TRAILER_MAGIC)) != 0) {
+    return false;
+  }
+
+  uint64_t count = GetU32(trailer + 4);
+  uint64_t offset = ((uint64_t)GetU32(trailer + 8) << 32) | GetU32(trailer + 12);
+  if (offset + 8 + count * 16 + RECORDING_TRAILER_SIZE != file_size) {
+    return false;
+  }
+
+  std::vector<uint8_t> index(8 + count * 16);
+  if (!SeekFile(m_file, offset) || fread(&index[0], 1, index.size(), m_file) != index.size() ||
+      memcmp(&index[0], RECORDING_INDEX_MAGIC, sizeof(RECORDING_INDEX_MAGIC)) != 0) {
+    return false;
+  }
+
+  m_index.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t *p = &index[8 + i * 16];
+    m_index[i].time = GetU64(p);
+    m_index[i].offset = ((uint64_t)GetU32(p + 8) << 32) | GetU32(p + 12);
+  }
+
+  m_end_time = m_start_time;
+  if (count > 0) {
+    uint8_t header[RECORDING_CHUNK_HEADER_SIZE];
+    if (!SeekFile(m_file, m_index[count - 1].offset) || fread(header, 1, sizeof(header), m_file) != sizeof(header)) {
+      m_index.clear();
+      return false;
+    }
+    m_end_time = GetU64(header + 24);
+  }
+  return true;
+}
+
+void RadarRecordingReader::RebuildIndex(uint64_t file_size) {
+  uint8_t header[RECORDING_CHUNK_HEADER_SIZE];
+
+  m_index.clear();
+  m_end_time = m_start_time;
+  for (uint64_t offset = RECORDING_ALIGN; offset + sizeof(header) <= file_size;) {
+    if (!SeekFile(m_file, offset) || fread(header, 1, sizeof(header), m_file) != sizeof(header) ||
+        memcmp(header, RECORDING_CHUNK_MAGIC, sizeof(RECORDING_CHUNK_MAGIC)) != 0) {
+      break;
+    }
+    uint64_t len = RECORDING_CHUNK_HEADER_SIZE + GetU32(header + 4);
+    if (offset + len > file_size) {
+      break;  // Cut off while it was being written
+    }
+
+    IndexEntry entry;
+    entry.time = GetU64(header + 16);
+    entry.offset = offset;
+    m_index.push_back(entry);
+    m_end_time = GetU64(header + 24);
+    offset += AlignUp(len);
+  }
+}
+
+bool RadarRecordingReader::LoadChunk(size_t n) {
+  uint8_t header[RECORDING_CHUNK_HEADER_SIZE];
+
+  m_chunk.clear();
+  m_chunk_pos = 0;
+  m_previous.clear();
+  m_next_chunk = n + 1;
+  if (n >= m_index.size()) {
+    return false;
+  }
+
+  if (!SeekFile(m_file, m_index[n].offset) || fread(header, 1, sizeof(header), m_file) != sizeof(header) ||
+      memcmp(header, RECORDING_CHUNK_MAGIC, sizeof(RECORDING_CHUNK_MAGIC)) != 0) {
+    return false;
+  }
+  m_chunk.resize(GetU32(header + 4));
+  if (m_chunk.size() > 0 && fread(&m_chunk[0], 1, m_chunk.size(), m_file) != m_chunk.size()) {
+    m_chunk.clear();
+    return false;
+  }
+  m_chunk_start = GetU64(header + 16);
+  return true;
+}
+
+bool RadarRecordingReader::Seek(wxLongLong time) {
+  if (!m_file || m_index.empty() || time > m_end_time) {
+    return false;
+  }
+
+  // Find the last chunk that starts at or before time
+  size_t lo = 0;
+  size_t hi = m_index.size();
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (m_index[mid].time <= time) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+
+  m_skip_before = time;
+  return LoadChunk(lo);
+}
+
+bool RadarRecordingReader::Next(RecordingRecord *record) {
+  if (!m_file) {
+    return false;
+  }
+
+  while (true) {
+    if (m_chunk_pos >= m_chunk.size()) {
+      if (m_next_chunk >= m_index.size()) {
+        return false;
+      }
+      LoadChunk(m_next_chunk);  // A damaged chunk comes back empty and is skipped
+      continue;
+    }
+    if (!DecodeRecord(record)) {
+      m_chunk_pos = m_chunk.size();  // Skip the rest of a damaged chunk
+      continue;
+    }
+    if (record->type == RECORD_SPOKE && record->time < m_skip_before) {
+      continue;
+    }
+    return true;
+  }
+}
+
+bool RadarRecordingReader::DecodeRecord(RecordingRecord *record) {
+  size_t left = m_chunk.size() - m_chunk_pos;
+  const uint8_t *p = &m_chunk[m_chunk_pos];
+
+  if (left < RECORD_HEADER_SIZE) {
+    return false;
+  }
+  record->type = (RecordingRecordType)p[0];
+  record->time = m_chunk_start + wxLongLong((long)GetU32(p + 1));
+
+  switch (record->type) {
+    case RECORD_SPOKE: {
+      if (left < SPOKE_RECORD_SIZE) {
+        return false;
+      }
+      const uint8_t *s = p + RECORD_HEADER_SIZE;
+      size_t len = GetU16(s + 8);
+      RecordingEncoding encoding = (RecordingEncoding)s[10];
+      size_t encoded_len = GetU16(s + 11);
+      const uint8_t *encoded = s + 13;
+
+      if (left < SPOKE_RECORD_SIZE + encoded_len || len > RECORDING_LEN_MAX) {
+        return false;
+      }
+      m_samples.resize(len);
+      uint8_t *samples = len ? &m_samples[0] : 0;
+      if (encoding == RECORDING_RAW) {
+        if (encoded_len != len) {
+          return false;
+        }
+        memcpy(samples, encoded, len);
+      } else if (!RunLengthDecode(encoded, encoded_len, samples, len)) {
+        return false;
+      }
+      if (encoding == RECORDING_DELTA_RLE) {
+        if (m_previous.size() != len) {
+          return false;
+        }
+        for (size_t i = 0; i < len; i++) {
+          samples[i] ^= m_previous[i];
+        }
+      }
+      m_previous.assign(samples, samples + len);
+
+      record->angle = (int)GetU16(s);
+      record->bearing = (int)GetU16(s + 2);
+      record->range_meters = (int)GetU32(s + 4);
+      record->len = len;
+      record->data = samples;
+      m_chunk_pos += SPOKE_RECORD_SIZE + encoded_len;
+      return true;
+    }
+
+    case RECORD_NAVIGATION: {
+      if (left < NAVIGATION_RECORD_SIZE) {
+        return false;
+      }
+      const uint8_t *n = p + RECORD_HEADER_SIZE;
+      record->heading = FromFixed((int32_t)GetU32(n), 1e3);
+      record->lat = FromFixed((int32_t)GetU32(n + 4), 1e7);
+      record->lon = FromFixed((int32_t)GetU32(n + 8), 1e7);
+      m_chunk_pos += NAVIGATION_RECORD_SIZE;
+      return true;
+    }
+
+    case RECORD_CONTROL: {
+      if (left < CONTROL_RECORD_SIZE) {
+        return false;
+      }
+      const uint8_t *c = p + RECORD_HEADER_SIZE;
+      record->control = (int)GetU16(c);
+      record->value = (int32_t)GetU32(c + 2);
+      record->state = c[6];
+      m_chunk_pos += CONTROL_RECORD_SIZE;
+      return true;
+    }
+  }
+  return false;
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,265 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RADARRECORDING_H_
+#define _RADARRECORDING_H_
+
+#include <deque>
+#include <vector>
+#include "RunLength.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Records a radar session as decoded spokes plus navigation and control state, so that it can be
+// replayed and seeked without the radar or a packet capture tool.
+//
+// All numbers are in network order. The file starts with a header of RECORDING_HEADER_SIZE bytes:
+//
+//   0  'R' 'P' 'I' 'R'
+//   4  uint8  version (RECORDING_VERSION)
+//   8  uint16 spokes per rotation
+//  10  uint16 maximum spoke length
+//  12  uint16 radar type
+//  16  uint32 high and low 32 bits of the start time, in ms since 1970
+//  24  char   name of the radar, NUL padded
+//
+// followed by chunks, each starting on a multiple of RECORDING_ALIGN so that a chunk can be mapped
+// on its own. A chunk has a header of RECORDING_CHUNK_HEADER_SIZE bytes:
+//
+//   0  'R' 'P' 'C' 'K'
+//   4  uint32 length of the records that follow
+//   8  uint32 number of records
+//  12  uint32 chunk sequence number
+//  16  uint32 high and low 32 bits of the time of the first record
+//  24  uint32 high and low 32 bits of the time of the last record
+//
+// The records in a chunk each start with a uint8 type (RecordingRecordType) and a uint32 time in ms
+// relative to the first record of the chunk:
+//
+//   RECORD_SPOKE       uint16 angle, uint16 bearing, uint32 range in meters, uint16 number of samples,
+//                      uint8 encoding (RecordingEncoding), uint16 encoded length, encoded samples
+//   RECORD_NAVIGATION  int32 heading in 1/1000 degrees, int32 latitude and longitude in 1e-7 degrees,
+//                      RECORDING_NO_VALUE when not known
+//   RECORD_CONTROL     uint16 control type, int32 value, uint8 state
+//
+// Every chunk starts with the navigation and control state at that time and deltas only refer to
+// the previous spoke in the same chunk, so reading can start at any chunk.
+//
+// After the last chunk comes the time index: 'R' 'P' 'I' 'X', uint32 number of entries and per
+// chunk the uint32 high and low time of its first record and uint32 high and low file offset.
+// The file ends with a trailer 'R' 'P' 'T' 'R', uint32 number of entries and the uint32 high and
+// low file offset of the index. A file without a trailer (the recorder did not close it) is still
+// readable, the index is then rebuilt from the chunk headers.
+//
+
+#define RECORDING_VERSION (1)
+#define RECORDING_HEADER_SIZE (64)
+#define RECORDING_CHUNK_HEADER_SIZE (32)
+#define RECORDING_TRAILER_SIZE (16)
+#define RECORDING_ALIGN (4096)
+#define RECORDING_CHUNK_SIZE (256 * 1024)  // Close a chunk when it holds this many bytes ...
+#define RECORDING_CHUNK_MILLIS (1000)      // ... or spans this many ms, which bounds the seek granularity
+#define RECORDING_QUEUE_MAX (8)            // Chunks waiting for the disk, beyond that chunks are dropped
+#define RECORDING_NAME_LEN (40)
+#define RECORDING_NO_VALUE ((int32_t)0x80000000)
+#define RECORDING_LEN_MAX (4096)
+
+enum RecordingRecordType { RECORD_SPOKE = 1, RECORD_NAVIGATION, RECORD_CONTROL };
+
+enum RecordingEncoding {
+  RECORDING_RAW,        // Samples as is
+  RECORDING_RLE,        // RunLengthEncode of the samples
+  RECORDING_DELTA_RLE,  // RunLengthEncode of the samples XOR the previous spoke in the chunk
+};
+
+struct RecordingRecord {
+  RecordingRecordType type;
+  wxLongLong time;
+
+  // RECORD_SPOKE, data remains valid until the next call to the reader
+  int angle;
+  int bearing;
+  int range_meters;
+  size_t len;
+  const uint8_t *data;
+
+  // RECORD_NAVIGATION, NAN when not known
+  double heading;
+  double lat;
+  double lon;
+
+  // RECORD_CONTROL
+  int control;
+  int value;
+  int state;
+};
+
+class RecordingWriter;
+
+//
+// Writing side, called on the receive thread of the radar. Records are collected in memory and a
+// separate thread writes the finished chunks, so the receive thread never waits for the disk.
+//
+class RadarRecorder {
+ public:
+  RadarRecorder();
+  ~RadarRecorder();
+
+  bool Open(const wxString &filename, const wxString &name, int radar_type, size_t spokes, size_t spoke_len_max);
+  void Close();
+  bool IsOpen() { return m_file != 0; }
+
+  void RecordSpoke(int angle, int bearing, const uint8_t *data, size_t len, int range_meters, wxLongLong time);
+  void RecordNavigation(wxLongLong time, double heading, double lat, double lon);
+  void RecordControl(wxLongLong time, int control, int value, int state);
+
+  uint64_t GetRecords() { return m_records; }
+  uint64_t GetSamples() { return m_samples; }
+  uint64_t GetBytesWritten();
+  uint64_t GetDroppedChunks();
+
+ private:
+  friend class RecordingWriter;
+
+  struct Navigation {
+    int32_t heading;
+    int32_t lat;
+    int32_t lon;
+  };
+  struct Control {
+    bool valid;
+    int value;
+    int state;
+  };
+  struct IndexEntry {
+    wxLongLong time;
+    uint64_t offset;
+  };
+
+  bool NextChunk(wxLongLong *time, size_t len);
+  uint8_t *Append(RecordingRecordType type, wxLongLong time, size_t len);
+  void PutNavigation(wxLongLong time);
+  void PutControl(wxLongLong time, int control);
+  void FinishChunk();
+
+  FILE *m_file;
+  wxString m_filename;
+  size_t m_spoke_len_max;
+
+  std::vector<uint8_t> *m_chunk;  // Chunk being filled, starts with room for the chunk header
+  size_t m_chunk_records;
+  uint32_t m_chunk_sequence;
+  wxLongLong m_chunk_start;
+  wxLongLong m_chunk_end;  // Time of the last record, also in earlier chunks
+
+  Navigation m_navigation;
+  bool m_have_navigation;
+  std::vector<Control> m_controls;
+
+  std::vector<uint8_t> m_previous;  // Samples of the previous spoke in the chunk
+  std::vector<uint8_t> m_delta;
+  std::vector<uint8_t> m_rle;
+  std::vector<uint8_t> m_delta_rle;
+
+  uint64_t m_records;
+  uint64_t m_samples;
+
+  // Shared with the writer thread
+  wxCriticalSection m_lock;
+  std::deque<std::vector<uint8_t> *> m_queue;
+  std::vector<IndexEntry> m_index;
+  uint64_t m_offset;  // Where the next chunk goes
+  uint64_t m_dropped_chunks;
+  bool m_quit;
+  RecordingWriter *m_writer;
+};
+
+//
+// Reading side. Seek finds the chunk by binary search in the time index, then reads only that chunk.
+//
+class RadarRecordingReader {
+ public:
+  RadarRecordingReader();
+  ~RadarRecordingReader();
+
+  bool Open(const wxString &filename);
+  void Close();
+
+  size_t GetSpokes() { return m_spokes; }
+  size_t GetSpokeLenMax() { return m_spoke_len_max; }
+  int GetRadarType() { return m_radar_type; }
+  const wxString &GetName() { return m_name; }
+  wxLongLong GetStartTime() { return m_start_time; }
+  wxLongLong GetEndTime() { return m_end_time; }
+  size_t GetChunkCount() { return m_index.size(); }
+
+  // Position the reader at time, returns false if the recording ends before it. Spokes before time
+  // are skipped, but the navigation and control records of the chunk are still returned so that the
+  // caller knows the state at that time.
+  bool Seek(wxLongLong time);
+
+  // Read the next record, returns false at the end of the recording.
+  bool Next(RecordingRecord *record);
+
+ private:
+  struct IndexEntry {
+    wxLongLong time;
+    uint64_t offset;
+  };
+
+  bool ReadIndex(uint64_t file_size);
+  void RebuildIndex(uint64_t file_size);
+  bool LoadChunk(size_t n);
+  bool DecodeRecord(RecordingRecord *record);
+
+  FILE *m_file;
+  size_t m_spokes;
+  size_t m_spoke_len_max;
+  int m_radar_type;
+  wxString m_name;
+  wxLongLong m_start_time;
+  wxLongLong m_end_time;
+
+  std::vector<IndexEntry> m_index;
+  size_t m_next_chunk;  // Chunk that Next() loads after m_chunk
+  std::vector<uint8_t> m_chunk;
+  size_t m_chunk_pos;
+  wxLongLong m_chunk_start;
+  wxLongLong m_skip_before;  // Spokes before this time are not returned
+
+  std::vector<uint8_t> m_samples;
+  std::vector<uint8_t> m_previous;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADARRECORDING_H_ */
@@ -0,0 +1,277 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/init.h>
+#include <wx/stopwatch.h>
+#include "RadarStream.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+static SOCKET Connect(uint16_t port) {
+  SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  struct sockaddr_in adr;
+
+  CLEAR_STRUCT(adr);
+  adr.sin_family = AF_INET;
+  adr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  adr.sin_port = htons(port);
+  if (s != INVALID_SOCKET && connect(s, (struct sockaddr *)&adr, sizeof(adr)) != 0) {
+    closesocket(s);
+    return INVALID_SOCKET;
+  }
+  return s;
+}
+
+struct Client {
+  SOCKET socket;
+  RadarStreamDecoder decoder;
+  std::vector<uint8_t> buffer;
+  size_t bytes;
+  size_t messages;
+};
+
+// Read and decode messages until the client shows the expected image
+static bool ReadUntil(Client &client, const std::vector<uint8_t> &expected, int timeout) {
+  wxStopWatch stopwatch;
+
+  while (stopwatch.Time() < timeout) {
+    if (client.decoder.HasImage() && client.decoder.GetImageBytes() == expected.size() &&
+        memcmp(client.decoder.GetImage(), &expected[0], expected.size()) == 0) {
+      return true;
+    }
+    if (!socketReady(client.socket, 50)) {
+      continue;
+    }
+    uint8_t data[65536];
+    int r = recv(client.socket, (char *)data, sizeof(data), 0);
+    if (r <= 0) {
+      cout << "ERROR: connection closed\n";
+      return false;
+    }
+    client.bytes += r;
+    client.buffer.insert(client.buffer.end(), data, data + r);
+    while (client.buffer.size() >= STREAM_HEADER_SIZE) {
+      size_t len = StreamMessageLength(&client.buffer[0]);
+      if (len == 0) {
+        cout << "ERROR: invalid message header\n";
+        return false;
+      }
+      if (client.buffer.size() < len) {
+        break;
+      }
+      if (!client.decoder.Decode(&client.buffer[0], len)) {
+        cout << "ERROR: message type " << (int)client.buffer[5] << " cannot be decoded\n";
+        return false;
+      }
+      client.messages++;
+      client.buffer.erase(client.buffer.begin(), client.buffer.begin() + len);
+    }
+  }
+  cout << "ERROR: client did not receive the image within " << timeout << " ms\n";
+  return false;
+}
+
+static void Blobs(std::vector<uint8_t> &image, size_t size, size_t bytes_per_pixel, size_t count) {
+  for (size_t b = 0; b < count; b++) {
+    size_t x = rand() % (size - 8);
+    size_t y = rand() % (size - 8);
+    uint8_t v = (uint8_t)(rand() % 4);
+    for (size_t row = 0; row < 8; row++) {
+      memset(&image[((y + row) * size + x) * bytes_per_pixel], v, 8 * bytes_per_pixel);
+    }
+  }
+}
+
+int main() {
+  int ret = 0;
+  wxInitializer initializer;  // needed for wxThread
+
+  // Run length coding round trips
+  srand(1);
+  for (size_t len = 0; len < 600; len++) {
+    std::vector<uint8_t> src(len);
+    std::vector<uint8_t> out;
+    for (size_t i = 0; i < len; i++) {
+      src[i] = (i > 0 && rand() % (1 + len % 7) != 0) ? src[i - 1] : (uint8_t)(rand() % 3);
+    }
+    RunLengthEncode(src.empty() ? 0 : &src[0], len, out);
+    std::vector<uint8_t> dst(len + 1);
+    if (!RunLengthDecode(out.empty() ? 0 : &out[0], out.size(), &dst[0], len) || memcmp(&dst[0], src.empty() ? 0 : &src[0], len) != 0) {
+      cout << "ERROR: RLE of " << len << " bytes does not round trip\n";
+      ret = 1;
+    }
+    if (RunLengthDecode(out.empty() ? 0 : &out[0], out.size(), &dst[0], len + 1)) {
+      cout << "ERROR: RLE of " << len << " bytes decodes into the wrong length\n";
+      ret = 1;
+    }
+  }
+
+  RadarStream stream(wxT("Test"));
+  if (!stream.Start(0, false)) {
+    cout << "ERROR: cannot start stream\n";
+    exit(1);
+  }
+  cout << "INFO: streaming on port " << stream.GetPort() << "\n";
+
+  Client a;
+  a.socket = Connect(stream.GetPort());
+  a.bytes = 0;
+  a.messages = 0;
+  if (a.socket == INVALID_SOCKET) {
+    cout << "ERROR: cannot connect\n";
+    exit(1);
+  }
+
+  // Palette indexed frames with a few changes each
+  const size_t size = 256;
+  std::vector<uint8_t> image(size * size, 0);
+  const int frames = 20;
+  for (int f = 0; f < frames && ret == 0; f++) {
+    Blobs(image, size, 1, 10);
+    stream.Publish(&image[0], size, 1);
+    if (!ReadUntil(a, image, 2000)) {
+      cout << "ERROR: frame " << f << " did not arrive intact\n";
+      ret = 1;
+    }
+  }
+  cout << "INFO: " << frames << " frames of " << size << "x" << size << " took " << a.bytes << " bytes in " << a.messages
+       << " messages, " << frames * size * size << " bytes uncompressed\n";
+
+  // The software draw method is only asked for a frame every STREAM_FRAME_MILLIS
+  if (stream.WantsFrame()) {
+    cout << "ERROR: stream wants a frame right after one was published\n";
+    ret = 1;
+  }
+  wxMilliSleep(STREAM_FRAME_MILLIS);
+  if (!stream.WantsFrame()) {
+    cout << "ERROR: stream does not want a frame while a client is connected\n";
+    ret = 1;
+  }
+
+  // RGBA, with a size that is not a multiple of the tile size
+  const size_t rgba_size = 200;
+  std::vector<uint8_t> rgba(rgba_size * rgba_size * 4, 0);
+  for (int f = 0; f < 3 && ret == 0; f++) {
+    Blobs(rgba, rgba_size, 4, 20);
+    stream.Publish(&rgba[0], rgba_size, 4);
+    if (!ReadUntil(a, rgba, 2000)) {
+      cout << "ERROR: RGBA frame " << f << " did not arrive intact\n";
+      ret = 1;
+    }
+  }
+
+  // A client that does not read must not hold up the other one, nor make the queues grow
+  Client b;
+  b.socket = Connect(stream.GetPort());
+  b.bytes = 0;
+  b.messages = 0;
+  const size_t noise_size = 512;
+  std::vector<uint8_t> noise(noise_size * noise_size * 4);
+  size_t max_queued = 0;
+  wxStopWatch stopwatch;
+  for (int f = 0; f < 60 && ret == 0; f++) {
+    for (size_t i = 0; i < noise.size(); i++) {
+      noise[i] = (uint8_t)rand();
+    }
+    stream.Publish(&noise[0], noise_size, 4);
+    if (!ReadUntil(a, noise, 5000)) {
+      cout << "ERROR: noise frame " << f << " did not arrive intact while the other client is stalled\n";
+      ret = 1;
+    }
+    max_queued = wxMax(max_queued, stream.GetQueuedMessages());
+  }
+  cout << "INFO: 60 frames of " << noise_size << "x" << noise_size << " RGBA noise took " << stopwatch.Time()
+       << " ms, at most " << max_queued << " messages queued, " << stream.GetStatus().c_str() << "\n";
+  if (max_queued > 2 * (STREAM_QUEUE_MAX + 2)) {
+    cout << "ERROR: queues grew to " << max_queued << " messages\n";
+    ret = 1;
+  }
+  if (ret == 0 && !ReadUntil(b, noise, 5000)) {
+    cout << "ERROR: stalled client did not catch up with the last frame\n";
+    ret = 1;
+  }
+
+  // Frames rendered from spokes
+  uint8_t map[RASTER_PALETTE_SIZE];
+  uint8_t palette[RASTER_PALETTE_SIZE][4];
+  for (size_t i = 0; i < RASTER_PALETTE_SIZE; i++) {
+    map[i] = (uint8_t)(i / 64);
+    palette[i][0] = (uint8_t)i;
+    palette[i][1] = 0;
+    palette[i][2] = (uint8_t)(255 - i);
+    palette[i][3] = 255;
+  }
+  RadarRaster raster;
+  raster.Init(256, 128, STREAM_IMAGE_SIZE);
+  stream.Init(256, 128);
+  stream.SetColourMap(map, &palette[0][0]);
+  for (int angle = 0; angle < 256; angle++) {
+    uint8_t spoke[128];
+    for (size_t r = 0; r < sizeof(spoke); r++) {
+      spoke[r] = (uint8_t)((angle * 7 + r) % 256);
+    }
+    stream.ProcessRadarSpoke(angle, spoke, sizeof(spoke));
+    raster.SetSpoke(angle, spoke, sizeof(spoke), map);
+  }
+  raster.Render(RASTER_INDEXED, 1);
+  std::vector<uint8_t> expected(raster.GetImage(), raster.GetImage() + raster.GetImageBytes());
+  if (ret == 0 && !ReadUntil(a, expected, 2000)) {
+    cout << "ERROR: image rendered from spokes did not arrive intact\n";
+    ret = 1;
+  }
+  if (memcmp(a.decoder.GetPalette(), palette, sizeof(palette)) != 0) {
+    cout << "ERROR: palette did not arrive\n";
+    ret = 1;
+  }
+
+  closesocket(b.socket);
+  closesocket(a.socket);
+  stopwatch.Start();
+  while (stream.GetClientCount() > 0 && stopwatch.Time() < 2000) {
+    wxMilliSleep(10);
+  }
+  if (stream.GetClientCount() != 0) {
+    cout << "ERROR: clients that went away are still counted\n";
+    ret = 1;
+  }
+  stream.Shutdown();
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
@@ -0,0 +1,704 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "RadarStream.h"
+
+#ifndef __WXMSW__
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL (0)
+#endif
+
+#define STREAM_IMAGE_SIZE_MAX (8192)  // Keeps the number of tiles within 16 bits
+
+PLUGIN_BEGIN_NAMESPACE
+
+static const uint8_t STREAM_MAGIC[4] = {'R', 'P', 'I', 'S'};
+
+static void PutU16(uint8_t *p, size_t v) {
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+}
+
+static void PutU32(uint8_t *p, size_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static size_t GetU16(const uint8_t *p) { return ((size_t)p[0] << 8) | p[1]; }
+
+static size_t GetU32(const uint8_t *p) { return ((size_t)p[0] << 24) | ((size_t)p[1] << 16) | ((size_t)p[2] << 8) | p[3]; }
+
+size_t StreamMessageLength(const uint8_t *header) {
+  if (memcmp(header, STREAM_MAGIC, sizeof(STREAM_MAGIC)) != 0 || header[4] != STREAM_VERSION) {
+    return 0;
+  }
+  return STREAM_HEADER_SIZE + GetU32(header + 20);
+}
+
+bool RadarStreamDecoder::Decode(const uint8_t *message, size_t len) {
+  if (len < STREAM_HEADER_SIZE || StreamMessageLength(message) != len) {
+    return false;
+  }
+
+  size_t type = message[5];
+  size_t bytes_per_pixel = message[6];
+  size_t tile_size = GetU16(message + 8);
+  size_t tiles = GetU16(message + 10);
+  size_t size = GetU32(message + 12);
+  const uint8_t *payload = message + STREAM_HEADER_SIZE;
+  size_t payload_len = len - STREAM_HEADER_SIZE;
+
+  switch (type) {
+    case STREAM_PALETTE:
+      if (payload_len != sizeof(m_palette)) {
+        return false;
+      }
+      memcpy(m_palette, payload, sizeof(m_palette));
+      return true;
+
+    case STREAM_KEY_FRAME:
+      if (size == 0 || size > STREAM_IMAGE_SIZE_MAX || (bytes_per_pixel != 1 && bytes_per_pixel != 4)) {
+        return false;
+      }
+      m_size = size;
+      m_bytes_per_pixel = bytes_per_pixel;
+      m_image.assign(size * size * bytes_per_pixel, 0);
+      m_have_key_frame = true;
+      break;
+
+    case STREAM_DELTA_FRAME:
+      if (!m_have_key_frame || size != m_size || bytes_per_pixel != m_bytes_per_pixel) {
+        return false;
+      }
+      break;
+
+    default:
+      return false;
+  }
+  if (tile_size == 0) {
+    return false;
+  }
+
+  std::vector<uint8_t> tile(tile_size * tile_size * bytes_per_pixel);
+  size_t pos = 0;
+
+  for (size_t t = 0; t < tiles; t++) {
+    if (pos + 8 > payload_len) {
+      return false;
+    }
+    size_t x = GetU16(payload + pos) * tile_size;
+    size_t y = GetU16(payload + pos + 2) * tile_size;
+    size_t tile_len = GetU32(payload + pos + 4);
+    pos += 8;
+    if (x >= size || y >= size || pos + tile_len > payload_len) {
+      return false;
+    }
+    size_t w = wxMin(tile_size, size - x);
+    size_t h = wxMin(tile_size, size - y);
+    size_t row_bytes = w * bytes_per_pixel;
+    if (!RunLengthDecode(payload + pos, tile_len, &tile[0], row_bytes * h)) {
+      return false;
+    }
+    pos += tile_len;
+    for (size_t row = 0; row < h; row++) {
+      memcpy(&m_image[((y + row) * size + x) * bytes_per_pixel], &tile[row * row_bytes], row_bytes);
+    }
+  }
+  m_sequence = (uint32_t)GetU32(message + 16);
+  return pos == payload_len;
+}
+
+static bool SetNonBlocking(SOCKET s) {
+#ifdef __WXMSW__
+  u_long one = 1;
+  return ioctlsocket(s, FIONBIO, &one) == 0;
+#else
+  int flags = fcntl(s, F_GETFL, 0);
+  return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static bool WouldBlock() {
+#ifdef __WXMSW__
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+RadarStream::RadarStream(const wxString &name) : wxThread(wxTHREAD_JOINABLE) {
+  m_name = name;
+  m_server = INVALID_SOCKET;
+  m_wake_receive = INVALID_SOCKET;
+  m_wake_send = INVALID_SOCKET;
+  m_port = 0;
+  m_shutdown = false;
+  m_polar_dirty = false;
+  CLEAR_STRUCT(m_map);
+  CLEAR_STRUCT(m_palette);
+  m_palette_changed = false;
+  m_pending_size = 0;
+  m_pending_bytes_per_pixel = 0;
+  m_pending_new = false;
+  m_publish_time = 0;
+  m_client_count = 0;
+  m_queued_messages = 0;
+  m_frames = 0;
+  m_client_resets = 0;
+  m_bytes_sent = 0;
+  m_size = 0;
+  m_bytes_per_pixel = 0;
+  m_sequence = 0;
+  m_palette_message = 0;
+  m_render_time = 0;
+  m_thread_frames = 0;
+  m_thread_client_resets = 0;
+  m_thread_bytes_sent = 0;
+}
+
+RadarStream::~RadarStream() {
+  for (size_t c = m_clients.size(); c > 0; c--) {
+    CloseClient(c - 1);
+  }
+  if (m_palette_message) {
+    ReleaseMessage(m_palette_message);
+    m_palette_message = 0;
+  }
+  if (m_server != INVALID_SOCKET) {
+    closesocket(m_server);
+  }
+  if (m_wake_receive != INVALID_SOCKET) {
+    closesocket(m_wake_receive);
+  }
+  if (m_wake_send != INVALID_SOCKET) {
+    closesocket(m_wake_send);
+  }
+}
+
+bool RadarStream::Start(uint16_t port, bool all_interfaces) {
+  struct sockaddr_in adr;
+  socklen_t adrlen = sizeof(adr);
+  int one = 1;
+
+  CLEAR_STRUCT(adr);
+#ifdef __WXMAC__
+  adr.sin_len = sizeof(adr);
+#endif
+  adr.sin_family = AF_INET;
+  adr.sin_addr.s_addr = htonl(all_interfaces ? INADDR_ANY : INADDR_LOOPBACK);
+  adr.sin_port = htons(port);
+
+  m_server = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (m_server == INVALID_SOCKET) {
+    wxLogError(wxT("radar_pi: %s cannot create stream socket"), m_name.c_str());
+    return false;
+  }
+  setsockopt(m_server, SOL_SOCKET, SO_REUSEADDR, (const char *)&one, sizeof(one));
+  if (::bind(m_server, (struct sockaddr *)&adr, sizeof(adr)) < 0 || listen(m_server, STREAM_CLIENTS_MAX) < 0 ||
+      !SetNonBlocking(m_server) || getsockname(m_server, (struct sockaddr *)&adr, &adrlen) < 0) {
+    wxLogError(wxT("radar_pi: %s cannot listen for stream clients on port %u: %s"), m_name.c_str(), port, SOCKETERRSTR);
+    closesocket(m_server);
+    m_server = INVALID_SOCKET;
+    return false;
+  }
+  m_port = ntohs(adr.sin_port);
+
+  m_wake_receive = GetLocalhostServerTCPSocket();
+  m_wake_send = GetLocalhostSendTCPSocket(m_wake_receive);
+
+  if (Create(256 * 1024) != wxTHREAD_NO_ERROR || Run() != wxTHREAD_NO_ERROR) {
+    wxLogError(wxT("radar_pi: %s cannot start stream thread"), m_name.c_str());
+    return false;
+  }
+  wxLogMessage(wxT("radar_pi: %s streaming radar image on port %u"), m_name.c_str(), m_port);
+  return true;
+}
+
+// Called from the main thread to stop the stream thread, and wait until it has.
+void RadarStream::Shutdown() {
+  m_shutdown = true;
+  if (m_wake_send != INVALID_SOCKET) {
+    send(m_wake_send, "!", 1, MSG_DONTROUTE);
+  }
+  Wait();
+}
+
+void RadarStream::Init(size_t spokes, size_t spoke_len) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  m_polar.Init(spokes, spoke_len);
+  m_polar_dirty = true;
+}
+
+void RadarStream::SetColourMap(const uint8_t *map, const uint8_t *palette) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  memcpy(m_map, map, sizeof(m_map));
+  memcpy(m_palette, palette, sizeof(m_palette));
+  m_palette_changed = true;
+}
+
+void RadarStream::ProcessRadarSpoke(int angle, const uint8_t *data, size_t len) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  if (m_polar.GetSpokes() > 0) {
+    m_polar.SetSpoke(angle, data, len, m_map);
+    m_polar_dirty = true;
+  }
+}
+
+bool RadarStream::WantsFrame() {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  return m_client_count > 0 && wxGetUTCTimeMillis() - m_publish_time >= STREAM_FRAME_MILLIS;
+}
+
+void RadarStream::Publish(const uint8_t *image, size_t size, size_t bytes_per_pixel) {
+  if (size == 0 || size > STREAM_IMAGE_SIZE_MAX || (bytes_per_pixel != 1 && bytes_per_pixel != 4)) {
+    return;
+  }
+  {
+    wxCriticalSectionLocker lock(m_exclusive);
+
+    m_publish_time = wxGetUTCTimeMillis();
+    m_pending.assign(image, image + size * size * bytes_per_pixel);
+    m_pending_size = size;
+    m_pending_bytes_per_pixel = bytes_per_pixel;
+    m_pending_new = true;
+  }
+  if (m_wake_send != INVALID_SOCKET) {
+    send(m_wake_send, "!", 1, MSG_DONTROUTE);
+  }
+}
+
+size_t RadarStream::GetClientCount() {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  return m_client_count;
+}
+
+size_t RadarStream::GetQueuedMessages() {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  return m_queued_messages;
+}
+
+wxString RadarStream::GetStatus() {
+  wxCriticalSectionLocker lock(m_exclusive);
+  wxString s;
+
+  s.Printf(wxT("port %u: %u clients, %u frames, %u resets, %u kB sent"), m_port, (unsigned)m_client_count, (unsigned)m_frames,
+           (unsigned)m_client_resets, (unsigned)(m_bytes_sent / 1024));
+  return s;
+}
+
+RadarStream::StreamMessage *RadarStream::NewMessage(StreamMessageType type) {
+  StreamMessage *message = new StreamMessage;
+
+  message->refs = 1;  // The creator's reference
+  message->data.resize(STREAM_HEADER_SIZE);
+  memcpy(&message->data[0], STREAM_MAGIC, sizeof(STREAM_MAGIC));
+  message->data[4] = STREAM_VERSION;
+  message->data[5] = (uint8_t)type;
+  message->data[6] = (uint8_t)m_bytes_per_pixel;
+  message->data[7] = 0;
+  PutU16(&message->data[8], STREAM_TILE_SIZE);
+  PutU16(&message->data[10], 0);
+  PutU32(&message->data[12], m_size);
+  PutU32(&message->data[16], m_sequence);
+  PutU32(&message->data[20], 0);
+  return message;
+}
+
+void RadarStream::ReleaseMessage(StreamMessage *message) {
+  if (--message->refs == 0) {
+    delete message;
+  }
+}
+
+void RadarStream::EncodeTile(StreamMessage *message, size_t tx, size_t ty) {
+  size_t x = tx * STREAM_TILE_SIZE;
+  size_t y = ty * STREAM_TILE_SIZE;
+  size_t row_bytes = wxMin((size_t)STREAM_TILE_SIZE, m_size - x) * m_bytes_per_pixel;
+  size_t h = wxMin((size_t)STREAM_TILE_SIZE, m_size - y);
+  uint8_t tile[STREAM_TILE_SIZE * STREAM_TILE_SIZE * 4];
+
+  for (size_t row = 0; row < h; row++) {
+    memcpy(tile + row * row_bytes, &m_current[((y + row) * m_size + x) * m_bytes_per_pixel], row_bytes);
+  }
+
+  std::vector<uint8_t> &data = message->data;
+  size_t start = data.size();
+
+  data.resize(start + 8);
+  PutU16(&data[start], tx);
+  PutU16(&data[start + 2], ty);
+  RunLengthEncode(tile, row_bytes * h, data);
+  PutU32(&data[start + 4], data.size() - start - 8);
+}
+
+// Encode all tiles, or only those that differ from the previous frame. Returns 0 if there are none.
+RadarStream::StreamMessage *RadarStream::EncodeFrame(bool key_frame) {
+  StreamMessage *message = NewMessage(key_frame ? STREAM_KEY_FRAME : STREAM_DELTA_FRAME);
+  size_t tiles_across = (m_size + STREAM_TILE_SIZE - 1) / STREAM_TILE_SIZE;
+  size_t tiles = 0;
+
+  for (size_t ty = 0; ty < tiles_across; ty++) {
+    for (size_t tx = 0; tx < tiles_across; tx++) {
+      bool dirty = key_frame;
+
+      if (!dirty) {
+        size_t x = tx * STREAM_TILE_SIZE;
+        size_t y = ty * STREAM_TILE_SIZE;
+        size_t row_bytes = wxMin((size_t)STREAM_TILE_SIZE, m_size - x) * m_bytes_per_pixel;
+        size_t h = wxMin((size_t)STREAM_TILE_SIZE, m_size - y);
+
+        for (size_t row = 0; row < h && !dirty; row++) {
+          size_t offset = ((y + row) * m_size + x) * m_bytes_per_pixel;
+          dirty = memcmp(&m_current[offset], &m_previous[offset], row_bytes) != 0;
+        }
+      }
+      if (dirty) {
+        EncodeTile(message, tx, ty);
+        tiles++;
+      }
+    }
+  }
+
+  if (tiles == 0) {
+    ReleaseMessage(message);
+    return 0;
+  }
+  PutU16(&message->data[10], tiles);
+  PutU32(&message->data[20], message->data.size() - STREAM_HEADER_SIZE);
+  return message;
+}
+
+// Move a new frame, either rendered from the spokes or published, to m_current. Returns true if there is one.
+bool RadarStream::TakeFrame() {
+  wxLongLong now = wxGetUTCTimeMillis();
+  size_t spokes = 0;
+  size_t spoke_len = 0;
+  bool render = false;
+
+  {
+    wxCriticalSectionLocker lock(m_exclusive);
+
+    // Only scan convert when someone is watching, and nobody publishes frames
+    if (m_polar_dirty && m_polar.GetSpokes() > 0 && !m_clients.empty() && now - m_render_time >= STREAM_FRAME_MILLIS &&
+        now - m_publish_time >= STREAM_PUBLISH_HOLD_MILLIS) {
+      spokes = m_polar.GetSpokes();
+      spoke_len = m_polar.GetSpokeLen();
+      if (m_raster.GetSpokes() == spokes && m_raster.GetSpokeLen() == spoke_len) {
+        m_raster.SetSpokes(m_polar);  // A copy, so the receive thread can go on while we render
+        m_polar_dirty = false;
+        render = true;
+      }
+    }
+  }
+
+  // Scan convert without holding the lock that ProcessRadarSpoke() needs
+  if (spokes > 0 && !render) {
+    m_raster.Init(spokes, spoke_len, STREAM_IMAGE_SIZE);  // The spokes are copied on the next call
+    m_raster.SetBackground(0);
+  }
+  if (render) {
+    m_raster.Render(RASTER_INDEXED, 1);
+    m_rendered.assign(m_raster.GetImage(), m_raster.GetImage() + m_raster.GetImageBytes());
+    m_render_time = now;
+  }
+
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  if (render && !m_pending_new) {  // A frame published while rendering takes precedence
+    m_pending.swap(m_rendered);
+    m_pending_size = m_raster.GetSize();
+    m_pending_bytes_per_pixel = 1;
+    m_pending_new = true;
+  }
+
+  if (m_palette_changed) {
+    if (m_palette_message) {
+      ReleaseMessage(m_palette_message);
+    }
+    m_palette_message = NewMessage(STREAM_PALETTE);
+    m_palette_message->data.insert(m_palette_message->data.end(), &m_palette[0][0], &m_palette[0][0] + sizeof(m_palette));
+    PutU32(&m_palette_message->data[20], sizeof(m_palette));
+    m_palette_changed = false;
+    for (size_t c = 0; c < m_clients.size(); c++) {
+      if (!m_clients[c].need_key_frame) {
+        Push(m_clients[c], m_palette_message);
+      }
+    }
+  }
+
+  if (!m_pending_new) {
+    return false;
+  }
+  if (m_pending_size != m_size || m_pending_bytes_per_pixel != m_bytes_per_pixel) {
+    // The old frame is of no use for deltas
+    m_size = m_pending_size;
+    m_bytes_per_pixel = m_pending_bytes_per_pixel;
+    m_previous.clear();
+    for (size_t c = 0; c < m_clients.size(); c++) {
+      DropQueue(m_clients[c]);
+    }
+  }
+  m_current.swap(m_pending);
+  m_pending_new = false;
+  return true;
+}
+
+void RadarStream::Distribute() {
+  m_sequence++;
+  m_thread_frames++;
+
+  if (m_previous.size() == m_current.size()) {
+    StreamMessage *delta = 0;
+    bool encoded = false;
+
+    for (size_t c = 0; c < m_clients.size(); c++) {
+      StreamClient &client = m_clients[c];
+
+      if (client.need_key_frame) {
+        continue;
+      }
+      if (client.queue.size() >= STREAM_QUEUE_MAX) {
+        // Too slow, throw its backlog away and let it start over with a key frame
+        DropQueue(client);
+        continue;
+      }
+      if (!encoded) {
+        delta = EncodeFrame(false);
+        encoded = true;
+      }
+      if (delta) {
+        Push(client, delta);
+      }
+    }
+    if (delta) {
+      ReleaseMessage(delta);
+    }
+  } else {
+    for (size_t c = 0; c < m_clients.size(); c++) {
+      m_clients[c].need_key_frame = true;
+    }
+  }
+
+  m_previous = m_current;
+}
+
+void RadarStream::ServeKeyFrames() {
+  StreamMessage *key = 0;
+
+  if (m_size == 0 || m_current.empty()) {
+    return;
+  }
+  for (size_t c = 0; c < m_clients.size(); c++) {
+    StreamClient &client = m_clients[c];
+
+    if (!client.need_key_frame) {
+      continue;
+    }
+    if (!key) {
+      key = EncodeFrame(true);
+    }
+    if (m_palette_message) {
+      Push(client, m_palette_message);
+    }
+    Push(client, key);
+    client.need_key_frame = false;
+  }
+  if (key) {
+    ReleaseMessage(key);
+  }
+}
+
+void RadarStream::Push(StreamClient &client, StreamMessage *message) {
+  message->refs++;
+  client.queue.push_back(message);
+}
+
+// Throw away what is queued for the client, except a message that is partly sent as that must be completed.
+void RadarStream::DropQueue(StreamClient &client) {
+  std::deque<StreamMessage *>::iterator first = client.queue.begin();
+
+  if (client.offset > 0) {
+    first++;
+  }
+  for (std::deque<StreamMessage *>::iterator i = first; i != client.queue.end(); i++) {
+    ReleaseMessage(*i);
+  }
+  client.queue.erase(first, client.queue.end());
+  client.need_key_frame = true;
+  m_thread_client_resets++;
+}
+
+void RadarStream::AcceptClient() {
+  SOCKET s = accept(m_server, 0, 0);
+  int one = 1;
+
+  if (s == INVALID_SOCKET) {
+    return;
+  }
+  if (m_clients.size() >= STREAM_CLIENTS_MAX || !SetNonBlocking(s)) {
+    wxLogMessage(wxT("radar_pi: %s refused stream client, already %u connected"), m_name.c_str(), (unsigned)m_clients.size());
+    closesocket(s);
+    return;
+  }
+  setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char *)&one, sizeof(one));
+
+  StreamClient client;
+  client.socket = s;
+  client.offset = 0;
+  client.need_key_frame = true;
+  m_clients.push_back(client);
+  wxLogMessage(wxT("radar_pi: %s stream client connected, %u clients"), m_name.c_str(), (unsigned)m_clients.size());
+}
+
+void RadarStream::CloseClient(size_t c) {
+  StreamClient &client = m_clients[c];
+
+  for (size_t i = 0; i < client.queue.size(); i++) {
+    ReleaseMessage(client.queue[i]);
+  }
+  closesocket(client.socket);
+  m_clients.erase(m_clients.begin() + c);
+}
+
+// Send as much as the socket will take. Returns false if the client is gone.
+bool RadarStream::SendClient(StreamClient &client) {
+  while (!client.queue.empty()) {
+    StreamMessage *message = client.queue.front();
+    int r = send(client.socket, (const char *)&message->data[client.offset], message->data.size() - client.offset, MSG_NOSIGNAL);
+
+    if (r < 0) {
+      return WouldBlock();
+    }
+    if (r == 0) {
+      return false;
+    }
+    client.offset += r;
+    m_thread_bytes_sent += r;
+    if (client.offset == message->data.size()) {
+      client.queue.pop_front();
+      ReleaseMessage(message);
+      client.offset = 0;
+    }
+  }
+  return true;
+}
+
+void RadarStream::UpdateCounters() {
+  size_t queued = 0;
+
+  for (size_t c = 0; c < m_clients.size(); c++) {
+    queued += m_clients[c].queue.size();
+  }
+
+  wxCriticalSectionLocker lock(m_exclusive);
+  m_client_count = m_clients.size();
+  m_queued_messages = queued;
+  m_frames = m_thread_frames;
+  m_client_resets = m_thread_client_resets;
+  m_bytes_sent = m_thread_bytes_sent;
+}
+
+void *RadarStream::Entry(void) {
+  uint8_t buf[256];
+
+  while (!m_shutdown) {
+    fd_set fdin;
+    fd_set fdout;
+    SOCKET max_fd = wxMax(m_server, m_wake_receive);
+    struct timeval tv = {(long)0, (long)(STREAM_SELECT_MILLIS * 1000)};
+
+    FD_ZERO(&fdin);
+    FD_ZERO(&fdout);
+    FD_SET(m_server, &fdin);
+    if (m_wake_receive != INVALID_SOCKET) {
+      FD_SET(m_wake_receive, &fdin);
+    }
+    for (size_t c = 0; c < m_clients.size(); c++) {
+      FD_SET(m_clients[c].socket, &fdin);
+      if (!m_clients[c].queue.empty()) {
+        FD_SET(m_clients[c].socket, &fdout);
+      }
+      max_fd = wxMax(max_fd, m_clients[c].socket);
+    }
+
+    int r = select(max_fd + 1, &fdin, &fdout, 0, &tv);
+    if (m_shutdown) {
+      break;
+    }
+    if (r > 0) {
+      if (m_wake_receive != INVALID_SOCKET && FD_ISSET(m_wake_receive, &fdin)) {
+        recv(m_wake_receive, (char *)buf, sizeof(buf), 0);
+      }
+      if (FD_ISSET(m_server, &fdin)) {
+        AcceptClient();
+      }
+      for (size_t c = m_clients.size(); c > 0; c--) {
+        // Clients do not send anything, so readable means it has gone away
+        if (FD_ISSET(m_clients[c - 1].socket, &fdin)) {
+          int n = recv(m_clients[c - 1].socket, (char *)buf, sizeof(buf), 0);
+          if (n == 0 || (n < 0 && !WouldBlock())) {
+            CloseClient(c - 1);
+            wxLogMessage(wxT("radar_pi: %s stream client disconnected, %u clients"), m_name.c_str(), (unsigned)m_clients.size());
+          }
+        }
+      }
+    }
+
+    if (TakeFrame()) {
+      Distribute();
+    }
+    ServeKeyFrames();
+
+    for (size_t c = m_clients.size(); c > 0; c--) {
+      if (!SendClient(m_clients[c - 1])) {
+        CloseClient(c - 1);
+        wxLogMessage(wxT("radar_pi: %s stream client lost, %u clients"), m_name.c_str(), (unsigned)m_clients.size());
+      }
+    }
+    UpdateCounters();
+  }
+
+  return 0;
+}
+
+PLUGIN_END_NAMESPACE
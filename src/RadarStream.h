@@ -0,0 +1,217 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RADARSTREAM_H_
+#define _RADARSTREAM_H_
+
+#include <deque>
+#include <vector>
+#include "RadarRaster.h"
+#include "RunLength.h"
+#include "socketutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Serves the radar image to displays that do not run OpenCPN, over a plain TCP connection.
+//
+// Every message starts with a header of STREAM_HEADER_SIZE bytes, all numbers in network order:
+//
+//   0  'R' 'P' 'I' 'S'
+//   4  uint8  version (STREAM_VERSION)
+//   5  uint8  type (StreamMessageType)
+//   6  uint8  bytes per pixel (1 = palette index, 4 = RGBA)
+//   7  uint8  reserved, 0
+//   8  uint16 tile size in pixels
+//  10  uint16 number of tiles that follow
+//  12  uint32 image size in pixels, the image is square
+//  16  uint32 frame sequence number
+//  20  uint32 length of the payload that follows the header
+//
+// A palette message carries RASTER_PALETTE_SIZE RGBA entries. A key frame carries all tiles, a delta
+// frame only those that changed since the previous frame. Each tile is uint16 column, uint16 row,
+// uint32 length followed by the tile's pixels, row by row, compressed with RunLengthEncode.
+//
+// A client is sent the palette and a key frame when it connects. When a client falls more than
+// STREAM_QUEUE_MAX messages behind its queue is thrown away and it gets a new key frame, so a slow
+// display costs a bounded amount of memory and never holds up the others.
+//
+
+#define STREAM_VERSION (1)
+#define STREAM_HEADER_SIZE (24)
+#define STREAM_TILE_SIZE (64)
+#define STREAM_CLIENTS_MAX (8)
+#define STREAM_QUEUE_MAX (4)
+#define STREAM_IMAGE_SIZE (1024)   // Size of the image rendered from spokes
+#define STREAM_FRAME_MILLIS (100)  // Render spokes into a new frame this often
+#define STREAM_PUBLISH_HOLD_MILLIS (1000)  // Frames from spokes stop while frames are published this recently
+#define STREAM_SELECT_MILLIS (20)
+
+enum StreamMessageType { STREAM_PALETTE, STREAM_KEY_FRAME, STREAM_DELTA_FRAME };
+
+// Return the total length of the message that starts with this header, or 0 if it is not a valid header.
+extern size_t StreamMessageLength(const uint8_t *header);
+
+//
+// Client side: rebuilds the image from the messages sent by RadarStream.
+//
+class RadarStreamDecoder {
+ public:
+  RadarStreamDecoder() {
+    m_size = 0;
+    m_bytes_per_pixel = 0;
+    m_sequence = 0;
+    m_have_key_frame = false;
+    CLEAR_STRUCT(m_palette);
+  }
+
+  // Apply one complete message, returns false if it is invalid or cannot be applied.
+  bool Decode(const uint8_t *message, size_t len);
+
+  bool HasImage() const { return m_have_key_frame; }
+  const uint8_t *GetImage() const { return m_image.empty() ? 0 : &m_image[0]; }
+  size_t GetImageBytes() const { return m_image.size(); }
+  size_t GetSize() const { return m_size; }
+  size_t GetBytesPerPixel() const { return m_bytes_per_pixel; }
+  uint32_t GetSequence() const { return m_sequence; }
+  const uint8_t *GetPalette() const { return &m_palette[0][0]; }
+
+ private:
+  std::vector<uint8_t> m_image;
+  size_t m_size;
+  size_t m_bytes_per_pixel;
+  uint32_t m_sequence;
+  bool m_have_key_frame;
+  uint8_t m_palette[RASTER_PALETTE_SIZE][4];
+};
+
+//
+// Server side. Frames come either from spokes, which are scan converted here at STREAM_FRAME_MILLIS
+// intervals, or ready made from Publish(). The software draw method publishes the image it draws,
+// and while it does the frames rendered from spokes are held back. All encoding and sending is done
+// on the stream's own thread, the producers only copy data.
+//
+class RadarStream : public wxThread {
+ public:
+  RadarStream(const wxString &name);
+  ~RadarStream();
+
+  // Open the listening socket and start the thread. Port 0 picks a free port, see GetPort().
+  bool Start(uint16_t port, bool all_interfaces);
+  void Shutdown();
+  uint16_t GetPort() const { return m_port; }
+
+  // Spoke input, called on the receive thread
+  void Init(size_t spokes, size_t spoke_len);
+  void SetColourMap(const uint8_t *map, const uint8_t *palette);  // RASTER_PALETTE_SIZE entries, palette RGBA
+  void ProcessRadarSpoke(int angle, const uint8_t *data, size_t len);
+
+  // Frame input, for images made elsewhere such as by the software draw method. WantsFrame() tells
+  // whether a frame published now would be sent to anyone, so the caller can skip copying it.
+  bool WantsFrame();
+  void Publish(const uint8_t *image, size_t size, size_t bytes_per_pixel);
+
+  size_t GetClientCount();
+  size_t GetQueuedMessages();
+  wxString GetStatus();
+
+  void *Entry(void);
+
+ private:
+  struct StreamMessage {
+    std::vector<uint8_t> data;
+    int refs;
+  };
+
+  struct StreamClient {
+    SOCKET socket;
+    std::deque<StreamMessage *> queue;
+    size_t offset;  // bytes of the first message in the queue that have been sent
+    bool need_key_frame;
+  };
+
+  wxString m_name;
+  SOCKET m_server;
+  SOCKET m_wake_receive;  // Publish and Shutdown send a byte to wake the thread
+  SOCKET m_wake_send;
+  uint16_t m_port;
+  volatile bool m_shutdown;
+
+  wxCriticalSection m_exclusive;  // protects the following data structures
+  RadarPolar m_polar;             // Spokes as stored by the receive thread
+  bool m_polar_dirty;
+  uint8_t m_map[RASTER_PALETTE_SIZE];
+  uint8_t m_palette[RASTER_PALETTE_SIZE][4];
+  bool m_palette_changed;
+  std::vector<uint8_t> m_pending;  // Frame waiting to be encoded
+  size_t m_pending_size;
+  size_t m_pending_bytes_per_pixel;
+  bool m_pending_new;
+  wxLongLong m_publish_time;  // When Publish() was last called
+  size_t m_client_count;
+  size_t m_queued_messages;
+  size_t m_frames;
+  size_t m_client_resets;
+  uint64_t m_bytes_sent;
+
+  // Only used on the stream thread
+  RadarRaster m_raster;             // Renders a copy of m_polar outside the lock
+  std::vector<uint8_t> m_rendered;  // Frame rendered from the spokes, swapped into m_pending
+  std::vector<uint8_t> m_current;
+  std::vector<uint8_t> m_previous;
+  size_t m_size;
+  size_t m_bytes_per_pixel;
+  uint32_t m_sequence;
+  StreamMessage *m_palette_message;
+  std::vector<StreamClient> m_clients;
+  wxLongLong m_render_time;
+  size_t m_thread_frames;
+  size_t m_thread_client_resets;
+  uint64_t m_thread_bytes_sent;
+
+  StreamMessage *NewMessage(StreamMessageType type);
+  void ReleaseMessage(StreamMessage *message);
+  void EncodeTile(StreamMessage *message, size_t tx, size_t ty);
+  StreamMessage *EncodeFrame(bool key_frame);
+  bool TakeFrame();
+  void Distribute();
+  void ServeKeyFrames();
+  void Push(StreamClient &client, StreamMessage *message);
+  void DropQueue(StreamClient &client);
+  void AcceptClient();
+  void CloseClient(size_t c);
+  bool SendClient(StreamClient &client);
+  void UpdateCounters();
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADARSTREAM_H_ */
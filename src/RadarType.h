@@ -56,6 +56,14 @@
 #include "emulator/EmulatorControlsDialog.h"
 #include "emulator/EmulatorReceive.h"
 
+#include "network/NetworkControl.h"
+#include "network/NetworkControlsDialog.h"
+#include "network/NetworkReceive.h"
+
+#include "replay/ReplayControl.h"
+#include "replay/ReplayControlsDialog.h"
+#include "replay/ReplayReceive.h"
+
 #endif /* _RADARTYPE_H_ */
 
 #define DEFINE_RADAR(t, x, s, l, a, b, c)
@@ -97,6 +105,9 @@
 
 #include "emulator/emulatortype.h"
 
+#include "network/networktype.h"
+#include "replay/replaytype.h"
+
 #undef DEFINE_RADAR  // Prepare for next inclusion
 #undef INITIALIZE_RADAR
 #undef DEFINE_RANGE_METRIC
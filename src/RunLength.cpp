@@ -0,0 +1,92 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "RunLength.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+static void PutLiterals(const uint8_t *src, size_t len, std::vector<uint8_t> &out) {
+  while (len > 0) {
+    size_t n = wxMin(len, (size_t)128);
+    out.push_back((uint8_t)(n - 1));
+    out.insert(out.end(), src, src + n);
+    src += n;
+    len -= n;
+  }
+}
+
+void RunLengthEncode(const uint8_t *src, size_t len, std::vector<uint8_t> &out) {
+  size_t literal_start = 0;
+  size_t i = 0;
+
+  while (i < len) {
+    size_t run = 1;
+    while (i + run < len && run < 130 && src[i + run] == src[i]) {
+      run++;
+    }
+    if (run >= 3) {
+      PutLiterals(src + literal_start, i - literal_start, out);
+      out.push_back((uint8_t)(run + 125));
+      out.push_back(src[i]);
+      literal_start = i + run;
+    }
+    i += run;
+  }
+  PutLiterals(src + literal_start, len - literal_start, out);
+}
+
+bool RunLengthDecode(const uint8_t *src, size_t len, uint8_t *dst, size_t dst_len) {
+  size_t pos = 0;
+  size_t o = 0;
+
+  while (pos < len) {
+    size_t c = src[pos++];
+    if (c < 128) {
+      size_t n = c + 1;
+      if (pos + n > len || o + n > dst_len) {
+        return false;
+      }
+      memcpy(dst + o, src + pos, n);
+      pos += n;
+      o += n;
+    } else {
+      size_t n = c - 125;
+      if (pos >= len || o + n > dst_len) {
+        return false;
+      }
+      memset(dst + o, src[pos++], n);
+      o += n;
+    }
+  }
+  return o == dst_len;
+}
+
+PLUGIN_END_NAMESPACE
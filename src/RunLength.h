@@ -0,0 +1,52 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RUNLENGTH_H_
+#define _RUNLENGTH_H_
+
+#include <vector>
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+// Byte oriented run length coding, fast and good enough for radar data which is mostly empty.
+// A control byte c < 128 is followed by c + 1 literal bytes, c >= 128 by one byte that is
+// repeated c - 125 times (3 .. 130).
+
+// Append the encoding of src to out.
+extern void RunLengthEncode(const uint8_t *src, size_t len, std::vector<uint8_t> &out);
+
+// Decode into dst, returns false unless the data decodes to exactly dst_len bytes.
+extern bool RunLengthDecode(const uint8_t *src, size_t len, uint8_t *dst, size_t dst_len);
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RUNLENGTH_H_ */
@@ -0,0 +1,98 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "SpokeConsumers.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+int main() {
+  SpokeConsumers consumers;
+  int ret = 0;
+
+  // Nothing is skipped or rebuilt before the main thread has said what is used
+  for (int c = 0; c < CONSUMERS; c++) {
+    if (!consumers.IsActive((SpokeConsumer)c) || consumers.TakeRebuild((SpokeConsumer)c)) {
+      cout << "ERROR: " << consumer_names[c] << " does not start active and up to date\n";
+      ret = 1;
+    }
+  }
+  if (!consumers.GetSummary().IsEmpty()) {
+    cout << "ERROR: summary while all stages run: " << consumers.GetSummary().ToAscii();
+    ret = 1;
+  }
+
+  // Hiding a view does not rebuild it, showing it again does, once
+  consumers.SetActive(CONSUMER_PANEL, false);
+  consumers.SetActive(CONSUMER_HISTORY, false);
+  if (consumers.IsActive(CONSUMER_PANEL) || consumers.TakeRebuild(CONSUMER_PANEL)) {
+    cout << "ERROR: hidden panel is active or rebuilt\n";
+    ret = 1;
+  }
+  wxString summary = consumers.GetSummary();
+  cout << "INFO: " << summary.ToAscii();
+  if (summary.Find(wxT("panel")) == wxNOT_FOUND || summary.Find(wxT("history")) == wxNOT_FOUND ||
+      summary.Find(wxT("overlay")) != wxNOT_FOUND) {
+    cout << "ERROR: summary does not list the skipped stages\n";
+    ret = 1;
+  }
+  consumers.SetActive(CONSUMER_PANEL, true);
+  consumers.SetActive(CONSUMER_PANEL, true);
+  if (!consumers.IsActive(CONSUMER_PANEL) || !consumers.TakeRebuild(CONSUMER_PANEL)) {
+    cout << "ERROR: panel is not rebuilt when shown again\n";
+    ret = 1;
+  }
+  if (consumers.TakeRebuild(CONSUMER_PANEL)) {
+    cout << "ERROR: panel is rebuilt twice\n";
+    ret = 1;
+  }
+  if (consumers.TakeRebuild(CONSUMER_HISTORY)) {
+    cout << "ERROR: history that is still skipped is rebuilt\n";
+    ret = 1;
+  }
+
+  // A new draw method has lost its image
+  consumers.RequestRebuild(CONSUMER_OVERLAY);
+  if (!consumers.TakeRebuild(CONSUMER_OVERLAY) || consumers.TakeRebuild(CONSUMER_OVERLAY)) {
+    cout << "ERROR: requested rebuild is not taken exactly once\n";
+    ret = 1;
+  }
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
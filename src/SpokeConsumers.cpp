@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "SpokeConsumers.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+const char *consumer_names[CONSUMERS] = {"panel", "overlay", "true-trails", "relative-trails", "history"};
+
+SpokeConsumers::SpokeConsumers() {
+  m_active = (1u << CONSUMERS) - 1;
+  m_rebuild = 0;
+}
+
+void SpokeConsumers::SetActive(SpokeConsumer consumer, bool active) {
+  wxCriticalSectionLocker lock(m_lock);
+  uint32_t bit = 1u << consumer;
+
+  if (active && !(m_active & bit)) {
+    m_rebuild |= bit;
+  }
+  m_active = active ? (m_active | bit) : (m_active & ~bit);
+}
+
+void SpokeConsumers::RequestRebuild(SpokeConsumer consumer) {
+  wxCriticalSectionLocker lock(m_lock);
+
+  m_rebuild |= 1u << consumer;
+}
+
+bool SpokeConsumers::TakeRebuild(SpokeConsumer consumer) {
+  uint32_t bit = 1u << consumer;
+
+  if (!(m_rebuild & bit)) {  // Once per spoke per stage, so don't take the lock for nothing
+    return false;
+  }
+  wxCriticalSectionLocker lock(m_lock);
+  m_rebuild &= ~bit;
+  return true;
+}
+
+wxString SpokeConsumers::GetSummary() {
+  wxString s;
+
+  for (int c = 0; c < CONSUMERS; c++) {
+    if (!IsActive((SpokeConsumer)c)) {
+      s << (s.IsEmpty() ? wxT("skipping") : wxT("")) << wxT(" ") << wxString::FromAscii(consumer_names[c]);
+    }
+  }
+  if (!s.IsEmpty()) {
+    s << wxT("\n");
+  }
+  return s;
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _SPOKECONSUMERS_H_
+#define _SPOKECONSUMERS_H_
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// The stages of RadarInfo::ProcessRadarSpoke that only matter when someone looks at their
+// result. The main thread says which of them are in use, and the receive thread skips the
+// others. A stage that was skipped is out of date, so when it is used again the receive
+// thread is told once to rebuild it before it adds the next spoke.
+//
+
+enum SpokeConsumer { CONSUMER_PANEL, CONSUMER_OVERLAY, CONSUMER_TRUE_TRAILS, CONSUMER_RELATIVE_TRAILS, CONSUMER_HISTORY, CONSUMERS };
+
+extern const char *consumer_names[CONSUMERS];
+
+class SpokeConsumers {
+ public:
+  SpokeConsumers();  // Everything is in use until told otherwise
+
+  // Main thread
+  void SetActive(SpokeConsumer consumer, bool active);
+  void RequestRebuild(SpokeConsumer consumer);  // The state was lost, e.g. a new RadarDraw
+
+  // Receive thread
+  bool IsActive(SpokeConsumer consumer) const { return (m_active & (1u << consumer)) != 0; }
+  bool TakeRebuild(SpokeConsumer consumer);  // True once after it became active or a rebuild was requested
+
+  wxString GetSummary();  // "skipping ..." line for the statistics, empty when all stages run
+
+ private:
+  wxCriticalSection m_lock;  // Protects m_rebuild
+  volatile uint32_t m_active;
+  volatile uint32_t m_rebuild;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _SPOKECONSUMERS_H_ */
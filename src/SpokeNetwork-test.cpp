@@ -0,0 +1,203 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/stopwatch.h>
+#include "SpokeNetwork.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define SPOKES (2048)
+#define SPOKE_LEN (1024)
+#define ROTATIONS (10)
+
+static uint8_t spoke_data[SPOKES][SPOKE_LEN];
+
+// Something that looks like radar: mostly empty, with targets that span several spokes and some noise
+static void MakeRotation() {
+  memset(spoke_data, 0, sizeof(spoke_data));
+  for (int t = 0; t < 200; t++) {
+    size_t angle = rand() % SPOKES;
+    size_t range = rand() % (SPOKE_LEN - 40);
+    size_t width = 2 + rand() % 20;
+    size_t depth = 2 + rand() % 30;
+    uint8_t strength = (uint8_t)(rand() % 256);
+    for (size_t a = angle; a < angle + width; a++) {
+      memset(&spoke_data[a % SPOKES][range], strength, depth);
+    }
+  }
+  for (size_t a = 0; a < SPOKES; a++) {
+    for (size_t r = 0; r < 60; r++) {
+      spoke_data[a][r] = (uint8_t)(rand() % 256);  // sea clutter near the boat
+    }
+  }
+}
+
+static SOCKET MakeReceiveSocket(NetworkAddress *address) {
+  SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  struct sockaddr_in adr;
+  socklen_t adrlen = sizeof(adr);
+  int buffer = 8 * 1024 * 1024;
+
+  CLEAR_STRUCT(adr);
+  adr.sin_family = AF_INET;
+  adr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char *)&buffer, sizeof(buffer));
+  if (::bind(s, (struct sockaddr *)&adr, sizeof(adr)) < 0 || getsockname(s, (struct sockaddr *)&adr, &adrlen) < 0) {
+    closesocket(s);
+    return INVALID_SOCKET;
+  }
+  address->addr = adr.sin_addr;
+  address->port = adr.sin_port;
+  return s;
+}
+
+// Receive and check all packets that are waiting, returns the number of spokes seen
+static size_t Drain(SOCKET s, SpokePacketDecoder &decoder, int &ret) {
+  size_t spokes = 0;
+  uint8_t packet[65536];
+
+  while (socketReady(s, 0)) {
+    int r = recv(s, (char *)packet, sizeof(packet), 0);
+    if (r <= 0) {
+      break;
+    }
+    if (!decoder.Decode(packet, r)) {
+      cout << "ERROR: packet of " << r << " bytes cannot be decoded\n";
+      ret = 1;
+      continue;
+    }
+    for (size_t i = 0; i < decoder.GetCount(); i++) {
+      const SpokeNetSpoke &spoke = decoder.GetSpoke(i);
+      if (spoke.len != SPOKE_LEN || spoke.bearing != (spoke.angle + 100) % SPOKES || spoke.range_meters != 1852 ||
+          memcmp(spoke.data, spoke_data[spoke.angle], SPOKE_LEN) != 0) {
+        cout << "ERROR: spoke " << spoke.angle << " does not match what was sent\n";
+        ret = 1;
+      }
+      spokes++;
+    }
+  }
+  return spokes;
+}
+
+int main() {
+  int ret = 0;
+
+  // Odd cases go through the decoder intact: empty spokes, spokes of different lengths in one packet
+  {
+    NetworkAddress address;
+    SOCKET s = MakeReceiveSocket(&address);
+    SpokePublisher publisher;
+    SpokePacketDecoder decoder;
+    uint8_t data[300];
+
+    publisher.Init(address, NetworkAddress(), 360, sizeof(data), 1);
+    for (size_t i = 0; i < sizeof(data); i++) {
+      data[i] = (uint8_t)(i * 7);
+    }
+    publisher.Publish(0, 0, data, 0, 100, 1);
+    publisher.Publish(1, 1, data, 200, 100, 1);
+    publisher.Publish(2, 2, data, 300, 100, 1);
+    publisher.Publish(3, 3, data, 300, 100, 1);
+    publisher.Flush();
+
+    uint8_t packet[65536];
+    int r = socketReady(s, 1000) ? recv(s, (char *)packet, sizeof(packet), 0) : -1;
+    if (r <= 0 || !decoder.Decode(packet, r) || decoder.GetCount() != 4 || decoder.GetSource() != 1 || decoder.GetSpokes() != 360 ||
+        decoder.GetSpoke(0).len != 0 || decoder.GetSpoke(1).len != 200 || memcmp(decoder.GetSpoke(3).data, data, 300) != 0) {
+      cout << "ERROR: mixed packet does not decode\n";
+      ret = 1;
+    }
+    if (r > 0) {
+      packet[r - 1] ^= 0xff;
+      if (decoder.Decode(packet, r - 1)) {
+        cout << "ERROR: truncated packet is accepted\n";
+        ret = 1;
+      }
+    }
+    closesocket(s);
+  }
+
+  // Throughput over loopback at full rotation size
+  NetworkAddress address;
+  SOCKET s = MakeReceiveSocket(&address);
+  if (s == INVALID_SOCKET) {
+    cout << "ERROR: cannot create receive socket\n";
+    exit(1);
+  }
+  SpokePublisher publisher;
+  SpokePacketDecoder decoder;
+  size_t received = 0;
+
+  publisher.Init(address, NetworkAddress(), SPOKES, SPOKE_LEN, 0);
+  srand(1);
+  MakeRotation();
+
+  wxStopWatch stopwatch;
+  for (int rotation = 0; rotation < ROTATIONS; rotation++) {
+    for (size_t a = 0; a < SPOKES; a++) {
+      publisher.Publish((int)a, (int)((a + 100) % SPOKES), spoke_data[a], SPOKE_LEN, 1852, wxGetUTCTimeMillis());
+      if (a % 64 == 63) {
+        received += Drain(s, decoder, ret);
+      }
+    }
+  }
+  publisher.Flush();
+  received += Drain(s, decoder, ret);
+  double seconds = stopwatch.Time() / 1000.;
+
+  double rotations_per_second = ROTATIONS / seconds;
+  cout << "INFO: " << ROTATIONS << " rotations of " << SPOKES << "x" << SPOKE_LEN << " in " << seconds << " s, "
+       << rotations_per_second << " rotations/s, received " << received << " spokes in " << publisher.GetPackets()
+       << " packets, " << publisher.GetBytes() << " bytes for " << publisher.GetSamples() << " samples, lost "
+       << decoder.GetLostPackets() << " packets\n";
+
+  if (received != (size_t)ROTATIONS * SPOKES || decoder.GetLostPackets() != 0) {
+    cout << "ERROR: not all spokes arrived\n";
+    ret = 1;
+  }
+  if (rotations_per_second < 10 * 24 / 60.) {  // ten times the speed of a radar turning at 24 RPM
+    cout << "ERROR: too slow to keep up with a radar\n";
+    ret = 1;
+  }
+
+  closesocket(s);
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
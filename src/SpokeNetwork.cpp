@@ -0,0 +1,283 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "SpokeNetwork.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+static const uint8_t SPOKE_NET_MAGIC[4] = {'R', 'P', 'S', 'N'};
+
+static void PutU16(uint8_t *p, size_t v) {
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+}
+
+static void PutU32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static size_t GetU16(const uint8_t *p) { return ((size_t)p[0] << 8) | p[1]; }
+
+static uint32_t GetU32(const uint8_t *p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]; }
+
+SpokePublisher::SpokePublisher() {
+  m_socket = INVALID_SOCKET;
+  CLEAR_STRUCT(m_destination);
+  m_spokes = 0;
+  m_spoke_len_max = 0;
+  m_source = 0;
+  m_packet_len = SPOKE_NET_HEADER_SIZE;
+  m_packet_spokes = 0;
+  m_packet_time = 0;
+  m_sequence = 0;
+  m_packets = 0;
+  m_samples = 0;
+  m_bytes = 0;
+}
+
+SpokePublisher::~SpokePublisher() {
+  if (m_socket != INVALID_SOCKET) {
+    Flush();
+    closesocket(m_socket);
+  }
+}
+
+bool SpokePublisher::Init(const NetworkAddress &destination, const NetworkAddress &interface_address, size_t spokes,
+                          size_t spoke_len_max, int source) {
+  m_spokes = spokes;
+  m_spoke_len_max = wxMin(spoke_len_max, (size_t)SPOKE_NET_LEN_MAX);
+  m_source = source;
+
+  CLEAR_STRUCT(m_destination);
+#ifdef __WXMAC__
+  m_destination.sin_len = sizeof(m_destination);
+#endif
+  m_destination.sin_family = AF_INET;
+  m_destination.sin_addr = destination.addr;
+  m_destination.sin_port = destination.port;
+
+  m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (m_socket == INVALID_SOCKET) {
+    wxLogError(wxT("radar_pi: cannot create spoke publish socket"));
+    return false;
+  }
+
+  if (IN_MULTICAST(ntohl(destination.addr.s_addr))) {
+    unsigned char ttl = 1;  // Stay on the local network
+    unsigned char loop = 1;  // Other processes on this computer may want it too
+
+    setsockopt(m_socket, IPPROTO_IP, IP_MULTICAST_TTL, (const char *)&ttl, sizeof(ttl));
+    setsockopt(m_socket, IPPROTO_IP, IP_MULTICAST_LOOP, (const char *)&loop, sizeof(loop));
+    if (interface_address.addr.s_addr != 0 &&
+        setsockopt(m_socket, IPPROTO_IP, IP_MULTICAST_IF, (const char *)&interface_address.addr, sizeof(interface_address.addr))) {
+      wxLogError(wxT("radar_pi: cannot publish spokes on interface %s"), FormatNetworkAddress(interface_address).c_str());
+    }
+  }
+
+  wxLogMessage(wxT("radar_pi: publishing spokes to %s"), FormatNetworkAddressPort(destination).c_str());
+  return true;
+}
+
+void SpokePublisher::Publish(int angle, int bearing, const uint8_t *data, size_t len, int range_meters, wxLongLong time) {
+  if (m_socket == INVALID_SOCKET) {
+    return;
+  }
+  if (len > m_spoke_len_max) {
+    len = m_spoke_len_max;
+  }
+
+  m_rle.clear();
+  RunLengthEncode(data, len, m_rle);
+
+  // Adjacent spokes look alike, so the XOR with the previous one is often mostly zero
+  bool have_delta = false;
+  if (m_packet_spokes > 0 && m_previous.size() == len) {
+    m_delta.resize(len);
+    for (size_t i = 0; i < len; i++) {
+      m_delta[i] = data[i] ^ m_previous[i];
+    }
+    m_delta_rle.clear();
+    RunLengthEncode(len ? &m_delta[0] : 0, len, m_delta_rle);
+    have_delta = m_delta_rle.size() < m_rle.size();
+  }
+
+  size_t encoded_len = have_delta ? m_delta_rle.size() : wxMin(m_rle.size(), len);
+  if (m_packet_spokes > 0 && m_packet_len + SPOKE_NET_SPOKE_HEADER_SIZE + encoded_len > SPOKE_NET_PACKET_MAX) {
+    Flush();
+    have_delta = false;
+    encoded_len = wxMin(m_rle.size(), len);
+  }
+
+  SpokeNetEncoding encoding = have_delta ? SPOKE_NET_DELTA_RLE : (m_rle.size() < len ? SPOKE_NET_RLE : SPOKE_NET_RAW);
+  const uint8_t *encoded = encoding == SPOKE_NET_DELTA_RLE ? &m_delta_rle[0] : encoding == SPOKE_NET_RLE ? &m_rle[0] : data;
+  uint8_t *p = m_packet + m_packet_len;
+
+  PutU16(p, angle);
+  PutU16(p + 2, bearing);
+  PutU32(p + 4, (uint32_t)range_meters);
+  PutU32(p + 8, (uint32_t)time.GetHi());
+  PutU32(p + 12, (uint32_t)time.GetLo());
+  PutU16(p + 16, len);
+  p[18] = (uint8_t)encoding;
+  PutU16(p + 19, encoded_len);
+  if (encoded_len > 0) {
+    memcpy(p + SPOKE_NET_SPOKE_HEADER_SIZE, encoded, encoded_len);
+  }
+  m_packet_len += SPOKE_NET_SPOKE_HEADER_SIZE + encoded_len;
+  if (m_packet_spokes == 0) {
+    m_packet_time = time;
+  }
+  m_packet_spokes++;
+  m_samples += len;
+  m_previous.assign(data, data + len);
+
+  if (m_packet_spokes >= SPOKE_NET_SPOKES_PER_PACKET || time - m_packet_time >= SPOKE_NET_FLUSH_MILLIS) {
+    Flush();
+  }
+}
+
+void SpokePublisher::Flush() {
+  if (m_packet_spokes == 0 || m_socket == INVALID_SOCKET) {
+    return;
+  }
+
+  memcpy(m_packet, SPOKE_NET_MAGIC, sizeof(SPOKE_NET_MAGIC));
+  m_packet[4] = SPOKE_NET_VERSION;
+  m_packet[5] = (uint8_t)m_packet_spokes;
+  PutU16(m_packet + 6, m_spokes);
+  PutU16(m_packet + 8, m_spoke_len_max);
+  PutU16(m_packet + 10, m_source);
+  PutU32(m_packet + 12, m_sequence++);
+
+  if (sendto(m_socket, (const char *)m_packet, m_packet_len, 0, (struct sockaddr *)&m_destination, sizeof(m_destination)) ==
+      (int)m_packet_len) {
+    m_packets++;
+    m_bytes += m_packet_len;
+  }
+
+  m_packet_len = SPOKE_NET_HEADER_SIZE;
+  m_packet_spokes = 0;
+}
+
+bool SpokePacketDecoder::Decode(const uint8_t *packet, size_t len) {
+  m_spoke.clear();
+
+  if (len < SPOKE_NET_HEADER_SIZE || memcmp(packet, SPOKE_NET_MAGIC, sizeof(SPOKE_NET_MAGIC)) != 0 ||
+      packet[4] != SPOKE_NET_VERSION) {
+    return false;
+  }
+
+  size_t count = packet[5];
+  size_t spokes = GetU16(packet + 6);
+  size_t spoke_len_max = GetU16(packet + 8);
+  uint32_t sequence = GetU32(packet + 12);
+
+  if (spokes == 0 || spoke_len_max == 0 || spoke_len_max > SPOKE_NET_LEN_MAX) {
+    return false;
+  }
+  if (m_have_sequence && sequence != m_next_sequence) {
+    // Only count gaps going forward, a restarted sender starts again at 0
+    uint32_t gap = sequence - m_next_sequence;
+    if (gap < 0x80000000U) {
+      m_lost_packets += gap;
+    }
+  }
+  m_next_sequence = sequence + 1;
+  m_have_sequence = true;
+  m_spokes = spokes;
+  m_spoke_len_max = spoke_len_max;
+  m_source = (int)GetU16(packet + 10);
+
+  m_data.resize(count * spoke_len_max);
+  m_spoke.resize(count);
+
+  size_t pos = SPOKE_NET_HEADER_SIZE;
+  for (size_t s = 0; s < count; s++) {
+    if (pos + SPOKE_NET_SPOKE_HEADER_SIZE > len) {
+      m_spoke.clear();
+      return false;
+    }
+    const uint8_t *p = packet + pos;
+    SpokeNetSpoke &spoke = m_spoke[s];
+    uint8_t *data = &m_data[s * spoke_len_max];
+
+    spoke.angle = (int)GetU16(p);
+    spoke.bearing = (int)GetU16(p + 2);
+    spoke.range_meters = (int)GetU32(p + 4);
+    spoke.time = wxLongLong((long)GetU32(p + 8), (unsigned long)GetU32(p + 12));
+    spoke.len = GetU16(p + 16);
+    spoke.data = data;
+
+    size_t encoding = p[18];
+    size_t encoded_len = GetU16(p + 19);
+    const uint8_t *encoded = p + SPOKE_NET_SPOKE_HEADER_SIZE;
+    pos += SPOKE_NET_SPOKE_HEADER_SIZE + encoded_len;
+
+    bool ok = pos <= len && spoke.len <= spoke_len_max && spoke.angle < (int)spokes && spoke.bearing < (int)spokes;
+    if (ok) {
+      switch (encoding) {
+        case SPOKE_NET_RAW:
+          ok = encoded_len == spoke.len;
+          if (ok) {
+            memcpy(data, encoded, encoded_len);
+          }
+          break;
+
+        case SPOKE_NET_RLE:
+          ok = RunLengthDecode(encoded, encoded_len, data, spoke.len);
+          break;
+
+        case SPOKE_NET_DELTA_RLE:
+          ok = s > 0 && m_spoke[s - 1].len == spoke.len && RunLengthDecode(encoded, encoded_len, data, spoke.len);
+          if (ok) {
+            const uint8_t *previous = m_spoke[s - 1].data;
+            for (size_t i = 0; i < spoke.len; i++) {
+              data[i] ^= previous[i];
+            }
+          }
+          break;
+
+        default:
+          ok = false;
+      }
+    }
+    if (!ok) {
+      m_spoke.clear();
+      return false;
+    }
+  }
+  return pos == len;
+}
+
+PLUGIN_END_NAMESPACE
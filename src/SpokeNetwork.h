@@ -0,0 +1,172 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _SPOKENETWORK_H_
+#define _SPOKENETWORK_H_
+
+#include <vector>
+#include "RunLength.h"
+#include "socketutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Shares decoded spokes with other processes, so that several chart stations can use one radar.
+//
+// Spokes are sent as UDP datagrams, normally to a multicast group. A packet starts with a header of
+// SPOKE_NET_HEADER_SIZE bytes, all numbers in network order:
+//
+//   0  'R' 'P' 'S' 'N'
+//   4  uint8  version (SPOKE_NET_VERSION)
+//   5  uint8  number of spokes in this packet
+//   6  uint16 spokes per rotation
+//   8  uint16 maximum spoke length
+//  10  uint16 source, the radar number of the sender
+//  12  uint32 packet sequence number
+//
+// followed by the spokes, each with a header of SPOKE_NET_SPOKE_HEADER_SIZE bytes:
+//
+//   0  uint16 angle, relative to the ship
+//   2  uint16 bearing, relative to north
+//   4  uint32 range of the last sample in meters
+//   8  uint32 high and low 32 bits of the time the spoke was received, in ms since 1970
+//  16  uint16 number of samples
+//  18  uint8  encoding (SpokeNetEncoding)
+//  19  uint16 length of the encoded samples that follow
+//
+// Packets are independent of each other: a delta only refers to the previous spoke in the same
+// packet, so a lost packet costs only its own spokes.
+//
+
+#define SPOKE_NET_VERSION (1)
+#define SPOKE_NET_HEADER_SIZE (16)
+#define SPOKE_NET_SPOKE_HEADER_SIZE (21)
+#define SPOKE_NET_PACKET_MAX (1472)      // Fits in one Ethernet frame
+#define SPOKE_NET_SPOKES_PER_PACKET (32)  // Send at least this often ...
+#define SPOKE_NET_FLUSH_MILLIS (20)       // ... or when the first spoke in the packet is this old
+#define SPOKE_NET_LEN_MAX (4096)
+#define SPOKE_NET_GROUP 239, 255, 80, 73  // Multicast group, the port is configured
+#define SPOKE_NET_PORT (6878)             // Default port for radar 0, radar n uses port + n
+
+enum SpokeNetEncoding {
+  SPOKE_NET_RAW,        // Samples as is
+  SPOKE_NET_RLE,        // RunLengthEncode of the samples
+  SPOKE_NET_DELTA_RLE,  // RunLengthEncode of the samples XOR the previous spoke in the packet
+};
+
+struct SpokeNetSpoke {
+  int angle;
+  int bearing;
+  int range_meters;
+  wxLongLong time;
+  size_t len;
+  const uint8_t *data;
+};
+
+//
+// Sending side, called on the receive thread of the radar.
+//
+class SpokePublisher {
+ public:
+  SpokePublisher();
+  ~SpokePublisher();
+
+  // Open the socket. A multicast destination is sent to on the given interface (0 = default).
+  bool Init(const NetworkAddress &destination, const NetworkAddress &interface_address, size_t spokes, size_t spoke_len_max,
+            int source);
+  void Publish(int angle, int bearing, const uint8_t *data, size_t len, int range_meters, wxLongLong time);
+  void Flush();
+
+  uint64_t GetPackets() const { return m_packets; }
+  uint64_t GetSamples() const { return m_samples; }
+  uint64_t GetBytes() const { return m_bytes; }
+
+ private:
+  SOCKET m_socket;
+  struct sockaddr_in m_destination;
+  size_t m_spokes;
+  size_t m_spoke_len_max;
+  int m_source;
+
+  uint8_t m_packet[SPOKE_NET_HEADER_SIZE + SPOKE_NET_SPOKE_HEADER_SIZE + SPOKE_NET_LEN_MAX];
+  size_t m_packet_len;
+  size_t m_packet_spokes;
+  wxLongLong m_packet_time;  // Time of the first spoke in the packet
+  uint32_t m_sequence;
+
+  std::vector<uint8_t> m_previous;  // Samples of the previous spoke in the packet
+  std::vector<uint8_t> m_delta;
+  std::vector<uint8_t> m_rle;
+  std::vector<uint8_t> m_delta_rle;
+
+  uint64_t m_packets;
+  uint64_t m_samples;
+  uint64_t m_bytes;
+};
+
+//
+// Receiving side.
+//
+class SpokePacketDecoder {
+ public:
+  SpokePacketDecoder() {
+    m_spokes = 0;
+    m_spoke_len_max = 0;
+    m_source = 0;
+    m_next_sequence = 0;
+    m_have_sequence = false;
+    m_lost_packets = 0;
+  }
+
+  // Decode a packet, returns false if it is invalid. The spokes remain valid until the next call.
+  bool Decode(const uint8_t *packet, size_t len);
+
+  size_t GetCount() const { return m_spoke.size(); }
+  const SpokeNetSpoke &GetSpoke(size_t i) const { return m_spoke[i]; }
+  size_t GetSpokes() const { return m_spokes; }
+  size_t GetSpokeLenMax() const { return m_spoke_len_max; }
+  int GetSource() const { return m_source; }
+  uint64_t GetLostPackets() const { return m_lost_packets; }
+
+ private:
+  std::vector<uint8_t> m_data;
+  std::vector<SpokeNetSpoke> m_spoke;
+  size_t m_spokes;
+  size_t m_spoke_len_max;
+  int m_source;
+  uint32_t m_next_sequence;
+  bool m_have_sequence;
+  uint64_t m_lost_packets;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _SPOKENETWORK_H_ */
@@ -0,0 +1,176 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "TraceRecorder.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+struct TraceEvent {
+  const char *name;
+  uint64_t start;
+  uint64_t duration;
+};
+
+struct TraceBuffer {
+  char name[TRACE_THREAD_NAME_LEN];
+  TraceEvent *events;     // [TRACE_EVENTS], allocated when the thread records its first event
+  volatile uint64_t next;  // Events recorded so far, the next one goes to events[next % TRACE_EVENTS]
+};
+
+volatile bool g_trace_enabled = false;
+
+static wxCriticalSection s_trace_lock;  // protects the following
+static TraceBuffer s_buffers[TRACE_THREADS_MAX];
+static size_t s_buffer_count = 0;
+
+// The buffer of the calling thread. __declspec(thread) does not work in a DLL that is loaded
+// with LoadLibrary on Windows XP, which is how OpenCPN loads us, so use a TLS slot there.
+#ifdef __WXMSW__
+struct TraceThreadSlot {
+  DWORD index;
+
+  TraceThreadSlot() { index = TlsAlloc(); }
+  ~TraceThreadSlot() {
+    if (index != TLS_OUT_OF_INDEXES) {
+      TlsFree(index);
+    }
+  }
+};
+
+static TraceThreadSlot s_thread_slot;  // Allocated when the plugin is loaded, freed when it is unloaded
+
+static TraceBuffer *GetThreadBuffer() {
+  return s_thread_slot.index != TLS_OUT_OF_INDEXES ? (TraceBuffer *)TlsGetValue(s_thread_slot.index) : 0;
+}
+
+static void SetThreadBuffer(TraceBuffer *buffer) {
+  if (s_thread_slot.index != TLS_OUT_OF_INDEXES) {
+    TlsSetValue(s_thread_slot.index, buffer);
+  }
+}
+#else
+static __thread TraceBuffer *s_thread_buffer = 0;
+
+static TraceBuffer *GetThreadBuffer() { return s_thread_buffer; }
+
+static void SetThreadBuffer(TraceBuffer *buffer) { s_thread_buffer = buffer; }
+#endif
+
+void TraceEnable(bool enable) { g_trace_enabled = enable; }
+
+static TraceBuffer *FindBuffer(const char *name) {
+  wxCriticalSectionLocker lock(s_trace_lock);
+
+  for (size_t i = 0; i < s_buffer_count; i++) {
+    if (strcmp(s_buffers[i].name, name) == 0) {
+      return &s_buffers[i];
+    }
+  }
+  if (s_buffer_count == TRACE_THREADS_MAX) {
+    return 0;
+  }
+  TraceBuffer *buffer = &s_buffers[s_buffer_count];
+  strncpy(buffer->name, name, sizeof(buffer->name) - 1);
+  buffer->name[sizeof(buffer->name) - 1] = 0;
+  buffer->events = 0;
+  buffer->next = 0;
+  s_buffer_count++;
+  return buffer;
+}
+
+void TraceThreadName(const wxString &name) { SetThreadBuffer(FindBuffer(name.ToUTF8())); }
+
+void TraceRecord(const char *name, uint64_t start, uint64_t end) {
+  TraceBuffer *buffer = GetThreadBuffer();
+
+  if (!buffer) {
+    char id[TRACE_THREAD_NAME_LEN];
+    snprintf(id, sizeof(id), "thread %lu", (unsigned long)wxThread::GetCurrentId());
+    buffer = FindBuffer(id);
+    if (!buffer) {
+      return;
+    }
+    SetThreadBuffer(buffer);
+  }
+  if (!buffer->events) {
+    TraceEvent *events = (TraceEvent *)calloc(TRACE_EVENTS, sizeof(TraceEvent));
+    if (!events) {
+      return;
+    }
+    buffer->events = events;
+  }
+
+  TraceEvent *event = &buffer->events[buffer->next % TRACE_EVENTS];
+  event->name = name;
+  event->start = start;
+  event->duration = end - start;
+  buffer->next = buffer->next + 1;
+}
+
+/*
+ * Complete ("X") events with the time in microseconds, one track per thread. Events that are
+ * overwritten while we write may come out wrong, so it is best to stop tracing first.
+ */
+bool WriteChromeTrace(const wxString &filename) {
+  FILE *f = wxFopen(filename, wxT("w"));
+
+  if (!f) {
+    return false;
+  }
+
+  wxCriticalSectionLocker lock(s_trace_lock);
+  const char *separator = "";
+
+  fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (size_t t = 0; t < s_buffer_count; t++) {
+    TraceBuffer *buffer = &s_buffers[t];
+
+    fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", separator,
+            (unsigned)t + 1, buffer->name);
+    separator = ",\n";
+    if (!buffer->events) {
+      continue;
+    }
+
+    uint64_t next = buffer->next;
+    uint64_t first = next > TRACE_EVENTS ? next - TRACE_EVENTS : 0;
+    for (uint64_t i = first; i < next; i++) {
+      const TraceEvent &event = buffer->events[i % TRACE_EVENTS];
+      fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", event.name, (unsigned)t + 1,
+              event.start / 1e3, event.duration / 1e3);
+    }
+  }
+  fprintf(f, "\n]}\n");
+  fclose(f);
+  return true;
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,88 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _TRACERECORDER_H_
+#define _TRACERECORDER_H_
+
+#include "LatencyHistogram.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Records how long the stages of the radar pipeline take, so that stutter can be looked at
+// afterwards in chrome://tracing or Perfetto. Every thread writes to its own ring buffer
+// without a lock, which keeps the last TRACE_EVENTS stages of that thread.
+//
+// While tracing is off a TRACE_SCOPE costs a test of g_trace_enabled, radar-bench measures it.
+//
+
+#define TRACE_EVENTS (32768)     // Events kept per thread
+#define TRACE_THREADS_MAX (32)  // Threads that can be traced, later threads are not
+#define TRACE_THREAD_NAME_LEN (48)
+
+extern volatile bool g_trace_enabled;
+
+extern void TraceEnable(bool enable);
+
+// The name of the calling thread in the trace. A thread with the same name as an earlier one,
+// such as a receive thread that is restarted, takes over its buffer.
+extern void TraceThreadName(const wxString &name);
+
+// Add a stage that ran from start to end in GetLatencyNanos() time
+extern void TraceRecord(const char *name, uint64_t start, uint64_t end);
+
+// Write all buffers as Chrome trace event JSON
+extern bool WriteChromeTrace(const wxString &filename);
+
+class TraceScope {
+ public:
+  TraceScope(const char *name) {
+    m_name = name;
+    m_start = g_trace_enabled ? GetLatencyNanos() : 0;
+  }
+  ~TraceScope() {
+    if (m_start) {
+      TraceRecord(m_name, m_start, GetLatencyNanos());
+    }
+  }
+
+ private:
+  const char *m_name;  // Must be a literal, only the pointer is stored
+  uint64_t m_start;
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _TRACERECORDER_H_ */
@@ -31,9 +31,6 @@
 
 #include "TrailBuffer.h"
 
-#undef M_SETTINGS
-#define M_SETTINGS m_ri->m_pi->m_settings
-
 PLUGIN_BEGIN_NAMESPACE
 
 // Allocated arrays are not two dimensional, so we make
@@ -47,11 +44,19 @@ PLUGIN_BEGIN_NAMESPACE
 #define M_RELATIVE_TRAILS_STRIDE m_max_spoke_len
 #define M_RELATIVE_TRAILS(x, y) m_relative_trails[x * M_RELATIVE_TRAILS_STRIDE + y]
 
-TrailBuffer::TrailBuffer(RadarInfo *ri, size_t spokes, size_t max_spoke_len) {
-  m_ri = ri;
+TrailBuffer::TrailBuffer(size_t spokes, size_t max_spoke_len, PolarToCartesianLookup *lookup) {
+  m_lookup = lookup;
   m_spokes = spokes;
   m_max_spoke_len = (int)max_spoke_len;
   m_previous_pixels_per_meter = 0.;
+  m_dir_lat = 0;
+  m_dir_lon = 0;
+  m_offset.lat = 0;
+  m_offset.lon = 0;
+  m_dif.lat = 0.;
+  m_dif.lon = 0.;
+  m_pos.lat = nan("");
+  m_pos.lon = nan("");
   m_trail_size = max_spoke_len * 2 + MARGIN * 2;
   m_true_trails = (TrailRevolutionsAge *)calloc(sizeof(TrailRevolutionsAge), m_trail_size * m_trail_size);
   m_relative_trails = (TrailRevolutionsAge *)calloc(sizeof(TrailRevolutionsAge), m_spokes * m_max_spoke_len);
@@ -71,16 +76,11 @@ TrailBuffer::~TrailBuffer() {
   free(m_copy_true_trails);
 }
 
-void TrailBuffer::UpdateTrueTrails(SpokeBearing bearing, uint8_t *data, size_t len) {
-  int motion = m_ri->m_trails_motion.GetValue();
-  RadarControlState trails = m_ri->m_target_trails.GetState();
-  bool update_targets_true = trails != RCS_OFF && motion == TARGET_MOTION_TRUE;
-
-  uint8_t weakest_normal_blob = m_ri->m_pi->m_settings.threshold_blue;
+void TrailBuffer::UpdateTrueTrails(int bearing, uint8_t *data, size_t len, uint8_t threshold, const uint8_t *colour) {
   size_t radius = 0;
 
   for (; radius < len - 1; radius++) {  //  len - 1 : no trails on range circle
-    PointInt point = m_ri->m_polar_lookup->GetPointInt(bearing, radius);
+    PointInt point = m_lookup->GetPointInt(bearing, radius);
 
     point.x += m_trail_size / 2 + m_offset.lat;
     point.y += m_trail_size / 2 + m_offset.lon;
@@ -89,14 +89,14 @@ void TrailBuffer::UpdateTrueTrails(SpokeBearing bearing, uint8_t *data, size_t l
       uint8_t *trail = &M_TRUE_TRAILS(point.x, point.y);
       // when ship moves north, offset.lat > 0. Add to move trails image in opposite direction
       // when ship moves east, offset.lon > 0. Add to move trails image in opposite direction
-      if (data[radius] >= weakest_normal_blob) {
+      if (data[radius] >= threshold) {
         *trail = 1;
       } else {
         if (*trail > 0 && *trail < TRAIL_MAX_REVOLUTIONS) {
           (*trail)++;
         }
-        if (update_targets_true) {
-          data[radius] = m_ri->m_trail_colour[*trail];
+        if (colour) {
+          data[radius] = colour[*trail];
         }
       }
     }
@@ -105,8 +105,8 @@ void TrailBuffer::UpdateTrueTrails(SpokeBearing bearing, uint8_t *data, size_t l
   // Now process the rest of the spoke from len to m_spoke_len_max.
   // This will only be called when the current spoke length is smaller than the max.
   // we need to update the trail 'age' for those points.
-  for (; radius < m_ri->m_spoke_len_max; radius++) {
-    PointInt point = m_ri->m_polar_lookup->GetPointInt(bearing, radius);
+  for (; radius < (size_t)m_max_spoke_len; radius++) {
+    PointInt point = m_lookup->GetPointInt(bearing, radius);
 
     point.x += m_trail_size / 2 + m_offset.lat;
     point.y += m_trail_size / 2 + m_offset.lon;
@@ -122,24 +122,19 @@ void TrailBuffer::UpdateTrueTrails(SpokeBearing bearing, uint8_t *data, size_t l
   }
 }
 
-void TrailBuffer::UpdateRelativeTrails(SpokeBearing angle, uint8_t *data, size_t len) {
-  int motion = m_ri->m_trails_motion.GetValue();
-  RadarControlState trails = m_ri->m_target_trails.GetState();
-  bool update_relative_motion = trails != RCS_OFF && motion == TARGET_MOTION_RELATIVE;
-
+void TrailBuffer::UpdateRelativeTrails(int angle, uint8_t *data, size_t len, uint8_t threshold, const uint8_t *colour) {
   uint8_t *trail = &M_RELATIVE_TRAILS(angle, 0);
-  uint8_t weakest_normal_blob = m_ri->m_pi->m_settings.threshold_blue;
   int radius = 0;
   int length = int(len);
   for (; radius < length - 1; radius++, trail++) {  // len - 1 : no trails on range circle
-    if (data[radius] >= weakest_normal_blob) {
+    if (data[radius] >= threshold) {
       *trail = 1;
     } else {
       if (*trail > 0 && *trail < TRAIL_MAX_REVOLUTIONS) {
         (*trail)++;
       }
-      if (update_relative_motion) {
-        data[radius] = m_ri->m_trail_colour[*trail];
+      if (colour) {
+        data[radius] = colour[*trail];
       }
     }
   }
@@ -211,8 +206,7 @@ void TrailBuffer::ZoomTrails(float zoom_factor) {
   m_copy_true_trails = flip;
 }
 
-void TrailBuffer::UpdateTrailPosition() {
-  GeoPosition radar;
+void TrailBuffer::UpdateTrailPosition(double pixels_per_meter, const GeoPosition *radar) {
   GeoPositionPixels shift;
   // When position changes the trail image is not moved, only the pointer to the center
   // of the image (offset) is changed.
@@ -220,27 +214,27 @@ void TrailBuffer::UpdateTrailPosition() {
   // But when there is no room anymore (margin used) the whole trails image is shifted
   // and the offset is reset
   if (m_offset.lon >= MARGIN || m_offset.lon <= -MARGIN || m_offset.lat >= MARGIN || m_offset.lat <= -MARGIN) {
-    LOG_INFO(wxT("radar_pi: offset lat %d or lon too large %d"), m_offset.lat, m_offset.lon);
+    wxLogMessage(wxT("radar_pi: offset lat %d or lon too large %d"), m_offset.lat, m_offset.lon);
     ClearTrails();
     return;
   }
 
   // zooming of trails required? First check conditions
-  if (m_previous_pixels_per_meter == 0. || m_ri->m_pixels_per_meter == 0.) {
+  if (m_previous_pixels_per_meter == 0. || pixels_per_meter == 0.) {
     ClearTrails();
-    if (m_ri->m_pixels_per_meter == 0.) {
+    if (pixels_per_meter == 0.) {
       return;
     }
-    m_previous_pixels_per_meter = m_ri->m_pixels_per_meter;
-  } else if (m_previous_pixels_per_meter != m_ri->m_pixels_per_meter && m_previous_pixels_per_meter != 0.) {
+    m_previous_pixels_per_meter = pixels_per_meter;
+  } else if (m_previous_pixels_per_meter != pixels_per_meter && m_previous_pixels_per_meter != 0.) {
     // zoom trails
-    double zoom_factor = m_ri->m_pixels_per_meter / m_previous_pixels_per_meter;
+    double zoom_factor = pixels_per_meter / m_previous_pixels_per_meter;
 
     if (zoom_factor < 0.25 || zoom_factor > 4.00) {
       ClearTrails();
       return;
     }
-    m_previous_pixels_per_meter = m_ri->m_pixels_per_meter;
+    m_previous_pixels_per_meter = pixels_per_meter;
     // center the image before zooming
     // otherwise the offset might get too large
     ShiftImageLatToCenter();
@@ -248,48 +242,53 @@ void TrailBuffer::UpdateTrailPosition() {
     ZoomTrails(zoom_factor);
   }
 
-  if (!m_ri->GetRadarPosition(&radar) || m_ri->m_pi->GetHeadingSource() == HEADING_NONE) {
+  if (!radar) {
     return;
   }
 
+  // Trails that were just cleared start at the current position
+  if (isnan(m_pos.lat)) {
+    m_pos = *radar;
+    return;
+  }
   // Did the ship move? No, return.
-  if (m_pos.lat == radar.lat && m_pos.lon == radar.lon) {
+  if (m_pos.lat == radar->lat && m_pos.lon == radar->lon) {
     return;
   }
   // Check the movement of the ship
-  double dif_lat = radar.lat - m_pos.lat;  // going north is positive
-  double dif_lon = radar.lon - m_pos.lon;  // moving east is positive
-  m_pos = radar;
+  double dif_lat = radar->lat - m_pos.lat;  // going north is positive
+  double dif_lon = radar->lon - m_pos.lon;  // moving east is positive
+  m_pos = *radar;
 
   // get (floating point) shift of the ship in radar pixels
-  double fshift_lat = dif_lat * 60. * 1852. * m_ri->m_pixels_per_meter;
-  double fshift_lon = dif_lon * 60. * 1852. * m_ri->m_pixels_per_meter;
-  fshift_lon *= cos(deg2rad(radar.lat));  // at higher latitudes a degree of longitude is fewer meters
+  double fshift_lat = dif_lat * 60. * 1852. * pixels_per_meter;
+  double fshift_lon = dif_lon * 60. * 1852. * pixels_per_meter;
+  fshift_lon *= cos(deg2rad(radar->lat));  // at higher latitudes a degree of longitude is fewer meters
   // Get the integer pixel shift, first add previous rounding error
   shift.lat = (int)(fshift_lat + m_dif.lat);
   shift.lon = (int)(fshift_lon + m_dif.lon);
 
   // Check for changes in the direction of movement, part of the image buffer has to be erased
 
-  if (shift.lat > 0 && m_ri->m_dir_lat <= 0) {
+  if (shift.lat > 0 && m_dir_lat <= 0) {
     // change of direction of movement, moving north now
     // clear space in trailbuffer above image (this area might not be empty)
     uint8_t *start_of_area_to_clear = m_true_trails + (m_trail_size - MARGIN + m_offset.lat) * m_trail_size;
     int number_of_pixels_to_clear = (MARGIN - m_offset.lat) * m_trail_size;
     memset(start_of_area_to_clear, 0, number_of_pixels_to_clear);
-    m_ri->m_dir_lat = 1;
+    m_dir_lat = 1;
   }
 
-  if (shift.lat < 0 && m_ri->m_dir_lat >= 0) {
+  if (shift.lat < 0 && m_dir_lat >= 0) {
     // change of direction of movement, moving south now
     // clear space in true_trails below image
     uint8_t *start_of_area_to_clear = m_true_trails;
     int number_of_pixels_to_clear = (MARGIN + m_offset.lat) * m_trail_size;
     memset(start_of_area_to_clear, 0, number_of_pixels_to_clear);
-    m_ri->m_dir_lat = -1;
+    m_dir_lat = -1;
   }
 
-  if (shift.lon > 0 && m_ri->m_dir_lon <= 0) {
+  if (shift.lon > 0 && m_dir_lon <= 0) {
     // change of direction of movement, moving east now
     // clear space in true_trails to the right of image
     int number_of_pixels_to_clear = MARGIN - m_offset.lon;
@@ -297,10 +296,10 @@ void TrailBuffer::UpdateTrailPosition() {
       uint8_t *start_of_area_to_clear = m_true_trails + m_trail_size * i + m_trail_size - MARGIN + m_offset.lon;
       memset(start_of_area_to_clear, 0, number_of_pixels_to_clear);
     }
-    m_ri->m_dir_lon = 1;
+    m_dir_lon = 1;
   }
 
-  if (shift.lon < 0 && m_ri->m_dir_lon >= 0) {
+  if (shift.lon < 0 && m_dir_lon >= 0) {
     // change of direction of movement, moving west now
     // clear space in true_trails outside image in that direction
     int number_of_pixels_to_clear = MARGIN + m_offset.lon;
@@ -308,7 +307,7 @@ void TrailBuffer::UpdateTrailPosition() {
       uint8_t *start_of_area_to_clear = m_true_trails + m_trail_size * i;
       memset(start_of_area_to_clear, 0, number_of_pixels_to_clear);
     }
-    m_ri->m_dir_lon = -1;
+    m_dir_lon = -1;
   }
 
   // save the rounding fraction and appy it next time
@@ -317,7 +316,7 @@ void TrailBuffer::UpdateTrailPosition() {
 
   if (shift.lat >= MARGIN || shift.lat <= -MARGIN || shift.lon >= MARGIN || shift.lon <= -MARGIN) {  // huge shift, reset trails
     ClearTrails();
-    LOG_INFO(wxT("radar_pi: %s Large movement trails reset"), m_ri->m_name.c_str());
+    wxLogMessage(wxT("radar_pi: Large movement trails reset"));
     return;
   }
 
@@ -341,7 +340,7 @@ void TrailBuffer::ShiftImageLatToCenter() {
   int image_size = m_trail_size * 2 * m_max_spoke_len;  // number of pixels to shift up / down
 
   if (m_offset.lat >= MARGIN || m_offset.lat <= -MARGIN) {  // abs not ok
-    LOG_INFO(wxT("radar_pi: offset lat too large %i"), m_offset.lat);
+    wxLogMessage(wxT("radar_pi: offset lat too large %i"), m_offset.lat);
     ClearTrails();
     return;
   }
@@ -368,7 +367,7 @@ void TrailBuffer::ShiftImageLatToCenter() {
 // shifts the true trails image in lon direction to center
 void TrailBuffer::ShiftImageLonToCenter() {
   if (m_offset.lon >= MARGIN || m_offset.lon <= -MARGIN) {  // abs no good
-    LOG_INFO(wxT("radar_pi: offset lon too large %i"), m_offset.lon);
+    wxLogMessage(wxT("radar_pi: offset lon too large %i"), m_offset.lon);
     ClearTrails();
     return;
   }
@@ -400,7 +399,6 @@ void TrailBuffer::ShiftImageLonToCenter() {
 }
 
 void TrailBuffer::ClearTrails() {
-  LOG_VERBOSE(wxT("radar_pi: ClearTrails"));
   if (m_true_trails) {
     memset(m_true_trails, 0, m_trail_size * m_trail_size);
     m_offset.lat = 0;
@@ -411,10 +409,8 @@ void TrailBuffer::ClearTrails() {
   if (m_relative_trails) {
     memset(m_relative_trails, 0, m_spokes * m_max_spoke_len);
   }
-  if (!m_ri->GetRadarPosition(&m_pos)) {
-    m_pos.lat = 0.;
-    m_pos.lon = 0.;
-  }
+  m_pos.lat = nan("");  // Set by the next UpdateTrailPosition()
+  m_pos.lon = nan("");
 }
 
 PLUGIN_END_NAMESPACE
@@ -32,23 +32,42 @@
 #ifndef _TRAIL_BUFFER_H_
 #define _TRAIL_BUFFER_H_
 
-#include "RadarInfo.h"
+#include "drawutil.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
 typedef uint8_t TrailRevolutionsAge;
 
+#define SECONDS_TO_REVOLUTIONS(x) ((x)*2 / 5)
+#define TRAIL_MAX_REVOLUTIONS SECONDS_TO_REVOLUTIONS(600) + 1
+
 #define MARGIN (100)
 
+//
+// The age in revolutions of every trail pixel, relative to the radar and in true motion.
+// It knows nothing of the radar it belongs to: the caller passes the settings that it needs with
+// every spoke, so that it can be used and measured without OpenCPN.
+//
 class TrailBuffer {
  public:
-  TrailBuffer(RadarInfo *ri, size_t spokes, size_t max_spoke_len);
+  TrailBuffer(size_t spokes, size_t max_spoke_len, PolarToCartesianLookup *lookup);
   ~TrailBuffer();
 
   void ClearTrails();
-  void UpdateTrailPosition();
-  void UpdateTrueTrails(SpokeBearing bearing, uint8_t *data, size_t len);
-  void UpdateRelativeTrails(SpokeBearing angle, uint8_t *data, size_t len);
+
+  // Move the true trails along with the ship. radar is the position of the radar, or 0 when
+  // either the position or the heading is not known.
+  void UpdateTrailPosition(double pixels_per_meter, const GeoPosition *radar);
+
+  // Age the trails of one spoke. Samples at or above threshold are echoes that restart their trail.
+  // When colour is given, with TRAIL_MAX_REVOLUTIONS + 1 entries, the other samples are replaced by
+  // the colour of the age of their trail.
+  void UpdateTrueTrails(int bearing, uint8_t *data, size_t len, uint8_t threshold, const uint8_t *colour);
+  void UpdateRelativeTrails(int angle, uint8_t *data, size_t len, uint8_t threshold, const uint8_t *colour);
+
+  size_t GetMemorySize() const {
+    return 2 * ((size_t)m_trail_size * m_trail_size + m_spokes * m_max_spoke_len) * sizeof(TrailRevolutionsAge);
+  }
 
   struct GeoPositionPixels {
     int lat;
@@ -64,11 +83,13 @@ class TrailBuffer {
   void ShiftImageLatToCenter();
   void ZoomTrails(float zoom_factor);
 
-  RadarInfo *m_ri;
+  PolarToCartesianLookup *m_lookup;
   size_t m_spokes;
   int m_max_spoke_len;
   int m_trail_size;
   double m_previous_pixels_per_meter;
+  int m_dir_lat;  // Direction the ship last moved in, -1, 0 or 1
+  int m_dir_lon;
 
   TrailRevolutionsAge *m_true_trails;           // m_trails_size * m_trails_size
   TrailRevolutionsAge *m_relative_trails;       // m_spokes * m_max_spoke_len
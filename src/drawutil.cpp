@@ -30,6 +30,9 @@
  */
 
 #include "drawutil.h"
+#include <vector>
+#include "GuardZoneIntervals.h"
+#include "MemoryAccount.h"
 #include "radar_pi.h"
 
 PLUGIN_BEGIN_NAMESPACE
@@ -129,6 +132,28 @@ void DrawOutlineArc(double r1, double r2, double a1, double a2, bool stippled) {
   }
 }
 
+void DrawOutlinePolygon(const GuardZoneVertex *vertex, size_t n, bool stippled) {
+  if (n < 2) {
+    return;
+  }
+  if (stippled) {
+    glEnable(GL_LINE_STIPPLE);
+    glLineStipple(1, 0x000F);
+  }
+  glLineWidth(1.0);
+
+  glBegin(GL_LINE_LOOP);
+  for (size_t i = 0; i < n; i++) {
+    double a = deg2rad(vertex[i].bearing);
+    glVertex2d(vertex[i].range * cos(a), vertex[i].range * sin(a));
+  }
+  glEnd();
+
+  if (stippled) {
+    glDisable(GL_LINE_STIPPLE);
+  }
+}
+
 void DrawFilledArc(double r1, double r2, double a1, double a2) {
   if (a1 > a2) {
     a2 += 360.0;
@@ -236,4 +261,49 @@ void DrawRoundRect(float x, float y, float width, float height, float radius) {
   glEnd();
 }  // DrawRoundRect
 
+struct SharedLookup {
+  PolarToCartesianLookup *lookup;
+  size_t spokes;
+  size_t spoke_len;
+  int users;
+};
+
+static std::vector<SharedLookup> s_lookups;
+static wxCriticalSection s_lookups_lock;
+
+PolarToCartesianLookup *AcquirePolarToCartesianLookup(size_t spokes, size_t spoke_len) {
+  wxCriticalSectionLocker lock(s_lookups_lock);
+
+  for (size_t i = 0; i < s_lookups.size(); i++) {
+    if (s_lookups[i].spokes == spokes && s_lookups[i].spoke_len == spoke_len) {
+      s_lookups[i].users++;
+      return s_lookups[i].lookup;
+    }
+  }
+
+  SharedLookup shared;
+  shared.lookup = new PolarToCartesianLookup(spokes, spoke_len);
+  shared.spokes = spokes;
+  shared.spoke_len = spoke_len;
+  shared.users = 1;
+  s_lookups.push_back(shared);
+  g_shared_memory.Allocated(MEMORY_LOOKUP, shared.lookup->GetMemorySize());
+  return shared.lookup;
+}
+
+void ReleasePolarToCartesianLookup(PolarToCartesianLookup *lookup) {
+  wxCriticalSectionLocker lock(s_lookups_lock);
+
+  for (size_t i = 0; i < s_lookups.size(); i++) {
+    if (s_lookups[i].lookup == lookup) {
+      if (--s_lookups[i].users == 0) {
+        g_shared_memory.Freed(MEMORY_LOOKUP, lookup->GetMemorySize());
+        delete lookup;
+        s_lookups.erase(s_lookups.begin() + i);
+      }
+      return;
+    }
+  }
+}
+
 PLUGIN_END_NAMESPACE
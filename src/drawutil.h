@@ -36,9 +36,12 @@
 
 PLUGIN_BEGIN_NAMESPACE
 
+struct GuardZoneVertex;
+
 extern void DrawArc(float cx, float cy, float r, float start_angle, float arc_angle, int num_segments);
 extern void DrawOutlineArc(double r1, double r2, double a1, double a2, bool stippled);
 extern void DrawFilledArc(double r1, double r2, double a1, double a2);
+extern void DrawOutlinePolygon(const GuardZoneVertex *vertex, size_t n, bool stippled);
 extern void CheckOpenGLError(const wxString &after);
 
 typedef struct {
@@ -100,8 +103,15 @@ class PolarToCartesianLookup {
   // We trust that the optimizer will inline this
   Point GetPoint(size_t angle, size_t radius) { return M_XY((angle + m_spokes) % m_spokes, radius); }
   PointInt GetPointInt(size_t angle, size_t radius) { return M_XYI((angle + m_spokes) % m_spokes, radius); };
+
+  size_t GetMemorySize() const { return (sizeof(Point) + sizeof(PointInt)) * m_spokes * m_spoke_len; }
 };
 
+// The lookup only depends on the number of spokes and their length, so radars of the same type
+// share one. Release it when the radar no longer needs it, the last user frees it.
+extern PolarToCartesianLookup *AcquirePolarToCartesianLookup(size_t spokes, size_t spoke_len);
+extern void ReleasePolarToCartesianLookup(PolarToCartesianLookup *lookup);
+
 extern void DrawRoundRect(float x, float y, float width, float height, float radius = 0.0);
 
 PLUGIN_END_NAMESPACE
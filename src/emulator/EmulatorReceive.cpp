@@ -31,11 +31,9 @@
  */
 
 #include "EmulatorReceive.h"
+#include "NmeaSentence.h"
 #include "RadarFactory.h"
 
-#define SCALE_RAW_TO_DEGREES(raw) ((raw) * (double)DEGREES_PER_ROTATION / EMULATOR_SPOKES)
-#define SCALE_DEGREES_TO_RAW(angle) ((int)((angle) * (double)EMULATOR_SPOKES / DEGREES_PER_ROTATION))
-
 PLUGIN_BEGIN_NAMESPACE
 
 /*
@@ -44,37 +42,128 @@ PLUGIN_BEGIN_NAMESPACE
  * The rest of the plugin uses a (slightly) abstract definition of the radar.
  */
 
-#define MILLIS_PER_SELECT 250
-#define SECONDS_SELECT(x) ((x)*MILLISECONDS_PER_SECOND / MILLIS_PER_SELECT)
+#define MILLIS_PER_SELECT 20  // Often enough that the spokes come in a steady stream, like a real radar
+#define MILLIS_PER_NMEA 1000  // How often the position is sent to OpenCPN, like a GPS
+
+void EmulatorReceive::InitScenario() {
+  const int *ranges;
+  size_t count = RadarFactory::GetRadarRanges(RT_EMULATOR, M_SETTINGS.range_units, &ranges);
+  ScenarioSettings settings;
+  GeoPosition pos;
+
+  settings.spokes = (int)m_ri->m_spokes;
+  settings.spoke_len = (int)m_ri->m_spoke_len_max;
+  settings.point_targets = M_SETTINGS.emulator_point_targets;
+  settings.extended_targets = M_SETTINGS.emulator_extended_targets;
+  settings.clutter = M_SETTINGS.emulator_clutter;
+  settings.speed = M_SETTINGS.emulator_speed;
+  settings.turn_rate = M_SETTINGS.emulator_turn_rate;
+  settings.seed = 1 + m_ri->m_radar;
+
+  // Start sailing where OpenCPN thinks we are, so that the chart underneath makes sense
+  if (!m_ri->GetRadarPosition(&pos)) {
+    pos.lat = SCENARIO_START_LAT;
+    pos.lon = SCENARIO_START_LON;
+  }
+  m_scenario.Init(settings, ranges[count - 1], pos.lat, pos.lon);
+  m_spoke_backlog = 0.;
+  m_last_millis = m_ri->GetRadarMillis();
+  m_next_nmea = m_last_millis;
+
+  LOG_INFO(wxT("radar_pi: %s emulates %d spokes of %d samples at %d RPM with %d targets"), m_ri->m_name.c_str(), settings.spokes,
+           settings.spoke_len, M_SETTINGS.emulator_rpm, m_scenario.GetTargetCount());
+}
 
 /*
- * Called once a second. Emulate a radar return that is
- * at the current desired auto_range.
- * Speed is 24 images per minute, e.g. 1/2.5 of a full
- * image.
+ * Give our own ship's position to OpenCPN, as a GPS would. The heading is given
+ * with every batch of spokes, as a radar with a heading sensor would.
+ *
+ * Every emulator sails its own scenario, so only the first emulated radar does this;
+ * otherwise the heading and position would jump between them.
  */
+void EmulatorReceive::SendNavigation(wxLongLong now) {
+  for (int r = 0; r < m_ri->m_radar; r++) {
+    if (m_pi->m_radar[r] && m_pi->m_radar[r]->m_radar_type == RT_EMULATOR) {
+      return;
+    }
+  }
+
+  if (!M_SETTINGS.ignore_radar_heading) {
+    m_pi->SetRadarHeading(m_scenario.GetHeading(), true);
+  } else {
+    m_pi->SetRadarHeading();
+  }
+
+  if (!M_SETTINGS.emulator_nmea || now < m_next_nmea) {
+    return;
+  }
+  m_next_nmea = now + MILLIS_PER_NMEA;
+
+  double lat = m_scenario.GetLat();
+  double lon = m_scenario.GetLon();
+  double lat_abs = fabs(lat);
+  double lon_abs = fabs(lon);
+  wxDateTime utc(m_ri->GetRadarTime());
+  NmeaSentence nmea("GPRMC");
+
+  nmea.AddField(utc.Format(wxT("%H%M%S"), wxDateTime::UTC).mb_str());
+  nmea.AddChar('A');
+  nmea.AddFixed(floor(lat_abs) * 100. + (lat_abs - floor(lat_abs)) * 60., 4);  // ddmm.mmmm
+  nmea.AddChar(lat < 0. ? 'S' : 'N');
+  nmea.AddFixed(floor(lon_abs) * 100. + (lon_abs - floor(lon_abs)) * 60., 4);  // dddmm.mmmm
+  nmea.AddChar(lon < 0. ? 'W' : 'E');
+  nmea.AddFixed(m_scenario.GetSpeed(), 1);
+  nmea.AddFixed(m_scenario.GetHeading(), 1);  // There is no current, so COG is the heading
+  nmea.AddField(utc.Format(wxT("%d%m%y"), wxDateTime::UTC).mb_str());
+  nmea.AddField("");
+  nmea.AddField("");
+  nmea.AddChar('S');  // Simulator mode
+  PushNMEABuffer(wxString::FromAscii(nmea.Finish()));
+}
 
-void EmulatorReceive::EmulateFakeBuffer(void) {
-  time_t now = time(0);
+/*
+ * Called every MILLIS_PER_SELECT. Emulate the spokes that the radar would have sent
+ * since the last call, at the current desired auto_range.
+ */
+void EmulatorReceive::EmulateSpokes(void) {
+  time_t now = m_ri->GetRadarTime();
+  wxLongLong millis = m_ri->GetRadarMillis();
+  double elapsed = (millis - m_last_millis).ToDouble() / MILLISECONDS_PER_SECOND;
   uint8_t data[EMULATOR_MAX_SPOKE_LEN];
 
+  m_last_millis = millis;
   m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
 
+  // We sail on, whether the radar is transmitting or not
+  m_scenario.Advance(elapsed);
+  SendNavigation(millis);
+
   int state = m_ri->m_state.GetValue();
 
   if (state != RADAR_TRANSMIT) {
     if (state == RADAR_OFF) {
       m_ri->m_state.Update(RADAR_STANDBY);
     }
+    m_spoke_backlog = 0.;
     return;
   }
 
   m_ri->m_statistics.packets++;
   m_ri->m_data_timeout = now + WATCHDOG_TIMEOUT;
 
-  m_next_rotation = (m_next_rotation + 1) % EMULATOR_SPOKES;
+  int spokes = (int)m_ri->m_spokes;
+  int rpm = M_SETTINGS.emulator_rpm;
+  int spokes_now;
+
+  if (rpm > 0) {
+    // Never more than one rotation behind, for when the thread was held up
+    m_spoke_backlog = wxMin(m_spoke_backlog + elapsed * spokes * rpm / 60., (double)spokes);
+    spokes_now = (int)m_spoke_backlog;
+    m_spoke_backlog -= spokes_now;
+  } else {
+    spokes_now = spokes;  // As fast as possible, a whole rotation every time
+  }
 
-  int scanlines_in_packet = EMULATOR_SPOKES * 24 / 60 * MILLIS_PER_SELECT / MILLISECONDS_PER_SECOND;
   int range_meters = m_ri->m_range.GetValue();
 
   const int *ranges;
@@ -89,48 +178,20 @@ void EmulatorReceive::EmulateFakeBuffer(void) {
     m_ri->m_range.Update(range_meters);
   }
 
-  int display_range_meters = range_meters * 5 / 4;
-  int spots = 0;
+  int bearing_offset = SCALE_DEGREES_TO_SPOKES(m_scenario.GetHeading());
 
-  for (int scanline = 0; scanline < scanlines_in_packet; scanline++) {
+  for (int scanline = 0; scanline < spokes_now; scanline++) {
     int angle = m_next_spoke;
     m_next_spoke = MOD_SPOKES(m_next_spoke + 1);
     m_ri->m_statistics.spokes++;
 
-    if (range_meters == ranges[count - 1]) {
-      // New pattern suited for arpa / guard zone detection
-      CLEAR_STRUCT(data);
-      if (scanline < 8) {
-        for (size_t range = 384; range < 410; range++) {
-          data[range] = 255;
-          spots++;
-        }
-      }
-    } else {
-      // The blotchy pattern
-      // Invent a pattern. Outermost ring, then a square pattern
-      for (size_t range = 0; range < sizeof(data); range++) {
-        size_t bit = range >> 7;
-        // use bit 'bit' of angle_raw
-        uint8_t colour = (((angle + m_next_rotation) >> 5) & (2 << bit)) > 0 ? (range / 2) : 0;
-        if (range > sizeof(data) - 10) {
-          colour = ((angle + m_next_rotation) % EMULATOR_SPOKES) <= 8 ? 255 : 0;
-        }
-        data[range] = colour;
-        if (colour > 0) {
-          spots++;
-        }
-      }
-    }
-
-    int hdt = SCALE_DEGREES_TO_SPOKES(m_pi->GetHeadingTrue());
-    int bearing = MOD_SPOKES(angle + hdt);
+    m_scenario.GenerateSpoke(angle, range_meters, data);
 
-    wxLongLong time_rec = wxGetUTCTimeMillis();
-    m_ri->ProcessRadarSpoke(angle, bearing, data, sizeof(data), range_meters, time_rec);
+    wxLongLong time_rec = m_ri->GetRadarMillis();
+    m_ri->ProcessRadarSpoke(angle, MOD_SPOKES(angle + bearing_offset), data, m_ri->m_spoke_len_max, range_meters, time_rec);
   }
 
-  LOG_VERBOSE(wxT("radar_pi: emulating %d spokes at range %d with %d spots"), scanlines_in_packet, range_meters, spots);
+  LOG_VERBOSE(wxT("radar_pi: emulating %d spokes at range %d"), spokes_now, range_meters);
 }
 
 /*
@@ -144,14 +205,16 @@ void *EmulatorReceive::Entry(void) {
   NetworkAddress fake(127, 0, 0, 10, 3333);
 
   LOG_VERBOSE(wxT("radar_pi: EmulatorReceive thread %s starting"), m_ri->m_name.c_str());
+  TraceThreadName(m_ri->m_name + wxT(" receive"));
 
   m_ri->DetectedRadar(fake, fake);
+  InitScenario();
 
   while (!m_shutdown) {
     struct timeval tv;
 
     tv.tv_sec = 0;
-    tv.tv_usec = (long)(MILLIS_PER_SELECT * 1000);
+    tv.tv_usec = (M_SETTINGS.emulator_rpm > 0) ? (long)(MILLIS_PER_SELECT * 1000) : 0;
 
     fd_set fdin;
     FD_ZERO(&fdin);
@@ -177,7 +240,7 @@ void *EmulatorReceive::Entry(void) {
       }
     }
 
-    EmulateFakeBuffer();
+    EmulateSpokes();
 
   }  // endless loop until thread destroy
 
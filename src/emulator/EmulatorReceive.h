@@ -32,6 +32,7 @@
 #ifndef _EMULATORRECEIVE_H_
 #define _EMULATORRECEIVE_H_
 
+#include "EmulatorScenario.h"
 #include "RadarReceive.h"
 #include "socketutil.h"
 
@@ -46,7 +47,7 @@ class EmulatorReceive : public RadarReceive {
   EmulatorReceive(radar_pi *pi, RadarInfo *ri) : RadarReceive(pi, ri) {
     m_shutdown = false;
     m_next_spoke = 0;
-    m_next_rotation = 0;
+    m_spoke_backlog = 0.;
     m_receive_socket = GetLocalhostServerTCPSocket();
     m_send_socket = GetLocalhostSendTCPSocket(m_receive_socket);
     LOG_RECEIVE(wxT("radar_pi: %s receive thread created"), m_ri->m_name.c_str());
@@ -62,12 +63,17 @@ class EmulatorReceive : public RadarReceive {
   wxString GetInfoStatus();
 
  private:
-  void EmulateFakeBuffer(void);
+  void InitScenario();
+  void SendNavigation(wxLongLong now);
+  void EmulateSpokes(void);
 
   volatile bool m_shutdown;
 
-  int m_next_spoke;     // emulator next spoke
-  int m_next_rotation;  // slowly rotate emulator
+  EmulatorScenario m_scenario;
+  int m_next_spoke;          // emulator next spoke
+  double m_spoke_backlog;    // Spokes that are due but not sent yet, less than one unless the thread was held up
+  wxLongLong m_last_millis;  // When the scenario was last moved on
+  wxLongLong m_next_nmea;    // When the position is sent to OpenCPN again
 
   SOCKET m_receive_socket;  // Where we listen for message from m_send_socket
   SOCKET m_send_socket;     // A message to this socket will interrupt select() and allow immediate shutdown
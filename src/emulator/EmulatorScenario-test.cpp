@@ -0,0 +1,212 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/stopwatch.h>
+#include "EmulatorScenario.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define HALO_SPOKES (4096)
+#define HALO_SPOKE_LEN (1024)
+#define HALO_RPM (48)  // Fastest that a HALO rotates
+#define RANGE (4000)
+
+static ScenarioSettings MakeSettings(int point_targets, int extended_targets, int clutter) {
+  ScenarioSettings settings;
+
+  settings.spokes = HALO_SPOKES;
+  settings.spoke_len = HALO_SPOKE_LEN;
+  settings.point_targets = point_targets;
+  settings.extended_targets = extended_targets;
+  settings.clutter = clutter;
+  settings.speed = 0.;
+  settings.turn_rate = 0.;
+  settings.seed = 42;
+  return settings;
+}
+
+// Number of spokes in one rotation that have any return, and the total number of samples with a return
+static void CountReturns(EmulatorScenario &scenario, int range, int *spokes, int *samples) {
+  static uint8_t data[HALO_SPOKE_LEN];
+
+  *spokes = 0;
+  *samples = 0;
+  for (int angle = 0; angle < HALO_SPOKES; angle++) {
+    scenario.GenerateSpoke(angle, range, data);
+    bool any = false;
+    for (int r = 0; r < HALO_SPOKE_LEN; r++) {
+      if (data[r]) {
+        any = true;
+        (*samples)++;
+      }
+    }
+    if (any) {
+      (*spokes)++;
+    }
+  }
+}
+
+static int TestOwnShip() {
+  EmulatorScenario scenario;
+  ScenarioSettings settings = MakeSettings(0, 0, 0);
+  int ret = 0;
+
+  settings.speed = 6.;
+  settings.turn_rate = 0.;
+  scenario.Init(settings, RANGE, SCENARIO_START_LAT, SCENARIO_START_LON);
+  for (int i = 0; i < 3600; i++) {
+    scenario.Advance(1.);
+  }
+  // Six miles north in an hour is a tenth of a degree
+  if (fabs(scenario.GetLat() - SCENARIO_START_LAT - 0.1) > 0.0001 || fabs(scenario.GetLon() - SCENARIO_START_LON) > 0.0001) {
+    cout << "ERROR: own ship sailed to " << scenario.GetLat() << " " << scenario.GetLon() << "\n";
+    ret = 1;
+  }
+
+  settings.turn_rate = -6.;
+  scenario.Init(settings, RANGE, SCENARIO_START_LAT, SCENARIO_START_LON);
+  scenario.Advance(600.);
+  if (fabs(scenario.GetHeading() - 300.) > 0.001) {
+    cout << "ERROR: own ship heading is " << scenario.GetHeading() << " after turning 60 degrees to port\n";
+    ret = 1;
+  }
+  return ret;
+}
+
+static int TestTargets() {
+  EmulatorScenario scenario;
+  int ret = 0;
+  int spokes, samples;
+
+  scenario.Init(MakeSettings(0, 0, 0), RANGE, SCENARIO_START_LAT, SCENARIO_START_LON);
+  CountReturns(scenario, RANGE, &spokes, &samples);
+  if (samples != 0) {
+    cout << "ERROR: empty scenario has " << samples << " returns\n";
+    ret = 1;
+  }
+
+  // A point target is as wide as the beam, as long as it is in range
+  scenario.Init(MakeSettings(1, 0, 0), RANGE, SCENARIO_START_LAT, SCENARIO_START_LON);
+  CountReturns(scenario, RANGE, &spokes, &samples);
+  int beam = (int)(SCENARIO_BEAM_WIDTH / 2. * HALO_SPOKES / 360.) * 2 + 1;
+  if (spokes != beam) {
+    cout << "ERROR: point target is seen on " << spokes << " spokes instead of " << beam << "\n";
+    ret = 1;
+  }
+
+  // The targets move, so a minute later the picture is different
+  EmulatorScenario later;
+  scenario.Init(MakeSettings(50, 10, 0), RANGE, SCENARIO_START_LAT, SCENARIO_START_LON);
+  later.Init(MakeSettings(50, 10, 0), RANGE, SCENARIO_START_LAT, SCENARIO_START_LON);
+  later.Advance(60.);
+  uint8_t before[HALO_SPOKE_LEN], after[HALO_SPOKE_LEN];
+  int changed = 0;
+  for (int angle = 0; angle < HALO_SPOKES; angle++) {
+    scenario.GenerateSpoke(angle, RANGE, before);
+    later.GenerateSpoke(angle, RANGE, after);
+    if (memcmp(before, after, sizeof(before)) != 0) {
+      changed++;
+    }
+  }
+  CountReturns(scenario, RANGE, &spokes, &samples);
+  if (changed == 0) {
+    cout << "ERROR: targets did not move in a minute\n";
+    ret = 1;
+  }
+  cout << "INFO: " << scenario.GetTargetCount() << " targets have " << samples << " returns, " << spokes << " spokes see a target, "
+       << changed << " spokes changed in a minute\n";
+  return ret;
+}
+
+static int TestClutter() {
+  EmulatorScenario scenario;
+  int ret = 0;
+  int spokes, samples;
+
+  scenario.Init(MakeSettings(0, 0, 100), RANGE, SCENARIO_START_LAT, SCENARIO_START_LON);
+  CountReturns(scenario, RANGE, &spokes, &samples);
+  if (spokes < HALO_SPOKES * 9 / 10) {
+    cout << "ERROR: only " << spokes << " spokes have sea clutter\n";
+    ret = 1;
+  }
+  // All of it is close by, so at a long range it occupies fewer samples
+  int samples_far;
+  CountReturns(scenario, RANGE * 4, &spokes, &samples_far);
+  if (samples_far * 2 > samples) {
+    cout << "ERROR: sea clutter is " << samples << " samples at " << RANGE << " m and " << samples_far << " at " << RANGE * 4
+         << " m\n";
+    ret = 1;
+  }
+  cout << "INFO: sea clutter is " << samples << " samples per rotation\n";
+  return ret;
+}
+
+// How many spokes a second the scenario can make, compared to what a HALO at full speed sends
+static int TestSpeed() {
+  static uint8_t data[HALO_SPOKE_LEN];
+  EmulatorScenario scenario;
+
+  scenario.Init(MakeSettings(SCENARIO_TARGETS_MAX, SCENARIO_TARGETS_MAX / 5, 50), RANGE, SCENARIO_START_LAT, SCENARIO_START_LON);
+
+  const int rotations = 20;
+  wxStopWatch stopwatch;
+  for (int rotation = 0; rotation < rotations; rotation++) {
+    for (int angle = 0; angle < HALO_SPOKES; angle++) {
+      scenario.GenerateSpoke(angle, RANGE, data);
+    }
+    scenario.Advance(60. / HALO_RPM);
+  }
+  long millis = wxMax(stopwatch.Time(), 1L);
+  long spokes_per_second = (long)rotations * HALO_SPOKES * 1000 / millis;
+  cout << "INFO: " << scenario.GetTargetCount() << " targets, " << spokes_per_second << " spokes/s, a HALO sends "
+       << HALO_SPOKES * HALO_RPM / 60 << " spokes/s\n";
+  return 0;
+}
+
+int main() {
+  int ret = 0;
+
+  ret |= TestOwnShip();
+  ret |= TestTargets();
+  ret |= TestClutter();
+  ret |= TestSpeed();
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { RadarPlugin::main(); }
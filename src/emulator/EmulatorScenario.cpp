@@ -0,0 +1,221 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "EmulatorScenario.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+EmulatorScenario::EmulatorScenario() {
+  CLEAR_STRUCT(m_settings);
+  m_area = 0.;
+  m_origin_lat = SCENARIO_START_LAT;
+  m_origin_lon = SCENARIO_START_LON;
+  m_meters_per_degree_lon = METERS_PER_NM * 60.;
+  m_x = 0.;
+  m_y = 0.;
+  m_heading = 0.;
+  m_random = 1;
+  m_clutter_range = 0;
+  m_clutter_samples = 0;
+}
+
+void EmulatorScenario::Init(const ScenarioSettings &settings, double area_meters, double lat, double lon) {
+  m_settings = settings;
+  m_area = area_meters;
+  m_origin_lat = lat;
+  m_origin_lon = lon;
+  m_meters_per_degree_lon = METERS_PER_NM * 60. * cos(deg2rad(lat));
+  m_x = 0.;
+  m_y = 0.;
+  m_heading = 0.;
+  m_random = settings.seed ? settings.seed : 1;
+  m_clutter_range = 0;
+  m_clutter_samples = 0;
+
+  m_targets.clear();
+  for (int i = 0; i < wxMin(settings.point_targets, SCENARIO_TARGETS_MAX); i++) {
+    AddTarget(false);
+  }
+  for (int i = 0; i < wxMin(settings.extended_targets, SCENARIO_TARGETS_MAX); i++) {
+    AddTarget(true);
+  }
+  Advance(0.);
+}
+
+void EmulatorScenario::AddTarget(bool extended) {
+  Target t;
+
+  // Spread evenly over the area, but not right on top of us
+  double r = m_area * sqrt(0.01 + 0.99 * RandomFraction());
+  double a = 2. * PI * RandomFraction();
+  t.x = m_x + r * sin(a);
+  t.y = m_y + r * cos(a);
+
+  double speed;
+  if (extended) {
+    // A third of them are land or at anchor
+    speed = (RandomFraction() < 1. / 3.) ? 0. : 12. * RandomFraction();
+    t.width = 50. + 450. * RandomFraction();
+    t.depth = 30. + 170. * RandomFraction();
+    t.strength = (uint8_t)(200 + 55 * RandomFraction());
+  } else {
+    speed = 20. * RandomFraction();
+    t.width = 5. + 15. * RandomFraction();
+    t.depth = t.width;
+    t.strength = (uint8_t)(160 + 95 * RandomFraction());
+  }
+  double course = 2. * PI * RandomFraction();
+  t.vx = speed * METERS_PER_NM / 3600. * sin(course);
+  t.vy = speed * METERS_PER_NM / 3600. * cos(course);
+  t.visible = false;
+  t.bearing = 0;
+  t.half_width = 0;
+  t.range = 0.;
+  m_targets.push_back(t);
+}
+
+void EmulatorScenario::Advance(double seconds) {
+  int spokes = m_settings.spokes;
+  double speed = m_settings.speed * METERS_PER_NM / 3600.;
+
+  m_heading = fmod(m_heading + m_settings.turn_rate * seconds / 60., 360.);
+  if (m_heading < 0.) {
+    m_heading += 360.;
+  }
+  m_x += speed * sin(deg2rad(m_heading)) * seconds;
+  m_y += speed * cos(deg2rad(m_heading)) * seconds;
+
+  if (spokes <= 0) {
+    return;
+  }
+  for (size_t i = 0; i < m_targets.size(); i++) {
+    Target &t = m_targets[i];
+
+    t.x += t.vx * seconds;
+    t.y += t.vy * seconds;
+
+    double dx = t.x - m_x;
+    double dy = t.y - m_y;
+    double range = sqrt(dx * dx + dy * dy);
+    if (range > m_area) {
+      // Sailed out of sight, so it comes back in on the opposite side and stays busy
+      dx *= -0.98;
+      dy *= -0.98;
+      range *= 0.98;
+      t.x = m_x + dx;
+      t.y = m_y + dy;
+    }
+
+    t.range = range;
+    t.visible = range > t.depth;
+    if (!t.visible) {
+      continue;  // Too close to make out a bearing
+    }
+    int bearing = (int)(rad2deg(atan2(dx, dy)) * spokes / 360.);
+    t.bearing = (bearing + spokes) % spokes;
+    double half_width = wxMax(rad2deg(atan2(t.width / 2., range)), SCENARIO_BEAM_WIDTH / 2.);
+    t.half_width = wxMin((int)(half_width * spokes / 360.), spokes / 4);
+  }
+}
+
+// Sea clutter gets less likely further out, and there is no point in drawing random numbers where it is unlikely
+void EmulatorScenario::ComputeClutter(int range_meters) {
+  size_t len = (size_t)m_settings.spoke_len;
+  double probability = m_settings.clutter / 200.;
+
+  m_clutter_range = range_meters;
+  m_clutter_threshold.resize(len);
+  m_clutter_samples = 0;
+  for (size_t i = 0; i < len; i++) {
+    double p = probability * exp(-(double)i * range_meters / len / SCENARIO_CLUTTER_RANGE);
+    if (p < 0.001) {
+      break;
+    }
+    m_clutter_threshold[i] = (uint32_t)(p * 4294967295.);
+    m_clutter_samples = i + 1;
+  }
+}
+
+void EmulatorScenario::GenerateSpoke(int angle, int range_meters, uint8_t *data) {
+  int spokes = m_settings.spokes;
+  int len = m_settings.spoke_len;
+
+  memset(data, 0, len);
+  if (range_meters <= 0 || spokes <= 0) {
+    return;
+  }
+  if (range_meters != m_clutter_range) {
+    ComputeClutter(range_meters);
+  }
+
+  for (size_t i = 0; i < m_clutter_samples; i++) {
+    if (Random() < m_clutter_threshold[i]) {
+      data[i] = (uint8_t)(64 + (Random() >> 25));
+    }
+  }
+
+  int bearing = (angle + (int)(m_heading * spokes / 360.)) % spokes;
+  double samples_per_meter = len / (double)range_meters;
+
+  for (size_t i = 0; i < m_targets.size(); i++) {
+    const Target &t = m_targets[i];
+
+    if (!t.visible) {
+      continue;
+    }
+    int delta = bearing - t.bearing;
+    if (delta > spokes / 2) {
+      delta -= spokes;
+    } else if (delta < -spokes / 2) {
+      delta += spokes;
+    }
+    if (delta > t.half_width || delta < -t.half_width) {
+      continue;
+    }
+    double near = t.range - t.depth / 2.;
+    if (near >= range_meters) {
+      continue;
+    }
+    int from = wxMax((int)(near * samples_per_meter), 0);
+    int to = wxMin((int)((t.range + t.depth / 2.) * samples_per_meter), len - 1);
+    for (int r = from; r <= to; r++) {
+      if (data[r] < t.strength) {
+        data[r] = t.strength;
+      }
+    }
+  }
+}
+
+double EmulatorScenario::GetLat() const { return m_origin_lat + m_y / (METERS_PER_NM * 60.); }
+
+double EmulatorScenario::GetLon() const { return m_origin_lon + m_x / m_meters_per_degree_lon; }
+
+PLUGIN_END_NAMESPACE
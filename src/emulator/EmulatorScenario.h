@@ -0,0 +1,125 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _EMULATORSCENARIO_H_
+#define _EMULATORSCENARIO_H_
+
+#include <vector>
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// The world that the emulator radar looks at: our own ship, that sails at a constant speed and
+// rate of turn, a number of other targets that sail in straight lines, and sea clutter around us.
+// Everything is kept in meters east and north of where our own ship started, which is close
+// enough to a chart for the few miles that a radar can see.
+//
+// The scenario knows nothing about the plugin, so it can be tested and benchmarked on its own.
+//
+
+#define SCENARIO_TARGETS_MAX (250)     // Point and extended targets each
+#define SCENARIO_BEAM_WIDTH (1.5)      // Degrees, even a point target is at least this wide
+#define SCENARIO_CLUTTER_RANGE (800.)  // Meters, sea clutter fades to a third over this distance
+#define SCENARIO_START_LAT (52.0)      // Where we sail when OpenCPN does not know where we are
+#define SCENARIO_START_LON (4.0)
+
+struct ScenarioSettings {
+  int spokes;            // Spokes per rotation
+  int spoke_len;         // Samples per spoke
+  int point_targets;     // Buoys and small craft
+  int extended_targets;  // Ships and bits of coast that are larger than the beam
+  int clutter;           // Sea clutter 0 (none) .. 100 (a lot)
+  double speed;          // Own ship speed in knots
+  double turn_rate;      // Own ship rate of turn in degrees per minute, positive is to starboard
+  uint32_t seed;         // Same seed, same targets
+};
+
+class EmulatorScenario {
+ public:
+  EmulatorScenario();
+
+  // Place the targets at random within area_meters of our own ship
+  void Init(const ScenarioSettings &settings, double area_meters, double lat, double lon);
+
+  // Move everything on by this many seconds, and work out where the targets are seen from our own ship
+  void Advance(double seconds);
+
+  // One spoke of settings.spoke_len samples at angle (0 .. settings.spokes) relative to the bow
+  void GenerateSpoke(int angle, int range_meters, uint8_t *data);
+
+  double GetHeading() const { return m_heading; }  // Degrees true
+  double GetSpeed() const { return m_settings.speed; }
+  double GetLat() const;
+  double GetLon() const;
+  int GetTargetCount() const { return (int)m_targets.size(); }
+
+ private:
+  struct Target {
+    double x, y;      // Meters east and north of the origin
+    double vx, vy;    // Meters per second east and north
+    double width;     // Meters across the beam
+    double depth;     // Meters along the beam
+    uint8_t strength;
+
+    // Seen from our own ship, updated by Advance()
+    bool visible;
+    int bearing;     // Spoke, true
+    int half_width;  // Spokes either side of bearing
+    double range;    // Meters to the middle of the target
+  };
+
+  uint32_t Random() {
+    m_random = m_random * 1664525u + 1013904223u;
+    return m_random;
+  }
+  double RandomFraction() { return (Random() >> 8) / (double)(1 << 24); }  // 0 .. 1
+  void AddTarget(bool extended);
+  void ComputeClutter(int range_meters);
+
+  ScenarioSettings m_settings;
+  double m_area;  // Targets that sail further than this away come back on the other side
+  double m_origin_lat, m_origin_lon;
+  double m_meters_per_degree_lon;
+  double m_x, m_y;  // Our own ship
+  double m_heading;
+  uint32_t m_random;
+
+  std::vector<Target> m_targets;
+
+  int m_clutter_range;                        // Range that m_clutter_threshold was computed for
+  std::vector<uint32_t> m_clutter_threshold;  // Per sample, a random number below this is clutter
+  size_t m_clutter_samples;                   // Samples beyond this never have clutter
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _EMULATORSCENARIO_H_ */
@@ -8,15 +8,18 @@ PLUGIN_END_NAMESPACE
 #endif
 
 #define RANGE_METRIC_RT_EMULATOR \
-  { 1000, 4000 }
+  { 500, 1000, 2000, 4000, 8000 }
 #define RANGE_MIXED_RT_EMULATOR \
-  { 1852 / 2, 1852 * 2 }
+  { 1852 / 4, 1852 / 2, 1852, 1852 * 2, 1852 * 4 }
 #define RANGE_NAUTIC_RT_EMULATOR \
-  { 1852 / 2, 1852 * 2 }
-
-// Emulator has 1440 spokes of exactly 768 bytes each, to emulate Garmin
-#define EMULATOR_SPOKES 1440
-#define EMULATOR_MAX_SPOKE_LEN 768
+  { 1852 / 4, 1852 / 2, 1852, 1852 * 2, 1852 * 4 }
+
+// The emulator has as many spokes as set by EmulatorSpokes and EmulatorSpokeLen, by default
+// 1440 spokes of 768 bytes each to emulate Garmin, and at most as many as a HALO.
+#define EMULATOR_SPOKES 4096
+#define EMULATOR_MAX_SPOKE_LEN 1024
+#define EMULATOR_DEFAULT_SPOKES 1440
+#define EMULATOR_DEFAULT_SPOKE_LEN 768
 
 #if SPOKES_MAX < EMULATOR_SPOKES
 #undef SPOKES_MAX
@@ -82,7 +82,7 @@ struct radar_line {
 //
 void GarminHDReceive::ProcessFrame(radar_line *packet) {
   // log_line.time_rec = wxGetUTCTimeMillis();
-  wxLongLong time_rec = wxGetUTCTimeMillis();
+  wxLongLong time_rec = m_ri->GetRadarMillis();
   time_t now = (time_t)(time_rec.GetValue() / MILLISECONDS_PER_SECOND);
   uint8_t line[GARMIN_HD_MAX_SPOKE_LEN];
   int i;
@@ -114,7 +114,7 @@ void GarminHDReceive::ProcessFrame(radar_line *packet) {
   m_ri->m_interference_rejection.Update(packet->crosstalk_onoff);
   m_ri->m_scan_speed.Update(packet->dome_speed);
 
-  wxCriticalSectionLocker lock(m_ri->m_exclusive);
+  ProfiledLocker lock(m_ri->m_exclusive);
 
   m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
   m_ri->m_data_timeout = now + DATA_TIMEOUT;
@@ -150,42 +150,6 @@ void GarminHDReceive::ProcessFrame(radar_line *packet) {
   m_ri->ProcessRadarSpoke(a, b, line, p - line, packet->display_meters, time_rec);
 }
 
-SOCKET GarminHDReceive::PickNextEthernetCard() {
-  SOCKET socket = INVALID_SOCKET;
-  CLEAR_STRUCT(m_interface_addr);
-
-  // Pick the next ethernet card
-  // If set, we used this one last time. Go to the next card.
-  if (m_interface) {
-    m_interface = m_interface->ifa_next;
-  }
-  // Loop until card with a valid IPv4 address
-  while (m_interface && !VALID_IPV4_ADDRESS(m_interface)) {
-    m_interface = m_interface->ifa_next;
-  }
-  if (!m_interface) {
-    if (m_interface_array) {
-      freeifaddrs(m_interface_array);
-      m_interface_array = 0;
-    }
-    if (!getifaddrs(&m_interface_array)) {
-      m_interface = m_interface_array;
-    }
-    // Loop until card with a valid IPv4 address
-    while (m_interface && !VALID_IPV4_ADDRESS(m_interface)) {
-      m_interface = m_interface->ifa_next;
-    }
-  }
-  if (m_interface && VALID_IPV4_ADDRESS(m_interface)) {
-    m_interface_addr.addr = ((struct sockaddr_in *)m_interface->ifa_addr)->sin_addr;
-    m_interface_addr.port = 0;
-  }
-
-  socket = GetNewReportSocket();
-
-  return socket;
-}
-
 SOCKET GarminHDReceive::GetNewReportSocket() {
   SOCKET socket;
   wxString error;
@@ -197,6 +161,7 @@ SOCKET GarminHDReceive::GetNewReportSocket() {
   error = wxT("");
   socket = startUDPMulticastReceiveSocket(m_interface_addr, m_report_addr, error);
   if (socket != INVALID_SOCKET) {
+    EnableReceiveAge(socket);  // The spokes come in on the report socket
     wxString addr = FormatNetworkAddress(m_interface_addr);
     wxString rep_addr = FormatNetworkAddressPort(m_report_addr);
 
@@ -228,8 +193,6 @@ void *GarminHDReceive::Entry(void) {
   socklen_t rx_len;
 
   uint8_t data[sizeof(radar_line)];
-  m_interface_array = 0;
-  m_interface = 0;
   m_no_spoke_timeout = 0;
   struct sockaddr_in radarFoundAddr;
   sockaddr_in *radar_addr = 0;
@@ -237,19 +200,13 @@ void *GarminHDReceive::Entry(void) {
   SOCKET reportSocket = INVALID_SOCKET;
 
   LOG_VERBOSE(wxT("radar_pi: GarminHDReceive thread %s starting"), m_ri->m_name.c_str());
+  TraceThreadName(m_ri->m_name + wxT(" receive"));
 
   if (m_interface_addr.addr.s_addr == 0) {
     reportSocket = GetNewReportSocket();
   }
 
   while (m_receive_socket != INVALID_SOCKET) {
-    if (reportSocket == INVALID_SOCKET) {
-      reportSocket = PickNextEthernetCard();
-      if (reportSocket != INVALID_SOCKET) {
-        no_data_timeout = 0;
-        m_no_spoke_timeout = 0;
-      }
-    }
 
     struct timeval tv = {(long)0, (long)(MILLIS_PER_SELECT * 1000)};
 
@@ -264,6 +221,10 @@ void *GarminHDReceive::Entry(void) {
     if (reportSocket != INVALID_SOCKET) {
       FD_SET(reportSocket, &fdin);
       maxFd = MAX(reportSocket, maxFd);
+    } else if (m_probe.Prepare(m_report_addr, &fdin, &maxFd)) {
+      LOG_RECEIVE(wxT("radar_pi: %s scanning interfaces %s for data from %s"), m_ri->m_name.c_str(),
+                  m_probe.GetInterfaces().c_str(), FormatNetworkAddressPort(m_report_addr).c_str());
+      SetInfoStatus(m_probe.GetStatus());
     }
 
     wxLongLong start = wxGetUTCTimeMillis();
@@ -271,6 +232,16 @@ void *GarminHDReceive::Entry(void) {
     // LOG_RECEIVE(wxT("radar_pi: select maxFd=%d r=%d elapsed=%lld"), maxFd, r, wxGetUTCTimeMillis() - start);
 
     if (r > 0) {
+      if (reportSocket == INVALID_SOCKET) {
+        // Continue with the interface that the report came in on, it is read below
+        reportSocket = m_probe.Pick(&fdin, &m_interface_addr);
+        if (reportSocket != INVALID_SOCKET) {
+          EnableReceiveAge(reportSocket);
+          no_data_timeout = 0;
+          m_no_spoke_timeout = 0;
+        }
+      }
+
       if (m_receive_socket != INVALID_SOCKET && FD_ISSET(m_receive_socket, &fdin)) {
         rx_len = sizeof(rx_addr);
         r = recvfrom(m_receive_socket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
@@ -281,9 +252,16 @@ void *GarminHDReceive::Entry(void) {
       }
 
       if (reportSocket != INVALID_SOCKET && FD_ISSET(reportSocket, &fdin)) {
+        uint64_t age;
         rx_len = sizeof(rx_addr);
-        r = recvfrom(reportSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
+        {
+          TRACE_SCOPE("receive");
+          r = ReceiveWithAge(reportSocket, (char *)data, sizeof(data), (struct sockaddr *)&rx_addr, &rx_len, &age);
+        }
         if (r > 0) {
+          if (age != RECEIVE_AGE_UNKNOWN) {
+            m_ri->m_latency.Record(LATENCY_SOCKET, age);
+          }
           NetworkAddress radar_address;
           radar_address.addr = rx_addr.ipv4.sin_addr;
           radar_address.port = rx_addr.ipv4.sin_port;
@@ -349,9 +327,7 @@ void *GarminHDReceive::Entry(void) {
     closesocket(m_receive_socket);
   }
 
-  if (m_interface_array) {
-    freeifaddrs(m_interface_array);
-  }
+  m_probe.Close();
 
 #ifdef TEST_THREAD_RACES
   LOG_VERBOSE(wxT("radar_pi: %s receive thread sleeping"), m_ri->m_name.c_str());
@@ -424,7 +400,7 @@ bool GarminHDReceive::UpdateScannerStatus(int status) {
     m_radar_status = status;
 
     wxString stat;
-    time_t now = time(0);
+    time_t now = m_ri->GetRadarTime();
 
     switch (m_radar_status) {
       case 1:
@@ -461,7 +437,7 @@ bool GarminHDReceive::UpdateScannerStatus(int status) {
 bool GarminHDReceive::ProcessReport(const uint8_t *report, int len) {
   LOG_BINARY_RECEIVE(wxT("ProcessReport"), report, len);
 
-  time_t now = time(0);
+  time_t now = m_ri->GetRadarTime();
 
   m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
 
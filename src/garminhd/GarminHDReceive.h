@@ -32,6 +32,7 @@
 #ifndef _GARMIN_HD_RECEIVE_H_
 #define _GARMIN_HD_RECEIVE_H_
 
+#include "InterfaceMonitor.h"
 #include "RadarReceive.h"
 #include "socketutil.h"
 
@@ -77,7 +78,6 @@ class GarminHDReceive : public RadarReceive {
   void ProcessFrame(radar_line *packet);
   bool ProcessReport(const uint8_t *data, int len);
 
-  SOCKET PickNextEthernetCard();
   SOCKET GetNewReportSocket();
 
   wxString m_ip;
@@ -85,8 +85,7 @@ class GarminHDReceive : public RadarReceive {
   SOCKET m_receive_socket;  // Where we listen for message from m_send_socket
   SOCKET m_send_socket;     // A message to this socket will interrupt select() and allow immediate shutdown
 
-  struct ifaddrs *m_interface_array;
-  struct ifaddrs *m_interface;
+  InterfaceProbe m_probe;  // Listens for reports on all interfaces until one is found
 
   int m_next_spoke;
   int m_radar_status;
@@ -119,18 +119,7 @@ bool GarminxHDControl::Init(radar_pi *pi, RadarInfo *ri, NetworkAddress &ifadr,
 }
 
 void GarminxHDControl::logBinaryData(const wxString &what, const void *data, int size) {
-  wxString explain;
-  const uint8_t *d = (const uint8_t *)data;
-  int i = 0;
-
-  explain.Alloc(size * 3 + 50);
-  explain += wxT("radar_pi: ") + m_name + wxT(" ");
-  explain += what;
-  explain += wxString::Format(wxT(" %d bytes: "), size);
-  for (i = 0; i < size; i++) {
-    explain += wxString::Format(wxT(" %02X"), d[i]);
-  }
-  LOG_TRANSMIT(explain);
+  AsyncLogBinary(wxT("radar_pi: ") + m_name + wxT(" ") + what, data, size);
 }
 
 bool GarminxHDControl::TransmitCmd(const void *msg, int size) {
@@ -75,13 +75,14 @@ struct radar_line {
 // from the radar up to the range indicated in the packet.
 //
 void GarminxHDReceive::ProcessFrame(const uint8_t *data, int len) {
+  TRACE_SCOPE("decode");
   // log_line.time_rec = wxGetUTCTimeMillis();
-  wxLongLong time_rec = wxGetUTCTimeMillis();
+  wxLongLong time_rec = m_ri->GetRadarMillis();
   time_t now = (time_t)(time_rec.GetValue() / MILLISECONDS_PER_SECOND);
 
   radar_line *packet = (radar_line *)data;
 
-  wxCriticalSectionLocker lock(m_ri->m_exclusive);
+  ProfiledLocker lock(m_ri->m_exclusive);
 
   m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
   m_ri->m_data_timeout = now + DATA_TIMEOUT;
@@ -121,49 +122,14 @@ void GarminxHDReceive::ProcessFrame(const uint8_t *data, int len) {
   heading_raw = SCALE_DEGREES_TO_RAW(m_pi->GetHeadingTrue());  // include variation
   bearing_raw = angle_raw + heading_raw;
 
-  SpokeBearing a = MOD_SPOKES(angle_raw);
-  SpokeBearing b = MOD_SPOKES(bearing_raw);
+  // Scale to the geometry of the radar we feed, which differs from ours when replaying
+  SpokeBearing a = MOD_SPOKES(angle_raw * (int)m_ri->m_spokes / GARMIN_XHD_SPOKES);
+  SpokeBearing b = MOD_SPOKES(bearing_raw * (int)m_ri->m_spokes / GARMIN_XHD_SPOKES);
 
   m_ri->m_range.Update(packet->range_meters);
   m_ri->ProcessRadarSpoke(a, b, packet->line_data, len, packet->display_meters, time_rec);
 }
 
-SOCKET GarminxHDReceive::PickNextEthernetCard() {
-  SOCKET socket = INVALID_SOCKET;
-  CLEAR_STRUCT(m_interface_addr);
-
-  // Pick the next ethernet card
-  // If set, we used this one last time. Go to the next card.
-  if (m_interface) {
-    m_interface = m_interface->ifa_next;
-  }
-  // Loop until card with a valid IPv4 address
-  while (m_interface && !VALID_IPV4_ADDRESS(m_interface)) {
-    m_interface = m_interface->ifa_next;
-  }
-  if (!m_interface) {
-    if (m_interface_array) {
-      freeifaddrs(m_interface_array);
-      m_interface_array = 0;
-    }
-    if (!getifaddrs(&m_interface_array)) {
-      m_interface = m_interface_array;
-    }
-    // Loop until card with a valid IPv4 address
-    while (m_interface && !VALID_IPV4_ADDRESS(m_interface)) {
-      m_interface = m_interface->ifa_next;
-    }
-  }
-  if (m_interface && VALID_IPV4_ADDRESS(m_interface)) {
-    m_interface_addr.addr = ((struct sockaddr_in *)m_interface->ifa_addr)->sin_addr;
-    m_interface_addr.port = 0;
-  }
-
-  socket = GetNewReportSocket();
-
-  return socket;
-}
-
 SOCKET GarminxHDReceive::GetNewReportSocket() {
   SOCKET socket;
   wxString error;
@@ -201,6 +167,7 @@ SOCKET GarminxHDReceive::GetNewDataSocket() {
   error.Printf(wxT("%s data: "), m_ri->m_name.c_str());
   socket = startUDPMulticastReceiveSocket(m_interface_addr, m_data_addr, error);
   if (socket != INVALID_SOCKET) {
+    EnableReceiveAge(socket);
     wxString addr = FormatNetworkAddress(m_interface_addr);
     wxString rep_addr = FormatNetworkAddressPort(m_data_addr);
 
@@ -229,8 +196,6 @@ void *GarminxHDReceive::Entry(void) {
   socklen_t rx_len;
 
   uint8_t data[sizeof(radar_line)];
-  m_interface_array = 0;
-  m_interface = 0;
   struct sockaddr_in radarFoundAddr;
   sockaddr_in *radar_addr = 0;
 
@@ -238,19 +203,13 @@ void *GarminxHDReceive::Entry(void) {
   SOCKET reportSocket = INVALID_SOCKET;
 
   LOG_VERBOSE(wxT("radar_pi: GarminxHDReceive thread %s starting"), m_ri->m_name.c_str());
+  TraceThreadName(m_ri->m_name + wxT(" receive"));
 
   if (m_interface_addr.addr.s_addr == 0) {
     reportSocket = GetNewReportSocket();
   }
 
   while (m_receive_socket != INVALID_SOCKET) {
-    if (reportSocket == INVALID_SOCKET) {
-      reportSocket = PickNextEthernetCard();
-      if (reportSocket != INVALID_SOCKET) {
-        no_data_timeout = 0;
-        no_spoke_timeout = 0;
-      }
-    }
     if (radar_addr) {
       // If we have detected a radar antenna at this address start opening more sockets.
       // We do this later for 2 reasons:
@@ -280,6 +239,10 @@ void *GarminxHDReceive::Entry(void) {
     if (reportSocket != INVALID_SOCKET) {
       FD_SET(reportSocket, &fdin);
       maxFd = MAX(reportSocket, maxFd);
+    } else if (m_probe.Prepare(m_report_addr, &fdin, &maxFd)) {
+      LOG_RECEIVE(wxT("radar_pi: %s scanning interfaces %s for data from %s"), m_ri->m_name.c_str(),
+                  m_probe.GetInterfaces().c_str(), FormatNetworkAddressPort(m_report_addr).c_str());
+      SetInfoStatus(m_probe.GetStatus());
     }
     if (dataSocket != INVALID_SOCKET) {
       FD_SET(dataSocket, &fdin);
@@ -291,6 +254,15 @@ void *GarminxHDReceive::Entry(void) {
     // LOG_RECEIVE(wxT("radar_pi: select maxFd=%d r=%d elapsed=%lld"), maxFd, r, wxGetUTCTimeMillis() - start);
 
     if (r > 0) {
+      if (reportSocket == INVALID_SOCKET) {
+        // Continue with the interface that the report came in on, it is read below
+        reportSocket = m_probe.Pick(&fdin, &m_interface_addr);
+        if (reportSocket != INVALID_SOCKET) {
+          no_data_timeout = 0;
+          no_spoke_timeout = 0;
+        }
+      }
+
       if (m_receive_socket != INVALID_SOCKET && FD_ISSET(m_receive_socket, &fdin)) {
         rx_len = sizeof(rx_addr);
         r = recvfrom(m_receive_socket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
@@ -301,9 +273,16 @@ void *GarminxHDReceive::Entry(void) {
       }
 
       if (dataSocket != INVALID_SOCKET && FD_ISSET(dataSocket, &fdin)) {
+        uint64_t age;
         rx_len = sizeof(rx_addr);
-        r = recvfrom(dataSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
+        {
+          TRACE_SCOPE("receive");
+          r = ReceiveWithAge(dataSocket, (char *)data, sizeof(data), (struct sockaddr *)&rx_addr, &rx_len, &age);
+        }
         if (r > 0) {
+          if (age != RECEIVE_AGE_UNKNOWN) {
+            m_ri->m_latency.Record(LATENCY_SOCKET, age);
+          }
           ProcessFrame(data, r);
           no_data_timeout = -15;
           no_spoke_timeout = -5;
@@ -394,9 +373,7 @@ void *GarminxHDReceive::Entry(void) {
     closesocket(m_receive_socket);
   }
 
-  if (m_interface_array) {
-    freeifaddrs(m_interface_array);
-  }
+  m_probe.Close();
 
 #ifdef TEST_THREAD_RACES
   LOG_VERBOSE(wxT("radar_pi: %s receive thread sleeping"), m_ri->m_name.c_str());
@@ -466,7 +443,7 @@ bool GarminxHDReceive::UpdateScannerStatus(int status) {
     m_radar_status = status;
 
     wxString stat;
-    time_t now = time(0);
+    time_t now = m_ri->GetRadarTime();
 
     switch (m_radar_status) {
       case 2:
@@ -520,7 +497,7 @@ bool GarminxHDReceive::UpdateScannerStatus(int status) {
 bool GarminxHDReceive::ProcessReport(const uint8_t *report, int len) {
   LOG_BINARY_RECEIVE(wxT("ProcessReport"), report, len);
 
-  time_t now = time(0);
+  time_t now = m_ri->GetRadarTime();
 
   m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
 
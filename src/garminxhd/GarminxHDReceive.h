@@ -32,6 +32,8 @@
 #ifndef _GARMIN_XH_RECEIVE_H_
 #define _GARMIN_XH_RECEIVE_H_
 
+#include "InterfaceMonitor.h"
+#include "RadarClock.h"
 #include "RadarReceive.h"
 #include "socketutil.h"
 
@@ -75,10 +77,11 @@ class GarminxHDReceive : public RadarReceive {
   volatile bool m_is_shutdown;
 
  private:
+  friend class ReplayReceive;  // Feeds recorded frames into ProcessFrame and ProcessReport
+
   void ProcessFrame(const uint8_t *data, int len);
   bool ProcessReport(const uint8_t *data, int len);
 
-  SOCKET PickNextEthernetCard();
   SOCKET GetNewReportSocket();
   SOCKET GetNewDataSocket();
 
@@ -87,8 +90,7 @@ class GarminxHDReceive : public RadarReceive {
   SOCKET m_receive_socket;  // Where we listen for message from m_send_socket
   SOCKET m_send_socket;     // A message to this socket will interrupt select() and allow immediate shutdown
 
-  struct ifaddrs *m_interface_array;
-  struct ifaddrs *m_interface;
+  InterfaceProbe m_probe;  // Listens for reports on all interfaces until one is found
 
   int m_next_spoke;
   int m_radar_status;
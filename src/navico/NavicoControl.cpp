@@ -107,17 +107,7 @@ bool NavicoControl::Init(radar_pi *pi, RadarInfo *ri, NetworkAddress &ifadr, Net
 }
 
 void NavicoControl::logBinaryData(const wxString &what, const uint8_t *data, int size) {
-  wxString explain;
-  int i = 0;
-
-  explain.Alloc(size * 3 + 50);
-  explain += wxT("radar_pi: ") + m_name.c_str() + wxT(" ");
-  explain += what;
-  explain += wxString::Format(wxT(" %d bytes: "), size);
-  for (i = 0; i < size; i++) {
-    explain += wxString::Format(wxT(" %02X"), data[i]);
-  }
-  LOG_TRANSMIT(explain);
+  AsyncLogBinary(wxT("radar_pi: ") + m_name + wxT(" ") + what, data, size);
 }
 
 bool NavicoControl::TransmitCmd(const uint8_t *msg, int size) {
@@ -135,14 +135,14 @@ struct radar_frame_pkt {
 // from the radar up to the range indicated in the packet.
 //
 void NavicoReceive::ProcessFrame(const uint8_t *data, int len) {
-  time_t now = time(0);
-
+  TRACE_SCOPE("decode");
   // log_line.time_rec = wxGetUTCTimeMillis();
-  wxLongLong time_rec = wxGetUTCTimeMillis();
+  wxLongLong time_rec = m_ri->GetRadarMillis();
+  time_t now = (time_t)(time_rec.GetValue() / MILLISECONDS_PER_SECOND);
 
   radar_frame_pkt *packet = (radar_frame_pkt *)data;
 
-  wxCriticalSectionLocker lock(m_ri->m_exclusive);
+  ProfiledLocker lock(m_ri->m_exclusive);
 
   m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
   m_ri->m_data_timeout = now + DATA_TIMEOUT;
@@ -198,7 +198,7 @@ void NavicoReceive::ProcessFrame(const uint8_t *data, int len) {
 
     heading_raw = (line->common.heading[1] << 8) | line->common.heading[0];
 
-    switch (m_ri->m_radar_type) {
+    switch (m_spoke_format) {
       case RT_BR24: {
         range_raw = ((line->br24.range[2] & 0xff) << 16 | (line->br24.range[1] & 0xff) << 8 | (line->br24.range[0] & 0xff));
         angle_raw = (line->br24.angle[1] << 8) | line->br24.angle[0];
@@ -275,42 +275,6 @@ void NavicoReceive::ProcessFrame(const uint8_t *data, int len) {
   }
 }
 
-SOCKET NavicoReceive::PickNextEthernetCard() {
-  SOCKET socket = INVALID_SOCKET;
-  CLEAR_STRUCT(m_interface_addr);
-
-  // Pick the next ethernet card
-  // If set, we used this one last time. Go to the next card.
-  if (m_interface) {
-    m_interface = m_interface->ifa_next;
-  }
-  // Loop until card with a valid IPv4 address
-  while (m_interface && !VALID_IPV4_ADDRESS(m_interface)) {
-    m_interface = m_interface->ifa_next;
-  }
-  if (!m_interface) {
-    if (m_interface_array) {
-      freeifaddrs(m_interface_array);
-      m_interface_array = 0;
-    }
-    if (!getifaddrs(&m_interface_array)) {
-      m_interface = m_interface_array;
-    }
-    // Loop until card with a valid IPv4 address
-    while (m_interface && !VALID_IPV4_ADDRESS(m_interface)) {
-      m_interface = m_interface->ifa_next;
-    }
-  }
-  if (m_interface && VALID_IPV4_ADDRESS(m_interface)) {
-    m_interface_addr.addr = ((struct sockaddr_in *)m_interface->ifa_addr)->sin_addr;
-    m_interface_addr.port = 0;
-  }
-
-  socket = GetNewReportSocket();
-
-  return socket;
-}
-
 SOCKET NavicoReceive::GetNewReportSocket() {
   SOCKET socket;
   wxString error;
@@ -348,6 +312,7 @@ SOCKET NavicoReceive::GetNewDataSocket() {
   error.Printf(wxT("%s data: "), m_ri->m_name.c_str());
   socket = startUDPMulticastReceiveSocket(m_interface_addr, m_data_addr, error);
   if (socket != INVALID_SOCKET) {
+    EnableReceiveAge(socket);
     wxString addr = FormatNetworkAddress(m_interface_addr);
     wxString rep_addr = FormatNetworkAddressPort(m_data_addr);
 
@@ -376,8 +341,6 @@ void *NavicoReceive::Entry(void) {
   socklen_t rx_len;
 
   uint8_t data[sizeof(radar_frame_pkt)];
-  m_interface_array = 0;
-  m_interface = 0;
   struct sockaddr_in radarFoundAddr;
   sockaddr_in *radar_addr = 0;
 
@@ -385,19 +348,13 @@ void *NavicoReceive::Entry(void) {
   SOCKET reportSocket = INVALID_SOCKET;
 
   LOG_VERBOSE(wxT("radar_pi: NavicoReceive thread %s starting"), m_ri->m_name.c_str());
+  TraceThreadName(m_ri->m_name + wxT(" receive"));
 
   if (m_interface_addr.addr.s_addr == 0) {
     reportSocket = GetNewReportSocket();
   }
 
   while (m_receive_socket != INVALID_SOCKET) {
-    if (reportSocket == INVALID_SOCKET) {
-      reportSocket = PickNextEthernetCard();
-      if (reportSocket != INVALID_SOCKET) {
-        no_data_timeout = 0;
-        no_spoke_timeout = 0;
-      }
-    }
     if (radar_addr) {
       // If we have detected a radar antenna at this address start opening more sockets.
       // We do this later for 2 reasons:
@@ -427,6 +384,10 @@ void *NavicoReceive::Entry(void) {
     if (reportSocket != INVALID_SOCKET) {
       FD_SET(reportSocket, &fdin);
       maxFd = MAX(reportSocket, maxFd);
+    } else if (m_probe.Prepare(m_report_addr, &fdin, &maxFd)) {
+      LOG_RECEIVE(wxT("radar_pi: %s scanning interfaces %s for data from %s"), m_ri->m_name.c_str(),
+                  m_probe.GetInterfaces().c_str(), FormatNetworkAddressPort(m_report_addr).c_str());
+      SetInfoStatus(m_probe.GetStatus());
     }
     if (dataSocket != INVALID_SOCKET) {
       FD_SET(dataSocket, &fdin);
@@ -438,6 +399,15 @@ void *NavicoReceive::Entry(void) {
     LOG_VERBOSE(wxT("radar_pi: select maxFd=%d r=%d elapsed=%lld"), maxFd, r, wxGetUTCTimeMillis() - start);
 
     if (r > 0) {
+      if (reportSocket == INVALID_SOCKET) {
+        // Continue with the interface that the report came in on, it is read below
+        reportSocket = m_probe.Pick(&fdin, &m_interface_addr);
+        if (reportSocket != INVALID_SOCKET) {
+          no_data_timeout = 0;
+          no_spoke_timeout = 0;
+        }
+      }
+
       if (m_receive_socket != INVALID_SOCKET && FD_ISSET(m_receive_socket, &fdin)) {
         rx_len = sizeof(rx_addr);
         r = recvfrom(m_receive_socket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
@@ -448,9 +418,16 @@ void *NavicoReceive::Entry(void) {
       }
 
       if (dataSocket != INVALID_SOCKET && FD_ISSET(dataSocket, &fdin)) {
+        uint64_t age;
         rx_len = sizeof(rx_addr);
-        r = recvfrom(dataSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
+        {
+          TRACE_SCOPE("receive");
+          r = ReceiveWithAge(dataSocket, (char *)data, sizeof(data), (struct sockaddr *)&rx_addr, &rx_len, &age);
+        }
         if (r > 0) {
+          if (age != RECEIVE_AGE_UNKNOWN) {
+            m_ri->m_latency.Record(LATENCY_SOCKET, age);
+          }
           ProcessFrame(data, r);
           no_data_timeout = -15;
           no_spoke_timeout = -5;
@@ -541,9 +518,7 @@ void *NavicoReceive::Entry(void) {
     closesocket(m_receive_socket);
   }
 
-  if (m_interface_array) {
-    freeifaddrs(m_interface_array);
-  }
+  m_probe.Close();
 
 #ifdef TEST_THREAD_RACES
   LOG_VERBOSE(wxT("radar_pi: %s receive thread sleeping"), m_ri->m_name.c_str());
@@ -661,7 +636,7 @@ static void AppendChar16String(wxString &dest, uint16_t *src) {
 bool NavicoReceive::ProcessReport(const uint8_t *report, int len) {
   LOG_BINARY_RECEIVE(wxT("ProcessReport"), report, len);
 
-  time_t now = time(0);
+  time_t now = m_ri->GetRadarTime();
 
   m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
 
@@ -32,7 +32,9 @@
 #ifndef _NAVICORECEIVE_H_
 #define _NAVICORECEIVE_H_
 
+#include "InterfaceMonitor.h"
 #include "NavicoCommon.h"
+#include "RadarClock.h"
 #include "RadarReceive.h"
 #include "socketutil.h"
 
@@ -52,6 +54,7 @@ class NavicoReceive : public RadarReceive {
     m_shutdown_time_requested = 0;
     m_is_shutdown = false;
     m_first_receive = true;
+    m_spoke_format = ri->m_radar_type;
     m_interface_addr = m_pi->GetRadarInterfaceAddress(ri->m_radar);
     m_receive_socket = GetLocalhostServerTCPSocket();
     m_send_socket = GetLocalhostSendTCPSocket(m_receive_socket);
@@ -74,10 +77,11 @@ class NavicoReceive : public RadarReceive {
   volatile bool m_is_shutdown;
 
  private:
+  friend class ReplayReceive;  // Feeds recorded frames into ProcessFrame and ProcessReport
+
   void ProcessFrame(const uint8_t *data, int len);
   bool ProcessReport(const uint8_t *data, int len);
 
-  SOCKET PickNextEthernetCard();
   SOCKET GetNewReportSocket();
   SOCKET GetNewDataSocket();
 
@@ -86,12 +90,12 @@ class NavicoReceive : public RadarReceive {
   SOCKET m_receive_socket;  // Where we listen for message from m_send_socket
   SOCKET m_send_socket;     // A message to this socket will interrupt select() and allow immediate shutdown
 
-  struct ifaddrs *m_interface_array;
-  struct ifaddrs *m_interface;
+  InterfaceProbe m_probe;  // Listens for reports on all interfaces until one is found
 
   int m_next_spoke;
   char m_radar_status;
   bool m_first_receive;
+  RadarType m_spoke_format;  // Layout of the spoke headers, the radar type unless replaying
 
   wxString m_addr;  // Radar's IP address
 
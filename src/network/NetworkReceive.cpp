@@ -0,0 +1,227 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "NetworkReceive.h"
+#include "RadarFactory.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define MILLIS_PER_SELECT 250
+#define SECONDS_SELECT(x) ((x)*MILLISECONDS_PER_SECOND / MILLIS_PER_SELECT)
+
+/*
+ * Fit a spoke from the network into our geometry. The sender may have fewer spokes per
+ * rotation, then one spoke is drawn on several of ours. If it has longer spokes they are
+ * shortened by taking the strongest of each group of samples.
+ */
+void NetworkReceive::ProcessSpoke(const SpokeNetSpoke &spoke, size_t spokes) {
+  size_t len = spoke.len;
+  const uint8_t *data = spoke.data;
+
+  if (len > m_ri->m_spoke_len_max) {
+    size_t group = (len + m_ri->m_spoke_len_max - 1) / m_ri->m_spoke_len_max;
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i += group, n++) {
+      uint8_t strongest = 0;
+      for (size_t j = i; j < wxMin(i + group, len); j++) {
+        strongest = wxMax(strongest, data[j]);
+      }
+      m_line[n] = strongest;
+    }
+    len = n;
+    data = m_line;
+  }
+
+  size_t first = spoke.angle * m_ri->m_spokes / spokes;
+  size_t last = wxMax((spoke.angle + 1) * m_ri->m_spokes / spokes, first + 1);
+  int offset = (int)(spoke.bearing * m_ri->m_spokes / spokes) - (int)first;
+
+  for (size_t angle = first; angle < last; angle++) {
+    uint8_t line[NETWORK_MAX_SPOKE_LEN];
+
+    // ProcessRadarSpoke modifies the data, so give it a copy each time
+    memcpy(line, data, len);
+    m_ri->ProcessRadarSpoke(MOD_SPOKES(angle), MOD_SPOKES(angle + offset), line, len, spoke.range_meters, spoke.time);
+  }
+}
+
+void NetworkReceive::ProcessPacket(const uint8_t *data, size_t len, NetworkAddress &sender) {
+  time_t now = m_ri->GetRadarTime();
+
+  ProfiledLocker lock(m_ri->m_exclusive);
+
+  m_ri->m_statistics.packets++;
+  if (!m_decoder.Decode(data, len)) {
+    m_ri->m_statistics.broken_packets++;
+    return;
+  }
+
+  m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
+  m_ri->m_data_timeout = now + DATA_TIMEOUT;
+  m_ri->m_state.Update(RADAR_TRANSMIT);
+
+  if (m_first_receive) {
+    m_first_receive = false;
+    NetworkAddress interface_address = m_pi->GetRadarInterfaceAddress(m_ri->m_radar);
+    m_ri->DetectedRadar(interface_address, sender);
+    LOG_INFO(wxT("radar_pi: %s receiving spokes of radar %d from %s"), m_ri->m_name.c_str(), m_decoder.GetSource(),
+             FormatNetworkAddress(sender).c_str());
+  }
+  if (m_decoder.GetLostPackets() != m_lost_packets) {
+    wxCriticalSectionLocker status_lock(m_lock);
+    m_lost_packets = m_decoder.GetLostPackets();
+  }
+
+  for (size_t i = 0; i < m_decoder.GetCount(); i++) {
+    const SpokeNetSpoke &spoke = m_decoder.GetSpoke(i);
+
+    m_ri->m_statistics.spokes++;
+    if (spoke.range_meters > 0 && spoke.range_meters != m_ri->m_range.GetValue()) {
+      m_ri->m_range.Update(spoke.range_meters);
+    }
+    ProcessSpoke(spoke, m_decoder.GetSpokes());
+  }
+}
+
+/*
+ * Entry
+ *
+ * Called by wxThread when the new thread is running.
+ * It should remain running until Shutdown is called.
+ */
+void *NetworkReceive::Entry(void) {
+  int r = 0;
+  int no_data_timeout = 0;
+  SOCKET data_socket = INVALID_SOCKET;
+  NetworkAddress group(SPOKE_NET_GROUP, M_SETTINGS.spoke_network_port + m_ri->m_radar);
+  uint8_t data[65536];
+
+  LOG_VERBOSE(wxT("radar_pi: NetworkReceive thread %s starting"), m_ri->m_name.c_str());
+  TraceThreadName(m_ri->m_name + wxT(" receive"));
+
+  while (!m_shutdown) {
+    if (data_socket == INVALID_SOCKET) {
+      wxString error;
+      NetworkAddress interface_address = m_pi->GetRadarInterfaceAddress(m_ri->m_radar);
+
+      data_socket = startUDPMulticastReceiveSocket(interface_address, group, error);
+      if (data_socket == INVALID_SOCKET) {
+        SetInfoStatus(wxString::Format(wxT("%s: %s"), m_ri->m_name.c_str(), error.c_str()));
+      } else {
+        SetInfoStatus(wxString::Format(wxT("%s: %s %s"), m_ri->m_name.c_str(), _("Listening on"),
+                                       FormatNetworkAddressPort(group).c_str()));
+        no_data_timeout = 0;
+      }
+    }
+
+    struct timeval tv;
+
+    tv.tv_sec = 0;
+    tv.tv_usec = (long)(MILLIS_PER_SELECT * 1000);
+
+    fd_set fdin;
+    FD_ZERO(&fdin);
+
+    int maxFd = INVALID_SOCKET;
+    if (m_receive_socket != INVALID_SOCKET) {
+      FD_SET(m_receive_socket, &fdin);
+      maxFd = MAX(m_receive_socket, maxFd);
+    }
+    if (data_socket != INVALID_SOCKET) {
+      FD_SET(data_socket, &fdin);
+      maxFd = MAX(data_socket, maxFd);
+    }
+
+    r = select(maxFd + 1, &fdin, 0, 0, &tv);
+    if (r > 0) {
+      if (m_receive_socket != INVALID_SOCKET && FD_ISSET(m_receive_socket, &fdin)) {
+        LOG_VERBOSE(wxT("radar_pi: %s received stop instruction"), m_ri->m_name.c_str());
+        break;
+      }
+      if (data_socket != INVALID_SOCKET && FD_ISSET(data_socket, &fdin)) {
+        sockaddr_in rx_addr;
+        socklen_t rx_len = sizeof(rx_addr);
+
+        r = recvfrom(data_socket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
+        if (r > 0) {
+          NetworkAddress sender;
+          sender.addr = rx_addr.sin_addr;
+          sender.port = rx_addr.sin_port;
+          ProcessPacket(data, r, sender);
+          no_data_timeout = 0;
+        } else {
+          closesocket(data_socket);
+          data_socket = INVALID_SOCKET;
+        }
+      }
+    } else if (no_data_timeout++ >= SECONDS_SELECT(DATA_TIMEOUT) && data_socket != INVALID_SOCKET) {
+      // Nothing for a while, maybe the interface changed. Subscribe again.
+      closesocket(data_socket);
+      data_socket = INVALID_SOCKET;
+    }
+
+  }  // endless loop until thread destroy
+
+  if (data_socket != INVALID_SOCKET) {
+    closesocket(data_socket);
+  }
+
+  LOG_VERBOSE(wxT("radar_pi: %s receive thread stopping"), m_ri->m_name.c_str());
+  return 0;
+}
+
+// Called from the main thread to stop this thread.
+// We send a simple one byte message to the thread so that it awakens from the select() call with
+// this message ready for it to be read on 'm_receive_socket'. See the constructor in NetworkReceive.h
+// for the setup of these two sockets.
+
+void NetworkReceive::Shutdown() {
+  m_shutdown = true;
+  if (m_send_socket != INVALID_SOCKET) {
+    if (send(m_send_socket, "!", 1, MSG_DONTROUTE) > 0) {
+      LOG_VERBOSE(wxT("radar_pi: %s requested receive thread to stop"), m_ri->m_name.c_str());
+      return;
+    }
+  }
+  LOG_INFO(wxT("radar_pi: %s receive thread will take long time to stop"), m_ri->m_name.c_str());
+}
+
+wxString NetworkReceive::GetInfoStatus() {
+  wxCriticalSectionLocker lock(m_lock);
+  // Called on the UI thread, so be gentle
+  if (m_lost_packets > 0) {
+    return m_status + wxString::Format(wxT("\n%s %u"), _("Lost packets"), (unsigned)m_lost_packets);
+  }
+  return m_status;
+}
+
+PLUGIN_END_NAMESPACE
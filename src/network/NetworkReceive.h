@@ -0,0 +1,90 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _NETWORKRECEIVE_H_
+#define _NETWORKRECEIVE_H_
+
+#include "RadarReceive.h"
+#include "SpokeNetwork.h"
+#include "socketutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Receives spokes that another station publishes with SpokePublisher, see SpokeNetwork.h.
+//
+
+class NetworkReceive : public RadarReceive {
+ public:
+  NetworkReceive(radar_pi *pi, RadarInfo *ri) : RadarReceive(pi, ri) {
+    m_shutdown = false;
+    m_first_receive = true;
+    m_lost_packets = 0;
+    m_receive_socket = GetLocalhostServerTCPSocket();
+    m_send_socket = GetLocalhostSendTCPSocket(m_receive_socket);
+    SetInfoStatus(wxString::Format(wxT("%s: %s"), m_ri->m_name.c_str(), _("Initializing")));
+    LOG_RECEIVE(wxT("radar_pi: %s receive thread created"), m_ri->m_name.c_str());
+  };
+
+  ~NetworkReceive() {
+    closesocket(m_receive_socket);
+    closesocket(m_send_socket);
+  }
+
+  void *Entry(void);
+  void Shutdown(void);
+  wxString GetInfoStatus();
+
+ private:
+  void ProcessPacket(const uint8_t *data, size_t len, NetworkAddress &sender);
+  void ProcessSpoke(const SpokeNetSpoke &spoke, size_t spokes);
+  void SetInfoStatus(wxString status) {
+    wxCriticalSectionLocker lock(m_lock);
+    m_status = status;
+  }
+
+  volatile bool m_shutdown;
+  bool m_first_receive;
+  uint64_t m_lost_packets;
+
+  SpokePacketDecoder m_decoder;
+  uint8_t m_line[NETWORK_MAX_SPOKE_LEN];
+
+  SOCKET m_receive_socket;  // Where we listen for message from m_send_socket
+  SOCKET m_send_socket;     // A message to this socket will interrupt select() and allow immediate shutdown
+
+  wxCriticalSection m_lock;  // Protects m_status and m_lost_packets
+  wxString m_status;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _NETWORKRECEIVE_H_ */
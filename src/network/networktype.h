@@ -0,0 +1,43 @@
+#ifdef INITIALIZE_RADAR
+
+PLUGIN_BEGIN_NAMESPACE
+
+PLUGIN_END_NAMESPACE
+
+#endif
+
+// The range is set by the station that owns the radar, these are only for display
+#define RANGE_METRIC_RT_NETWORK \
+  { 50, 75, 100, 250, 500, 750, 1000, 1500, 2000, 3000, 4000, 6000, 8000, 12000, 16000, 24000, 36000, 48000, 72000 }
+#define RANGE_MIXED_RT_NETWORK                                                                                               \
+  {                                                                                                                          \
+    50, 75, 100, 1852 / 8, 1852 / 4, 1852 / 2, 1852 * 3 / 4, 1852 * 1, 1852 * 3 / 2, 1852 * 2, 1852 * 3, 1852 * 4, 1852 * 6, \
+        1852 * 8, 1852 * 12, 1852 * 16, 1852 * 24, 1852 * 36                                                                 \
+  }
+#define RANGE_NAUTIC_RT_NETWORK                                                                                             \
+  {                                                                                                                         \
+    1852 / 32, 1852 / 16, 1852 / 8, 1852 / 4, 1852 / 2, 1852 * 3 / 4, 1852 * 1, 1852 * 3 / 2, 1852 * 2, 1852 * 3, 1852 * 4, \
+        1852 * 6, 1852 * 8, 1852 * 12, 1852 * 16, 1852 * 24, 1852 * 36                                                      \
+  }
+
+// Spokes from the network are fitted into the largest geometry of any radar type
+#define NETWORK_SPOKES 2048
+#define NETWORK_MAX_SPOKE_LEN 1024
+
+#if SPOKES_MAX < NETWORK_SPOKES
+#undef SPOKES_MAX
+#define SPOKES_MAX NETWORK_SPOKES
+#endif
+#if SPOKE_LEN_MAX < NETWORK_MAX_SPOKE_LEN
+#undef SPOKE_LEN_MAX
+#define SPOKE_LEN_MAX NETWORK_MAX_SPOKE_LEN
+#endif
+
+DEFINE_RADAR(RT_NETWORK,             /* Type */
+             wxT("Network"),         /* Name */
+             NETWORK_SPOKES,         /* Spokes */
+             NETWORK_MAX_SPOKE_LEN,  /* Spoke length */
+             NetworkControlsDialog,  /* Controls class */
+             NetworkReceive(pi, ri), /* Receive class */
+             NetworkControl          /* Send/Control class */
+)
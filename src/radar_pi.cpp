@@ -30,13 +30,17 @@
  */
 
 #include "radar_pi.h"
+#include "AisMessage.h"
 #include "GuardZone.h"
 #include "GuardZoneBogey.h"
+#include "InterfaceMonitor.h"
 #include "Kalman.h"
 #include "MessageBox.h"
+#include "NmeaHeading.h"
 #include "OptionsDialog.h"
 #include "RadarMarpa.h"
 #include "SelectDialog.h"
+#include "SpokeNetwork.h"
 #include "icons.h"
 #include "nmea0183/nmea0183.h"
 
@@ -45,6 +49,8 @@ PLUGIN_BEGIN_NAMESPACE
 #undef M_SETTINGS
 #define M_SETTINGS m_settings
 
+#define LOCK_PROFILE_MILLIS (10000)  // How often the lock profile is logged
+
 // the class factories, used to create and destroy instances of the PlugIn
 
 extern "C" DECL_EXP opencpn_plugin *create_pi(void *ppimgr) { return new radar_pi(ppimgr); }
@@ -120,9 +126,11 @@ END_EVENT_TABLE()
 //
 //---------------------------------------------------------------------------------------------------------
 
-radar_pi::radar_pi(void *ppimgr) : opencpn_plugin_114(ppimgr) {
+radar_pi::radar_pi(void *ppimgr) : opencpn_plugin_114(ppimgr), m_exclusive(LOCK_RADAR_PI) {
   m_boot_time = wxGetUTCTimeMillis();
   m_initialized = false;
+  m_init_pending = false;
+  m_init_nanos = 0;
 
   // Create the PlugIn icons
   initialize_images();
@@ -147,10 +155,11 @@ radar_pi::~radar_pi() {}
  */
 
 int radar_pi::Init(void) {
-  if (m_initialized) {
+  if (m_initialized || m_init_pending) {
     // Whoops, shouldn't happen
     return PLUGIN_OPTIONS;
   }
+  m_init_nanos = GetLatencyNanos();
 
   if (m_first_init) {
 #ifdef __WXMSW__
@@ -172,7 +181,9 @@ int radar_pi::Init(void) {
     m_first_init = false;
   }
 
-  time_t now = time(0);
+  StartAsyncLog();
+
+  time_t now = GetRadarTime();
 
   // Font can change so initialize every time
   m_font = GetOCPNGUIScaledFont_PlugIn(_T("Dialog"));
@@ -185,6 +196,8 @@ int radar_pi::Init(void) {
   m_bpos_set = false;
   m_ownship.lat = nan("");
   m_ownship.lon = nan("");
+  m_ownship_sog = nan("");
+  m_ownship_cog = nan("");
   m_cursor_pos.lat = nan("");
   m_cursor_pos.lon = nan("");
 
@@ -252,6 +265,14 @@ int radar_pi::Init(void) {
     LOG_RECEIVE(wxT("radar_pi: RECEIVE  log is enabled"));
     LOG_GUARD(wxT("radar_pi: GUARD    log is enabled"));
     LOG_ARPA(wxT("radar_pi: ARPA     log is enabled"));
+    if (!m_settings.trace_file.IsEmpty()) {
+      LOG_INFO(wxT("radar_pi: tracing processing stages to %s"), m_settings.trace_file.c_str());
+      StartTrace();
+    }
+    if (m_settings.lock_profile || m_settings.stress_radars > 0) {
+      LOG_INFO(wxT("radar_pi: profiling the shared locks with %d radars"), (int)m_settings.radar_count);
+      EnableLockProfile(true);
+    }
   } else {
     wxLogError(wxT("radar_pi: configuration file values initialisation failed"));
     return 0;  // give up
@@ -264,6 +285,7 @@ int radar_pi::Init(void) {
   wxString svg_toggled = m_shareLocn + wxT("radar_active.svg");
   m_tool_id = InsertPlugInToolSVG(wxT("Radar"), svg_normal, svg_rollover, svg_toggled, wxITEM_NORMAL, wxT("Radar"),
                                   _("Radar plugin with support for multiple radars"), NULL, RADAR_TOOL_POSITION, 0, this);
+  LOG_INFO(wxT("radar_pi: toolbar icon %.1f ms after Init"), (GetLatencyNanos() - m_init_nanos) / 1e6);
 
   // CacheSetToolbarToolBitmaps(BM_ID_RED, BM_ID_BLANK);
 
@@ -303,22 +325,46 @@ int radar_pi::Init(void) {
               m_settings.chart_overlay);
 
   m_notify_time_ms = 0;
+  m_lock_profile_time_ms = 0;
   m_timer = new wxTimer(this, TIMER_ID);
 
-  // Now that the settings are made we can initialize the RadarInfos
-  for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
-    m_radar[r]->Init();
-  }
   for (size_t r = M_SETTINGS.radar_count; r < RADARS; r++) {
     delete m_radar[r];
     m_radar[r] = 0;
   }
 
+  // OpenCPN waits for every plugin's Init() before it shows its window, so the radars themselves
+  // are started by FinishInit() from the first timer event, once OpenCPN runs its event loop.
+  m_init_pending = true;
+  m_timer->StartOnce(1);
+  LOG_INFO(wxT("radar_pi: Init took %.1f ms"), (GetLatencyNanos() - m_init_nanos) / 1e6);
+
+  return PLUGIN_OPTIONS;
+}
+
+/**
+ * The part of Init() that can wait: the receive threads, buffers and windows of the radars.
+ * The windows themselves are only made when they are first shown.
+ */
+void radar_pi::FinishInit() {
+  if (!m_init_pending) {
+    return;
+  }
+  m_init_pending = false;
+
+  // Shared by the receive threads, so it must exist before the first one starts
+  StartInterfaceMonitor();
+
+  // Now that the settings are made we can initialize the RadarInfos
+  for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
+    m_radar[r]->Init();
+  }
+
   m_initialized = true;
   SetRadarWindowViz();
   TimedControlUpdate();
-
-  return PLUGIN_OPTIONS;
+  LOG_INFO(wxT("radar_pi: %d radars initialized %.1f ms after Init"), (int)M_SETTINGS.radar_count,
+           (GetLatencyNanos() - m_init_nanos) / 1e6);
 }
 
 /**
@@ -328,13 +374,17 @@ int radar_pi::Init(void) {
  */
 
 bool radar_pi::DeInit(void) {
-  if (!m_initialized) {
+  // When FinishInit() has not run yet the radars were never started, so there is less to stop
+  bool radars_started = m_initialized;
+
+  if (!m_initialized && !m_init_pending) {
     return false;
   }
 
   LOG_VERBOSE(wxT("radar_pi: DeInit of plugin"));
 
   m_initialized = false;
+  m_init_pending = false;
 
   if (m_timer) {
     m_timer->Stop();
@@ -345,8 +395,17 @@ bool radar_pi::DeInit(void) {
   // Stop processing in all radars.
   // This waits for the receive threads to stop and removes the dialog, so that its settings
   // can be saved.
-  for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
-    m_radar[r]->Shutdown();
+  if (radars_started) {
+    for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
+      m_radar[r]->Shutdown();
+    }
+  }
+
+  if (g_trace_enabled) {
+    TraceEnable(false);
+    if (!m_settings.trace_file.IsEmpty() && !WriteChromeTrace(m_settings.trace_file)) {
+      wxLogError(wxT("radar_pi: cannot write trace to %s"), m_settings.trace_file.c_str());
+    }
   }
 
   if (m_bogey_dialog) {
@@ -362,8 +421,13 @@ bool radar_pi::DeInit(void) {
     m_radar[r] = 0;
   }
 
+  if (radars_started) {
+    StopInterfaceMonitor();  // The receive threads have stopped
+  }
+
   // No need to delete wxWindow stuff, wxWidgets does this for us.
   LOG_VERBOSE(wxT("radar_pi: DeInit of plugin done"));
+  StopAsyncLog();
   return true;
 }
 
@@ -464,6 +528,7 @@ bool radar_pi::IsRadarSelectionComplete(bool force) {
 
 void radar_pi::ShowPreferencesDialog(wxWindow *parent) {
   LOG_DIALOG(wxT("radar_pi: ShowPreferencesDialog"));
+  FinishInit();
 
   bool oldShow = M_SETTINGS.show;
   M_SETTINGS.show = 0;
@@ -480,7 +545,7 @@ void radar_pi::ShowPreferencesDialog(wxWindow *parent) {
           m_radar[r]->UpdateControlState(true);
         }
         if (!m_guard_bogey_confirmed && m_alarm_sound_timeout && m_settings.guard_zone_timeout) {
-          m_alarm_sound_timeout = time(0) + m_settings.guard_zone_timeout;
+          m_alarm_sound_timeout = GetRadarTime() + m_settings.guard_zone_timeout;
         }
       }
       m_settings.reset_radars = false;
@@ -718,7 +783,7 @@ void radar_pi::PassHeadingToOpenCPN() {
  */
 void radar_pi::CheckGuardZoneBogeys(void) {
   bool bogeys_found = false;
-  time_t now = time(0);
+  time_t now = GetRadarTime();
   wxString text;
 
   for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
@@ -729,7 +794,7 @@ void radar_pi::CheckGuardZoneBogeys(void) {
     if (m_radar[r]->m_state.GetValue() == RADAR_TRANSMIT) {
       bool bogeys_found_this_radar = false;
 
-      for (size_t z = 0; z < GUARD_ZONES; z++) {
+      for (size_t z = 0; z < m_radar[r]->m_guard_zone_count; z++) {
         int bogeys = m_radar[r]->m_guard_zone[z]->GetBogeyCount();
         if (bogeys > m_settings.guard_zone_threshold) {
           bogeys_found = true;
@@ -747,6 +812,14 @@ void radar_pi::CheckGuardZoneBogeys(void) {
         }
         text << wxT("\n");
       }
+      if (m_settings.arpa_cpa_alarm > 0. && m_radar[r]->m_arpa) {
+        int dangerous = m_radar[r]->m_arpa->GetDangerousTargetCount();
+        if (dangerous > 0) {
+          bogeys_found = true;
+          bogeys_found_this_radar = true;
+          text << _(" CPA") << wxT(": ") << dangerous << wxT("\n");
+        }
+      }
       LOG_GUARD(wxT("radar_pi: Radar %c: CheckGuardZoneBogeys found=%d confirmed=%d"), r + 'A', bogeys_found_this_radar,
                 m_guard_bogey_confirmed);
     }
@@ -793,10 +866,10 @@ void radar_pi::CheckGuardZoneBogeys(void) {
 }
 
 void radar_pi::SetRadarHeading(double heading, bool isTrue) {
-  wxCriticalSectionLocker lock(m_exclusive);
+  ProfiledLocker lock(m_exclusive);
   m_radar_heading = heading;
   m_radar_heading_true = isTrue;
-  time_t now = time(0);
+  time_t now = GetRadarTime();
   if (!wxIsNaN(m_radar_heading)) {
     if (m_radar_heading_true) {
       if (m_heading_source != HEADING_RADAR_HDT) {
@@ -824,13 +897,15 @@ void radar_pi::SetRadarHeading(double heading, bool isTrue) {
 
 void radar_pi::UpdateHeadingPositionState() {
   {
-    wxCriticalSectionLocker lock(m_exclusive);
-    time_t now = time(0);
+    ProfiledLocker lock(m_exclusive);
+    time_t now = GetRadarTime();
 
     if (m_bpos_set && TIMED_OUT(now, m_bpos_timestamp + WATCHDOG_TIMEOUT)) {
       // If the position data is 10s old reset our position.
       // Note that the watchdog is reset every time we receive a position.
       m_bpos_set = false;
+      m_ownship_sog = nan("");
+      m_ownship_cog = nan("");
       LOG_VERBOSE(wxT("radar_pi: Lost Boat Position data"));
     }
 
@@ -910,6 +985,10 @@ void radar_pi::ScheduleWindowRefresh() {
 }
 
 void radar_pi::OnTimerNotify(wxTimerEvent &event) {
+  if (m_init_pending) {
+    FinishInit();
+    return;
+  }
   if (m_settings.show) {  // Is radar enabled?
     if (m_settings.chart_overlay >= 0) {
       // If overlay is enabled schedule another chart draw. Note this will cause another call to RenderGLOverlay,
@@ -956,6 +1035,11 @@ void radar_pi::TimedControlUpdate() {
       m_radar[r]->m_arpa->RadarLost();
     }
     m_radar[r]->UpdateTransmitState();
+    m_radar[r]->UpdateConsumers();
+    m_radar[r]->UpdateStream();
+    for (size_t z = 0; z < m_radar[r]->m_guard_zone_count; z++) {
+      m_radar[r]->m_guard_zone[z]->UpdateIntervals();
+    }
   }
 
   if (any_data_seen && m_settings.show) {
@@ -966,18 +1050,48 @@ void radar_pi::TimedControlUpdate() {
     PassHeadingToOpenCPN();
   }
 
+  if (g_lock_profile && TIMED_OUT(now, m_lock_profile_time_ms + LOCK_PROFILE_MILLIS)) {
+    m_lock_profile_time_ms = now;
+    m_lock_profile = GetLockProfile();
+
+    wxString t = m_lock_profile;
+    t.Replace(wxT("\n"), wxT(" "));
+    LOG_INFO(wxT("radar_pi: %s"), t.c_str());
+
+    if (m_settings.stress_radars > 0) {
+      size_t buffers = g_shared_memory.GetTotal();
+      for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
+        buffers += m_radar[r]->m_memory.GetTotal();
+      }
+      LOG_INFO(wxT("radar_pi: %d radars hold %.1f MB of buffers, process resident %.1f MB"), m_settings.stress_radars,
+               buffers / (1024. * 1024.), GetResidentMemory() / (1024. * 1024.));
+    }
+  }
+
   if (m_pMessageBox->IsShown() || (m_settings.verbose != 0)) {
     wxString t;
     for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
       if (m_radar[r]->m_state.GetValue() != RADAR_OFF) {
-        wxCriticalSectionLocker lock(m_radar[r]->m_exclusive);
+        ProfiledLocker lock(m_radar[r]->m_exclusive);
 
         t << wxString::Format(wxT("%s\npackets %d/%d\nspokes %d/%d/%d\n"), m_radar[r]->m_name.c_str(),
                               m_radar[r]->m_statistics.packets, m_radar[r]->m_statistics.broken_packets,
                               m_radar[r]->m_statistics.spokes, m_radar[r]->m_statistics.broken_spokes,
                               m_radar[r]->m_statistics.missing_spokes);
+        t << m_radar[r]->m_latency.GetSummary();
+        t << m_radar[r]->m_consumers.GetSummary();
+        t << m_radar[r]->m_governor.GetSummary();
+        t << m_radar[r]->m_memory.GetSummary();
       }
     }
+    t << wxT("shared ") << g_shared_memory.GetSummary();
+    size_t resident = GetResidentMemory();
+    if (resident > 0) {
+      t << wxString::Format(wxT("process %.1f MB\n"), resident / (1024. * 1024.));
+    }
+    if (g_lock_profile) {
+      t << m_lock_profile;
+    }
     m_pMessageBox->SetStatisticsInfo(t);
     if (t.length() > 0) {
       t.Replace(wxT("\n"), wxT(" "));
@@ -987,13 +1101,20 @@ void radar_pi::TimedControlUpdate() {
 
   // Always reset the counters, so they don't show huge numbers after IsShown changes
   for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
-    wxCriticalSectionLocker lock(m_radar[r]->m_exclusive);
+    ProfiledLocker lock(m_radar[r]->m_exclusive);
 
     m_radar[r]->m_statistics.broken_packets = 0;
     m_radar[r]->m_statistics.broken_spokes = 0;
     m_radar[r]->m_statistics.missing_spokes = 0;
     m_radar[r]->m_statistics.packets = 0;
     m_radar[r]->m_statistics.spokes = 0;
+    DegradeLevel level = m_radar[r]->m_governor.GetLevel();
+    m_radar[r]->m_governor.Update(
+        m_radar[r]->m_latency.GetTotal(LATENCY_SPOKE) + m_radar[r]->m_latency.GetTotal(LATENCY_RENDER), GetLatencyNanos());
+    if (m_radar[r]->m_governor.GetLevel() != level) {
+      LOG_INFO(wxT("radar_pi: %s %s"), m_radar[r]->m_name.c_str(), m_radar[r]->m_governor.GetSummary().Trim().c_str());
+    }
+    m_radar[r]->m_latency.NextInterval();
   }
 
   wxString info;
@@ -1097,6 +1218,7 @@ bool radar_pi::RenderOverlay(wxDC &dc, PlugIn_ViewPort *vp) {
 // Called by Plugin Manager on main system process cycle
 
 bool radar_pi::RenderGLOverlay(wxGLContext *pcontext, PlugIn_ViewPort *vp) {
+  TRACE_SCOPE("RenderGLOverlay");
   GeoPosition radar_pos;
 
   if (!m_initialized) {
@@ -1113,9 +1235,9 @@ bool radar_pi::RenderGLOverlay(wxGLContext *pcontext, PlugIn_ViewPort *vp) {
   SetOpenGLMode(OPENGL_ON);
 
   if (vp->rotation != m_vp_rotation) {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
 
-    m_cog_timeout = time(0) + m_COGAvgSec;
+    m_cog_timeout = GetRadarTime() + m_COGAvgSec;
     m_cog = m_COGAvg;
     m_vp_rotation = vp->rotation;
   }
@@ -1164,8 +1286,63 @@ bool radar_pi::RenderGLOverlay(wxGLContext *pcontext, PlugIn_ViewPort *vp) {
   return true;
 }
 
+/*
+ * Write the latency histograms of all radars to a CSV file, see RadarLatency::Export().
+ */
+bool radar_pi::ExportLatency(const wxString &filename) {
+  FILE *f = wxFopen(filename, wxT("w"));
+
+  if (!f) {
+    wxLogError(wxT("radar_pi: cannot write latency histograms to %s"), filename.c_str());
+    return false;
+  }
+  fprintf(f, "radar,stage,from_us,to_us,count\n");
+  for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
+    m_radar[r]->m_latency.Export(f, m_radar[r]->m_name);
+  }
+  fclose(f);
+  LOG_INFO(wxT("radar_pi: latency histograms written to %s"), filename.c_str());
+  return true;
+}
+
+void radar_pi::StartTrace() {
+  TraceThreadName(wxT("main"));
+  TraceEnable(true);
+}
+
+/*
+ * Write the stages traced so far to a Chrome trace file, see WriteChromeTrace(). Tracing is
+ * paused while the buffers are written, so that the events are not overwritten halfway.
+ */
+bool radar_pi::ExportTrace(const wxString &filename) {
+  TraceEnable(false);
+  bool written = WriteChromeTrace(filename);
+  TraceEnable(true);
+
+  if (!written) {
+    wxLogError(wxT("radar_pi: cannot write trace to %s"), filename.c_str());
+    return false;
+  }
+  LOG_INFO(wxT("radar_pi: trace written to %s"), filename.c_str());
+  return true;
+}
+
 //****************************************************************************
 
+// Parse "bearing/range;bearing/range;..." into polygon, returns the number of corners
+static size_t ParseGuardZonePolygon(wxString s, GuardZoneVertex *polygon) {
+  size_t n = 0;
+
+  while (!s.IsEmpty() && n < GUARD_ZONE_POLYGON_MAX) {
+    wxString corner = s.BeforeFirst(wxT(';'));
+    s = s.AfterFirst(wxT(';'));
+    if (corner.BeforeFirst(wxT('/')).ToDouble(&polygon[n].bearing) && corner.AfterFirst(wxT('/')).ToDouble(&polygon[n].range)) {
+      n++;
+    }
+  }
+  return n;
+}
+
 bool radar_pi::LoadConfig(void) {
   wxFileConfig *pConf = m_pconfig;
   int v, x, y, state;
@@ -1190,10 +1367,29 @@ bool radar_pi::LoadConfig(void) {
     pConf->Read(wxT("RadarCount"), &v, 0);
     M_SETTINGS.radar_count = v;
 
+    // In a stress test all radars are emulators, or replays when there is something to replay, that transmit
+    pConf->Read(wxT("StressRadars"), &m_settings.stress_radars, 0);
+    m_settings.stress_radars = wxMax(wxMin(m_settings.stress_radars, RADARS), 0);
+    pConf->Read(wxT("LockProfile"), &m_settings.lock_profile, false);
+    RadarType stress_type = RT_EMULATOR;
+    if (m_settings.stress_radars > 0) {
+      M_SETTINGS.radar_count = m_settings.stress_radars;
+      pConf->Read(wxT("ReplayFile"), &s, wxT(""));
+      if (!s.IsEmpty()) {
+        stress_type = RT_REPLAY;
+      }
+    }
+
+    pConf->Read(wxT("GuardZoneCount"), &m_settings.guard_zone_count, GUARD_ZONES);
+    m_settings.guard_zone_count = wxMax(wxMin(m_settings.guard_zone_count, GUARD_ZONES_MAX), GUARD_ZONES);
+
     size_t n = 0;
     for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
       RadarInfo *ri = m_radar[n];
       pConf->Read(wxString::Format(wxT("Radar%dType"), r), &s, "unknown");
+      if (m_settings.stress_radars > 0) {
+        s = RadarTypeName[stress_type];
+      }
       ri->m_radar_type = RT_MAX;  // = not used
       for (int i = 0; i < RT_MAX; i++) {
         if (s.IsSameAs(RadarTypeName[i])) {
@@ -1217,6 +1413,9 @@ bool radar_pi::LoadConfig(void) {
       }
       ri->m_orientation.Update(v);
       pConf->Read(wxString::Format(wxT("Radar%dTransmit"), r), &v, 0);
+      if (m_settings.stress_radars > 0) {
+        v = RADAR_TRANSMIT;
+      }
       ri->m_boot_state.Update(v);
       pConf->Read(wxString::Format(wxT("Radar%dMinContourLength"), r), &ri->m_min_contour_length, 6);
       if (ri->m_min_contour_length > 10) ri->m_min_contour_length = 6;  // Prevent user and system error
@@ -1237,6 +1436,9 @@ bool radar_pi::LoadConfig(void) {
       m_radar[r]->m_timed_run.Update(v);
 
       pConf->Read(wxString::Format(wxT("Radar%dWindowShow"), r), &m_settings.show_radar[n], n ? false : true);
+      if (m_settings.stress_radars > 0) {
+        m_settings.show_radar[n] = true;  // So that drawing takes part in the test
+      }
       pConf->Read(wxString::Format(wxT("Radar%dWindowPosX"), r), &x, 30 + 540 * n);
       pConf->Read(wxString::Format(wxT("Radar%dWindowPosY"), r), &y, 120);
       m_settings.window_pos[n] = wxPoint(x, y);
@@ -1248,7 +1450,8 @@ bool radar_pi::LoadConfig(void) {
       pConf->Read(wxString::Format(wxT("Radar%dControlPosY"), r), &y, wxDefaultPosition.y);
       m_settings.control_pos[n] = wxPoint(x, y);
       LOG_DIALOG(wxT("radar_pi: LoadConfig: show_radar[%d]=%d control=%d,%d"), n, v, x, y);
-      for (int i = 0; i < GUARD_ZONES; i++) {
+      ri->SetGuardZoneCount(m_settings.guard_zone_count);
+      for (size_t i = 0; i < ri->m_guard_zone_count; i++) {
         pConf->Read(wxString::Format(wxT("Radar%dZone%dStartBearing"), r, i), &ri->m_guard_zone[i]->m_start_bearing, 0);
         pConf->Read(wxString::Format(wxT("Radar%dZone%dEndBearing"), r, i), &ri->m_guard_zone[i]->m_end_bearing, 0);
         pConf->Read(wxString::Format(wxT("Radar%dZone%dOuterRange"), r, i), &ri->m_guard_zone[i]->m_outer_range, 0);
@@ -1257,6 +1460,14 @@ bool radar_pi::LoadConfig(void) {
         pConf->Read(wxString::Format(wxT("Radar%dZone%dAlarmOn"), r, i), &ri->m_guard_zone[i]->m_alarm_on, 0);
         pConf->Read(wxString::Format(wxT("Radar%dZone%dArpaOn"), r, i), &ri->m_guard_zone[i]->m_arpa_on, 0);
         ri->m_guard_zone[i]->SetType((GuardZoneType)v);
+        if (v == GZ_POLYGON && i >= GUARD_ZONES) {
+          // Polygon zones are not editable in the controls dialog, they are only set here
+          // as "bearing/range;bearing/range;..." in degrees relative to the bow and meters.
+          pConf->Read(wxString::Format(wxT("Radar%dZone%dPolygon"), r, i), &s, wxT(""));
+          GuardZoneVertex polygon[GUARD_ZONE_POLYGON_MAX];
+          size_t corners = ParseGuardZonePolygon(s, polygon);
+          ri->m_guard_zone[i]->SetPolygon(polygon, corners);
+        }
       }
       pConf->Read(wxT("AlarmPosX"), &x, 25);
       pConf->Read(wxT("AlarmPosY"), &y, 175);
@@ -1264,6 +1475,8 @@ bool radar_pi::LoadConfig(void) {
       pConf->Read(wxT("EnableCOGHeading"), &m_settings.enable_cog_heading, false);
       pConf->Read(wxT("AISatARPAoffset"), &m_settings.AISatARPAoffset, 50);
       if (m_settings.AISatARPAoffset < 10 || m_settings.AISatARPAoffset > 300) m_settings.AISatARPAoffset = 50;
+      pConf->Read(wxT("ArpaCPAAlarm"), &m_settings.arpa_cpa_alarm, 0.0);
+      pConf->Read(wxT("ArpaTCPAAlarm"), &m_settings.arpa_tcpa_alarm, 12);
 
       n++;
     }
@@ -1271,6 +1484,26 @@ bool radar_pi::LoadConfig(void) {
 
     pConf->Read(wxT("AlertAudioFile"), &m_settings.alert_audio_file, m_shareLocn + wxT("alarm.wav"));
     pConf->Read(wxT("ChartOverlay"), &m_settings.chart_overlay, 0);
+    pConf->Read(wxT("StreamPort"), &m_settings.stream_port, 0);
+    pConf->Read(wxT("StreamAllInterfaces"), &m_settings.stream_all_interfaces, false);
+    pConf->Read(wxT("SpokePublish"), &m_settings.spoke_publish, false);
+    pConf->Read(wxT("SpokeNetworkPort"), &m_settings.spoke_network_port, SPOKE_NET_PORT);
+    pConf->Read(wxT("RecordDirectory"), &m_settings.record_directory, wxT(""));
+    pConf->Read(wxT("ReplayFile"), &m_settings.replay_file, wxT(""));
+    pConf->Read(wxT("ReplaySpeed"), &m_settings.replay_speed, 1);
+    pConf->Read(wxT("TraceFile"), &m_settings.trace_file, wxT(""));
+    pConf->Read(wxT("EmulatorSpokes"), &m_settings.emulator_spokes, EMULATOR_DEFAULT_SPOKES);
+    m_settings.emulator_spokes = wxMax(wxMin(m_settings.emulator_spokes, EMULATOR_SPOKES), 360);
+    pConf->Read(wxT("EmulatorSpokeLen"), &m_settings.emulator_spoke_len, EMULATOR_DEFAULT_SPOKE_LEN);
+    m_settings.emulator_spoke_len = wxMax(wxMin(m_settings.emulator_spoke_len, EMULATOR_MAX_SPOKE_LEN), 128);
+    pConf->Read(wxT("EmulatorRPM"), &m_settings.emulator_rpm, 24);
+    m_settings.emulator_rpm = wxMax(m_settings.emulator_rpm, 0);
+    pConf->Read(wxT("EmulatorPointTargets"), &m_settings.emulator_point_targets, 20);
+    pConf->Read(wxT("EmulatorExtendedTargets"), &m_settings.emulator_extended_targets, 4);
+    pConf->Read(wxT("EmulatorClutter"), &m_settings.emulator_clutter, 30);
+    pConf->Read(wxT("EmulatorSpeed"), &m_settings.emulator_speed, 6.0);
+    pConf->Read(wxT("EmulatorTurnRate"), &m_settings.emulator_turn_rate, 0.0);
+    pConf->Read(wxT("EmulatorNMEA"), &m_settings.emulator_nmea, false);
     pConf->Read(wxT("ColourStrong"), &s, "red");
     m_settings.strong_colour = wxColour(s);
     pConf->Read(wxT("ColourIntermediate"), &s, "green");
@@ -1325,6 +1558,10 @@ bool radar_pi::LoadConfig(void) {
 bool radar_pi::SaveConfig(void) {
   wxFileConfig *pConf = m_pconfig;
 
+  if (m_settings.stress_radars > 0) {
+    LOG_INFO(wxT("radar_pi: stress test, configuration is not saved"));
+    return true;
+  }
   if (pConf) {
     pConf->DeleteGroup(wxT("/Plugins/Radar"));
     pConf->SetPath(wxT("/Plugins/Radar"));
@@ -1340,6 +1577,7 @@ bool radar_pi::SaveConfig(void) {
     pConf->Write(wxT("GuardZoneOnOverlay"), m_settings.guard_zone_on_overlay);
     pConf->Write(wxT("OverlayStandby"), m_settings.overlay_on_standby);
     pConf->Write(wxT("GuardZoneTimeout"), m_settings.guard_zone_timeout);
+    pConf->Write(wxT("GuardZoneCount"), m_settings.guard_zone_count);
     pConf->Write(wxT("GuardZonesRenderStyle"), m_settings.guard_zone_render_style);
     pConf->Write(wxT("GuardZonesThreshold"), m_settings.guard_zone_threshold);
     pConf->Write(wxT("IgnoreRadarHeading"), m_settings.ignore_radar_heading);
@@ -1361,6 +1599,25 @@ bool radar_pi::SaveConfig(void) {
     pConf->Write(wxT("Transparency"), m_settings.overlay_transparency.GetValue());
     pConf->Write(wxT("VerboseLog"), m_settings.verbose);
     pConf->Write(wxT("AISatARPAoffset"), m_settings.AISatARPAoffset);
+    pConf->Write(wxT("ArpaCPAAlarm"), m_settings.arpa_cpa_alarm);
+    pConf->Write(wxT("ArpaTCPAAlarm"), m_settings.arpa_tcpa_alarm);
+    pConf->Write(wxT("StreamPort"), m_settings.stream_port);
+    pConf->Write(wxT("StreamAllInterfaces"), m_settings.stream_all_interfaces);
+    pConf->Write(wxT("SpokePublish"), m_settings.spoke_publish);
+    pConf->Write(wxT("SpokeNetworkPort"), m_settings.spoke_network_port);
+    pConf->Write(wxT("RecordDirectory"), m_settings.record_directory);
+    pConf->Write(wxT("ReplayFile"), m_settings.replay_file);
+    pConf->Write(wxT("ReplaySpeed"), m_settings.replay_speed);
+    pConf->Write(wxT("TraceFile"), m_settings.trace_file);
+    pConf->Write(wxT("EmulatorSpokes"), m_settings.emulator_spokes);
+    pConf->Write(wxT("EmulatorSpokeLen"), m_settings.emulator_spoke_len);
+    pConf->Write(wxT("EmulatorRPM"), m_settings.emulator_rpm);
+    pConf->Write(wxT("EmulatorPointTargets"), m_settings.emulator_point_targets);
+    pConf->Write(wxT("EmulatorExtendedTargets"), m_settings.emulator_extended_targets);
+    pConf->Write(wxT("EmulatorClutter"), m_settings.emulator_clutter);
+    pConf->Write(wxT("EmulatorSpeed"), m_settings.emulator_speed);
+    pConf->Write(wxT("EmulatorTurnRate"), m_settings.emulator_turn_rate);
+    pConf->Write(wxT("EmulatorNMEA"), m_settings.emulator_nmea);
     pConf->Write(wxT("ColourStrong"), m_settings.strong_colour.GetAsString());
     pConf->Write(wxT("ColourIntermediate"), m_settings.intermediate_colour.GetAsString());
     pConf->Write(wxT("ColourWeak"), m_settings.weak_colour.GetAsString());
@@ -1396,7 +1653,7 @@ bool radar_pi::SaveConfig(void) {
       pConf->Write(wxString::Format(wxT("Radar%dRunTimeOnIdle"), r), m_radar[r]->m_timed_run.GetValue());
 
       // LOG_DIALOG(wxT("radar_pi: SaveConfig: show_radar[%d]=%d"), r, m_settings.show_radar[r]);
-      for (int i = 0; i < GUARD_ZONES; i++) {
+      for (size_t i = 0; i < m_radar[r]->m_guard_zone_count; i++) {
         pConf->Write(wxString::Format(wxT("Radar%dZone%dStartBearing"), r, i), m_radar[r]->m_guard_zone[i]->m_start_bearing);
         pConf->Write(wxString::Format(wxT("Radar%dZone%dEndBearing"), r, i), m_radar[r]->m_guard_zone[i]->m_end_bearing);
         pConf->Write(wxString::Format(wxT("Radar%dZone%dOuterRange"), r, i), m_radar[r]->m_guard_zone[i]->m_outer_range);
@@ -1404,6 +1661,15 @@ bool radar_pi::SaveConfig(void) {
         pConf->Write(wxString::Format(wxT("Radar%dZone%dType"), r, i), (int)m_radar[r]->m_guard_zone[i]->m_type);
         pConf->Write(wxString::Format(wxT("Radar%dZone%dAlarmOn"), r, i), m_radar[r]->m_guard_zone[i]->m_alarm_on);
         pConf->Write(wxString::Format(wxT("Radar%dZone%dArpaOn"), r, i), m_radar[r]->m_guard_zone[i]->m_arpa_on);
+        if (m_radar[r]->m_guard_zone[i]->m_type == GZ_POLYGON) {
+          GuardZoneVertex polygon[GUARD_ZONE_POLYGON_MAX];
+          size_t corners = m_radar[r]->m_guard_zone[i]->GetPolygon(polygon);
+          wxString text;
+          for (size_t c = 0; c < corners; c++) {
+            text << wxString::Format(c ? wxT(";%g/%g") : wxT("%g/%g"), polygon[c].bearing, polygon[c].range);
+          }
+          pConf->Write(wxString::Format(wxT("Radar%dZone%dPolygon"), r, i), text);
+        }
       }
     }
 
@@ -1419,9 +1685,9 @@ bool radar_pi::SaveConfig(void) {
 void radar_pi::SetPositionFix(PlugIn_Position_Fix &pfix) {}
 
 void radar_pi::SetPositionFixEx(PlugIn_Position_Fix_Ex &pfix) {
-  wxCriticalSectionLocker lock(m_exclusive);
+  ProfiledLocker lock(m_exclusive);
 
-  time_t now = time(0);
+  time_t now = GetRadarTime();
   wxString info;
   if (m_var_source <= VARIATION_SOURCE_FIX && !wxIsNaN(pfix.Var) && (fabs(pfix.Var) > 0.0 || m_var == 0.0)) {
     if (m_var_source < VARIATION_SOURCE_FIX || fabs(pfix.Var - m_var) > 0.05) {
@@ -1472,6 +1738,8 @@ void radar_pi::SetPositionFixEx(PlugIn_Position_Fix_Ex &pfix) {
   if (pfix.FixTime > 0 && NOT_TIMED_OUT(now, pfix.FixTime + WATCHDOG_TIMEOUT)) {
     m_ownship.lat = pfix.Lat;
     m_ownship.lon = pfix.Lon;
+    m_ownship_sog = pfix.Sog;
+    m_ownship_cog = pfix.Cog;
 
     if (!m_bpos_set) {
       LOG_VERBOSE(wxT("radar_pi: GPS position is now known"));
@@ -1489,6 +1757,31 @@ void radar_pi::SetPositionFixEx(PlugIn_Position_Fix_Ex &pfix) {
   }
 }
 
+/**
+ * Own ship velocity over ground, as north and east components in m/s.
+ * Returns false when there is no recent position fix with SOG (and COG when moving).
+ */
+bool radar_pi::GetOwnShipVelocity(double *dlat_dt, double *dlon_dt) {
+  ProfiledLocker lock(m_exclusive);
+
+  if (!m_bpos_set || wxIsNaN(m_ownship_sog)) {
+    return false;
+  }
+  double speed = m_ownship_sog * 1852. / 3600.;
+  if (wxIsNaN(m_ownship_cog)) {
+    // Some GPS units send no COG at all when not moving
+    if (m_ownship_sog > 0.1) {
+      return false;
+    }
+    *dlat_dt = 0.;
+    *dlon_dt = 0.;
+    return true;
+  }
+  *dlat_dt = speed * cos(deg2rad(m_ownship_cog));
+  *dlon_dt = speed * sin(deg2rad(m_ownship_cog));
+  return true;
+}
+
 void radar_pi::UpdateCOGAvg(double cog) {
   // This is a straight copy (except for formatting) of the code in
   // OpenCPN/src/chart1.cpp MyFrame::PostProcessNNEA
@@ -1536,7 +1829,7 @@ void radar_pi::SetPluginMessage(wxString &message_id, wxString &message_body) {
     wxJSONReader reader;
     wxJSONValue message;
     if (!reader.Parse(message_body, &message)) {
-      wxCriticalSectionLocker lock(m_exclusive);
+      ProfiledLocker lock(m_exclusive);
       wxJSONValue defaultValue(360);
       double variation = message.Get(_T("Decl"), defaultValue).AsDouble();
 
@@ -1546,7 +1839,7 @@ void radar_pi::SetPluginMessage(wxString &message_id, wxString &message_body) {
         }
         m_var = variation;
         m_var_source = VARIATION_SOURCE_WMM;
-        m_var_timeout = time(0) + WATCHDOG_TIMEOUT;
+        m_var_timeout = GetRadarTime() + WATCHDOG_TIMEOUT;
         if (m_pMessageBox->IsShown()) {
           info = _("WMM");
           info << wxT(" ") << wxString::Format(wxT("%2.1f"), m_var);
@@ -1554,83 +1847,63 @@ void radar_pi::SetPluginMessage(wxString &message_id, wxString &message_body) {
         }
       }
     }
-  } else if (message_id == wxS("AIS") || m_ais_in_arpa_zone.size() > 0) {
+  } else if (message_id == wxS("AIS") || m_ais_in_arpa_zone.GetCount() > 0) {
     // Check for ARPA targets
     bool arpa_is_present = false;
     for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
-      if (m_radar[r]->m_arpa->GetTargetCount() > 0) {
+      if (m_radar[r]->m_arpa && m_radar[r]->m_arpa->GetTargetCount() > 0) {
         arpa_is_present = true;
         break;
       }
     }
     if (arpa_is_present) {
-      wxJSONReader reader;
-      wxJSONValue message;
-      if (!reader.Parse(message_body, &message)) {
-        wxJSONValue defaultValue(999);
-        long json_ais_mmsi = message.Get(_T("mmsi"), defaultValue).AsLong();
+      // Only mmsi, lat and lon are needed, so scan for those instead of parsing into a wxJSONValue
+      long json_ais_mmsi;
+      double f_AISLat, f_AISLon;
+      if (ParseAisMessage(message_body, &json_ais_mmsi, &f_AISLat, &f_AISLon)) {
         if (json_ais_mmsi > 200000000) {  // Neither ARPA targets nor SAR_aircraft
-          wxJSONValue defaultValue("90.0");
-          double f_AISLat = wxAtof(message.Get(_T("lat"), defaultValue).AsString());
-          double f_AISLon = wxAtof(message.Get(_T("lon"), defaultValue).AsString());
-
           // Rectangle around own ship to look for AIS targets.
           double d_side = m_arpa_max_range / 1852.0 / 60.0;
           if (f_AISLat < (m_ownship.lat + d_side) && f_AISLat > (m_ownship.lat - d_side) &&
               f_AISLon < (m_ownship.lon + d_side * 2) && f_AISLon > (m_ownship.lon - d_side * 2)) {
-            bool updated = false;
-            for (size_t i = 0; i < m_ais_in_arpa_zone.size(); i++) {  // Check for existing mmsi
-              if (m_ais_in_arpa_zone[i].ais_mmsi == json_ais_mmsi) {
-                m_ais_in_arpa_zone[i].ais_time_upd = time(0);
-                m_ais_in_arpa_zone[i].ais_lat = f_AISLat;
-                m_ais_in_arpa_zone[i].ais_lon = f_AISLon;
-                updated = true;
-                break;
-              }
-            }
-            if (!updated) {  // Add a new target to the list
-              AisArpa m_new_ais_target;
-              m_new_ais_target.ais_mmsi = json_ais_mmsi;
-              m_new_ais_target.ais_time_upd = time(0);
-              m_new_ais_target.ais_lat = f_AISLat;
-              m_new_ais_target.ais_lon = f_AISLon;
-              m_ais_in_arpa_zone.push_back(m_new_ais_target);
-            }
+            m_ais_in_arpa_zone.Update(json_ais_mmsi, f_AISLat, f_AISLon, GetRadarTime());
           }
         }
       }
     }
     // Delete > 3 min old AIS items or at once if no active ARPA
-    if (m_ais_in_arpa_zone.size() > 0) {
-      for (size_t i = 0; i < m_ais_in_arpa_zone.size(); i++) {
-        if (m_ais_in_arpa_zone[i].ais_mmsi > 0 && (time(0) - m_ais_in_arpa_zone[i].ais_time_upd > 3 * 60 || !arpa_is_present)) {
-          m_ais_in_arpa_zone.erase(m_ais_in_arpa_zone.begin() + i);
-          m_arpa_max_range = BASE_ARPA_DIST;  // Renew AIS search area
-        }
+    if (m_ais_in_arpa_zone.GetCount() > 0) {
+      if (!arpa_is_present) {
+        m_ais_in_arpa_zone.Clear();
+        m_arpa_max_range = BASE_ARPA_DIST;  // Renew AIS search area
+      } else if (m_ais_in_arpa_zone.Expire(GetRadarTime()) > 0) {
+        m_arpa_max_range = BASE_ARPA_DIST;  // Renew AIS search area
       }
     }
   }
 }
 
 bool radar_pi::FindAIS_at_arpaPos(const GeoPosition &pos, const double &arpa_dist) {
-  m_arpa_max_range = MAX(arpa_dist + 200, m_arpa_max_range);  // For AIS search area
-  if (m_ais_in_arpa_zone.size() < 1) return false;
-  bool hit = false;
-  // Default 50 >> look 100 meters around + 4% of distance to target
-  double offset = (double)m_settings.AISatARPAoffset;
-  double dist2target = (4.0 / 100) * arpa_dist;
-  offset += dist2target;
-  offset = offset / 1852. / 60.;
-  for (size_t i = 0; i < m_ais_in_arpa_zone.size(); i++) {
-    if (m_ais_in_arpa_zone[i].ais_mmsi != 0) {  // Avtive post
-      if (pos.lat + offset > m_ais_in_arpa_zone[i].ais_lat && pos.lat - offset < m_ais_in_arpa_zone[i].ais_lat &&
-          pos.lon + (offset * 1.75) > m_ais_in_arpa_zone[i].ais_lon && pos.lon - (offset * 1.75) < m_ais_in_arpa_zone[i].ais_lon) {
-        hit = true;
-        break;
-      }
+  AisArpaQuery query;
+  bool hit;
+
+  query.pos = pos;
+  query.dist = arpa_dist;
+  FindAIS_at_arpaPos(&query, 1, &hit);
+  return hit;
+}
+
+void radar_pi::FindAIS_at_arpaPos(const AisArpaQuery *query, size_t n, bool *hit) {
+  for (size_t i = 0; i < n; i++) {
+    m_arpa_max_range = MAX(query[i].dist + 200, m_arpa_max_range);  // For AIS search area
+  }
+  if (m_ais_in_arpa_zone.GetCount() < 1) {
+    for (size_t i = 0; i < n; i++) {
+      hit[i] = false;
     }
+    return;
   }
-  return hit;
+  m_ais_in_arpa_zone.MatchArpaTargets(query, n, (double)m_settings.AISatARPAoffset, hit);
 }
 
 //*****************************************************************************************************
@@ -1676,22 +1949,23 @@ void radar_pi::CacheSetToolbarToolBitmaps() {
 */
 
 void radar_pi::SetNMEASentence(wxString &sentence) {
-  m_NMEA0183 << sentence;
-  time_t now = time(0);
+  NmeaHeading heading;
   double hdm = nan("");
   double hdt = nan("");
-  double var;
 
   LOG_RECEIVE(wxT("radar_pi: SetNMEASentence %s"), sentence.c_str());
 
-  if (m_NMEA0183.PreParse()) {
-    if (m_NMEA0183.LastSentenceIDReceived == _T("HDG") && m_NMEA0183.Parse()) {
-      if (!wxIsNaN(m_NMEA0183.Hdg.MagneticVariationDegrees)) {
-        if (m_NMEA0183.Hdg.MagneticVariationDirection == East) {
-          var = +m_NMEA0183.Hdg.MagneticVariationDegrees;
-        } else {
-          var = -m_NMEA0183.Hdg.MagneticVariationDegrees;
-        }
+  // Only HDG, HDM and HDT are used, all other sentences are rejected here
+  NmeaHeadingType type = ParseNmeaHeading(sentence, &heading);
+  if (type == NMEA_HEADING_NONE) {
+    return;
+  }
+
+  time_t now = GetRadarTime();
+  switch (type) {
+    case NMEA_HEADING_HDG:
+      if (!wxIsNaN(heading.variation)) {
+        double var = heading.variation;
         if (fabs(var - m_var) >= 0.05 && m_var_source <= VARIATION_SOURCE_NMEA) {
           //        LOG_INFO(wxT("radar_pi: NMEA provides new magnetic variation %f from %s"), var, sentence.c_str());
           m_var = var;
@@ -1702,15 +1976,19 @@ void radar_pi::SetNMEASentence(wxString &sentence) {
           m_pMessageBox->SetVariationInfo(info);
         }
       }
+      hdm = heading.heading;
+      break;
 
-      if (!wxIsNaN(m_NMEA0183.Hdg.MagneticSensorHeadingDegrees)) {
-        hdm = m_NMEA0183.Hdg.MagneticSensorHeadingDegrees;
-      }
-    } else if (m_NMEA0183.LastSentenceIDReceived == _T("HDM") && m_NMEA0183.Parse() && !wxIsNaN(m_NMEA0183.Hdm.DegreesMagnetic)) {
-      hdm = m_NMEA0183.Hdm.DegreesMagnetic;
-    } else if (m_NMEA0183.LastSentenceIDReceived == _T("HDT") && m_NMEA0183.Parse() && !wxIsNaN(m_NMEA0183.Hdt.DegreesTrue)) {
-      hdt = m_NMEA0183.Hdt.DegreesTrue;
-    }
+    case NMEA_HEADING_HDM:
+      hdm = heading.heading;
+      break;
+
+    case NMEA_HEADING_HDT:
+      hdt = heading.heading;
+      break;
+
+    default:
+      break;
   }
 
   if (!wxIsNaN(hdt)) {
@@ -1756,17 +2034,7 @@ bool radar_pi::MouseEventHook(wxMouseEvent &event) {
 }
 
 void radar_pi::logBinaryData(const wxString &what, const uint8_t *data, int size) {
-  wxString explain;
-  int i = 0;
-
-  explain.Alloc(size * 3 + 50);
-  explain += wxT("radar_pi: ");
-  explain += what;
-  explain += wxString::Format(wxT(" %d bytes: "), size);
-  for (i = 0; i < size; i++) {
-    explain += wxString::Format(wxT(" %02X"), data[i]);
-  }
-  wxLogMessage(explain);
+  AsyncLogBinary(wxT("radar_pi: ") + what, data, size);
 }
 
 PLUGIN_END_NAMESPACE
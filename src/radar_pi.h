@@ -37,7 +37,13 @@
 
 #include <algorithm>
 #include <vector>
+#include "AisArpaIndex.h"
+#include "AsyncLog.h"
+#include "LatencyHistogram.h"
+#include "MemoryAccount.h"
+#include "RadarClock.h"
 #include "RadarControlItem.h"
+#include "TraceRecorder.h"
 #include "drawutil.h"
 #include "jsonreader.h"
 #include "nmea0183/nmea0183.h"
@@ -73,9 +79,10 @@ class radar_pi;
 class GuardZoneBogey;
 class RadarArpa;
 
-#define RADARS (4)         // Arbitrary limit, anyone running this many is already crazy!
-#define GUARD_ZONES (2)    // Could be increased if wanted
-#define BEARING_LINES (2)  // And these as well
+#define RADARS (4)            // Arbitrary limit, anyone running this many is already crazy!
+#define GUARD_ZONES (2)       // Guard zones that can be edited in the controls dialog
+#define GUARD_ZONES_MAX (16)  // More zones, for instance polygons, can be added in the config file
+#define BEARING_LINES (2)     // And these as well
 
 static const int SECONDS_PER_TIMED_IDLE_SETTING = 60;  // Can't change this anymore, has to be same as Garmin hardware
 static const int SECONDS_PER_TIMED_RUN_SETTING = 60;
@@ -129,25 +136,27 @@ typedef int AngleDegrees;  // An angle relative to North or HeadUp. Generally [0
     IF_LOG_AT_LEVEL(x) { y; } \
   } while (0)
 #define LOG_INFO wxLogMessage
-#define LOG_VERBOSE IF_LOG_AT_LEVEL(LOGLEVEL_VERBOSE) wxLogMessage
-#define LOG_DIALOG IF_LOG_AT_LEVEL(LOGLEVEL_DIALOG) wxLogMessage
-#define LOG_TRANSMIT IF_LOG_AT_LEVEL(LOGLEVEL_TRANSMIT) wxLogMessage
-#define LOG_RECEIVE IF_LOG_AT_LEVEL(LOGLEVEL_RECEIVE) wxLogMessage
-#define LOG_GUARD IF_LOG_AT_LEVEL(LOGLEVEL_GUARD) wxLogMessage
-#define LOG_ARPA IF_LOG_AT_LEVEL(LOGLEVEL_ARPA) wxLogMessage
-
-#define LOG_BINARY_VERBOSE(what, data, size) \
-  IF_LOG_AT_LEVEL(LOGLEVEL_VERBOSE) { M_PLUGIN logBinaryData(what, data, size); }
-#define LOG_BINARY_DIALOG(what, data, size) \
-  IF_LOG_AT_LEVEL(LOGLEVEL_DIALOG) { M_PLUGIN logBinaryData(what, data, size); }
-#define LOG_BINARY_TRANSMIT(what, data, size) \
-  IF_LOG_AT_LEVEL(LOGLEVEL_TRANSMIT) { M_PLUGIN logBinaryData(what, data, size); }
-#define LOG_BINARY_RECEIVE(what, data, size) \
-  IF_LOG_AT_LEVEL(LOGLEVEL_RECEIVE) { M_PLUGIN logBinaryData(what, data, size); }
-#define LOG_BINARY_GUARD(what, data, size) \
-  IF_LOG_AT_LEVEL(LOGLEVEL_GUARD) { M_PLUGIN logBinaryData(what, data, size); }
-#define LOG_BINARY_ARPA(what, data, size) \
-  IF_LOG_AT_LEVEL(LOGLEVEL_ARPA) { M_PLUGIN logBinaryData(what, data, size); }
+// The other levels go through the asynchronous, rate limited log, see AsyncLog.h
+#define LOG_AT_LEVEL(x) IF_LOG_AT_LEVEL(x) if (LogRateAllowed(__FILE__, __LINE__)) AsyncLog() << wxString::Format
+#define LOG_VERBOSE LOG_AT_LEVEL(LOGLEVEL_VERBOSE)
+#define LOG_DIALOG LOG_AT_LEVEL(LOGLEVEL_DIALOG)
+#define LOG_TRANSMIT LOG_AT_LEVEL(LOGLEVEL_TRANSMIT)
+#define LOG_RECEIVE LOG_AT_LEVEL(LOGLEVEL_RECEIVE)
+#define LOG_GUARD LOG_AT_LEVEL(LOGLEVEL_GUARD)
+#define LOG_ARPA LOG_AT_LEVEL(LOGLEVEL_ARPA)
+
+#define LOG_BINARY_AT_LEVEL(x, what, data, size) \
+  IF_LOG_AT_LEVEL(x) {                           \
+    if (LogRateAllowed(__FILE__, __LINE__)) {    \
+      M_PLUGIN logBinaryData(what, data, size);  \
+    }                                            \
+  }
+#define LOG_BINARY_VERBOSE(what, data, size) LOG_BINARY_AT_LEVEL(LOGLEVEL_VERBOSE, what, data, size)
+#define LOG_BINARY_DIALOG(what, data, size) LOG_BINARY_AT_LEVEL(LOGLEVEL_DIALOG, what, data, size)
+#define LOG_BINARY_TRANSMIT(what, data, size) LOG_BINARY_AT_LEVEL(LOGLEVEL_TRANSMIT, what, data, size)
+#define LOG_BINARY_RECEIVE(what, data, size) LOG_BINARY_AT_LEVEL(LOGLEVEL_RECEIVE, what, data, size)
+#define LOG_BINARY_GUARD(what, data, size) LOG_BINARY_AT_LEVEL(LOGLEVEL_GUARD, what, data, size)
+#define LOG_BINARY_ARPA(what, data, size) LOG_BINARY_AT_LEVEL(LOGLEVEL_ARPA, what, data, size)
 
 enum { BM_ID_RED, BM_ID_RED_SLAVE, BM_ID_GREEN, BM_ID_GREEN_SLAVE, BM_ID_AMBER, BM_ID_AMBER_SLAVE, BM_ID_BLANK, BM_ID_BLANK_SLAVE };
 
@@ -193,7 +202,7 @@ struct receive_statistics {
   int missing_spokes;
 };
 
-typedef enum GuardZoneType { GZ_ARC, GZ_CIRCLE } GuardZoneType;
+typedef enum GuardZoneType { GZ_ARC, GZ_CIRCLE, GZ_POLYGON } GuardZoneType;
 
 typedef enum RadarType {
 #define DEFINE_RADAR(t, n, s, l, a, b, c) t,
@@ -303,6 +312,7 @@ struct PersistentSettings {
   int guard_zone_threshold;               // How many blobs must be sent by radar before we fire alarm
   int guard_zone_render_style;            // 0 = Shading, 1 = Outline, 2 = Shading + Outline
   int guard_zone_timeout;                 // How long before we warn again when bogeys are found
+  int guard_zone_count;                   // Number of guard zones per radar, GUARD_ZONES .. GUARD_ZONES_MAX
   bool guard_zone_on_overlay;
   bool trails_on_overlay;
   bool overlay_on_standby;
@@ -331,6 +341,27 @@ struct PersistentSettings {
   int threshold_multi_sweep;                       // Radar data has to be this strong not to be ignored in multisweep
   int type_detection_method;                       // 0 = default, 1 = ignore reports
   int AISatARPAoffset;                             // Rectangle side where to search AIS targets at ARPA position
+  double arpa_cpa_alarm;                           // Alarm when ARPA target CPA is less than this (NM), 0 = off
+  int arpa_tcpa_alarm;                             // ... and it will be reached within this many minutes
+  int stream_port;                                 // TCP port where radar n streams its image on port + n, 0 = off
+  bool stream_all_interfaces;                      // Accept stream clients from the network, not just this computer
+  bool spoke_publish;                              // Publish the spokes of our radars for other stations
+  int spoke_network_port;                          // UDP port where spokes of radar n are published on port + n
+  wxString record_directory;                       // Directory where radar sessions are recorded, empty = off
+  wxString replay_file;                            // Capture or recording that the Replay radar plays
+  int replay_speed;                                // Multiple of real time to replay at, 0 = as fast as possible
+  wxString trace_file;                             // Chrome trace of the processing stages written on exit, empty = off
+  int emulator_spokes;                             // Spokes per rotation of the Emulator radar
+  int emulator_spoke_len;                          // Samples per spoke of the Emulator radar
+  int emulator_rpm;                                // Rotations per minute of the Emulator, 0 = as fast as possible
+  int emulator_point_targets;                      // Moving point targets around the Emulator
+  int emulator_extended_targets;                   // Ships and land larger than the beam around the Emulator
+  int emulator_clutter;                            // Sea clutter 0 .. 100
+  double emulator_speed;                           // Speed in knots that the Emulator sails at
+  double emulator_turn_rate;                       // Rate of turn in degrees per minute of the Emulator
+  bool emulator_nmea;                              // First emulator sends its position to OpenCPN, off by default
+  int stress_radars;                               // Run this many emulators or replays instead of the radars, 0 = off
+  bool lock_profile;                               // Count how long the shared locks are waited for and held
   wxPoint control_pos[RADARS];                     // Saved position of control menu windows
   wxPoint window_pos[RADARS];                      // Saved position of radar windows, when floating and not docked
   wxPoint alarm_pos;                               // Saved position of alarm window
@@ -346,16 +377,6 @@ struct PersistentSettings {
   wxColour ppi_background_colour;                  // Colour for PPI background (normally very dark)
 };
 
-// Table for AIS targets inside ARPA zone
-struct AisArpa {
-  long ais_mmsi;
-  time_t ais_time_upd;
-  double ais_lat;
-  double ais_lon;
-
-  AisArpa() : ais_mmsi(0), ais_time_upd(), ais_lat(), ais_lon() {}
-};
-
 //----------------------------------------------------------------------------------------------------------
 //    The PlugIn Class Definition
 //----------------------------------------------------------------------------------------------------------
@@ -420,6 +441,9 @@ class radar_pi : public opencpn_plugin_114, public wxEvtHandler {
   void ConfirmGuardZoneBogeys();
   void ResetOpenGLContext();
   void logBinaryData(const wxString &what, const uint8_t *data, int size);
+  bool ExportLatency(const wxString &filename);
+  void StartTrace();
+  bool ExportTrace(const wxString &filename);
 
   void UpdateAllControlStates(bool all);
 
@@ -432,43 +456,45 @@ class radar_pi : public opencpn_plugin_114, public wxEvtHandler {
   long GetOptimalRangeMeters();
 
   void SetRadarInterfaceAddress(int r, NetworkAddress &addr) {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
     m_settings.radar_interface_address[r] = addr;
   };
   NetworkAddress &GetRadarInterfaceAddress(int r) {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
     return m_settings.radar_interface_address[r];
   }
 
   void SetRadarHeading(double heading = nan(""), bool isTrue = false);
   double GetHeadingTrue() {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
     return m_hdt;
   }
   time_t GetHeadingTrueTimeout() {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
     return m_hdt_timeout;
   }
   time_t GetHeadingMagTimeout() {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
     return m_hdm_timeout;
   }
   VariationSource GetVariationSource() {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
     return m_var_source;
   }
   double GetCOG() {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
     return m_cog;
   }
   HeadingSource GetHeadingSource() { return m_heading_source; }
   bool IsInitialized() { return m_initialized; }
   bool IsBoatPositionValid() {
-    wxCriticalSectionLocker lock(m_exclusive);
+    ProfiledLocker lock(m_exclusive);
     return m_bpos_set;
   }
+  bool GetOwnShipVelocity(double *dlat_dt, double *dlon_dt);
 
   wxLongLong GetBootMillis() { return m_boot_time; }
+  uint64_t GetInitNanos() { return m_init_nanos; }
   bool IsOpenGLEnabled() { return m_opengl_mode == OPENGL_ON; }
   wxGLContext *GetChartOpenGLContext();
 
@@ -483,8 +509,9 @@ class radar_pi : public opencpn_plugin_114, public wxEvtHandler {
   wxWindow *m_parent_window;
 
   // Check for AIS targets inside ARPA zone
-  vector<AisArpa> m_ais_in_arpa_zone;  // Array for AIS targets in ARPA zone(s)
+  AisArpaIndex m_ais_in_arpa_zone;  // Index of AIS targets in ARPA zone(s)
   bool FindAIS_at_arpaPos(const GeoPosition &pos, const double &arpa_dist);
+  void FindAIS_at_arpaPos(const AisArpaQuery *query, size_t n, bool *hit);
 #define BASE_ARPA_DIST (750.)
   double m_arpa_max_range;  //  Temporary distance(m) fron own ship to collect AIS targets.
 
@@ -500,6 +527,7 @@ class radar_pi : public opencpn_plugin_114, public wxEvtHandler {
   void PassHeadingToOpenCPN();
   void CacheSetToolbarToolBitmaps();
   void SetRadarWindowViz(bool reparent = false);
+  void FinishInit();
   void UpdateContextMenu();
   void UpdateCOGAvg(double cog);
   void OnTimerNotify(wxTimerEvent &event);
@@ -507,7 +535,7 @@ class radar_pi : public opencpn_plugin_114, public wxEvtHandler {
   void ScheduleWindowRefresh();
   void SetOpenGLMode(OpenGLMode mode);
 
-  wxCriticalSection m_exclusive;  // protects callbacks that come from multiple radars
+  ProfiledCriticalSection m_exclusive;  // protects callbacks that come from multiple radars
 
   double m_hdt;                    // this is the heading that the pi is using for all heading operations, in degrees.
                                    // m_hdt will come from the radar if available else from the NMEA stream.
@@ -548,8 +576,6 @@ class radar_pi : public opencpn_plugin_114, public wxEvtHandler {
   wxString m_shareLocn;
   // wxBitmap *m_ptemp_icon;
 
-  NMEA0183 m_NMEA0183;
-
   ToolbarIconColor m_toolbar_button;
   ToolbarIconColor m_sent_toolbar_button;
 
@@ -557,6 +583,8 @@ class radar_pi : public opencpn_plugin_114, public wxEvtHandler {
   volatile bool m_notify_radar_window_viz;
   volatile bool m_notify_control_dialog;
   wxLongLong m_notify_time_ms;
+  wxLongLong m_lock_profile_time_ms;  // When the lock profile was last made
+  wxString m_lock_profile;
 
 #define HEADING_TIMEOUT (5)
 
@@ -583,10 +611,14 @@ class radar_pi : public opencpn_plugin_114, public wxEvtHandler {
   // Cursor position. Used to show position in radar window
   GeoPosition m_cursor_pos;
   GeoPosition m_ownship;
+  double m_ownship_sog;  // Last SOG in knots, or nan if not known
+  double m_ownship_cog;  // Last (not averaged) COG in degrees, or nan if not known
 
   bool m_initialized;      // True if Init() succeeded and DeInit() not called yet.
+  bool m_init_pending;     // True from Init() until FinishInit() has initialized the radars
   bool m_first_init;       // True in first Init() call.
   wxLongLong m_boot_time;  // millis when started
+  uint64_t m_init_nanos;   // GetLatencyNanos() when Init() was last called, to time the startup
 
   OpenGLMode m_opengl_mode;
   volatile bool m_opengl_mode_changed;
@@ -77,42 +77,6 @@ RaymarineReceive::RaymarineReceive(radar_pi *pi, RadarInfo *ri, NetworkAddress r
 #define SECONDS_SELECT(x) ((x)*MILLISECONDS_PER_SECOND / MILLIS_PER_SELECT)
 
 
-SOCKET RaymarineReceive::PickNextEthernetCard() {
-  SOCKET socket = INVALID_SOCKET;
-  CLEAR_STRUCT(m_interface_addr);
-
-  // Pick the next ethernet card
-  // If set, we used this one last time. Go to the next card.
-  if (m_interface) {
-    m_interface = m_interface->ifa_next;
-  }
-  // Loop until card with a valid IPv4 address
-  while (m_interface && !VALID_IPV4_ADDRESS(m_interface)) {
-    m_interface = m_interface->ifa_next;
-  }
-  if (!m_interface) {
-    if (m_interface_array) {
-      freeifaddrs(m_interface_array);
-      m_interface_array = 0;
-    }
-    if (!getifaddrs(&m_interface_array)) {
-      m_interface = m_interface_array;
-    }
-    // Loop until card with a valid IPv4 address
-    while (m_interface && !VALID_IPV4_ADDRESS(m_interface)) {
-      m_interface = m_interface->ifa_next;
-    }
-  }
-  if (m_interface && VALID_IPV4_ADDRESS(m_interface)) {
-    m_interface_addr.addr = ((struct sockaddr_in *)m_interface->ifa_addr)->sin_addr;
-    m_interface_addr.port = 0;
-  }
-
-  socket = GetNewReportSocket();
-
-  return socket;
-}
-
 SOCKET RaymarineReceive::GetNewReportSocket() {
   SOCKET socket;
   wxString error;
@@ -154,6 +118,7 @@ SOCKET RaymarineReceive::GetNewDataSocket(const NetworkAddress & dataGroup)
 	socket = startUDPMulticastReceiveSocket(m_interface_addr, dataGroup, error);
 	if (socket != INVALID_SOCKET)
 	{
+    EnableReceiveAge(socket);
     wxString addr = FormatNetworkAddress(m_interface_addr);
     wxString data_addr = FormatNetworkAddressPort(dataGroup);
 	  LOG_RECEIVE(wxT("radar_pi: %s listening for data on interface %s multicast group %s"), m_ri->m_name.c_str(), addr.c_str(), data_addr.c_str());
@@ -186,8 +151,6 @@ void *RaymarineReceive::Entry(void)
   socklen_t rx_len;
 
   uint8_t data[2048];
-  m_interface_array = 0;
-  m_interface = 0;
   m_no_spoke_timeout = 0;
   struct sockaddr_in radarFoundAddr;
   sockaddr_in *radar_addr = 0;
@@ -196,19 +159,13 @@ void *RaymarineReceive::Entry(void)
   SOCKET dataSocket = INVALID_SOCKET;
 
   LOG_VERBOSE(wxT("radar_pi: RaymarineReceive thread %s starting"), m_ri->m_name.c_str());
+  TraceThreadName(m_ri->m_name + wxT(" receive"));
 
   if (m_interface_addr.addr.s_addr == 0) {
     reportSocket = GetNewReportSocket();
   }
 
   while (m_receive_socket != INVALID_SOCKET) {
-    if (reportSocket == INVALID_SOCKET) {
-      reportSocket = PickNextEthernetCard();
-      if (reportSocket != INVALID_SOCKET) {
-        no_data_timeout = 0;
-        m_no_spoke_timeout = 0;
-      }
-    }
 
     struct timeval tv = {(long)0, (long)(MILLIS_PER_SELECT * 1000)};
 
@@ -223,6 +180,10 @@ void *RaymarineReceive::Entry(void)
     if (reportSocket != INVALID_SOCKET) {
       FD_SET(reportSocket, &fdin);
       maxFd = MAX(reportSocket, maxFd);
+    } else if (m_probe.Prepare(m_report_addr, &fdin, &maxFd)) {
+      LOG_RECEIVE(wxT("radar_pi: %s scanning interfaces %s for data from %s"), m_ri->m_name.c_str(),
+                  m_probe.GetInterfaces().c_str(), FormatNetworkAddressPort(m_report_addr).c_str());
+      SetInfoStatus(m_probe.GetStatus());
     }
     if (dataSocket != INVALID_SOCKET) {
       FD_SET(dataSocket, &fdin);
@@ -234,6 +195,15 @@ void *RaymarineReceive::Entry(void)
     // LOG_RECEIVE(wxT("radar_pi: select maxFd=%d r=%d elapsed=%lld"), maxFd, r, wxGetUTCTimeMillis() - start);
 
     if (r > 0) {
+      if (reportSocket == INVALID_SOCKET) {
+        // Continue with the interface that the report came in on, it is read below
+        reportSocket = m_probe.Pick(&fdin, &m_interface_addr);
+        if (reportSocket != INVALID_SOCKET) {
+          no_data_timeout = 0;
+          m_no_spoke_timeout = 0;
+        }
+      }
+
       if (m_receive_socket != INVALID_SOCKET && FD_ISSET(m_receive_socket, &fdin)) {
         rx_len = sizeof(rx_addr);
         r = recvfrom(m_receive_socket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
@@ -245,10 +215,18 @@ void *RaymarineReceive::Entry(void)
 
 			if (dataSocket != INVALID_SOCKET && FD_ISSET(dataSocket, &fdin)) 
 			{
+				uint64_t age;
 				rx_len = sizeof(rx_addr);
-				r = recvfrom(dataSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
+				{
+					TRACE_SCOPE("receive");
+					r = ReceiveWithAge(dataSocket, (char *)data, sizeof(data), (struct sockaddr *)&rx_addr, &rx_len, &age);
+				}
 				if (r > 0) 
 				{
+					if (age != RECEIVE_AGE_UNKNOWN) 
+					{
+						m_ri->m_latency.Record(LATENCY_SOCKET, age);
+					}
 					ProcessFrame(data, r);
           no_data_timeout = SECONDS_SELECT(-5);
 				} 
@@ -346,9 +324,7 @@ void *RaymarineReceive::Entry(void)
     closesocket(m_receive_socket);
   }
 
-  if (m_interface_array) {
-    freeifaddrs(m_interface_array);
-  }
+  m_probe.Close();
 
 #ifdef TEST_THREAD_RACES
   LOG_VERBOSE(wxT("radar_pi: %s receive thread sleeping"), m_ri->m_name.c_str());
@@ -374,7 +350,7 @@ bool RaymarineReceive::UpdateScannerStatus(int status)
     m_radar_status = status;
 
     wxString stat;
-    time_t now = time(0);
+    time_t now = m_ri->GetRadarTime();
 
     switch (m_radar_status) {
       case 0:
@@ -410,8 +386,9 @@ bool RaymarineReceive::UpdateScannerStatus(int status)
 
 void RaymarineReceive::ProcessFrame(const uint8_t *data, int len) 
 {
+	TRACE_SCOPE("decode");
 	// wxLongLong nowMillis = wxGetLocalTimeMillis();
-	time_t now = time(0);
+	time_t now = m_ri->GetRadarTime();
 	m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
 
 	int spoke = 0;
@@ -745,12 +722,12 @@ void RaymarineReceive::ProcessCurveFeedback(const UINT8 *data, int len)
 			m_stcCurve.Set(8);
 			break;
 		default:
-			fprintf(stderr, "ProcessCurveFeedback: unknown curve value %d.\n", (int)fbPtr->curve_value);
+			LOG_RECEIVE(wxT("radar_pi: %s ProcessCurveFeedback: unknown curve value %d"), m_ri->m_name.c_str(), (int)fbPtr->curve_value);
 		}
 	}
 	else
 	{
-		fprintf(stderr, "ProcessCurveFeedback: got %d bytes, expected %d.\n", len, (int)sizeof(SCurveFeedback));
+		LOG_RECEIVE(wxT("radar_pi: %s ProcessCurveFeedback: got %d bytes, expected %d"), m_ri->m_name.c_str(), len, (int)sizeof(SCurveFeedback));
 	}
 }
 
@@ -812,7 +789,7 @@ void RaymarineReceive::ProcessScanData(const UINT8 *data, int len)
 		if(pHeader->type != 0x00010003 || pHeader->something_1 != 0x0000001c || 
 			pHeader->something_3 != 0x0000001)
 		{
-			fprintf(stderr, "ProcessScanData::Packet header mismatch %x, %x, %x, %x.\n", pHeader->type, pHeader->something_1, 
+			LOG_RECEIVE(wxT("radar_pi: %s ProcessScanData::Packet header mismatch %x, %x, %x, %x"), m_ri->m_name.c_str(), pHeader->type, pHeader->something_1, 
 				pHeader->nspokes, pHeader->something_3);
 			return;
 		}
@@ -835,7 +812,7 @@ void RaymarineReceive::ProcessScanData(const UINT8 *data, int len)
 		}
 
 		// wxLongLong nowMillis = wxGetLocalTimeMillis();
-    wxLongLong time_rec = wxGetUTCTimeMillis();
+    wxLongLong time_rec = m_ri->GetRadarMillis();
 		int headerIdx = 0;
 		int nextOffset = sizeof(CRMPacketHeader);
 
@@ -845,7 +822,7 @@ void RaymarineReceive::ProcessScanData(const UINT8 *data, int len)
 			CRMScanHeader *sHeader = (CRMScanHeader *)(data + nextOffset);
 			if(sHeader->type != 0x00000001 || sHeader->length != 0x00000028)
 			{
-				fprintf(stderr, "ProcessScanData::Scan header #%d (%d) - %x, %x.\n", headerIdx, nextOffset, sHeader->type, sHeader->length);
+				LOG_RECEIVE(wxT("radar_pi: %s ProcessScanData::Scan header #%d (%d) - %x, %x"), m_ri->m_name.c_str(), headerIdx, nextOffset, sHeader->type, sHeader->length);
 				break;
 			}
 		
@@ -855,20 +832,20 @@ void RaymarineReceive::ProcessScanData(const UINT8 *data, int len)
 				if(sHeader->something_2 != 3 || sHeader->something_3 != 2 || sHeader->something_4 != 3 ||
 					sHeader->something_5 != 0 || sHeader->something_6 != 0 || sHeader->something_7 != 1)
 				{
-					fprintf(stderr, "ProcessScanData::Scan header #%d part 2 check failed.\n", headerIdx);
+					LOG_RECEIVE(wxT("radar_pi: %s ProcessScanData::Scan header #%d part 2 check failed"), m_ri->m_name.c_str(), headerIdx);
 					break;
 				}
 				else if(m_radarType != RM_HD)
 				{
 					m_radarType = RM_HD;
-					fprintf(stderr, "ProcessScanData::Scan header #%d HD second header with regular first.\n", headerIdx);
+					LOG_RECEIVE(wxT("radar_pi: %s ProcessScanData::Scan header #%d HD second header with regular first"), m_ri->m_name.c_str(), headerIdx);
 				}				
 				
 			}
 			else if(m_radarType != RM_D)
 			{
 				m_radarType = RM_D;
-				fprintf(stderr, "ProcessScanData::Scan header #%d regular second header with HD first.\n", headerIdx);
+				LOG_RECEIVE(wxT("radar_pi: %s ProcessScanData::Scan header #%d regular second header with HD first"), m_ri->m_name.c_str(), headerIdx);
 			}
 
 			nextOffset += sizeof(CRMScanHeader);
@@ -887,7 +864,7 @@ void RaymarineReceive::ProcessScanData(const UINT8 *data, int len)
 			
 			if((pSData->type & 0x7fffffff) != 0x00000003 || pSData->length < pSData->data_len + 8)
 			{
-				fprintf(stderr, "ProcessScanData::Scan data header #%d check failed %x, %d, %d.\n", headerIdx, 
+				LOG_RECEIVE(wxT("radar_pi: %s ProcessScanData::Scan data header #%d check failed %x, %d, %d"), m_ri->m_name.c_str(), headerIdx, 
 					pSData->type, pSData->length, pSData->data_len);
 				break;
 			}
@@ -953,7 +930,7 @@ void RaymarineReceive::ProcessScanData(const UINT8 *data, int len)
 				if(pSData->data_len != RAYMARINE_MAX_SPOKE_LEN)
 				{
 					m_ri->m_statistics.broken_spokes++;
-					fprintf(stderr, "ProcessScanData data len %d should be %d.\n", pSData->data_len, RAYMARINE_MAX_SPOKE_LEN);
+					LOG_RECEIVE(wxT("radar_pi: %s ProcessScanData data len %d should be %d"), m_ri->m_name.c_str(), pSData->data_len, RAYMARINE_MAX_SPOKE_LEN);
 					break;
 				}
 				// if(m_range_meters == 0) m_range_meters = 1852 / 4; // !!!TEMP delete!!!
@@ -976,7 +953,7 @@ void RaymarineReceive::ProcessScanData(const UINT8 *data, int len)
 			}
 			else
 			{
-				fprintf(stderr, "ProcessScanData::Packet radar type is not set somehow.\n");
+				LOG_RECEIVE(wxT("radar_pi: %s ProcessScanData::Packet radar type is not set somehow"), m_ri->m_name.c_str());
 				break;
 			}
 
@@ -33,6 +33,7 @@
 #define _RAYMARINE_RECEIVE_H_
 
 #include <exception>
+#include "InterfaceMonitor.h"
 #include "RadarReceive.h"
 #include "socketutil.h"
 
@@ -125,7 +126,6 @@ class RaymarineReceive : public RadarReceive {
 	void ProcessCurveFeedback(const UINT8 *data, int len);
 
 
-  SOCKET PickNextEthernetCard();
   SOCKET GetNewReportSocket();
   SOCKET GetNewDataSocket(const NetworkAddress & dataGroup);
 
@@ -134,8 +134,7 @@ class RaymarineReceive : public RadarReceive {
 //  SOCKET m_receive_socket;  // Where we listen for message from m_send_socket
 //  SOCKET m_send_socket;     // A message to this socket will interrupt select() and allow immediate shutdown
 
-  struct ifaddrs *m_interface_array;
-  struct ifaddrs *m_interface;
+  InterfaceProbe m_probe;  // Listens for reports on all interfaces until one is found
 
   int m_next_spoke;
   int m_radar_status;
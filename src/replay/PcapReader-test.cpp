@@ -0,0 +1,124 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <wx/init.h>
+#include <wx/stopwatch.h>
+#include "PcapReader.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define NAVICO_FRAME_LEN (8 + 32 * (24 + 512))  // Frame header and 32 spokes
+#define GARMIN_XHD_FRAME_LEN (734)
+
+struct Capture {
+  const char *filename;
+  NetworkAddress data;
+  size_t frame_len;
+};
+
+// The captures in the example directory and where their spokes go
+static const Capture captures[] = {
+    {"example/3g.pcap.gz", NetworkAddress(236, 6, 7, 8, 6678), NAVICO_FRAME_LEN},
+    {"example/4g-heading.pcap.gz", NetworkAddress(236, 6, 7, 8, 6678), NAVICO_FRAME_LEN},
+    {"example/br24-ranges-km.pcap.gz", NetworkAddress(236, 6, 7, 8, 6678), NAVICO_FRAME_LEN},
+    {"example/halo_start_transmit_off.pcap.gz", NetworkAddress(236, 6, 7, 100, 6132), NAVICO_FRAME_LEN},
+    {"example/garminxhd_txon_txoff.pcap", NetworkAddress(239, 254, 2, 0, 50102), GARMIN_XHD_FRAME_LEN},
+};
+
+static int ReadCapture(PcapReader &reader, const Capture &capture, size_t *frames) {
+  PcapPacket packet;
+  size_t packets = 0;
+  int ret = 0;
+
+  *frames = 0;
+  while (reader.Next(&packet)) {
+    packets++;
+    if (packet.destination == capture.data) {
+      if (packet.len != capture.frame_len) {
+        cout << "ERROR: " << capture.filename << " frame " << *frames << " is " << packet.len << " bytes instead of "
+             << capture.frame_len << "\n";
+        ret = 1;
+      }
+      (*frames)++;
+    }
+  }
+  if (*frames == 0) {
+    cout << "ERROR: " << capture.filename << " contains no radar frames in " << packets << " packets\n";
+    ret = 1;
+  }
+  return ret;
+}
+
+// Run it in the source directory, or give the source directory as argument
+int main(int argc, char *argv[]) {
+  wxInitializer initializer;  // needed for wxThread
+  int ret = 0;
+  wxString directory = argc > 1 ? wxString(argv[1]) + wxT("/") : wxString(wxT(""));
+
+  for (size_t i = 0; i < ARRAY_SIZE(captures); i++) {
+    const Capture &capture = captures[i];
+    PcapReader reader;
+    size_t frames;
+    size_t again;
+
+    if (!reader.Open(directory + wxString(capture.filename))) {
+      cout << "ERROR: cannot open " << capture.filename << "\n";
+      ret = 1;
+      continue;
+    }
+    wxStopWatch stopwatch;
+    ret |= ReadCapture(reader, capture, &frames);
+    long millis = stopwatch.Time();
+    cout << "INFO: " << capture.filename << " has " << frames << " radar frames, read in " << millis << " ms\n";
+
+    if (!reader.Rewind()) {
+      cout << "ERROR: cannot rewind " << capture.filename << "\n";
+      ret = 1;
+      continue;
+    }
+    ret |= ReadCapture(reader, capture, &again);
+    if (again != frames) {
+      cout << "ERROR: " << capture.filename << " has " << again << " radar frames after rewinding\n";
+      ret = 1;
+    }
+  }
+
+  if (ret == 0) {
+    cout << "INFO: TEST PASSED\n";
+  } else {
+    cout << "ERROR: TEST FAILED\n";
+  }
+  exit(ret);
+}
+
+PLUGIN_END_NAMESPACE
+
+int main(int argc, char *argv[]) { RadarPlugin::main(argc, argv); }
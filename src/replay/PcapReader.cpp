@@ -0,0 +1,466 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "PcapReader.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define PCAP_FRAME_MAX (256 * 1024)
+#define PCAPNG_BLOCK_MAX (16 * 1024 * 1024)
+
+#define PCAPNG_SECTION_HEADER (0x0A0D0D0A)
+#define PCAPNG_INTERFACE_DESCRIPTION (1)
+#define PCAPNG_SIMPLE_PACKET (3)
+#define PCAPNG_ENHANCED_PACKET (6)
+#define PCAPNG_OPTION_TSRESOL (9)
+
+#define LINKTYPE_NULL (0)
+#define LINKTYPE_ETHERNET (1)
+#define LINKTYPE_RAW (101)
+#define LINKTYPE_LINUX_SLL (113)
+#define LINKTYPE_IPV4 (228)
+#define LINKTYPE_LINUX_SLL2 (276)
+
+#define ETHERTYPE_IPV4 (0x0800)
+#define ETHERTYPE_VLAN (0x8100)
+#define ETHERTYPE_QINQ (0x88A8)
+
+#define IP_PROTOCOL_UDP (17)
+#define IP_MORE_FRAGMENTS (0x2000)
+#define IP_FRAGMENT_OFFSET (0x1FFF)
+
+// Network headers are always big endian, unlike the pcap headers
+static uint16_t GetBE16(const uint8_t *p) { return (uint16_t)((p[0] << 8) | p[1]); }
+
+PcapReader::PcapReader() {
+  m_file = 0;
+  m_pcapng = false;
+  m_big_endian = false;
+  m_last_time = 0;
+  m_fragment_age = 0;
+  for (size_t i = 0; i < ARRAY_SIZE(m_fragments); i++) {
+    m_fragments[i].used = false;
+  }
+}
+
+PcapReader::~PcapReader() { Close(); }
+
+bool PcapReader::Open(const wxString &filename) {
+  Close();
+
+#ifdef HAVE_ZLIB
+  // gzread passes files that are not compressed through as is
+  m_file = gzopen(filename.mb_str(wxConvFile), "rb");
+#else
+  m_file = fopen(filename.mb_str(wxConvFile), "rb");
+#endif
+  if (!m_file) {
+    wxLogError(wxT("radar_pi: cannot open capture %s"), filename.c_str());
+    return false;
+  }
+  if (!ReadHeader()) {
+#ifdef HAVE_ZLIB
+    wxLogError(wxT("radar_pi: %s is not a pcap or pcapng capture"), filename.c_str());
+#else
+    wxLogError(wxT("radar_pi: %s is not a pcap or pcapng capture, or it is compressed and zlib is missing"), filename.c_str());
+#endif
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void PcapReader::Close() {
+  if (m_file) {
+#ifdef HAVE_ZLIB
+    gzclose(m_file);
+#else
+    fclose(m_file);
+#endif
+    m_file = 0;
+  }
+  for (size_t i = 0; i < ARRAY_SIZE(m_fragments); i++) {
+    m_fragments[i].used = false;
+    m_fragments[i].data.clear();
+  }
+}
+
+bool PcapReader::Rewind() {
+#ifdef HAVE_ZLIB
+  if (!m_file || gzrewind(m_file) != 0) {
+    return false;
+  }
+#else
+  if (!m_file || fseek(m_file, 0, SEEK_SET) != 0) {
+    return false;
+  }
+#endif
+  for (size_t i = 0; i < ARRAY_SIZE(m_fragments); i++) {
+    m_fragments[i].used = false;
+  }
+  return ReadHeader();
+}
+
+#ifdef HAVE_ZLIB
+bool PcapReader::Read(void *buf, size_t len) { return len == 0 || gzread(m_file, buf, (unsigned)len) == (int)len; }
+
+bool PcapReader::Skip(size_t len) { return len == 0 || gzseek(m_file, (z_off_t)len, SEEK_CUR) != -1; }
+#else
+bool PcapReader::Read(void *buf, size_t len) { return len == 0 || fread(buf, 1, len, m_file) == len; }
+
+bool PcapReader::Skip(size_t len) { return len == 0 || fseek(m_file, (long)len, SEEK_CUR) == 0; }
+#endif
+
+uint16_t PcapReader::Get16(const uint8_t *p) {
+  if (m_big_endian) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+  }
+  return (uint16_t)((p[1] << 8) | p[0]);
+}
+
+uint32_t PcapReader::Get32(const uint8_t *p) {
+  if (m_big_endian) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+  }
+  return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+}
+
+bool PcapReader::ReadHeader() {
+  uint8_t header[24];
+
+  m_interfaces.clear();
+  m_last_time = 0;
+  if (!Read(header, 4)) {
+    return false;
+  }
+
+  if (header[0] == 0x0A && header[1] == 0x0D && header[2] == 0x0D && header[3] == 0x0A) {
+    // pcapng section header block: type, length, byte order magic 0x1A2B3C4D, ...
+    if (!Read(header + 4, 8)) {
+      return false;
+    }
+    m_pcapng = true;
+    m_big_endian = header[8] == 0x1A;
+    uint32_t block_len = Get32(header + 4);
+    if (Get32(header + 8) != 0x1A2B3C4D || block_len < 12) {
+      return false;
+    }
+    return Skip(block_len - 12);
+  }
+
+  // Classic pcap, with microsecond or nanosecond timestamps
+  static const uint8_t magic_us[4] = {0xA1, 0xB2, 0xC3, 0xD4};
+  static const uint8_t magic_ns[4] = {0xA1, 0xB2, 0x3C, 0x4D};
+  Interface interface;
+
+  m_pcapng = false;
+  if (memcmp(header, magic_us, 4) == 0 || memcmp(header, magic_ns, 4) == 0) {
+    m_big_endian = true;
+  } else if (header[0] == 0xD4 && header[1] == 0xC3 && header[2] == 0xB2 && header[3] == 0xA1) {
+    m_big_endian = false;
+  } else if (header[0] == 0x4D && header[1] == 0x3C && header[2] == 0xB2 && header[3] == 0xA1) {
+    m_big_endian = false;
+  } else {
+    return false;
+  }
+  if (!Read(header + 4, 20)) {
+    return false;
+  }
+  interface.units_per_second = (header[m_big_endian ? 2 : 1] == 0x3C) ? 1000000000 : 1000000;
+  interface.link_type = Get32(header + 20) & 0xFFFF;
+  m_interfaces.push_back(interface);
+  return true;
+}
+
+bool PcapReader::NextPcapFrame(uint32_t *link_type, wxLongLong *time, const uint8_t **data, size_t *len) {
+  uint8_t header[16];
+
+  if (!Read(header, sizeof(header))) {
+    return false;
+  }
+  uint32_t seconds = Get32(header);
+  uint32_t fraction = Get32(header + 4);
+  size_t captured = Get32(header + 8);
+  if (captured > PCAP_FRAME_MAX) {
+    return false;
+  }
+  m_frame.resize(captured);
+  if (!Read(captured ? &m_frame[0] : 0, captured)) {
+    return false;
+  }
+
+  *link_type = m_interfaces[0].link_type;
+  *time = wxLongLong((long)0, (unsigned long)seconds) * MILLISECONDS_PER_SECOND +
+          wxLongLong((long)(fraction / (m_interfaces[0].units_per_second / MILLISECONDS_PER_SECOND)));
+  *data = captured ? &m_frame[0] : 0;
+  *len = captured;
+  return true;
+}
+
+bool PcapReader::NextPcapngFrame(uint32_t *link_type, wxLongLong *time, const uint8_t **data, size_t *len) {
+  while (true) {
+    uint8_t header[8];
+
+    if (!Read(header, sizeof(header))) {
+      return false;
+    }
+
+    if (header[0] == 0x0A && header[1] == 0x0D && header[2] == 0x0D && header[3] == 0x0A) {
+      // A new section, which may have a different byte order and its own interfaces
+      uint8_t bom[4];
+      if (!Read(bom, sizeof(bom))) {
+        return false;
+      }
+      m_big_endian = bom[0] == 0x1A;
+      uint32_t block_len = Get32(header + 4);
+      if (block_len < 12 || !Skip(block_len - 12)) {
+        return false;
+      }
+      m_interfaces.clear();
+      continue;
+    }
+
+    uint32_t type = Get32(header);
+    uint32_t block_len = Get32(header + 4);
+    if (block_len < 12 || block_len > PCAPNG_BLOCK_MAX) {
+      return false;
+    }
+    m_frame.resize(block_len - 8);
+    if (!Read(&m_frame[0], m_frame.size())) {
+      return false;
+    }
+    const uint8_t *body = &m_frame[0];
+    size_t body_len = m_frame.size() - 4;  // without the trailing copy of the length
+
+    if (type == PCAPNG_INTERFACE_DESCRIPTION && body_len >= 8) {
+      Interface interface;
+      interface.link_type = Get16(body);
+      interface.units_per_second = 1000000;
+      for (size_t o = 8; o + 4 <= body_len;) {
+        size_t code = Get16(body + o);
+        size_t option_len = Get16(body + o + 2);
+        if (code == 0 || o + 4 + option_len > body_len) {
+          break;
+        }
+        if (code == PCAPNG_OPTION_TSRESOL && option_len >= 1) {
+          uint8_t resolution = body[o + 4];
+          uint64_t base = (resolution & 0x80) ? 2 : 10;
+          interface.units_per_second = 1;
+          for (int i = 0; i < (resolution & 0x7F); i++) {
+            interface.units_per_second *= base;
+          }
+        }
+        o += 4 + ((option_len + 3) & ~3);
+      }
+      m_interfaces.push_back(interface);
+    } else if (type == PCAPNG_ENHANCED_PACKET && body_len >= 20) {
+      size_t id = Get32(body);
+      uint64_t timestamp = ((uint64_t)Get32(body + 4) << 32) | Get32(body + 8);
+      size_t captured = Get32(body + 12);
+      if (id >= m_interfaces.size() || 20 + captured > body_len) {
+        continue;
+      }
+      uint64_t units = m_interfaces[id].units_per_second;
+      uint64_t millis = units >= MILLISECONDS_PER_SECOND ? timestamp / (units / MILLISECONDS_PER_SECOND)
+                                                         : timestamp * MILLISECONDS_PER_SECOND / units;
+      *link_type = m_interfaces[id].link_type;
+      *time = wxLongLong((long)(millis >> 32), (unsigned long)(millis & 0xFFFFFFFF));
+      *data = body + 20;
+      *len = captured;
+      return true;
+    } else if (type == PCAPNG_SIMPLE_PACKET && body_len >= 4 && !m_interfaces.empty()) {
+      *link_type = m_interfaces[0].link_type;
+      *time = m_last_time;  // Simple packets have no timestamp
+      *data = body + 4;
+      *len = wxMin((size_t)Get32(body), body_len - 4);
+      return true;
+    }
+    // Anything else, such as statistics and name resolution, is of no interest
+  }
+}
+
+/*
+ * Put fragmented datagrams back together. Radar frames are sent in order and quickly after
+ * each other, so only a few datagrams are being assembled at any time; when a new one comes
+ * along the oldest unfinished one is given up.
+ *
+ * @return true if a complete UDP datagram is in packet.
+ */
+bool PcapReader::ProcessIPv4(const uint8_t *ip, size_t len, wxLongLong time, PcapPacket *packet) {
+  if (len < 20 || (ip[0] >> 4) != 4 || ip[9] != IP_PROTOCOL_UDP) {
+    return false;
+  }
+  size_t header_len = (ip[0] & 0x0F) * 4;
+  size_t total_len = wxMin((size_t)GetBE16(ip + 2), len);
+  if (header_len < 20 || total_len < header_len) {
+    return false;
+  }
+
+  uint16_t flags = GetBE16(ip + 6);
+  size_t offset = (flags & IP_FRAGMENT_OFFSET) * 8;
+  bool more = (flags & IP_MORE_FRAGMENTS) != 0;
+  const uint8_t *payload = ip + header_len;
+  size_t payload_len = total_len - header_len;
+  uint32_t source;
+  uint32_t destination;
+
+  memcpy(&source, ip + 12, sizeof(source));
+  memcpy(&destination, ip + 16, sizeof(destination));
+
+  if (more || offset > 0) {
+    uint16_t id = GetBE16(ip + 4);
+    Fragments *f = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(m_fragments) && !f; i++) {
+      Fragments &c = m_fragments[i];
+      if (c.used && c.id == id && c.source == source && c.destination == destination) {
+        f = &c;
+      }
+    }
+    if (!f) {
+      f = &m_fragments[0];
+      for (size_t i = 0; i < ARRAY_SIZE(m_fragments); i++) {
+        if (!m_fragments[i].used) {
+          f = &m_fragments[i];
+          break;
+        }
+        if (m_fragments[i].age < f->age) {
+          f = &m_fragments[i];
+        }
+      }
+      f->used = true;
+      f->id = id;
+      f->source = source;
+      f->destination = destination;
+      f->received = 0;
+      f->total = 0;
+      f->data.clear();
+      f->age = m_fragment_age++;
+    }
+
+    if (offset + payload_len > 65535) {
+      f->used = false;
+      return false;
+    }
+    if (f->data.size() < offset + payload_len) {
+      f->data.resize(offset + payload_len);
+    }
+    memcpy(&f->data[offset], payload, payload_len);
+    f->received += payload_len;
+    if (!more) {
+      f->total = offset + payload_len;
+    }
+    if (f->total == 0 || f->received < f->total) {
+      return false;
+    }
+
+    m_datagram.swap(f->data);
+    f->used = false;
+    payload = &m_datagram[0];
+    payload_len = f->total;
+  }
+
+  if (payload_len < 8) {
+    return false;
+  }
+  size_t udp_len = GetBE16(payload + 4);
+  if (udp_len < 8) {
+    return false;
+  }
+
+  packet->time = time;
+  packet->source.addr.s_addr = source;
+  memcpy(&packet->source.port, payload, sizeof(packet->source.port));
+  packet->destination.addr.s_addr = destination;
+  memcpy(&packet->destination.port, payload + 2, sizeof(packet->destination.port));
+  packet->data = payload + 8;
+  packet->len = wxMin(udp_len, payload_len) - 8;
+  return true;
+}
+
+bool PcapReader::Next(PcapPacket *packet) {
+  if (!m_file) {
+    return false;
+  }
+
+  while (true) {
+    uint32_t link_type;
+    wxLongLong time;
+    const uint8_t *data;
+    size_t len;
+
+    if (m_pcapng ? !NextPcapngFrame(&link_type, &time, &data, &len) : !NextPcapFrame(&link_type, &time, &data, &len)) {
+      return false;
+    }
+    m_last_time = time;
+
+    // Strip the link layer
+    size_t header_len = 0;
+    uint16_t protocol = ETHERTYPE_IPV4;
+    switch (link_type) {
+      case LINKTYPE_ETHERNET:
+        header_len = 14;
+        if (len < header_len) {
+          continue;
+        }
+        protocol = GetBE16(data + 12);
+        while ((protocol == ETHERTYPE_VLAN || protocol == ETHERTYPE_QINQ) && len >= header_len + 4) {
+          protocol = GetBE16(data + header_len + 2);
+          header_len += 4;
+        }
+        break;
+      case LINKTYPE_LINUX_SLL:
+        header_len = 16;
+        protocol = len >= header_len ? GetBE16(data + 14) : 0;
+        break;
+      case LINKTYPE_LINUX_SLL2:
+        header_len = 20;
+        protocol = len >= header_len ? GetBE16(data) : 0;
+        break;
+      case LINKTYPE_NULL:
+        header_len = 4;  // Address family in host order of the capturing machine, just try IPv4
+        break;
+      case LINKTYPE_RAW:
+      case LINKTYPE_IPV4:
+        break;
+      default:
+        continue;
+    }
+    if (protocol != ETHERTYPE_IPV4 || len < header_len) {
+      continue;
+    }
+    if (ProcessIPv4(data + header_len, len - header_len, time, packet)) {
+      return true;
+    }
+  }
+}
+
+PLUGIN_END_NAMESPACE
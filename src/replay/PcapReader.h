@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _PCAPREADER_H_
+#define _PCAPREADER_H_
+
+#include <vector>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#include "socketutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+//
+// Reads the UDP datagrams from a packet capture, as made by tcpdump or Wireshark. Both the
+// classic pcap and the pcapng format are understood, gzip compressed as well when built with zlib
+// (HAVE_ZLIB). Radar frames are larger than an Ethernet frame, so fragmented IPv4 datagrams are put
+// back together.
+//
+
+struct PcapPacket {
+  wxLongLong time;  // Capture time in ms since 1970
+  NetworkAddress source;
+  NetworkAddress destination;
+  const uint8_t *data;  // UDP payload, valid until the next call to Next()
+  size_t len;
+};
+
+#define PCAP_REASSEMBLY_SLOTS (8)  // Datagrams being put back together at the same time
+
+class PcapReader {
+ public:
+  PcapReader();
+  ~PcapReader();
+
+  bool Open(const wxString &filename);
+  void Close();
+  bool Rewind();
+
+  // The next UDP datagram, skipping all other traffic. Returns false at the end of the capture.
+  bool Next(PcapPacket *packet);
+
+ private:
+  struct Interface {
+    uint32_t link_type;
+    uint64_t units_per_second;  // Resolution of the timestamps
+  };
+  struct Fragments {
+    bool used;
+    uint32_t source;
+    uint32_t destination;
+    uint16_t id;
+    size_t received;  // Bytes received so far
+    size_t total;     // Length of the datagram, 0 until the last fragment is seen
+    std::vector<uint8_t> data;
+    uint64_t age;
+  };
+
+  bool ReadHeader();
+  bool Read(void *buf, size_t len);
+  uint16_t Get16(const uint8_t *p);
+  uint32_t Get32(const uint8_t *p);
+  bool Skip(size_t len);
+  bool NextPcapFrame(uint32_t *link_type, wxLongLong *time, const uint8_t **data, size_t *len);
+  bool NextPcapngFrame(uint32_t *link_type, wxLongLong *time, const uint8_t **data, size_t *len);
+  bool ProcessIPv4(const uint8_t *ip, size_t len, wxLongLong time, PcapPacket *packet);
+
+#ifdef HAVE_ZLIB
+  gzFile m_file;
+#else
+  FILE *m_file;
+#endif
+  bool m_pcapng;
+  bool m_big_endian;  // Byte order of the numbers in the file
+  std::vector<Interface> m_interfaces;
+  std::vector<uint8_t> m_frame;
+  wxLongLong m_last_time;
+
+  Fragments m_fragments[PCAP_REASSEMBLY_SLOTS];
+  uint64_t m_fragment_age;
+  std::vector<uint8_t> m_datagram;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _PCAPREADER_H_ */
@@ -0,0 +1,347 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "ReplayReceive.h"
+#include "RadarFactory.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define MILLIS_PER_SLEEP 100  // Longest wait before the thread checks whether it should stop
+
+// The multicast addresses that the Navico radars use, and the radar whose spoke layout
+// goes with them. A BR24 or 3G uses the same addresses as a 4G A, but a different header.
+struct NavicoChannel {
+  NetworkAddress data;
+  NetworkAddress report;
+  RadarType type;
+};
+
+static const NavicoChannel g_navico_channels[] = {
+    {NetworkAddress(236, 6, 7, 8, 6678), NetworkAddress(236, 6, 7, 9, 6679), RT_4GA},
+    {NetworkAddress(236, 6, 7, 13, 6657), NetworkAddress(236, 6, 7, 15, 6659), RT_4GB},
+    {NetworkAddress(236, 6, 7, 100, 6132), NetworkAddress(236, 6, 7, 102, 6134), RT_HaloA},
+    {NetworkAddress(236, 6, 7, 103, 6135), NetworkAddress(236, 6, 7, 105, 6137), RT_HaloB},
+};
+
+static const NetworkAddress g_garmin_xhd_data(239, 254, 2, 0, 50102);
+static const NetworkAddress g_garmin_xhd_report(239, 254, 2, 0, 50100);
+
+bool ReplayReceive::OpenFile() {
+  m_filename = M_SETTINGS.replay_file;
+  m_speed = wxMax(M_SETTINGS.replay_speed, 0);
+
+  if (m_filename.IsEmpty()) {
+    SetInfoStatus(wxString::Format(wxT("%s: %s"), m_ri->m_name.c_str(), _("No replay file set")));
+    return false;
+  }
+  if (m_recording.Open(m_filename)) {
+    m_is_recording = true;
+  } else if (m_capture.Open(m_filename)) {
+    m_is_recording = false;
+  } else {
+    SetInfoStatus(wxString::Format(wxT("%s: %s %s"), m_ri->m_name.c_str(), _("Cannot read"), m_filename.c_str()));
+    return false;
+  }
+
+  wxString speed = m_speed ? wxString::Format(wxT("%dx"), m_speed) : wxString(_("full speed"));
+  SetInfoStatus(wxString::Format(wxT("%s: %s %s %s %s"), m_ri->m_name.c_str(), _("Replaying"),
+                                 wxFileName(m_filename).GetFullName().c_str(), _("at"), speed.c_str()));
+  LOG_INFO(wxT("radar_pi: %s replaying %s %s at %s"), m_ri->m_name.c_str(), m_is_recording ? wxT("recording") : wxT("capture"),
+           m_filename.c_str(), speed.c_str());
+  return true;
+}
+
+// Sleep in short steps so that Shutdown is noticed. Returns false when the thread should stop.
+bool ReplayReceive::Sleep(wxLongLong millis) {
+  while (millis > 0 && !m_shutdown) {
+    long step = (long)wxMin(millis.GetValue(), (wxLongLong_t)MILLIS_PER_SLEEP);
+    wxMilliSleep(step);
+    millis -= step;
+  }
+  return !m_shutdown;
+}
+
+/*
+ * Wait until it is time to play something that happened at file_time, and move the radar clock
+ * there. The clock continues where it was at the start of each pass, so it never goes back when
+ * the file starts over.
+ */
+bool ReplayReceive::WaitFor(wxLongLong file_time, bool first) {
+  if (first) {
+    m_file_start = file_time;
+    m_file_last = file_time;
+    m_clock_start = m_ri->m_replay_clock.GetMillis();
+    m_wall_start = wxGetUTCTimeMillis();
+  }
+  if (file_time > m_file_last) {
+    m_file_last = file_time;  // Captures are not always in order, but the clock must not go back
+  }
+
+  wxLongLong elapsed = m_file_last - m_file_start;
+  if (m_speed > 0) {
+    wxLongLong wait = m_wall_start + elapsed / m_speed - wxGetUTCTimeMillis();
+    if (wait > 0 && !Sleep(wait)) {
+      return false;
+    }
+  }
+  m_ri->m_replay_clock.SetMillis(m_clock_start + elapsed);
+  return !m_shutdown;
+}
+
+void ReplayReceive::ProcessPacket(const PcapPacket &packet) {
+  NetworkAddress radar_address = packet.source;
+
+  // A capture can contain reports of several radars, so the first spokes decide which one is replayed
+  if (m_navico_channel < 0) {
+    for (size_t i = 0; i < ARRAY_SIZE(g_navico_channels); i++) {
+      if (packet.destination == g_navico_channels[i].data) {
+        m_navico_channel = (int)i;
+      }
+    }
+  }
+  if (m_navico_channel >= 0) {
+    const NavicoChannel &channel = g_navico_channels[m_navico_channel];
+
+    if (packet.destination == channel.data) {
+      if (!m_navico) {
+        m_navico = new NavicoReceive(m_pi, m_ri, channel.report, channel.data);
+        m_navico->m_spoke_format = channel.type;
+        // The BR24 marks its spoke headers with 0x0d 0x0e where the 4G has its range
+        if (channel.type == RT_4GA && packet.len > 8 + 7 && packet.data[8 + 6] == 0x0d && packet.data[8 + 7] == 0x0e) {
+          m_navico->m_spoke_format = RT_BR24;
+        }
+        m_ri->DetectedRadar(m_pi->GetRadarInterfaceAddress(m_ri->m_radar), radar_address);
+        LOG_INFO(wxT("radar_pi: %s replaying Navico spokes from %s"), m_ri->m_name.c_str(),
+                 FormatNetworkAddressPort(packet.destination).c_str());
+      }
+      m_navico->ProcessFrame(packet.data, (int)packet.len);
+    } else if (packet.destination == channel.report && m_navico) {
+      m_navico->ProcessReport(packet.data, (int)packet.len);
+    }
+    return;
+  }
+
+  if (packet.destination == g_garmin_xhd_data) {
+    if (!m_garmin) {
+      m_garmin = new GarminxHDReceive(m_pi, m_ri, g_garmin_xhd_report, g_garmin_xhd_data);
+      m_ri->DetectedRadar(m_pi->GetRadarInterfaceAddress(m_ri->m_radar), radar_address);
+      LOG_INFO(wxT("radar_pi: %s replaying Garmin xHD spokes from %s"), m_ri->m_name.c_str(),
+               FormatNetworkAddressPort(packet.destination).c_str());
+    }
+    m_garmin->ProcessFrame(packet.data, (int)packet.len);
+  } else if (packet.destination == g_garmin_xhd_report && m_garmin) {
+    m_garmin->ProcessReport(packet.data, (int)packet.len);
+  }
+}
+
+/*
+ * Fit a recorded spoke into our geometry, the same way as NetworkReceive does with spokes from
+ * the network.
+ */
+void ReplayReceive::ProcessSpoke(const RecordingRecord &record) {
+  size_t spokes = m_recording.GetSpokes();
+  size_t len = record.len;
+  const uint8_t *data = record.data;
+
+  if (len > m_ri->m_spoke_len_max) {
+    size_t group = (len + m_ri->m_spoke_len_max - 1) / m_ri->m_spoke_len_max;
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i += group, n++) {
+      uint8_t strongest = 0;
+      for (size_t j = i; j < wxMin(i + group, len); j++) {
+        strongest = wxMax(strongest, data[j]);
+      }
+      m_line[n] = strongest;
+    }
+    len = n;
+    data = m_line;
+  }
+
+  size_t first = record.angle * m_ri->m_spokes / spokes;
+  size_t last = wxMax((record.angle + 1) * m_ri->m_spokes / spokes, first + 1);
+  int offset = (int)(record.bearing * m_ri->m_spokes / spokes) - (int)first;
+  wxLongLong time_rec = m_ri->m_replay_clock.GetMillis();
+
+  for (size_t angle = first; angle < last; angle++) {
+    uint8_t line[REPLAY_MAX_SPOKE_LEN];
+
+    // ProcessRadarSpoke modifies the data, so give it a copy each time
+    memcpy(line, data, len);
+    m_ri->ProcessRadarSpoke(MOD_SPOKES(angle), MOD_SPOKES(angle + offset), line, len, record.range_meters, time_rec);
+  }
+}
+
+void ReplayReceive::ProcessRecord(const RecordingRecord &record) {
+  switch (record.type) {
+    case RECORD_SPOKE: {
+      time_t now = m_ri->GetRadarTime();
+
+      ProfiledLocker lock(m_ri->m_exclusive);
+
+      m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
+      m_ri->m_data_timeout = now + DATA_TIMEOUT;
+      m_ri->m_state.Update(RADAR_TRANSMIT);
+      m_ri->m_statistics.packets++;
+      m_ri->m_statistics.spokes++;
+      if (record.range_meters > 0 && record.range_meters != m_ri->m_range.GetValue()) {
+        m_ri->m_range.Update(record.range_meters);
+      }
+      ProcessSpoke(record);
+      break;
+    }
+
+    case RECORD_NAVIGATION:
+      // The position stays with OpenCPN, but this radar's spokes are drawn relative to the recorded heading
+      if (!isnan(record.heading)) {
+        m_ri->SetReplayHeading(record.heading);
+      }
+      break;
+
+    case RECORD_CONTROL:
+      // Only the range is shown for a replayed radar, and that follows the spokes
+      break;
+  }
+}
+
+// One pass through a packet capture. Returns false when the thread should stop.
+bool ReplayReceive::ReplayCapture() {
+  PcapPacket packet;
+  bool first = true;
+
+  if (!m_capture.Rewind()) {
+    return false;
+  }
+  while (m_capture.Next(&packet)) {
+    if (!WaitFor(packet.time, first)) {
+      return false;
+    }
+    first = false;
+    ProcessPacket(packet);
+  }
+  return !first;
+}
+
+// One pass through a recording. Returns false when the thread should stop.
+bool ReplayReceive::ReplayRecording() {
+  RecordingRecord record;
+  bool first = true;
+
+  if (!m_recording.Seek(m_recording.GetStartTime())) {
+    return false;
+  }
+  while (m_recording.Next(&record)) {
+    if (!WaitFor(record.time, first)) {
+      return false;
+    }
+    first = false;
+    ProcessRecord(record);
+  }
+  return !first;
+}
+
+void ReplayReceive::DeleteReceivers() {
+  // They never ran as a thread, so only the sockets that their constructor made need to go
+  if (m_navico) {
+    closesocket(m_navico->m_receive_socket);
+    closesocket(m_navico->m_send_socket);
+    delete m_navico;
+    m_navico = 0;
+  }
+  if (m_garmin) {
+    closesocket(m_garmin->m_receive_socket);
+    closesocket(m_garmin->m_send_socket);
+    delete m_garmin;
+    m_garmin = 0;
+  }
+}
+
+/*
+ * Entry
+ *
+ * Called by wxThread when the new thread is running.
+ * It should remain running until Shutdown is called.
+ */
+void *ReplayReceive::Entry(void) {
+  LOG_VERBOSE(wxT("radar_pi: ReplayReceive thread %s starting"), m_ri->m_name.c_str());
+  TraceThreadName(m_ri->m_name + wxT(" receive"));
+
+  bool opened = false;
+  while (!m_shutdown && !opened) {
+    opened = OpenFile() || !Sleep(MILLISECONDS_PER_SECOND);
+  }
+
+  if (opened && !m_shutdown) {
+    // Only this radar runs on the time of the file, the others and the rest of the plugin keep real time
+    m_ri->m_replay_clock.SetMillis(wxGetUTCTimeMillis());
+    m_ri->m_clock = &m_ri->m_replay_clock;
+
+    // Play the file over and over until we are stopped
+    while (!m_shutdown) {
+      wxLongLong start = wxGetUTCTimeMillis();
+
+      if (!(m_is_recording ? ReplayRecording() : ReplayCapture())) {
+        if (!m_shutdown) {
+          wxLogError(wxT("radar_pi: %s nothing to replay in %s"), m_ri->m_name.c_str(), m_filename.c_str());
+        }
+        break;
+      }
+      m_passes++;
+      LOG_INFO(wxT("radar_pi: %s replayed %s in %lld ms"), m_ri->m_name.c_str(), m_filename.c_str(),
+               (wxGetUTCTimeMillis() - start).GetValue());
+    }
+
+    m_ri->m_clock = GetRadarClock();
+    m_ri->SetReplayHeading(nan(""));
+  }
+
+  DeleteReceivers();
+  m_capture.Close();
+  m_recording.Close();
+
+  LOG_VERBOSE(wxT("radar_pi: %s receive thread stopping"), m_ri->m_name.c_str());
+  return 0;
+}
+
+// Called from the main thread to stop this thread. There is no socket to wake up, the thread
+// checks m_shutdown at least every MILLIS_PER_SLEEP.
+void ReplayReceive::Shutdown() { m_shutdown = true; }
+
+wxString ReplayReceive::GetInfoStatus() {
+  wxCriticalSectionLocker lock(m_lock);
+  // Called on the UI thread, so be gentle
+  if (m_passes > 0) {
+    return m_status + wxString::Format(wxT("\n%s %d"), _("Passes"), m_passes);
+  }
+  return m_status;
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _REPLAYRECEIVE_H_
+#define _REPLAYRECEIVE_H_
+
+#include "RadarClock.h"
+#include "RadarReceive.h"
+#include "RadarRecording.h"
+#include "PcapReader.h"
+#include "socketutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+class NavicoReceive;
+class GarminxHDReceive;
+
+//
+// Plays back a radar session from a file instead of a radar on the network. The file is either a
+// packet capture of a Navico or Garmin xHD radar, whose frames are handed to the receive code of
+// that radar, or a recording made by RadarRecorder. The radar clock follows the time in the
+// file, so replaying faster than real time speeds up everything that depends on time as well.
+//
+
+class ReplayReceive : public RadarReceive {
+ public:
+  ReplayReceive(radar_pi *pi, RadarInfo *ri) : RadarReceive(pi, ri) {
+    m_shutdown = false;
+    m_speed = 1;
+    m_is_recording = false;
+    m_navico = 0;
+    m_navico_channel = -1;
+    m_garmin = 0;
+    m_passes = 0;
+    SetInfoStatus(wxString::Format(wxT("%s: %s"), m_ri->m_name.c_str(), _("Initializing")));
+    LOG_RECEIVE(wxT("radar_pi: %s receive thread created"), m_ri->m_name.c_str());
+  };
+
+  ~ReplayReceive() {}
+
+  void *Entry(void);
+  void Shutdown(void);
+  wxString GetInfoStatus();
+
+ private:
+  bool OpenFile();
+  bool ReplayCapture();
+  bool ReplayRecording();
+  bool WaitFor(wxLongLong file_time, bool first);
+  bool Sleep(wxLongLong millis);
+  void ProcessPacket(const PcapPacket &packet);
+  void ProcessRecord(const RecordingRecord &record);
+  void ProcessSpoke(const RecordingRecord &record);
+  void DeleteReceivers();
+  void SetInfoStatus(wxString status) {
+    wxCriticalSectionLocker lock(m_lock);
+    m_status = status;
+  }
+
+  volatile bool m_shutdown;
+
+  wxString m_filename;
+  int m_speed;  // Multiple of real time, 0 = as fast as possible
+  bool m_is_recording;
+  PcapReader m_capture;
+  RadarRecordingReader m_recording;
+
+  // The receivers that decode the frames in a capture, created when the first frame is seen
+  NavicoReceive *m_navico;
+  int m_navico_channel;  // Which of the Navico address pairs the capture contains
+  GarminxHDReceive *m_garmin;
+
+  wxLongLong m_file_start;   // Time in the file at the start of this pass
+  wxLongLong m_file_last;    // Latest time seen in the file, so the clock never goes back
+  wxLongLong m_clock_start;  // Radar clock at the start of this pass
+  wxLongLong m_wall_start;   // Real time at the start of this pass
+  int m_passes;
+
+  uint8_t m_line[REPLAY_MAX_SPOKE_LEN];
+
+  wxCriticalSection m_lock;  // Protects m_status
+  wxString m_status;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _REPLAYRECEIVE_H_ */
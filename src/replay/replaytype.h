@@ -0,0 +1,43 @@
+#ifdef INITIALIZE_RADAR
+
+PLUGIN_BEGIN_NAMESPACE
+
+PLUGIN_END_NAMESPACE
+
+#endif
+
+// The range is set by the recording, these are only for display
+#define RANGE_METRIC_RT_REPLAY \
+  { 50, 75, 100, 250, 500, 750, 1000, 1500, 2000, 3000, 4000, 6000, 8000, 12000, 16000, 24000, 36000, 48000, 72000 }
+#define RANGE_MIXED_RT_REPLAY                                                                                                \
+  {                                                                                                                          \
+    50, 75, 100, 1852 / 8, 1852 / 4, 1852 / 2, 1852 * 3 / 4, 1852 * 1, 1852 * 3 / 2, 1852 * 2, 1852 * 3, 1852 * 4, 1852 * 6, \
+        1852 * 8, 1852 * 12, 1852 * 16, 1852 * 24, 1852 * 36                                                                 \
+  }
+#define RANGE_NAUTIC_RT_REPLAY                                                                                              \
+  {                                                                                                                         \
+    1852 / 32, 1852 / 16, 1852 / 8, 1852 / 4, 1852 / 2, 1852 * 3 / 4, 1852 * 1, 1852 * 3 / 2, 1852 * 2, 1852 * 3, 1852 * 4, \
+        1852 * 6, 1852 * 8, 1852 * 12, 1852 * 16, 1852 * 24, 1852 * 36                                                      \
+  }
+
+// Navico frames fit as is, Garmin frames and recorded spokes are fitted into this geometry
+#define REPLAY_SPOKES 2048
+#define REPLAY_MAX_SPOKE_LEN 1024
+
+#if SPOKES_MAX < REPLAY_SPOKES
+#undef SPOKES_MAX
+#define SPOKES_MAX REPLAY_SPOKES
+#endif
+#if SPOKE_LEN_MAX < REPLAY_MAX_SPOKE_LEN
+#undef SPOKE_LEN_MAX
+#define SPOKE_LEN_MAX REPLAY_MAX_SPOKE_LEN
+#endif
+
+DEFINE_RADAR(RT_REPLAY,             /* Type */
+             wxT("Replay"),         /* Name */
+             REPLAY_SPOKES,         /* Spokes */
+             REPLAY_MAX_SPOKE_LEN,  /* Spoke length */
+             ReplayControlsDialog,  /* Controls class */
+             ReplayReceive(pi, ri), /* Receive class */
+             ReplayControl          /* Send/Control class */
+)
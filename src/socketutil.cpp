@@ -32,6 +32,10 @@
 
 #include "socketutil.h"
 
+#ifdef __linux__
+#include <time.h>
+#endif
+
 PLUGIN_BEGIN_NAMESPACE
 
 wxString FormatNetworkAddress(const NetworkAddress &addr) {
@@ -171,6 +175,63 @@ bool socketReady(SOCKET sockfd, int timeout) {
   return r > 0;
 }
 
+void EnableReceiveAge(SOCKET sockfd) {
+#if defined(__linux__) && defined(SO_TIMESTAMPNS)
+  int one = 1;
+
+  if (setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPNS, (const char *)&one, sizeof(one))) {
+    wxLogError(wxT("radar_pi: cannot timestamp received datagrams"));
+  }
+#endif
+}
+
+int ReceiveWithAge(SOCKET sockfd, char *buf, size_t len, struct sockaddr *from, socklen_t *fromlen, uint64_t *age) {
+  *age = RECEIVE_AGE_UNKNOWN;
+#if defined(__linux__) && defined(SO_TIMESTAMPNS)
+  struct iovec iov;
+  struct msghdr msg;
+  union {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(struct timespec))];
+  } control;
+
+  iov.iov_base = buf;
+  iov.iov_len = len;
+  CLEAR_STRUCT(msg);
+  msg.msg_name = from;
+  msg.msg_namelen = *fromlen;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  int r = (int)recvmsg(sockfd, &msg, 0);
+  if (r < 0) {
+    return r;
+  }
+  *fromlen = msg.msg_namelen;
+
+  for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+      struct timespec received;
+      struct timespec now;
+
+      // The kernel stamps with the wall clock, so that is what it is compared with. A step of the
+      // clock between the two gives one wrong sample; ages below zero are not counted.
+      memcpy(&received, CMSG_DATA(cmsg), sizeof(received));
+      clock_gettime(CLOCK_REALTIME, &now);
+      int64_t nanos = ((int64_t)now.tv_sec - received.tv_sec) * 1000000000 + (now.tv_nsec - received.tv_nsec);
+      if (nanos >= 0) {
+        *age = (uint64_t)nanos;
+      }
+    }
+  }
+  return r;
+#else
+  return recvfrom(sockfd, buf, (int)len, 0, from, fromlen);
+#endif
+}
+
 SOCKET startUDPMulticastReceiveSocket(const NetworkAddress &interface_address, const NetworkAddress &mcast_address, wxString &error_message) {
   SOCKET rx_socket;
   struct sockaddr_in listenAddress;
@@ -66,6 +66,7 @@ class NetworkAddress {
     addr.s_addr = u.word;
     port = htons(p);
   }
+  bool operator==(const NetworkAddress &other) const { return addr.s_addr == other.addr.s_addr && port == other.port; }
   struct in_addr addr;
   uint16_t port;
 };
@@ -75,6 +76,15 @@ extern wxString FormatNetworkAddressPort(const NetworkAddress &addr);
 
 extern bool socketReady(SOCKET sockfd, int timeout);
 
+#define RECEIVE_AGE_UNKNOWN (~(uint64_t)0)
+
+// Ask the kernel to timestamp the datagrams that sockfd receives, where the OS can do that
+extern void EnableReceiveAge(SOCKET sockfd);
+// recvfrom() that also sets *age to how long ago the kernel received the datagram, or to
+// RECEIVE_AGE_UNKNOWN when that is not known. The timestamp comes with the datagram, so this
+// costs no extra system call.
+extern int ReceiveWithAge(SOCKET sockfd, char *buf, size_t len, struct sockaddr *from, socklen_t *fromlen, uint64_t *age);
+
 extern int radar_inet_aton(const char *cp, struct in_addr *addr);
 extern SOCKET startUDPMulticastReceiveSocket(const NetworkAddress &addr, const NetworkAddress &mcast_address, wxString &error_message);
 extern SOCKET GetLocalhostServerTCPSocket();